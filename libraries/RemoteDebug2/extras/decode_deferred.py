@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+"""
+Decoder of the deferred logs of RemoteDebug (DEBUG_DEFERRED or Debug.deferred)
+
+The board sends the logs as binary frames between the normal text:
+
+    0x1E, type, size (varint), data
+
+    'F'  slot (1), id (4), format              once per connection, for each format
+    'L'  slot (1), level (1), time, args       each log, time: zigzag varint of the
+                                               ms since the last log
+
+    args: 'i' zigzag varint, 'u' varint, 'd' double (8, little endian),
+          's' size (1) and the bytes of a string
+
+    varint: 7 bits per byte, low bits first, high bit set if more bytes follow
+
+A broken frame (bytes lost or changed on the way, unknown type, size too big,
+arguments not complete) is skipped up to the next 0x1E, the bytes skipped are
+told on stderr.
+
+Usage:
+
+    decode_deferred.py host[:port]   connect to the telnet port of the board (23),
+                                     lines typed here are sent as commands
+    decode_deferred.py file          decode a saved stream (nc board 23 > log.bin)
+    decode_deferred.py -             from stdin (e.g. serial)
+
+Options:
+
+    --no-time                        do not show the time of the logs
+"""
+
+import re
+import socket
+import struct
+import sys
+import threading
+
+FRAME = 0x1E
+FRAME_TYPES = b"FL"
+FRAME_MAX = 4096  # Format or arguments (DEBUG_DEFERRED_SIZE), bigger is a broken frame
+SIZE_BYTES = 3  # Varint of the frame size
+LEVELS = "PVDIWE"
+
+# printf conversion: flags, width, precision, length, type
+CONVERSION = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|L|z|j|t)?([diouxXeEfFgGaAcspn%])")
+
+
+class Decoder:
+    def __init__(self, out, show_time=True, err=sys.stderr):
+        self.out = out
+        self.err = err
+        self.show_time = show_time
+        self.formats = {}
+        self.time = 0
+        self.buffer = b""
+        self.dropped = 0  # Bytes of a broken frame, up to the next 0x1E
+        self.skipped = 0  # All the bytes skipped
+
+    def feed(self, data):
+        self.buffer += data
+        while self.buffer:
+            start = self.buffer.find(bytes([FRAME]))
+            if self.dropped:  # Resync on the next frame
+                self.drop(len(self.buffer) if start < 0 else start)
+                if start >= 0:
+                    self.report()
+                continue
+            if start != 0:
+                text = self.buffer if start < 0 else self.buffer[:start]
+                self.out.write(text.decode("utf-8", "replace"))
+                self.buffer = b"" if start < 0 else self.buffer[start:]
+                continue
+            if len(self.buffer) < 2:
+                break
+            size, pos = varint(self.buffer, 2)
+            if self.buffer[1] not in FRAME_TYPES or pos - 2 > SIZE_BYTES or (size is not None and size > FRAME_MAX):
+                self.drop(1)
+                continue
+            if size is None or len(self.buffer) < pos + size:
+                break
+            if not self.frame(chr(self.buffer[1]), self.buffer[pos:pos + size]):
+                self.drop(1)
+                continue
+            self.buffer = self.buffer[pos + size:]
+        self.out.flush()
+
+    def drop(self, size):
+        self.dropped += size
+        self.buffer = self.buffer[size:]
+
+    def report(self):
+        self.out.flush()
+        self.err.write("decode_deferred: %d bytes skipped, broken frame\n" % self.dropped)
+        self.err.flush()
+        self.skipped += self.dropped
+        self.dropped = 0
+
+    def end(self):
+        """end of the stream, a frame not complete is broken too"""
+        self.drop(len(self.buffer))
+        if self.dropped:
+            self.report()
+
+    def frame(self, type, data):
+        """False if the frame is broken"""
+        if type == "F":
+            if len(data) < 5:
+                return False
+            self.formats[data[0]] = data[5:].decode("utf-8", "replace")
+        elif type == "L":
+            if len(data) < 3:
+                return False
+            slot, level = data[0], data[1]
+            elapsed, pos = varint(data, 2)
+            args = self.arguments(data[pos:]) if elapsed is not None else None
+            if args is None:
+                return False
+            self.time = (self.time + ((elapsed >> 1) ^ -(elapsed & 1))) & 0xFFFFFFFF
+            time = self.time
+            format = self.formats.get(slot)
+            if format is None:
+                format = "<format %d not received>\n" % slot
+            prefix = ""
+            if level < len(LEVELS):
+                prefix = LEVELS[level]
+            if self.show_time:
+                prefix += (" " if prefix else "") + "t:%dms" % time
+            if prefix:
+                prefix = "(" + prefix + ") "
+            text = self.format(format, args)
+            # New lines as the text of the board
+            self.out.write(prefix + text.replace("\r\n", "\n").replace("\n", "\r\n"))
+        return True
+
+    @staticmethod
+    def arguments(data):
+        """None if they are not complete"""
+        args = []
+        pos = 0
+        while pos < len(data):
+            type = chr(data[pos])
+            pos += 1
+            if type in "iu":
+                value, pos = varint(data, pos)
+                if value is None:
+                    return None
+                if type == "i":
+                    value = (value >> 1) ^ -(value & 1)
+                args.append((type, value))
+            elif type == "d" and pos + 8 <= len(data):
+                (value,) = struct.unpack_from("<d", data, pos)
+                pos += 8
+                args.append((type, value))
+            elif type == "s" and pos < len(data) and pos + 1 + data[pos] <= len(data):
+                size = data[pos]
+                args.append((type, data[pos + 1:pos + 1 + size].decode("utf-8", "replace")))
+                pos += 1 + size
+            else:
+                return None
+        return args
+
+    @staticmethod
+    def format(format, args):
+        args = list(args)
+
+        def next_arg():
+            return args.pop(0) if args else (None, None)
+
+        def convert(match):
+            flags, width, precision, length, conversion = match.groups()
+            if conversion == "%":
+                return "%"
+            if conversion == "n":
+                return ""
+            if width == "*":
+                width = str(next_arg()[1] or 0)
+            if precision == "*":
+                precision = str(next_arg()[1] or 0)
+            spec = "%" + flags + (width or "") + ("." + precision if precision is not None else "")
+            type, value = next_arg()
+            if value is None:
+                return "?"
+            if conversion in "diouxXc":
+                if type in "sd":
+                    return (spec + "s") % value
+                if conversion in "ouxX" and value < 0:
+                    value &= (1 << (64 if length in ("ll", "j") else 32)) - 1
+                if conversion == "c":
+                    return (spec + "s") % chr(value & 0xFF)
+                return (spec + conversion.replace("i", "d")) % value
+            if conversion in "eEfFgGaA":
+                if type == "s":
+                    return (spec + "s") % value
+                if conversion in "aA":
+                    return float(value).hex()
+                return (spec + conversion) % float(value)
+            if conversion == "p":
+                return "0x%x" % (value if type != "s" else 0)
+            return (spec + "s") % value
+
+        return CONVERSION.sub(convert, format)
+
+
+def varint(data, pos):
+    """value and position after it, None if not complete"""
+    value = 0
+    shift = 0
+    while pos < len(data):
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+    return None, pos
+
+
+def main():
+    args = [arg for arg in sys.argv[1:] if not arg.startswith("--")]
+    show_time = "--no-time" not in sys.argv
+    if len(args) != 1:
+        sys.stderr.write(__doc__)
+        return 1
+
+    decoder = Decoder(sys.stdout, show_time)
+    source = args[0]
+
+    if source == "-":
+        stream = sys.stdin.buffer
+    elif ":" in source or not _is_file(source):
+        host, _, port = source.partition(":")
+        connection = socket.create_connection((host, int(port or 23)))
+
+        # Commands typed here go to the board
+        def commands():
+            for line in sys.stdin:
+                connection.sendall(line.rstrip("\r\n").encode() + b"\r\n")
+
+        threading.Thread(target=commands, daemon=True).start()
+        stream = connection.makefile("rb", buffering=0)
+    else:
+        stream = open(source, "rb")
+
+    read = getattr(stream, "read1", stream.read)
+    while True:
+        data = read(4096)
+        if not data:
+            break
+        decoder.feed(data)
+    decoder.end()
+    return 0
+
+
+def _is_file(name):
+    try:
+        open(name, "rb").close()
+        return True
+    except OSError:
+        return False
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -32,6 +32,10 @@ bool system_update_cpu_freq(uint8_t freq);
 #error Only for ESP8266 or ESP32
 #endif  // ESP8266 or ESP32 ?
 
+#if defined(ESP32) && defined(ESP_ARDUINO_VERSION)
+#include <lwip/sockets.h>  // Telnet writes not blocking
+#endif
+
 #include "RemoteDebug.h"  // This library
 
 #ifdef ALPHA_VERSION  // In test, not good yet
@@ -50,55 +54,43 @@ bool system_update_cpu_freq(uint8_t freq);
 // use the following line to enable debug
 // #define D(fmt, ...) Serial.printf("rd: " fmt "\n", ##__VA_ARGS__);  // Serial debug
 
-// Internal print macros for send messages to client
-
-#if not WEBSOCKET_DISABLED
-
-#define debugPrintf(fmt, ...)                        \
-    {                                                \
-        if (_connected)                              \
-            TelnetClient.printf(fmt, ##__VA_ARGS__); \
-        else if (_connectedWS)                       \
-            DebugWS.printf(fmt, ##__VA_ARGS__);      \
-    }
-#define debugPrintln(str)              \
-    {                                  \
-        if (_connected)                \
-            TelnetClient.println(str); \
-        else if (_connectedWS)         \
-            DebugWS.println(str);      \
-    }
-#define debugPrint(str)              \
-    {                                \
-        if (_connected)              \
-            TelnetClient.print(str); \
-        else if (_connectedWS)       \
-            DebugWS.print(str);      \
-    }
-
-#else  // With  too
+// Internal print macros for send messages to clients:
+// to the client of the command in process, or to all the clients (see clientPrint)
 
-#define debugPrintf(fmt, ...)                                    \
-    {                                                            \
-        if (_connected) TelnetClient.printf(fmt, ##__VA_ARGS__); \
+#define debugPrintf(fmt, ...)                                                            \
+    {                                                                                    \
+        for (uint8_t printClient = 0; printClient < DEBUG_MAX_CLIENTS; printClient++) { \
+            Print* print = clientPrint(printClient);                                     \
+            if (print) print->printf(fmt, ##__VA_ARGS__);                                \
+        }                                                                                \
     }
-#define debugPrintln(str)                          \
-    {                                              \
-        if (_connected) TelnetClient.println(str); \
+#define debugPrintln(str)                                                                \
+    {                                                                                    \
+        for (uint8_t printClient = 0; printClient < DEBUG_MAX_CLIENTS; printClient++) { \
+            Print* print = clientPrint(printClient);                                     \
+            if (print) print->println(str);                                              \
+        }                                                                                \
     }
-#define debugPrint(str)                          \
-    {                                            \
-        if (_connected) TelnetClient.print(str); \
+#define debugPrint(str)                                                                  \
+    {                                                                                    \
+        for (uint8_t printClient = 0; printClient < DEBUG_MAX_CLIENTS; printClient++) { \
+            Print* print = clientPrint(printClient);                                     \
+            if (print) print->print(str);                                                \
+        }                                                                                \
     }
 
-#endif
-
 // Instance
 static RemoteDebug* _instance;
 
+#ifdef DEBUG_RING_SIZE
+// Level of the last isActive of the task that prints (tasks in both cores)
+// its address tells the tasks apart (lines kept for a task, see write)
+static thread_local uint8_t _ringLevel = RemoteDebug::DEBUG;
+#endif
+
 // WiFi server (telnet)
-static WiFiServer TelnetServer(TELNET_PORT);  // @suppress("Abstract class cannot be instantiated")
-static WiFiClient TelnetClient;               // @suppress("Abstract class cannot be instantiated")
+static WiFiServer TelnetServer(TELNET_PORT);                // @suppress("Abstract class cannot be instantiated")
+static WiFiClient TelnetClients[DEBUG_MAX_CLIENTS];         // By client, when it is a telnet one
 
 // Support to websocket connection with RemoteDebugApp
 #if not WEBSOCKET_DISABLED
@@ -106,37 +98,26 @@ static WiFiClient TelnetClient;               // @suppress("Abstract class canno
 // Instance of RemoteDebugWS
 static RemoteDebugWS DebugWS;  // @suppress("Abstract class cannot be instantiated")
 
-static boolean _connectedWS = false;  // Connected :
+static boolean _connectedWS = false;  // A web app is connected ?
 
 // Callbacks
 class MyRemoteDebugCallbacks : public RemoteDebugWSCallbacks {
-    void onConnect() {
+    void onConnect(uint8_t num) {
         // WebSocket (app) connected
-        D("rd: onconnect")
-
-        _connectedWS = true;
-
-        // Is telnet connected -> disconnect it, due reduce overheads
-        if (_instance->isConnected()) {
-            D("disconnect telnet, because WS is connected")
-            _instance->disconnect(true);
-        }
-
-        // Call same routine that telnet
-        _instance->onConnection(true);
+        D("rd: onconnect %u", num)
+        _instance->wsOnConnect(num);
     }
 
-    void onDisconnect() {
+    void onDisconnect(uint8_t num) {
         //  (app) disconnected
-
-        D("rd: ondisconnect")
-        _connectedWS = false;
+        D("rd: ondisconnect %u", num)
+        _instance->wsOnDisconnect(num);
     }
 
-    void onReceive(const char* message) {
+    void onReceive(uint8_t num, const char* message) {
         // Receive a message
-        D("rd: onreceive")
-        _instance->wsOnReceive(message);
+        D("rd: onreceive %u", num)
+        _instance->wsOnReceive(num, message);
     }
 };
 
@@ -172,27 +153,17 @@ bool RemoteDebug::begin(String hostName, uint16_t port, uint8_t startingDebugLev
 #if not WEBSOCKET_DISABLED
     // Initialize  (for RemoteDebugApp)
     DebugWS.begin(new MyRemoteDebugCallbacks());
-#endif
-
-    // Reserve space to buffer of print writes
-
-    _bufferPrint.reserve(BUFFER_PRINT);
-
-#ifdef CLIENT_BUFFERING
-    // Reserve space to buffer of send
-
-    _bufferPrint.reserve(MAX_SIZE_SEND);
-
 #endif
 
     // Host name of this device
 
     _hostName = hostName;
 
-    // Debug level
+    // Debug level (of the new clients and serial)
 
-    _clientDebugLevel = startingDebugLevel;
+    _debugLevel = startingDebugLevel;
     _lastDebugLevel = startingDebugLevel;
+    updateClients();
 
     return true;
 }
@@ -208,8 +179,18 @@ void RemoteDebug::initDebugger(boolean (*callbackEnabled)(), void (*callbackHand
     _callbackDbgProcessCmd = callbackProcessCmd;
 }
 
+// Telnet client of the command in process, else the first one
+
 WiFiClient* RemoteDebug::getTelnetClient() {
-    return &TelnetClient;
+    if (_clientCommand >= 0 && _clients[_clientCommand].type == CLIENT_TELNET) {
+        return &TelnetClients[_clientCommand];
+    }
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (_clients[client].type == CLIENT_TELNET) {
+            return &TelnetClients[client];
+        }
+    }
+    return &TelnetClients[0];
 }
 
 #endif
@@ -224,8 +205,10 @@ void RemoteDebug::setPassword(String password) {
 
 RemoteDebug::~RemoteDebug() {
     // Flush
-    if (TelnetClient && TelnetClient.connected()) {
-        TelnetClient.flush();
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (TelnetClients[client] && TelnetClients[client].connected()) {
+            TelnetClients[client].flush();
+        }
     }
 
     // Stop
@@ -236,9 +219,11 @@ RemoteDebug::~RemoteDebug() {
 
 void RemoteDebug::stop() {
     D("rd: stop")
-    // Stop Client
-    if (TelnetClient && TelnetClient.connected()) {
-        TelnetClient.stop();
+    // Stop Clients
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (_clients[client].type == CLIENT_TELNET) {
+            closeClient(client);
+        }
     }
 
     // Stop server
@@ -255,6 +240,11 @@ void RemoteDebug::stop() {
 // Handle the connection (in begin of loop in sketch)
 // TODO: optimize when loop not have a large delay
 void RemoteDebug::handle() {
+#ifdef DEBUG_SCOPES
+    // Loop time, between the calls
+    _profiler.loop(micros());
+#endif
+
 #ifdef ALPHA_VERSION  // In test, not good yet
     static uint32_t lastTime = millis();
 #endif
@@ -271,24 +261,21 @@ void RemoteDebug::handle() {
         silence(false, true);
     }
 
-    // Debug level is profiler -> set the level before
-    if (_clientDebugLevel == PROFILER) {
-        if (millis() > _levelProfilerDisable) {
-            _clientDebugLevel = _levelBeforeProfiler;
-            debugPrintln("* Debug level profile inactive now");
-        }
-    }
-
 #ifdef ALPHA_VERSION  // In test, not good yet
 
     // Automatic change to profiler level if time between handles is greater than n millis
-    if (_autoLevelProfiler > 0 && _clientDebugLevel != PROFILER) {
+    if (_autoLevelProfiler > 0) {
         uint32_t diff = (millis() - lastTime);
 
         if (diff >= _autoLevelProfiler) {
-            _levelBeforeProfiler = _clientDebugLevel;
-            _clientDebugLevel = PROFILER;
-            _levelProfilerDisable = 1000;  // Disable it at 1 sec
+            for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+                if (_clients[client].type != CLIENT_NONE && _clients[client].debugLevel != PROFILER) {
+                    _clients[client].levelBeforeProfiler = _clients[client].debugLevel;
+                    _clients[client].debugLevel = PROFILER;
+                    _clients[client].levelProfilerDisable = 1000;  // Disable it at 1 sec
+                }
+            }
+            updateClients();
 
             debugPrintf("* Debug level profile active now - time between handels: %u\r\n", diff);
         }
@@ -299,42 +286,43 @@ void RemoteDebug::handle() {
 
     // look for Client connect trial
     if (TelnetServer.hasClient()) {
-        // Old connection logic
+        // New connection logic - 10/08/17, more than one client
 
-        //      if (!TelnetClient || !TelnetClient.connected()) {
-        //
-        //        if (TelnetClient) { // Close the last connect - only one supported
-        //
-        //          TelnetClient.stop();
-        //
-        //        }
+        WiFiClient newClient;  // @suppress("Abstract class cannot be instantiated")
+        newClient = TelnetServer.available();
 
-        // New connection logic - 10/08/17
+        // A free client, else the one with the same IP (reconnect)
+        int8_t slot = -1;
 
-        if (TelnetClient && TelnetClient.connected()) {
-            // Verify if the IP is same than actual conection
-
-            WiFiClient newClient;  // @suppress("Abstract class cannot be instantiated")
-            newClient = TelnetServer.available();
+        for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+            if (_clients[client].type == CLIENT_NONE) {
+                slot = client;
+                break;
+            }
+        }
+        if (slot < 0 && newClient) {
             String ip = newClient.remoteIP().toString();
 
-            if (ip == TelnetClient.remoteIP().toString()) {
-                // Reconnect
-
-                TelnetClient.stop();
-                TelnetClient = newClient;
-
-            } else {
-                // Disconnect (not allow more than one connection)
-                newClient.stop();
-
-                return;
+            for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+                if (_clients[client].type == CLIENT_TELNET && ip == TelnetClients[client].remoteIP().toString()) {
+                    closeClient(client);
+                    slot = client;
+                    break;
+                }
             }
+        }
 
-        } else {
+        if (slot < 0) {
+            // Disconnect (not allow more connections)
+            newClient.println("* Too many clients connected, closing ...");
+            newClient.stop();
+
+        } else if (newClient) {
             // New TCP client
 
-            TelnetClient = TelnetServer.available();
+            WiFiClient& telnet = TelnetClients[slot];
+            telnet = newClient;
+            _clients[slot].type = CLIENT_TELNET;
 
             // Password request ? - 18/07/18
 
@@ -343,58 +331,69 @@ void RemoteDebug::handle() {
                       // Send command to telnet client to not do local echos
                       // Experimental code !
 
+                _clientCommand = slot;
                 sendTelnetCommand(TELNET_WONT, TELNET_ECHO);
+                _clientCommand = -1;
 #endif
             }
-        }
 
-        if (!TelnetClient) {  // No client yet ???
-            return;
-        }
+            // Set client
+            telnet.setNoDelay(true);  // More faster
+            telnet.flush();           // clear input buffer, else you get strange characters
 
-        // Set client
-        TelnetClient.setNoDelay(true);  // More faster
-        TelnetClient.flush();           // clear input buffer, else you get strange characters
+            // Empty buffer
+            delay(100);
 
-        // Empty buffer
-        delay(100);
+            while (telnet.available()) {
+                telnet.read();
+            }
 
-        while (TelnetClient.available()) {
-            TelnetClient.read();
+            // Connection event
+            onConnection(slot);
         }
-
-        // Connection event
-        onConnection(true);
     }
 
-    // Is client connected ? (to reduce overhead in active)
-    _connected = (TelnetClient && TelnetClient.connected());
+    // Get commands over telnet
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (_clients[client].type != CLIENT_TELNET) {
+            continue;
+        }
+        WiFiClient& telnet = TelnetClients[client];
+
+        if (!telnet || !telnet.connected()) {  // Disconnected
+            closeClient(client);
+            continue;
+        }
 
-    // Get command over telnet
-    if (_connected) {
         char last = ' ';  // To avoid process two times the "\r\n"
 
-        while (TelnetClient.available()) {  // get data from Client
+        while (_clients[client].type == CLIENT_TELNET && telnet.available()) {  // get data from Client
 
             // Get character
-            char character = TelnetClient.read();
+            char character = telnet.read();
+            String& command = _clients[client].command;
 
             // Newline (CR or LF) - once one time if (\r\n) - 26/07/17
             if (isCRLF(character) == true) {
                 if (isCRLF(last) == false) {
                     // Process the command
 
-                    if (_command.length() > 0) {
+                    if (command.length() > 0) {
+                        _command = command;
                         _lastCommand = _command;  // Store the last command
+                        command = "";
+
+                        _clientCommand = client;  // Answer to this client
                         processCommand();
+                        _clientCommand = -1;
                     }
                 }
 
-                _command = "";  // Init it for next command
+                command = "";  // Init it for next command
 
             } else if (isPrintable(character)) {
                 // Concat
-                _command.concat(character);
+                command.concat(character);
             }
 
             // Last char
@@ -402,23 +401,40 @@ void RemoteDebug::handle() {
         }
     }
 
-    // Client connected ?
+#ifdef DEBUG_RING_SIZE
+    // Send the messages of the ring - written by any task
+    drainRing();
+#endif
 
-#if not WEBSOCKET_DISABLED
-    boolean connected = (_connected || _connectedWS);
-#else  // By telnet
-    boolean connected = _connected;
+#ifdef DEBUG_SPOOL
+    // Write the logs staged for a while
+    _spool.handle();
 #endif
 
-    if (connected) {
+    // Clients connected ?
+
+    boolean connected = isConnected();
+
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        DebugClient& debugClient = _clients[client];
+
+        if (debugClient.type == CLIENT_NONE) {
+            continue;
+        }
+        _clientCommand = client;  // Messages to this client
+
+        // Debug level is profiler -> set the level before
+        if (debugClient.debugLevel == PROFILER && millis() > debugClient.levelProfilerDisable) {
+            debugClient.debugLevel = debugClient.levelBeforeProfiler;
+            updateClients();
+            debugPrintln("* Debug level profile inactive now");
+        }
+
 #ifdef CLIENT_BUFFERING
         // Client buffering - send data in intervals to avoid delays or if its is too big
 
-        if ((millis() - _lastTimeSend) >= DELAY_TO_SEND || _sizeBufferSend >= MAX_SIZE_SEND) {
-            debugPrint(_bufferSend);
-            _bufferSend = "";
-            _sizeBufferSend = 0;
-            _lastTimeSend = millis();
+        if ((millis() - debugClient.lastTimeSend) >= DELAY_TO_SEND || debugClient.sizeBufferSend >= MAX_SIZE_SEND) {
+            sendBuffer(client);
         }
 #endif
 
@@ -430,22 +446,29 @@ void RemoteDebug::handle() {
 
         uint32_t maxTime = MAX_TIME_INACTIVE;  // Normal
 
-        if (_password != "" && !_passwordOk) {  // Request password - 18/08/08
-            maxTime = 60000;                    // One minute to password
+        if (_password != "" && !debugClient.passwordOk) {  // Request password - 18/08/08
+            maxTime = 60000;                                // One minute to password
         } else
             maxTime = connectionTimeout;  // When password is ok set normal timeout
 
-        if ((maxTime > 0) && ((millis() - _lastTimeCommand) > maxTime)) {
+        if ((maxTime > 0) && ((millis() - debugClient.lastTimeCommand) > maxTime)) {
             debugPrintln("* Closing session by inactivity");
 
             // Disconnect
 
-            disconnect();
-            return;
+            closeClient(client);
         }
 #endif
 #endif
+        _clientCommand = -1;
+    }
+
+#ifdef DEBUG_SPOOL
+    // Command spool: the next piece, as the window of the client frees up
+    if (_spoolShow) {
+        showSpoolNext();
     }
+#endif
 
 #if not WEBSOCKET_DISABLED  // For websocket server
 
@@ -483,87 +506,167 @@ void RemoteDebug::handle() {
     // DV("*handle time: ", (millis() - timeBegin));
 }
 
-// Disconnect client
+// Disconnect clients (all or only the telnet ones)
 
 void RemoteDebug::disconnect(boolean onlyTelnetClient) {
     // Disconnect
-    // TODO XXX show info about onlyTelnetClient
     D("rd onlyTelnetClient %d", onlyTelnetClient);
-    if (onlyTelnetClient) {
-        if (_connected) {
-            TelnetClient.println("* Closing client connection ...");  // this is to web app new conn not receive it
+
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (_clients[client].type == CLIENT_TELNET || (_clients[client].type == CLIENT_WS && !onlyTelnetClient)) {
+            Print* print = clientPrint(client);
+            if (print) {
+                print->println("* Closing client connection ...");
+            }
+            closeClient(client);
         }
-    } else {
-        debugPrintln("* Closing client connection ...");
     }
 
     _silence = false;
     _silenceTimeout = 0;
+}
 
-    if (_connected) {  // By telnet
-        TelnetClient.stop();
-        _connected = false;
+// Close a client
+
+void RemoteDebug::closeClient(uint8_t client) {
+    uint8_t type = _clients[client].type;
+
+    if (type == CLIENT_NONE) {
+        return;
+    }
+    D("rd close client %u", client);
+
+#ifdef CLIENT_BUFFERING
+    sendBuffer(client);
+#endif
+    _clients[client].type = CLIENT_NONE;  // Before the disconnect, it can call wsOnDisconnect
+
+    if (type == CLIENT_TELNET) {  // By telnet
+        TelnetClients[client].stop();
     }
 #if not WEBSOCKET_DISABLED
-    if (_connectedWS && !onlyTelnetClient) {
-        D("rd DebugWS.disconnect()")
-        DebugWS.disconnect();  // Disconnect client
-        _connectedWS = false;
+    else {
+        D("rd DebugWS.disconnect(%d)", _clients[client].num)
+        DebugWS.disconnect(_clients[client].num);  // Disconnect client
     }
 #endif
+
+    updateClients();
 }
 
-// Connection/disconnection event
+// Connection event
 
-void RemoteDebug::onConnection(boolean connected) {
+void RemoteDebug::onConnection(uint8_t client) {
     // Clear variables
 
-    D("rd onconn %d", connected);
-
-    _bufferPrint = "";            // Clean buffer
-    _lastTimeCommand = millis();  // To mark time for inactivity
-    _command = "";                // Clear command
-    _lastCommand = "";            // Clear las command
-    _lastTimePrint = millis();    // Clear the time
-    _silence = false;             // No silence
-    _silenceTimeout = 0;
+    D("rd onconn %u", client);
+    DebugClient& debugClient = _clients[client];
+
+    debugClient.debugLevel = _debugLevel;
+    debugClient.levelBeforeProfiler = _debugLevel;
+    debugClient.levelProfilerDisable = 0;
+    debugClient.command = "";                     // Clear command
+    debugClient.lastTimeCommand = millis();       // To mark time for inactivity
+    debugClient.filter.clear();
+    debugClient.deferred = DeferredState();       // Formats of deferred logs not sent
+    _lastCommand = "";                            // Clear las command
+
+    if (getClientsConnected() == 1) {  // First client
+        _lastTimePrint = millis();     // Clear the time
+        _silence = false;              // No silence
+        _silenceTimeout = 0;
+    }
 
 #ifdef CLIENT_BUFFERING
     // Client buffering - send data in intervals to avoid delays or if its is too big
-    _bufferSend = "";
-    _sizeBufferSend = 0;
-    _lastTimeSend = millis();
+    debugClient.sizeBufferSend = 0;
+    debugClient.lastTimeSend = millis();
 #endif
+    debugClient.dropped = 0;
+    debugClient.droppedShow = 0;
 
     // Password request ? - 18/07/18
 
-    if (_password != "") {
-        _passwordOk = false;
+    debugClient.passwordOk = false;
 
 #ifdef REMOTEDEBUG_PWD_ATTEMPTS
-        _passwordAttempt = 1;
+    debugClient.passwordAttempt = 1;
+#endif
+
+    updateClients();
+
+    // Callback
+
+    if (_callbackNewClient) {
+        _callbackNewClient();
+    }
+
+    // Show the initial message
+#if SHOW_HELP
+    _clientCommand = client;
+    showHelp();
+    _clientCommand = -1;
 #endif
+
+#ifdef DEBUG_SPOOL
+    if (_spoolShow && _spoolClient == (int8_t)client) {  // Command spool of the client before in this slot
+        _spoolShow = false;
     }
 
-    // Save it
-    _connected = connected;
+    // Logs kept before, maybe with no client
+    if (_spool.isActive()) {
+        _clientCommand = client;
+        debugPrintf("* Debug: %lu bytes of logs in the spool, command spool to show them\r\n", (unsigned long)_spool.size());
+        _clientCommand = -1;
+    }
+#endif
+}
 
-    // Process
-    if (connected) {  // Connected ?
+// Connected clients: flags, lowest level for isActive
 
-        // Callback
+void RemoteDebug::updateClients() {
+    _connected = false;
+#if not WEBSOCKET_DISABLED
+    _connectedWS = false;
+#endif
+    _clientDebugLevel = (_serialEnabled) ? _debugLevel : ANY;
 
-        if (_callbackNewClient) {
-            _callbackNewClient();
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (_clients[client].type == CLIENT_TELNET) {
+            _connected = true;
+        }
+#if not WEBSOCKET_DISABLED
+        if (_clients[client].type == CLIENT_WS) {
+            _connectedWS = true;
         }
-
-        // Show the initial message
-#if SHOW_HELP
-        showHelp();
 #endif
+        if (clientReady(client) && _clients[client].debugLevel < _clientDebugLevel) {
+            _clientDebugLevel = _clients[client].debugLevel;
+        }
     }
 }
 
+// Client connected, with the password if it is requested ?
+
+boolean RemoteDebug::clientReady(uint8_t client) {
+    return (_clients[client].type != CLIENT_NONE && (_password == "" || _clients[client].passwordOk));
+}
+
+// Print of a client for the messages: only the client of the command in process, if any
+
+Print* RemoteDebug::clientPrint(uint8_t client) {
+    if (_clients[client].type == CLIENT_NONE || (_clientCommand >= 0 && client != _clientCommand)) {
+        return NULL;
+    }
+#if not WEBSOCKET_DISABLED
+    if (_clients[client].type == CLIENT_WS) {
+        DebugWS.select(_clients[client].num);
+        return &DebugWS;
+    }
+#endif
+    return &TelnetClients[client];
+}
+
 boolean RemoteDebug::isConnected() {
     // Is connected
 
@@ -574,10 +677,22 @@ boolean RemoteDebug::isConnected() {
 #endif
 }
 
+uint8_t RemoteDebug::getClientsConnected() {
+    uint8_t count = 0;
+
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (_clients[client].type != CLIENT_NONE) {
+            count++;
+        }
+    }
+    return count;
+}
+
 // Send to serial too (use only if need)
 void RemoteDebug::setSerialEnabled(boolean enable) {
     _serialEnabled = enable;
     _showColors = false;  // Disable it for Serial
+    updateClients();
 }
 
 // Allow ESP reset over telnet client
@@ -647,276 +762,1087 @@ boolean RemoteDebug::isActive(uint8_t debugLevel) {
     boolean ret = (debugLevel >= _clientDebugLevel &&
                    !_silence &&
                    (_connected || _serialEnabled));
+#endif
+#ifdef DEBUG_SPOOL
+    // Kept in the spool
+    ret = ret || (debugLevel >= _spoolLevel && !_silence && _spool.isActive());
 #endif
     if (ret) {
         _lastDebugLevel = debugLevel;
+#ifdef DEBUG_RING_SIZE
+        _ringLevel = debugLevel;
+#endif
+    }
+
+    return ret;
+}
+
+// Set help for commands over telnet set by sketch
+void RemoteDebug::setHelpProjectsCmds(String help) {
+    _helpProjectCmds = help;
+}
+
+// Set callback of sketch function to process project messages
+void RemoteDebug::setCallBackProjectCmds(void (*callback)()) {
+    _callbackProjectCmds = callback;
+}
+
+void RemoteDebug::setCallBackNewClient(void (*callback)()) {
+    _callbackNewClient = callback;
+}
+
+// Print
+size_t RemoteDebug::write(const uint8_t* buffer, size_t size) {
+    // Process buffer
+    // Insert due a write bug w/ latest Esp8266 SDK - 17/08/18
+
+    // In silent mode now ?
+    if (_silence) {
+        return size;
+    }
+
+#ifdef DEBUG_RING_SIZE
+    // From any task or core -> to the ring, handle() sends it
+    // A line not complete is kept for the task, so a print and the println after it are one message
+    uint8_t debugLevel = _ringLevel;
+    RingLine* line = findRingLine();
+    size_t pos = 0;
+
+    while (pos < size) {
+        const uint8_t* newLine = (const uint8_t*)memchr(buffer + pos, '\n', size - pos);
+        size_t length = (newLine) ? (size_t)(newLine - buffer) + 1 - pos : size - pos;
+
+        if (line && line->size + length <= DEBUG_RING_LINE) {  // Adds to the line of the task
+            memcpy(line->data + line->size, buffer + pos, length);
+            line->size += length;
+        } else {
+            if (line) {  // Too long, its start first
+                pushRingLine(line);
+                line = NULL;
+            }
+            if (!newLine && length < DEBUG_RING_LINE && (line = takeRingLine()) != NULL) {
+                memcpy(line->data, buffer + pos, length);
+                line->size = length;
+                line->level = debugLevel;
+            } else {  // Complete, or no line free
+                pushRingParts(buffer + pos, length, debugLevel);
+            }
+        }
+
+        if (newLine && line) {  // Line complete
+            pushRingLine(line);
+            line = NULL;
+        }
+        pos += length;
+    }
+#else
+    writeBuffer(buffer, size, _lastDebugLevel, millis());
+#endif
+
+    return size;
+}
+
+size_t RemoteDebug::write(uint8_t character) {
+    return write(&character, 1);
+}
+
+// Write to the line buffer
+// The buffer is scanned for new lines and copied in blocks, without dynamic allocation
+
+void RemoteDebug::writeBuffer(const uint8_t* buffer, size_t size, uint8_t debugLevel, uint32_t time) {
+    // Connected ?
+#if not WEBSOCKET_DISABLED
+    boolean connected = (_connected || _connectedWS);
+#else
+    boolean connected = _connected;
+#endif
+
+    size_t pos = 0;
+
+    while (pos < size) {
+        // New line writted before ?
+        if (_newLine) {
+            beginLine(connected, debugLevel, time);
+        }
+
+        // Text until the end of line or the limit of buffer
+        const uint8_t* end = (const uint8_t*)memchr(buffer + pos, '\n', size - pos);
+        size_t length = (end) ? (size_t)(end - (buffer + pos)) : (size - pos);
+        size_t room = _sizePrefix + BUFFER_PRINT - _sizeBufferPrint;
+        boolean newLine = (end && length <= room);
+
+        if (length > room) {
+            length = room;
+        }
+
+        memcpy(_bufferPrint + _sizeBufferPrint, buffer + pos, length);
+        _sizeBufferPrint += length;
+        pos += length;
+
+        // Send the characters buffered by print.h
+        if (newLine) {
+            _bufferPrint[_sizeBufferPrint++] = '\r';  // Para clientes windows - 29/01/17
+            _bufferPrint[_sizeBufferPrint++] = '\n';
+            pos++;
+
+            _newLine = true;
+            flushLine(connected);
+
+        } else if (_sizeBufferPrint == _sizePrefix + BUFFER_PRINT) {  // Limit of buffer
+            flushLine(connected);
+        }
+    }
+}
+
+// Begin of a line - debugger handle and prefix (level, time and profiler)
+
+void RemoteDebug::beginLine(boolean connected, uint8_t debugLevel, uint32_t time) {
+    _newLine = false;
+    _sizePrefix = 0;
+    _elapsedPrint = 0;
+    _levelPrint = debugLevel;
+    _timePrint = time;
+
+#ifdef DEBUGGER_ENABLED
+    // For Simple software debugger - based on SerialDebug Library
+    // Changed handle debugger logic - 2018-02-29
+    if (!_showRaw) {  // Not for raw mode
+
+        if (_callbackDbgEnabled && _callbackDbgEnabled()) {  // Callbacks ok
+
+            if (connected && _callbackDbgEnabled()) {  // Only call if is connected and debugger is enabled
+                // Call the handle
+                _callbackDbgHandle(false);
+            }
+        }
+    }
+#endif
+
+    // Formatted in the stack, once per line
+    char show[BUFFER_PREFIX];
+    size_t size = 0;
+
+    // Not in raw mode (only data)
+    if (!_showRaw) {
+        const char* colorLevel = "";
+
+        // New color system
+        if (_showColors) {
+            switch (debugLevel) {
+                case VERBOSE:
+                    colorLevel = COLOR_VERBOSE;
+                    break;
+                case DEBUG:
+                    colorLevel = COLOR_DEBUG;
+                    break;
+                case INFO:
+                    colorLevel = COLOR_INFO;
+                    break;
+                case WARNING:
+                    colorLevel = COLOR_WARNING;
+                    break;
+                case ERROR:
+                    colorLevel = COLOR_ERROR;
+                    break;
+            }
+            size += snprintf(show + size, sizeof(show) - size, "%s", colorLevel);
+        }
+
+        // Show debug level
+        if (_showDebugLevel && debugLevel < ANY) {
+            size += snprintf(show + size, sizeof(show) - size, "(%c", "PVDIWE"[debugLevel]);
+        }
+
+        // Show time in millis
+        if (_showTime) {
+            size += snprintf(show + size, sizeof(show) - size, "%st:%lums", (size > 0) ? " " : "", (unsigned long)time);
+        }
+
+        // Show profiler (time between messages)
+        if (_showProfiler) {
+            _elapsedPrint = ((int32_t)(time - _lastTimePrint) > 0) ? (time - _lastTimePrint) : 0;  // Message before the last print
+            const char* colorProfiler = "";
+            if (_showColors) {
+                if (_elapsedPrint < 250) {
+                    ;  // not color this
+                } else if (_elapsedPrint < 1000) {
+                    colorProfiler = COLOR_BLACK COLOR_BACKGROUND_GREEN;
+                } else if (_elapsedPrint < 3000) {
+                    colorProfiler = COLOR_BLACK COLOR_BACKGROUND_YELLOW;
+                } else if (_elapsedPrint < 5000) {
+                    colorProfiler = COLOR_WHITE COLOR_BACKGROUND_MAGENTA;
+                } else {
+                    colorProfiler = COLOR_WHITE COLOR_BACKGROUND_RED;
+                }
+            }
+            size += snprintf(show + size, sizeof(show) - size, "%s%sp:^%04lums", (size > 0) ? " " : "", colorProfiler, (unsigned long)_elapsedPrint);
+            if (*colorProfiler) {
+                size += snprintf(show + size, sizeof(show) - size, COLOR_RESET "%s", colorLevel);
+            }
+            _lastTimePrint = time;
+        }
+
+        // Show anything ?
+        if (size > 0) {
+            size += snprintf(show + size, sizeof(show) - size, ") ");
+        }
+    } else {  // Raw mode - only data - e.g. used for debugger messages
+        size += snprintf(show + size, sizeof(show) - size, COLOR_RAW);
+    }
+
+    // Write to telnet buffered
+    if (connected || _serialEnabled) {  // send data to Client
+        if (size >= sizeof(show)) {     // Truncated
+            size = sizeof(show) - 1;
+        }
+        memcpy(_bufferPrint, show, size);
+        _sizePrefix = size;
+    }
+    _sizeBufferPrint = _sizePrefix;
+}
+
+// Send the line buffered to the clients that want it, returns the size of it
+// The line is formatted once, each client has its debug level and filter
+
+size_t RemoteDebug::flushLine(boolean connected) {
+    size_t ret = _sizeBufferPrint;
+    size_t sizePrefix = _sizePrefix;
+    size_t sizeText = _sizeBufferPrint;
+
+#ifdef DEBUG_SPOOL
+    // Spool of the logs, with no client too (text only, the prefix is done when shown)
+    if (_spool.isActive() && _levelPrint >= _spoolLevel && !_showRaw) {
+        size_t size = sizeText - sizePrefix;
+        while (size > 0 && (_bufferPrint[sizePrefix + size - 1] == '\n' || _bufferPrint[sizePrefix + size - 1] == '\r')) {
+            size--;
+        }
+        _spool.write(_levelPrint, _timePrint, _bufferPrint + sizePrefix, size);
+    }
+#endif
+
+    if (!(_showProfiler && _elapsedPrint < _minTimeShowProfiler)) {  // Profiler time Minimal
+        if (_showColors) {
+            memcpy(_bufferPrint + _sizeBufferPrint, COLOR_RESET, sizeof(COLOR_RESET) - 1);
+            _sizeBufferPrint += sizeof(COLOR_RESET) - 1;
+        }
+
+        // Send to telnet or websocket (buffered)
+        for (uint8_t client = 0; connected && client < DEBUG_MAX_CLIENTS; client++) {
+            DebugClient& debugClient = _clients[client];
+
+            if (!clientReady(client) || _levelPrint < debugClient.debugLevel) {  // With no password -> no output - 2018-10-19
+                continue;
+            }
+#ifdef DEBUG_LOG_RECORDS
+            if (_lineRecord && debugClient.type == CLIENT_WS) {  // Web app: the record was sent as a binary frame
+                continue;
+            }
+#endif
+
+            // Check filter before print, over the text of the line (not the prefix)
+            if (debugClient.filter.isActive() && !debugClient.filter.match(_bufferPrint + sizePrefix, sizeText - sizePrefix, _levelPrint)) {
+                continue;
+            }
+
+            sendData(client, (const uint8_t*)_bufferPrint, _sizeBufferPrint);
+
+#ifdef CLIENT_BUFFERING
+            // Client buffering - send data in intervals to avoid delays or if its is too big
+            // Not for raw mode
+            if (_showRaw || (millis() - debugClient.lastTimeSend) >= DELAY_TO_SEND) {
+                sendBuffer(client);
+            }
+#endif
+        }
+
+        // Echo to serial (not buffering it), with the level of begin
+        if (_serialEnabled && _levelPrint >= _debugLevel) {
+            Serial.write((const uint8_t*)_bufferPrint, _sizeBufferPrint);
+        }
+    }
+
+    // Empty the buffer, the rest of a long line is without prefix
+    _sizeBufferPrint = 0;
+    _sizePrefix = 0;
+
+    return ret;
+}
+
+// Send data to telnet or websocket (buffered)
+// The buffer is sent when it is full or by handle() in intervals. When it has no room,
+// even after a send (telnet window full: slow client), the message is dropped and counted
+
+void RemoteDebug::sendData(uint8_t client, const uint8_t* data, size_t size) {
+    DebugClient& debugClient = _clients[client];
+
+#ifndef CLIENT_BUFFERING
+    size_t sent = clientWrite(client, data, size);
+    if (sent < size) {  // Not waiting the window
+        debugClient.dropped += size - sent;
+        _sendStats.dropped += size - sent;
+    }
+#else  // Client buffering
+
+    roomSend(client, size);
+
+    // Data bigger than the buffer -> by parts, else all or nothing (a message is not cut)
+    while (size > 0) {
+        size_t room = MAX_SIZE_SEND - debugClient.sizeBufferSend;
+
+        if (room < size && size <= MAX_SIZE_SEND) {  // Still no room
+            break;
+        } else if (room == 0) {
+            sendBuffer(client);
+            room = MAX_SIZE_SEND - debugClient.sizeBufferSend;
+            if (room == 0) {
+                break;
+            }
+        }
+        size_t length = (size < room) ? size : room;
+
+        copySend(client, data, length);
+        data += length;
+        size -= length;
+    }
+
+    if (size > 0) {  // Dropped
+        debugClient.dropped += size;
+        _sendStats.dropped += size;
+    }
+#endif
+}
+
+#ifdef CLIENT_BUFFERING
+// Room in the buffer of send for a message, returns if it has it now
+// The bytes dropped before are told first (between two messages), when there is room again
+
+boolean RemoteDebug::roomSend(uint8_t client, size_t size) {
+    DebugClient& debugClient = _clients[client];
+
+    if (debugClient.dropped != debugClient.droppedShow) {
+        char show[64];
+        size_t sizeShow = snprintf(show, sizeof(show), "* Debug: %lu bytes dropped, slow connection\r\n",
+                                   (unsigned long)(debugClient.dropped - debugClient.droppedShow));
+        if (debugClient.sizeBufferSend + sizeShow + size > MAX_SIZE_SEND) {
+            sendBuffer(client);
+        }
+        if (debugClient.sizeBufferSend + sizeShow + size <= MAX_SIZE_SEND) {
+            copySend(client, (const uint8_t*)show, sizeShow);
+            debugClient.droppedShow = debugClient.dropped;
+        }
+    }
+
+    // No room -> send the buffer (or the part the window takes)
+    if ((debugClient.sizeBufferSend + size) > MAX_SIZE_SEND) {
+        sendBuffer(client);
+    }
+    return (debugClient.sizeBufferSend + size) <= MAX_SIZE_SEND;
+}
+
+void RemoteDebug::copySend(uint8_t client, const uint8_t* data, size_t size) {
+    DebugClient& debugClient = _clients[client];
+
+    if (debugClient.sizeBufferSend == 0) {
+        debugClient.timeBuffer = micros();
+    }
+    memcpy(debugClient.bufferSend + debugClient.sizeBufferSend, data, size);
+    debugClient.sizeBufferSend += size;
+}
+
+// Send the buffer of send of a client, the rest (telnet window full) is kept for the next time
+
+void RemoteDebug::sendBuffer(uint8_t client) {
+    DebugClient& debugClient = _clients[client];
+
+    if (debugClient.sizeBufferSend > 0) {
+        size_t sent = clientWrite(client, (const uint8_t*)debugClient.bufferSend, debugClient.sizeBufferSend);
+
+        if (sent > 0) {
+            uint32_t latency = micros() - debugClient.timeBuffer;
+            _sendStats.bytes += sent;
+            _sendStats.writes++;
+            _sendStats.latency += latency;
+            if (latency > _sendStats.latencyMax) {
+                _sendStats.latencyMax = latency;
+            }
+        }
+        if (sent < debugClient.sizeBufferSend) {
+            _sendStats.partial++;
+            memmove(debugClient.bufferSend, debugClient.bufferSend + sent, debugClient.sizeBufferSend - sent);
+        }
+        debugClient.sizeBufferSend -= sent;
+    }
+    debugClient.lastTimeSend = millis();
+}
+#endif
+
+// Write to a telnet client what its TCP window takes now, returns the bytes sent
+// (WiFiClient::write waits for the window, up to seconds with a slow client)
+
+static size_t telnetWrite(WiFiClient& telnet, const uint8_t* data, size_t size) {
+#if defined(ESP32) && defined(ESP_ARDUINO_VERSION)  // Socket of the ESP32 core, not blocking
+    int sent = send(telnet.fd(), data, size, MSG_DONTWAIT);
+    return (sent > 0) ? sent : 0;
+#else  // Free space of the window
+    size_t room = telnet.availableForWrite();
+    return (room > 0) ? telnet.write(data, (size < room) ? size : room) : 0;
+#endif
+}
+
+// Write to a client, returns the bytes sent
+
+size_t RemoteDebug::clientWrite(uint8_t client, const uint8_t* data, size_t size) {
+    if (_clients[client].type == CLIENT_TELNET) {
+        return telnetWrite(TelnetClients[client], data, size);
+    }
+#if not WEBSOCKET_DISABLED
+    else if (_clients[client].type == CLIENT_WS) {
+        DebugWS.select(_clients[client].num);
+        return DebugWS.write(data, size);
+    }
+#endif
+    return 0;
+}
+
+const RemoteDebug::SendStats& RemoteDebug::getSendStats() {
+    return _sendStats;
+}
+
+#ifdef DEBUG_RING_SIZE
+// Lock-free ring of messages: many writers (tasks in both cores), one reader (handle)
+// A writer reserves its space moving the head (compare and swap), copies the message
+// and sets the commit flag in the header. The reader sends the committed messages in order,
+// zeroes their space and moves the tail. A message is not split at the end of the ring,
+// the rest of the ring is skipped with a padding header.
+
+#if (DEBUG_RING_SIZE & (DEBUG_RING_SIZE - 1)) != 0
+#error "DEBUG_RING_SIZE must be a power of 2"
+#endif
+
+#define RING_COMMIT 0x80000000  // Header: message is complete
+#define RING_PADDING 0x40000000  // Header: skip to the begin of the ring
+#define RING_DEFERRED 0x20000000  // Header: deferred log
+#define RING_RECORD 0x10000000  // Header: structured log
+#define RING_HEADER 8            // Header and time
+#define RING_ALIGN(size) (((size) + 7) & ~7)
+
+// Line kept for the task that prints: its own, a free one, or NULL
+
+RemoteDebug::RingLine* RemoteDebug::findRingLine() {
+    for (RingLine& slot : _ringLines) {
+        if (__atomic_load_n(&slot.task, __ATOMIC_RELAXED) == &_ringLevel) {
+            return &slot;
+        }
+    }
+    return NULL;
+}
+
+RemoteDebug::RingLine* RemoteDebug::takeRingLine() {
+    for (RingLine& slot : _ringLines) {
+        const void* expected = NULL;
+        if (__atomic_compare_exchange_n(&slot.task, &expected, (const void*)&_ringLevel, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return &slot;
+        }
+    }
+    return NULL;
+}
+
+// To the ring and free
+
+void RemoteDebug::pushRingLine(RingLine* line) {
+    pushRingParts(line->data, line->size, line->level);
+    line->size = 0;
+    __atomic_store_n(&line->task, (const void*)NULL, __ATOMIC_RELEASE);
+}
+
+// Big messages in parts
+
+void RemoteDebug::pushRingParts(const uint8_t* buffer, size_t size, uint8_t debugLevel) {
+    size_t pos = 0;
+
+    while (pos < size) {
+        size_t length = size - pos;
+        if (length > DEBUG_RING_SIZE / 4) {
+            length = DEBUG_RING_SIZE / 4;
+        }
+        pushRing(buffer + pos, length, debugLevel);
+        pos += length;
+    }
+}
+
+boolean RemoteDebug::pushRing(const uint8_t* buffer, size_t size, uint8_t debugLevel, uint32_t flags) {
+    uint32_t need = RING_ALIGN(RING_HEADER + size);
+    uint32_t head = __atomic_load_n(&_ringHead, __ATOMIC_RELAXED);
+    uint32_t offset;
+    uint32_t padding;
+
+    // Reserve
+    do {
+        uint32_t tail = __atomic_load_n(&_ringTail, __ATOMIC_ACQUIRE);
+        offset = head & (DEBUG_RING_SIZE - 1);
+        padding = (offset + need > DEBUG_RING_SIZE) ? (DEBUG_RING_SIZE - offset) : 0;
+
+        if (head + padding + need - tail > DEBUG_RING_SIZE) {  // Full -> drop it
+            __atomic_fetch_add(&_ringOverflows, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&_ringHead, &head, head + padding + need, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    if (padding > 0) {
+        __atomic_store_n((uint32_t*)(_ring + offset), RING_COMMIT | RING_PADDING, __ATOMIC_RELEASE);
+        offset = 0;
+    }
+
+    // Copy and commit
+    uint32_t* header = (uint32_t*)(_ring + offset);
+    header[1] = millis();
+    memcpy(_ring + offset + RING_HEADER, buffer, size);
+    __atomic_store_n(header, RING_COMMIT | flags | ((uint32_t)debugLevel << 16) | size, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+void RemoteDebug::drainRing() {
+    uint32_t start = micros();
+    uint32_t tail = __atomic_load_n(&_ringTail, __ATOMIC_RELAXED);
+
+    // Send the messages in order, up to one not complete yet or the time limit
+    while (tail != __atomic_load_n(&_ringHead, __ATOMIC_ACQUIRE)) {
+        uint32_t offset = tail & (DEBUG_RING_SIZE - 1);
+        uint32_t* header = (uint32_t*)(_ring + offset);
+        uint32_t value = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+
+        if (!(value & RING_COMMIT)) {  // Writer still copying
+            break;
+        }
+
+        uint32_t size;
+        if (value & RING_PADDING) {
+            size = DEBUG_RING_SIZE - offset;
+        } else if (value & RING_DEFERRED) {
+            size = RING_ALIGN(RING_HEADER + (value & 0xFFFF));
+            writeDeferred(_ring + offset + RING_HEADER, value & 0xFFFF, (value >> 16) & 0xFF, header[1]);
+#ifdef DEBUG_LOG_RECORDS
+        } else if (value & RING_RECORD) {
+            size = RING_ALIGN(RING_HEADER + (value & 0xFFFF));
+            writeRecord(_ring + offset + RING_HEADER, value & 0xFFFF, (value >> 16) & 0xFF, header[1]);
+#endif
+        } else {
+            size = RING_ALIGN(RING_HEADER + (value & 0xFFFF));
+            writeBuffer(_ring + offset + RING_HEADER, value & 0xFFFF, (value >> 16) & 0xFF, header[1]);
+        }
+
+        // Free it, headers are zero
+        memset(_ring + offset, 0, size);
+        tail += size;
+        __atomic_store_n(&_ringTail, tail, __ATOMIC_RELEASE);
+
+        if ((micros() - start) >= DEBUG_RING_DRAIN_TIME) {
+            break;
+        }
+    }
+
+    // Messages dropped ? (not in the middle of a line)
+    uint32_t overflows = __atomic_load_n(&_ringOverflows, __ATOMIC_RELAXED);
+    if (overflows != _ringOverflowsShow && _newLine) {
+        char show[64];
+        int size = snprintf(show, sizeof(show), "* Debug: %lu messages dropped, ring full\n", (unsigned long)(overflows - _ringOverflowsShow));
+        _ringOverflowsShow = overflows;
+        writeBuffer((const uint8_t*)show, size, ANY, millis());
+    }
+}
+
+uint32_t RemoteDebug::getRingOverflows() {
+    return __atomic_load_n(&_ringOverflows, __ATOMIC_RELAXED);
+}
+#endif
+
+// Deferred logs - see extras/decode_deferred.py
+// In the record: id of the format, pointer to it and the arguments (type and value)
+// Integers as varints (7 bits per byte, signed ones zigzag), doubles as 8 bytes,
+// strings as size (1 byte) and the bytes
+// Sent as frames: 0x1E, type, size (varint) and the data
+//   'F' format: slot, id (4 bytes, little endian) and the format - once per connection
+//   'L' log: slot, debug level, time (varint, zigzag ms since the last log) and the arguments
+
+#define DEFERRED_FRAME 0x1E       // Record separator, not in text
+#define DEFERRED_NO_SLOT 0xFF     // Format table full, format sent with each log
+
+#if DEBUG_DEFERRED_FORMATS > 255
+#error "DEBUG_DEFERRED_FORMATS must be up to 255"
+#endif
+
+// Put a varint, returns the bytes used (up to 10)
+static size_t putVarint(uint8_t* data, uint64_t value) {
+    size_t size = 0;
+    while (value >= 0x80) {
+        data[size++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    data[size++] = (uint8_t)value;
+    return size;
+}
+
+#ifdef DEBUG_SPOOL
+// Text of a deferred log for the spool, as extras/decode_deferred.py does it
+// Get a varint, false if cut
+static boolean getVarint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (uint8_t shift = 0; pos < size && shift < 64; shift += 7) {
+        uint8_t byte = data[pos++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Next argument: its type (0 if none), the integer, the double or the string
+struct DeferredArg {
+    char type = 0;
+    int64_t integer = 0;
+    double real = 0;
+    char text[256];
+};
+
+static void nextDeferredArg(const uint8_t* args, size_t size, size_t& pos, DeferredArg& arg) {
+    uint64_t value;
+    arg.type = 0;
+    if (pos >= size) {
+        return;
+    }
+    char type = args[pos++];
+    if ((type == 'i' || type == 'u') && getVarint(args, size, pos, value)) {
+        arg.integer = (type == 'i') ? (int64_t)((value >> 1) ^ (~(value & 1) + 1)) : (int64_t)value;
+        arg.real = (type == 'i') ? (double)arg.integer : (double)value;
+    } else if (type == 'd' && pos + sizeof(arg.real) <= size) {
+        memcpy(&arg.real, args + pos, sizeof(arg.real));
+        arg.integer = (int64_t)arg.real;
+        pos += sizeof(arg.real);
+    } else if (type == 's' && pos < size && pos + 1 + args[pos] <= size) {
+        memcpy(arg.text, args + pos + 1, args[pos]);
+        arg.text[args[pos]] = 0;
+        arg.integer = 0;
+        arg.real = 0;
+        pos += 1 + args[pos];
+    } else {
+        pos = size;
+        return;
     }
-
-    return ret;
+    arg.type = type;
 }
 
-// Set help for commands over telnet set by sketch
-void RemoteDebug::setHelpProjectsCmds(String help) {
-    _helpProjectCmds = help;
+static size_t formatDeferred(char* text, size_t size, const char* format, const uint8_t* args, size_t sizeArgs) {
+    size_t length = 0;
+    size_t pos = 0;
+    DeferredArg arg;
+
+    while (*format && length + 1 < size) {
+        if (*format != '%') {
+            text[length++] = *format++;
+            continue;
+        }
+
+        // Conversion: %[flags][width][.precision][length]type, the length is of the argument
+        char spec[32] = "%";
+        size_t sizeSpec = 1;
+        format++;
+        while (*format && strchr("-+ #0", *format) && sizeSpec < 8) {
+            spec[sizeSpec++] = *format++;
+        }
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*format != '.') {
+                    break;
+                }
+                spec[sizeSpec++] = *format++;
+            }
+            if (*format == '*') {
+                nextDeferredArg(args, sizeArgs, pos, arg);
+                sizeSpec += snprintf(spec + sizeSpec, sizeof(spec) - sizeSpec - 4, "%d", (int)arg.integer);
+                format++;
+            }
+            while (*format >= '0' && *format <= '9' && sizeSpec < sizeof(spec) - 8) {
+                spec[sizeSpec++] = *format++;
+            }
+        }
+        boolean wide = false;  // ll or j: 64 bits for the unsigned ones
+        while (*format && strchr("hlLzjt", *format)) {
+            wide = wide || *format == 'j' || (*format == 'l' && format[1] == 'l');
+            format += (*format == 'l' && format[1] == 'l') ? 2 : 1;
+        }
+        char conversion = *format;
+        if (!conversion) {
+            break;
+        }
+        format++;
+
+        int count = 0;
+        size_t room = size - length;
+        if (conversion == '%') {
+            text[length++] = '%';
+            continue;
+        } else if (conversion == 'n') {
+            continue;
+        }
+        nextDeferredArg(args, sizeArgs, pos, arg);
+        if (!arg.type) {
+            text[length++] = '?';
+            continue;
+        }
+        if (arg.type == 's' || conversion == 's') {  // A string, or a number shown as %s
+            if (arg.type == 'd') {
+                snprintf(arg.text, sizeof(arg.text), "%g", arg.real);
+            } else if (arg.type != 's') {
+                snprintf(arg.text, sizeof(arg.text), "%lld", (long long)arg.integer);
+            }
+            memcpy(spec + sizeSpec, "s", 2);
+            count = snprintf(text + length, room, spec, arg.text);
+        } else if (strchr("eEfFgGaA", conversion)) {
+            spec[sizeSpec++] = conversion;
+            spec[sizeSpec] = 0;
+            count = snprintf(text + length, room, spec, arg.real);
+        } else if (conversion == 'c') {
+            memcpy(spec + sizeSpec, "c", 2);
+            count = snprintf(text + length, room, spec, (int)(uint8_t)arg.integer);
+        } else if (conversion == 'p') {
+            count = snprintf(text + length, room, "0x%llx", (unsigned long long)arg.integer);
+        } else if (conversion == 'd' || conversion == 'i') {
+            memcpy(spec + sizeSpec, "lld", 4);
+            count = snprintf(text + length, room, spec, (long long)arg.integer);
+        } else {  // o u x X
+            uint64_t value = (uint64_t)arg.integer;
+            if (arg.integer < 0 && !wide) {
+                value &= 0xFFFFFFFFu;
+            }
+            spec[sizeSpec++] = 'l';
+            spec[sizeSpec++] = 'l';
+            spec[sizeSpec++] = conversion;
+            spec[sizeSpec] = 0;
+            count = snprintf(text + length, room, spec, (unsigned long long)value);
+        }
+        if (count > 0) {
+            length += ((size_t)count < room) ? count : room - 1;
+        }
+    }
+    text[length] = 0;
+    return length;
 }
+#endif
 
-// Set callback of sketch function to process project messages
-void RemoteDebug::setCallBackProjectCmds(void (*callback)()) {
-    _callbackProjectCmds = callback;
+void RemoteDebug::deferredBegin(DeferredRecord& record, uint32_t id, const char* format) {
+    memcpy(record.data, &id, sizeof(id));
+    memcpy(record.data + sizeof(id), &format, sizeof(format));
+    record.size = sizeof(id) + sizeof(format);
+    record.full = false;
 }
 
-void RemoteDebug::setCallBackNewClient(void (*callback)()) {
-    _callbackNewClient = callback;
+void RemoteDebug::deferredPut(DeferredRecord& record, char type, const void* value, size_t size) {
+    if (record.full || record.size + 1 + size > sizeof(record.data)) {  // No more arguments
+        record.full = true;
+        return;
+    }
+    record.data[record.size++] = type;
+    memcpy(record.data + record.size, value, size);
+    record.size += size;
 }
 
-// Print
-size_t RemoteDebug::write(const uint8_t* buffer, size_t size) {
-    // Process buffer
-    // Insert due a write bug w/ latest Esp8266 SDK - 17/08/18
+void RemoteDebug::deferredVarint(DeferredRecord& record, char type, uint64_t value) {
+    uint8_t data[10];
+    size_t size = putVarint(data, value);
 
-    for (size_t i = 0; i < size; i++) {
-        write((uint8_t)buffer[i]);
+    if (record.full || record.size + 1 + size > sizeof(record.data)) {
+        record.full = true;
+        return;
     }
-
-    return size;
+    record.data[record.size++] = type;
+    memcpy(record.data + record.size, data, size);
+    record.size += size;
 }
 
-size_t RemoteDebug::write(uint8_t character) {
-    // Write logic
-    uint32_t elapsed = 0;
-    size_t ret = 0;
-    String colorLevel = "";
+void RemoteDebug::deferredArg(DeferredRecord& record, const char* value) {
+    if (!value) {
+        value = "(null)";
+    }
+    size_t size = strlen(value);
+    size_t room = sizeof(record.data) - record.size;
 
-    // Connected ?
-#if not WEBSOCKET_DISABLED
-    boolean connected = (_connected || _connectedWS);
+    if (record.full || room < 3) {
+        record.full = true;
+        return;
+    }
+    if (size > room - 2) {  // Cut it
+        size = room - 2;
+    }
+    if (size > 255) {
+        size = 255;
+    }
+    record.data[record.size++] = 's';
+    record.data[record.size++] = size;
+    memcpy(record.data + record.size, value, size);
+    record.size += size;
+}
+
+void RemoteDebug::deferredEnd(DeferredRecord& record) {
+#ifdef DEBUG_RING_SIZE
+    RingLine* line = findRingLine();  // Text printed before it first
+    if (line) {
+        pushRingLine(line);
+    }
+    pushRing(record.data, record.size, _ringLevel, RING_DEFERRED);
 #else
-    boolean connected = _connected;
+    writeDeferred(record.data, record.size, _lastDebugLevel, millis());
 #endif
+}
 
-    // In silent mode now ?
-    if (_silence) {
-        return 0;
+void RemoteDebug::writeDeferred(const uint8_t* record, size_t size, uint8_t debugLevel, uint32_t time) {
+    uint32_t id;
+    const char* format;
+    memcpy(&id, record, sizeof(id));
+    memcpy(&format, record + sizeof(id), sizeof(format));
+    record += sizeof(id) + sizeof(format);
+    size -= sizeof(id) + sizeof(format);
+
+#ifdef DEBUG_SPOOL
+    // Spool of the logs, with no client too: the text is made here (no decoder for the flash)
+    if (_spool.isActive() && debugLevel >= _spoolLevel && !_showRaw) {
+        char text[256];
+        size_t sizeText = formatDeferred(text, sizeof(text), format, record, size);
+        while (sizeText > 0 && (text[sizeText - 1] == '\n' || text[sizeText - 1] == '\r')) {
+            sizeText--;
+        }
+        _spool.write(debugLevel, time, text, sizeText);
     }
+#endif
 
-    // New line writted before ?
-    if (_newLine) {
-#ifdef DEBUGGER_ENABLED
-        // For Simple software debugger - based on SerialDebug Library
-        // Changed handle debugger logic - 2018-02-29
-        if (!_showRaw) {  // Not for raw mode
-
-            if (_callbackDbgEnabled && _callbackDbgEnabled()) {  // Callbacks ok
+    // Only telnet and serial (the web app shows text), only the level:wie of the filter (no text here)
+    for (uint8_t client = 0; _connected && client < DEBUG_MAX_CLIENTS; client++) {
+        DebugClient& debugClient = _clients[client];
+        if (debugClient.type != CLIENT_TELNET || !clientReady(client) || debugLevel < debugClient.debugLevel ||
+            (debugClient.filter.isActive() && !debugClient.filter.matchLevel(debugLevel))) {
+            continue;
+        }
+        writeDeferred(debugClient.deferred, client, id, format, record, size, debugLevel, time);
 
-                if (connected && _callbackDbgEnabled()) {  // Only call if is connected and debugger is enabled
-                    // Call the handle
-                    _callbackDbgHandle(false);
-                }
-            }
+#ifdef CLIENT_BUFFERING
+        if ((millis() - debugClient.lastTimeSend) >= DELAY_TO_SEND) {
+            sendBuffer(client);
         }
 #endif
+    }
+    if (_serialEnabled && debugLevel >= _debugLevel) {
+        writeDeferred(_deferredSerial, -1, id, format, record, size, debugLevel, time);
+    }
+}
 
-        String show = "";
+// Deferred log to a client (-1: serial), with the formats it has
+
+void RemoteDebug::writeDeferred(DeferredState& state, int8_t client, uint32_t id, const char* format, const uint8_t* args, size_t size, uint8_t debugLevel, uint32_t time) {
+    // Slot of the format in this connection (open addressing)
+    uint32_t key = (id) ? id : 1;
+    uint8_t slot = DEFERRED_NO_SLOT;
+    boolean sent = false;
+    for (size_t i = 0; i < DEBUG_DEFERRED_FORMATS; i++) {
+        size_t index = (key + i) % DEBUG_DEFERRED_FORMATS;
+        if (state.sent[index] == key || state.sent[index] == 0) {  // Sent, or not yet -> take it
+            slot = index;
+            sent = (state.sent[index] == key);
+            break;
+        }
+    }
 
-        // Not in raw mode (only data)
-        if (!_showRaw) {
-            // New color system
-            if (_showColors) {
-                switch (_lastDebugLevel) {
-                    case VERBOSE:
-                        show = COLOR_VERBOSE;
-                        break;
-                    case DEBUG:
-                        show = COLOR_DEBUG;
-                        break;
-                    case INFO:
-                        show = COLOR_INFO;
-                        break;
-                    case WARNING:
-                        show = COLOR_WARNING;
-                        break;
-                    case ERROR:
-                        show = COLOR_ERROR;
-                        break;
-                }
-                colorLevel = show;
-            }
+    int32_t elapsed = (int32_t)(time - state.time);  // Logs of other tasks can be a bit older
+    uint8_t header[2 + 5];
+    header[0] = slot;
+    header[1] = debugLevel;
+    size_t sizeHeader = 2 + putVarint(header + 2, ((uint32_t)elapsed << 1) ^ (uint32_t)(elapsed >> 31));
+
+    if (!sent) {
+        uint8_t headerFormat[1 + sizeof(id)];
+        headerFormat[0] = slot;
+        memcpy(headerFormat + 1, &id, sizeof(id));
+        if (!sendFrame(client, 'F', headerFormat, sizeof(headerFormat), (const uint8_t*)format, strlen(format))) {
+            dropFrame(client, sizeHeader + size);  // No log without its format, the format is sent with the next one
+            return;
+        }
+        if (slot != DEFERRED_NO_SLOT) {
+            state.sent[slot] = key;
+        }
+    }
 
-            // Show debug level
-            if (_showDebugLevel) {
-                switch (_lastDebugLevel) {
-                    case PROFILER:
-                        show.concat("(P");
-                        break;
-                    case VERBOSE:
-                        show.concat("(V");
-                        break;
-                    case DEBUG:
-                        show.concat("(D");
-                        break;
-                    case INFO:
-                        show.concat("(I");
-                        break;
-                    case WARNING:
-                        show.concat("(W");
-                        break;
-                    case ERROR:
-                        show.concat("(E");
-                        break;
-                }
-            }
+    if (sendFrame(client, 'L', header, sizeHeader, args, size)) {
+        state.time = time;  // The times are from the last log the decoder has
+    }
+}
 
-            // Show time in millis
-            if (_showTime) {
-                if (show != "") {
-                    show.concat(" ");
-                }
-                show.concat("t:");
-                show.concat(millis());
-                show.concat("ms");
-            }
+// Frame of deferred logs to a client (-1: serial), queued whole or dropped, returns if it was queued
 
-            // Show profiler (time between messages)
-            if (_showProfiler) {
-                elapsed = (millis() - _lastTimePrint);
-                boolean resetColors = false;
-                if (show != "") {
-                    show.concat(" ");
-                }
-                if (_showColors) {
-                    if (elapsed < 250) {
-                        ;  // not color this
-                    } else if (elapsed < 1000) {
-                        show.concat(COLOR_BLACK);
-                        show.concat(COLOR_BACKGROUND_GREEN);
-                        resetColors = true;
-                    } else if (elapsed < 3000) {
-                        show.concat(COLOR_BLACK);
-                        show.concat(COLOR_BACKGROUND_YELLOW);
-                        resetColors = true;
-                    } else if (elapsed < 5000) {
-                        show.concat(COLOR_WHITE);
-                        show.concat(COLOR_BACKGROUND_MAGENTA);
-                        resetColors = true;
-                    } else {
-                        show.concat(COLOR_WHITE);
-                        show.concat(COLOR_BACKGROUND_RED);
-                        resetColors = true;
-                    }
-                }
-                show.concat("p:^");
-                show.concat(formatNumber(elapsed, 4));
-                show.concat("ms");
-                if (resetColors) {
-                    show.concat(COLOR_RESET);
-                    show.concat(colorLevel);
-                }
-                _lastTimePrint = millis();
-            }
-        } else {  // Raw mode - only data - e.g. used for debugger messages
-            show.concat(COLOR_RAW);
-        }
+boolean RemoteDebug::sendFrame(int8_t client, char type, const uint8_t* data1, size_t size1, const uint8_t* data2, size_t size2) {
+    uint8_t header[2 + 3] = { DEFERRED_FRAME, (uint8_t)type };
+    size_t sizeHeader = 2 + putVarint(header + 2, size1 + size2);
 
-        // Show anything ?
-        if (show != "") {
-            if (!_showRaw) {
-                show.concat(") ");
-            }
+    if (client < 0) {
+        Serial.write(header, sizeHeader);
+        Serial.write(data1, size1);
+        Serial.write(data2, size2);
+        return true;
+    }
 
-            // Write to telnet buffered
-            if (connected || _serialEnabled) {  // send data to Client
-                _bufferPrint = show;
-            }
-        }
+#ifdef CLIENT_BUFFERING
+    if (!roomSend(client, sizeHeader + size1 + size2)) {
+        dropFrame(client, size1 + size2);
+        return false;
+    }
+    copySend(client, header, sizeHeader);
+    copySend(client, data1, size1);
+    copySend(client, data2, size2);
+    return true;
+#else  // Written now, a frame cut by the window is skipped by the decoder
+    sendData(client, header, sizeHeader);
+    sendData(client, data1, size1);
+    sendData(client, data2, size2);
+    return true;
+#endif
+}
 
-        _newLine = false;
+// Frame not sent to a client: its bytes are dropped (told as the lines)
+
+void RemoteDebug::dropFrame(int8_t client, size_t size) {
+    if (client >= 0) {
+        uint8_t sizeBytes[3];
+        size += 2 + putVarint(sizeBytes, size);
+        _clients[client].dropped += size;
+        _sendStats.dropped += size;
     }
+}
 
-    // Print ?
-    boolean doPrint = false;
+#ifdef DEBUG_LOG_RECORDS
+// Structured logs - the record is a JsonDocument with the memory of _logArena,
+// serialized once in _logBuffer: size of the MessagePack (2 bytes, 0 if none), MessagePack and JSON
+// The web app gets a binary frame (MessagePack or JSON), telnet, serial and spool the JSON as a line
 
-    // New line ?
-    if (character == '\n') {
-        _bufferPrint.concat("\r");  // Para clientes windows - 29/01/17
+static const char* const LOG_LEVELS[] = { "P", "V", "D", "I", "W", "E", "A" };
 
-        _newLine = true;
-        doPrint = true;
+RemoteDebugRecord RemoteDebug::log(uint8_t debugLevel) {
+    if (!isActive(debugLevel)) {
+        return RemoteDebugRecord(NULL);
+    }
 
-    } else if (_bufferPrint.length() == BUFFER_PRINT) {  // Limit of buffer
-        doPrint = true;
+    // One record at a time, the one of other task is dropped (not blocked)
+#ifdef DEBUG_RING_SIZE
+    if (__atomic_test_and_set(&_logBusy, __ATOMIC_ACQUIRE)) {
+        __atomic_add_fetch(&_logDropped, 1, __ATOMIC_RELAXED);
+        return RemoteDebugRecord(NULL);
+    }
+#else
+    if (_logBusy) {  // Log in a value of a record
+        _logDropped++;
+        return RemoteDebugRecord(NULL);
     }
+    _logBusy = true;
+#endif
 
-    // Write to telnet Buffered
-    _bufferPrint.concat((char)character);
+    _logDoc.clear();
+    _logArena.reset();
+    _logLevel = (debugLevel <= ANY) ? debugLevel : ANY;
+    _logDoc["time"] = millis();
+    _logDoc["level"] = JsonString(LOG_LEVELS[_logLevel], true);
 
-    // Send the characters buffered by print.h
-    if (doPrint) {  // Print the buffer
-        boolean noPrint = false;
+    return RemoteDebugRecord(this);
+}
 
-        if (_showProfiler && elapsed < _minTimeShowProfiler) {  // Profiler time Minimal
-            noPrint = true;
-        } else if (_filterActive) {  // Check filter before print
+void RemoteDebug::logEnd() {
+    size_t sizeBinary = 0;
+    size_t size = 2;
+    boolean ok = !_logDoc.overflowed();  // Arena full -> keys or values missing
 
-            String aux = _bufferPrint;
-            aux.toLowerCase();
+#if defined DEBUG_LOG_MSGPACK && not WEBSOCKET_DISABLED
+    if (ok && _connectedWS) {
+        sizeBinary = serializeMsgPack(_logDoc, _logBuffer + size, sizeof(_logBuffer) - size);
+        ok = (sizeBinary > 0 && sizeBinary < sizeof(_logBuffer) - size);
+        size += sizeBinary;
+    }
+#endif
+    if (ok) {
+        size_t sizeJson = serializeJson(_logDoc, (char*)_logBuffer + size, sizeof(_logBuffer) - size);
+        ok = (sizeJson + 1 < sizeof(_logBuffer) - size);  // Not truncated
+        size += sizeJson;
+    }
+    _logBuffer[0] = (uint8_t)sizeBinary;
+    _logBuffer[1] = (uint8_t)(sizeBinary >> 8);
 
-            if (aux.indexOf(_filter) == -1) {  // not find -> no print
-                noPrint = true;
-            }
+    if (!ok) {
+        D("record too big, dropped")
+#ifdef DEBUG_RING_SIZE
+        __atomic_add_fetch(&_logDropped, 1, __ATOMIC_RELAXED);
+#else
+        _logDropped++;
+#endif
+    } else {
+#ifdef DEBUG_RING_SIZE
+        RingLine* line = findRingLine();  // Text printed before it first
+        if (line) {
+            pushRingLine(line);
         }
+        pushRing(_logBuffer, size, _logLevel, RING_RECORD);
+#else
+        writeRecord(_logBuffer, size, _logLevel, millis());
+#endif
+    }
 
-        if (noPrint == false) {
-            if (_showColors) _bufferPrint.concat(COLOR_RESET);
-            // Send to telnet or websocket (buffered)
-            boolean sendToClient = connected;
-
-            if (_password != "" && !_passwordOk) {  // With no password -> no telnet output - 2018-10-19
-                sendToClient = false;
-            }
-
-            if (sendToClient) {  // send data to Client
+#ifdef DEBUG_RING_SIZE
+    __atomic_clear(&_logBusy, __ATOMIC_RELEASE);
+#else
+    _logBusy = false;
+#endif
+}
 
-#ifndef CLIENT_BUFFERING
-                debugPrint(_bufferPrint);
-#else  // Client buffering
-                uint8_t size = _bufferPrint.length();
-
-                // Buffer too big ?
-                if ((_sizeBufferSend + size) >= MAX_SIZE_SEND) {
-                    // Send it
-                    debugPrint(_bufferSend);
-                    _bufferSend = "";
-                    _sizeBufferSend = 0;
-                    _lastTimeSend = millis();
-                }
+void RemoteDebug::writeRecord(const uint8_t* record, size_t size, uint8_t debugLevel, uint32_t time) {
+    size_t sizeBinary = record[0] | (record[1] << 8);
+    const char* json = (const char*)record + 2 + sizeBinary;
+    size_t sizeJson = size - 2 - sizeBinary;
 
-                // Add to buffer of send
-                _bufferSend.concat(_bufferPrint);
-                _sizeBufferSend += size;
-
-                // Client buffering - send data in intervals to avoid delays or if its is too big
-                // Not for raw mode
-                if (_showRaw || (millis() - _lastTimeSend) >= DELAY_TO_SEND) {
-                    debugPrint(_bufferSend);
-                    _bufferSend = "";
-                    _sizeBufferSend = 0;
-                    _lastTimeSend = millis();
-                }
-#endif
-            }
+#if not WEBSOCKET_DISABLED
+    // Web app: a binary frame, after the text buffered before it
+    const uint8_t* binary = (sizeBinary > 0) ? record + 2 : (const uint8_t*)json;
+    if (sizeBinary == 0) {
+        sizeBinary = sizeJson;
+    }
+    for (uint8_t client = 0; _connectedWS && client < DEBUG_MAX_CLIENTS; client++) {
+        DebugClient& debugClient = _clients[client];
 
-            // Echo to serial (not buffering it)
-            if (_serialEnabled) {
-                Serial.print(_bufferPrint);
-            }
+        if (debugClient.type != CLIENT_WS || !clientReady(client) || debugLevel < debugClient.debugLevel) {
+            continue;
         }
+        if (debugClient.filter.isActive() && !debugClient.filter.match(json, sizeJson, debugLevel)) {
+            continue;
+        }
+#ifdef CLIENT_BUFFERING
+        sendBuffer(client);
+#endif
+        DebugWS.sendBinary(debugClient.num, binary, sizeBinary);
+    }
+#endif
 
-        // Empty the buffer
-        ret = _bufferPrint.length();
-        _bufferPrint = "";
+    // Telnet, serial and spool: the JSON as a line (the rest of a line before goes in its own)
+    if (!_newLine) {
+        writeBuffer((const uint8_t*)"\n", 1, debugLevel, time);
     }
-    return ret;
+    _lineRecord = true;
+    writeBuffer((const uint8_t*)json, sizeJson, debugLevel, time);
+    writeBuffer((const uint8_t*)"\n", 1, debugLevel, time);
+    _lineRecord = false;
+}
+
+uint32_t RemoteDebug::getLogDropped() {
+#ifdef DEBUG_RING_SIZE
+    return __atomic_load_n(&_logDropped, __ATOMIC_RELAXED);
+#else
+    return _logDropped;
+#endif
 }
+#endif
 
 /**
  * @brief Show help of commands
@@ -926,13 +1852,18 @@ void RemoteDebug::showHelp() {
     D("showHelp")
     String help = "";
 
+    if (_clientCommand < 0) {  // Only for a client
+        return;
+    }
+    DebugClient& debugClient = _clients[_clientCommand];
+
     // Password request ? - 04/03/18
-    if (_password != "" && !_passwordOk) {
+    if (_password != "" && !debugClient.passwordOk) {
         help.concat("\r\n");
         help.concat("* Please enter with a password to access");
 #ifdef REMOTEDEBUG_PWD_ATTEMPTS
         help.concat(" (attempt ");
-        help.concat(_passwordAttempt);
+        help.concat(debugClient.passwordAttempt);
         help.concat(" of ");
         help.concat(REMOTEDEBUG_PWD_ATTEMPTS);
         help.concat(")");
@@ -989,9 +1920,23 @@ void RemoteDebug::showHelp() {
     help.concat("      A time -> set auto debug level to profiler\r\n");
 #endif
     help.concat("    c -> show colors\r\n");
+    help.concat("    stats -> show the bytes sent and dropped (slow connections)\r\n");
     help.concat("    filter:\r\n");
-    help.concat("          filter <string> -> show only debugs with this\r\n");
+    help.concat("          filter <string> -> show only debugs with this (spaces included)\r\n");
+    help.concat("                 more terms, separated by |: text1 | text2 (one of them), -text (not this),\r\n");
+    help.concat("                 \"text\" (as it is), fn:function, level:wie (only these levels)\r\n");
     help.concat("          nofilter        -> disable the filter\r\n");
+#ifdef DEBUG_SPOOL
+    help.concat("    spool:\r\n");
+    help.concat("          spool       -> show the logs kept on the flash\r\n");
+    help.concat("          spool stats -> show the writes to the flash\r\n");
+    help.concat("          spool clear -> remove them\r\n");
+#endif
+#ifdef DEBUG_SCOPES
+    help.concat("    scopes:\r\n");
+    help.concat("          scopes       -> show the times of the scopes and of the loop\r\n");
+    help.concat("          scopes reset -> set them to zero\r\n");
+#endif
 #if defined(ESP8266)
     help.concat("    cpu80  -> ESP8266 CPU a 80MHz\r\n");
     help.concat("    cpu160 -> ESP8266 CPU a 160MHz\r\n");
@@ -1024,7 +1969,7 @@ void RemoteDebug::showHelp() {
     help.concat("\r\n");
 
 #if not WEBSOCKET_DISABLED
-    if (!_connectedWS) {  // For telnet only
+    if (debugClient.type == CLIENT_TELNET) {  // For telnet only
         help.concat("****\r\n");
         help.concat("* New features available:\r\n");
         help.concat("* - Now you can debug in web browser too.\r\n");
@@ -1058,27 +2003,33 @@ void RemoteDebug::clearLastCommand() {
 // Process user command over telnet or
 
 void RemoteDebug::processCommand() {
-    static uint32_t lastTime = 0;
+    static uint32_t lastTime[DEBUG_MAX_CLIENTS] = {};
+
+    if (_clientCommand < 0) {  // Commands come from a client
+        return;
+    }
+    DebugClient& debugClient = _clients[_clientCommand];
 
     // Bug -> sometimes the command is process twice
     // Workaround -> check time
     // TODO: see correction for this
 
-    if (lastTime > 0 && (millis() - lastTime) < 500) {
+    if (lastTime[_clientCommand] > 0 && (millis() - lastTime[_clientCommand]) < 500) {
         debugPrintln("* Bug workaround: ignoring command repeating");
         return;
     }
-    lastTime = millis();
+    lastTime[_clientCommand] = millis();
 
     D("processCommand cmd: %s", _command.c_str());
 
     // Password request ? - 18/07/18
-    if (_password != "" && !_passwordOk) {  // Process the password - 18/08/18 - adjust in 04/09/08 and 2018-10-19
+    if (_password != "" && !debugClient.passwordOk) {  // Process the password - 18/08/18 - adjust in 04/09/08 and 2018-10-19
 
         if (_command == _password) {
             debugPrintln("* Password ok, allowing access now...");
 
-            _passwordOk = true;
+            debugClient.passwordOk = true;
+            updateClients();
 
 #ifdef ALPHA_VERSION                                      // In test, not good yet
             sendTelnetCommand(TELNET_WILL, TELNET_ECHO);  // Send a command to telnet to restore echoes = 18/08/18
@@ -1088,14 +2039,14 @@ void RemoteDebug::processCommand() {
             debugPrintln("* Wrong password!");
 
 #ifdef REMOTEDEBUG_PWD_ATTEMPTS
-            _passwordAttempt++;
+            debugClient.passwordAttempt++;
 
-            if (_passwordAttempt > REMOTEDEBUG_PWD_ATTEMPTS) {
+            if (debugClient.passwordAttempt > REMOTEDEBUG_PWD_ATTEMPTS) {
                 debugPrintln("* Many attempts. Closing session now.");
 
                 // Disconnect
 
-                disconnect();
+                closeClient(_clientCommand);
 
             } else {
                 showHelp();
@@ -1117,7 +2068,7 @@ void RemoteDebug::processCommand() {
     }
 
     // Set time of last command received
-    _lastTimeCommand = millis();
+    debugClient.lastTimeCommand = millis();
 
     // Get out of silent mode
     if (_command != "s" && _silence) {
@@ -1135,7 +2086,7 @@ void RemoteDebug::processCommand() {
 
         debugPrintln("* Closing client connection ...");
 
-        TelnetClient.stop();
+        closeClient(_clientCommand);
 
     } else if (_command == "m") {
         uint32_t free = ESP.getFreeHeap();
@@ -1146,7 +2097,8 @@ void RemoteDebug::processCommand() {
 #if not WEBSOCKET_DISABLED
 
         // Send status to app
-        if (_connectedWS) {
+        if (debugClient.type == CLIENT_WS) {
+            DebugWS.select(debugClient.num);
             DebugWS.printf("$app:M:%du:\n", free);
         }
 
@@ -1167,7 +2119,8 @@ void RemoteDebug::processCommand() {
     } else if (_command == "v") {
         // Debug level
 
-        _clientDebugLevel = VERBOSE;
+        debugClient.debugLevel = VERBOSE;
+        updateClients();
 
         debugPrintln("* Debug level set to Verbose");
 
@@ -1178,7 +2131,8 @@ void RemoteDebug::processCommand() {
     } else if (_command == "d") {
         // Debug level
 
-        _clientDebugLevel = DEBUG;
+        debugClient.debugLevel = DEBUG;
+        updateClients();
 
         debugPrintln("* Debug level set to Debug");
 
@@ -1189,7 +2143,8 @@ void RemoteDebug::processCommand() {
     } else if (_command == "i") {
         // Debug level
 
-        _clientDebugLevel = INFO;
+        debugClient.debugLevel = INFO;
+        updateClients();
 
         debugPrintln("* Debug level set to Info");
 
@@ -1200,7 +2155,8 @@ void RemoteDebug::processCommand() {
     } else if (_command == "w") {
         // Debug level
 
-        _clientDebugLevel = WARNING;
+        debugClient.debugLevel = WARNING;
+        updateClients();
 
         debugPrintln("* Debug level set to Warning");
 
@@ -1211,7 +2167,8 @@ void RemoteDebug::processCommand() {
     } else if (_command == "e") {
         // Debug level
 
-        _clientDebugLevel = ERROR;
+        debugClient.debugLevel = ERROR;
+        updateClients();
 
         debugPrintln("* Debug level set to Error");
 
@@ -1273,23 +2230,24 @@ void RemoteDebug::processCommand() {
 
     } else if (_command == "P") {
         // Debug level profile
-        _levelBeforeProfiler = _clientDebugLevel;
-        _clientDebugLevel = PROFILER;
+        debugClient.levelBeforeProfiler = debugClient.debugLevel;
+        debugClient.debugLevel = PROFILER;
+        updateClients();
 
         if (_showProfiler == false) {
             _showProfiler = true;
         }
 
-        _levelProfilerDisable = 1000;  // Default
+        debugClient.levelProfilerDisable = 1000;  // Default
 
         if (options.length() > 0) {  // With time of disable
             int32_t aux = options.toInt();
             if (aux > 0) {  // Valid number
-                _levelProfilerDisable = millis() + aux;
+                debugClient.levelProfilerDisable = millis() + aux;
             }
         }
 
-        debugPrintf("* Debug level set to Profiler (disable in %u millis)\r\n", _levelProfilerDisable);
+        debugPrintf("* Debug level set to Profiler (disable in %u millis)\r\n", debugClient.levelProfilerDisable);
 
     } else if (_command == "A") {
         // Auto debug level profile
@@ -1311,11 +2269,44 @@ void RemoteDebug::processCommand() {
         _showColors = !_showColors;
         debugPrintf("* Show colors: %s\r\n", (_showColors) ? "On" : "Off");
 
+    } else if (_command == "stats") {
+        debugPrintf("* Debug: sent %lu bytes in %lu writes (%lu partial, window full), %lu bytes dropped\r\n",
+                    (unsigned long)_sendStats.bytes, (unsigned long)_sendStats.writes, (unsigned long)_sendStats.partial,
+                    (unsigned long)_sendStats.dropped);
+        debugPrintf("* Debug: time in the buffer avg %lu us, max %lu us\r\n",
+                    (unsigned long)(_sendStats.writes ? _sendStats.latency / _sendStats.writes : 0), (unsigned long)_sendStats.latencyMax);
+
     } else if (_command.startsWith("filter ") && options.length() > 0) {
         setFilter(options);
 
     } else if (_command == "nofilter") {
         setNoFilter();
+#ifdef DEBUG_SPOOL
+    } else if (_command == "spool") {
+        showSpool();
+
+    } else if (_command == "spool clear") {
+        _spool.clear();
+        debugPrintln("* Debug: spool cleared");
+
+    } else if (_command == "spool stats") {
+        const RemoteDebugSpool::Stats& stats = _spool.getStats();
+
+        debugPrintf("* Debug: spool %lu lines, %lu bytes, %lu bytes written in %lu flushes, %lu file flushes\r\n",
+                    (unsigned long)stats.lines, (unsigned long)stats.bytes, (unsigned long)stats.written, (unsigned long)stats.flushes,
+                    (unsigned long)stats.syncs);
+        debugPrintf("* Debug: flush time avg %lu us, max %lu us, %lu lines dropped\r\n",
+                    (unsigned long)(stats.flushes ? stats.flushTime / stats.flushes : 0), (unsigned long)stats.flushTimeMax,
+                    (unsigned long)stats.dropped);
+#endif
+#ifdef DEBUG_SCOPES
+    } else if (_command == "scopes") {
+        showScopes();
+
+    } else if (_command == "scopes reset") {
+        _profiler.reset();
+        debugPrintln("* Debug: scopes reset");
+#endif
     } else if (_command == "reset" && _resetCommandEnabled) {
         debugPrintln("* Reset ...");
 
@@ -1327,11 +2318,10 @@ void RemoteDebug::processCommand() {
         debugPrintln("* Resetting the ESP32 ...");
 #endif
 
-        TelnetClient.stop();
-        TelnetServer.stop();
-
-#if not WEBSOCKET_DISABLED
-        DebugWS.stop();
+        _clientCommand = -1;
+        stop();
+#ifdef DEBUG_SPOOL
+        _spool.flush();
 #endif
 
         delay(500);
@@ -1372,22 +2362,193 @@ void RemoteDebug::processCommand() {
 
 // Filter
 
+// Of the client of the command in process, else of all the clients
+
+// Compiled once, case insensitive
+
 void RemoteDebug::setFilter(String filter) {
-    _filter = filter;
-    _filter.toLowerCase();  // TODO: option to case insensitive ?
-    _filterActive = true;
+    RemoteDebugFilter compiled;
+
+    if (!compiled.compile(filter.c_str())) {
+        debugPrintf("* Debug: Filter too long (max. %d terms and %d characters)\r\n", DEBUG_FILTER_TERMS, DEBUG_FILTER_SIZE);
+        return;
+    }
+    if (!compiled.isActive()) {
+        setNoFilter();
+        return;
+    }
+
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (clientPrint(client)) {
+            _clients[client].filter = compiled;
+        }
+    }
 
     debugPrint("* Debug: Filter active: ");
-    debugPrintln(_filter);
+    debugPrintln(filter);
+#ifdef DEBUG_DEFERRED
+    if (compiled.hasText()) {
+        debugPrintln("* Debug: The deferred logs have no text, only their level is filtered (level:wie)");
+    }
+#endif
 }
 
 void RemoteDebug::setNoFilter() {
-    _filter = "";
-    _filterActive = false;
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (clientPrint(client)) {
+            _clients[client].filter.clear();
+        }
+    }
 
     debugPrintln("* Debug: Filter disabled");
 }
 
+#ifdef DEBUG_SPOOL
+
+// Spool of the logs on the flash
+// The filesystem is mounted by the sketch (e.g. SPIFFS.begin(true))
+
+boolean RemoteDebug::setSpool(fs::FS& fs, uint8_t debugLevel) {
+    _spoolLevel = debugLevel;
+    return _spool.begin(fs);
+}
+
+// Records formatted as the lines, in the send buffer of the clients
+// A piece by handle(): the send buffer is sent (what the window takes), then filled with the next lines
+
+void RemoteDebug::showSpool() {
+    static const char begin[] = "* Debug: logs of the spool:\r\n";
+
+    _spoolClient = _clientCommand;
+    spoolSend(begin, sizeof(begin) - 1);
+    _spool.readBegin(_spoolCursor);
+    _spoolShow = true;
+    showSpoolNext();
+}
+
+void RemoteDebug::showSpoolNext() {
+    static const char end[] = "* Debug: end of the spool\r\n";
+    int8_t clientCommand = _clientCommand;
+    _clientCommand = _spoolClient;
+
+    if (_spoolClient >= 0 && !clientReady(_spoolClient)) {  // Gone
+        _spoolShow = false;
+    }
+
+#ifdef CLIENT_BUFFERING
+    for (uint8_t client = 0; _spoolShow && client < DEBUG_MAX_CLIENTS; client++) {
+        if (clientReady(client) && clientPrint(client)) {
+            sendBuffer(client);
+        }
+    }
+#endif
+
+    if (_spoolShow && !_spool.read(_spoolCursor, spoolLine, this) && spoolRoom(sizeof(end) - 1)) {
+        spoolSend(end, sizeof(end) - 1);
+        _spoolShow = false;
+    }
+    _clientCommand = clientCommand;
+}
+
+// Room for a line in the send buffer of the clients of the command spool
+
+boolean RemoteDebug::spoolRoom(size_t size) {
+#ifdef CLIENT_BUFFERING
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (clientReady(client) && clientPrint(client) && _clients[client].sizeBufferSend + size > MAX_SIZE_SEND) {
+            return false;
+        }
+    }
+#else
+    (void)size;
+#endif
+    return true;
+}
+
+// To the client of the command (else all the clients and serial)
+
+void RemoteDebug::spoolSend(const char* text, size_t size) {
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (clientReady(client) && clientPrint(client)) {
+            sendData(client, (const uint8_t*)text, size);
+        }
+    }
+    if (_clientCommand < 0 && _serialEnabled) {
+        Serial.write((const uint8_t*)text, size);
+    }
+}
+
+// Line of a record, false if a client has no room for it now
+
+boolean RemoteDebug::spoolLine(void* arg, uint8_t level, uint32_t time, const char* text, size_t size) {
+    RemoteDebug& debug = *(RemoteDebug*)arg;
+    char line[32 + 255 + 2];
+    size_t pos;
+
+    if (level == RemoteDebugSpool::LEVEL_BOOT) {
+        pos = snprintf(line, 32, "* ---- boot ----");
+    } else if (level < ANY) {
+        pos = snprintf(line, 32, "(%c t:%lums) ", "PVDIWE"[level], (unsigned long)time);
+    } else {
+        pos = snprintf(line, 32, "(t:%lums) ", (unsigned long)time);
+    }
+    memcpy(line + pos, text, size);
+    pos += size;
+    line[pos++] = '\r';
+    line[pos++] = '\n';
+
+    if (!debug.spoolRoom(pos)) {
+        return false;
+    }
+    debug.spoolSend(line, pos);
+    return true;
+}
+
+const RemoteDebugSpool::Stats& RemoteDebug::getSpoolStats() {
+    return _spool.getStats();
+}
+
+#endif
+
+#ifdef DEBUG_SCOPES
+// Report of the profiler: the loop (time between the calls of handle) and the scopes,
+// the ones with more time first
+
+void RemoteDebug::showScopes() {
+    uint32_t time = _profiler.getTime();
+    uint8_t order[DEBUG_SCOPES_SIZE];
+    uint8_t size = _profiler.sorted(order);
+
+    debugPrintf("* Debug: scopes in %lu ms (micros, percentiles as the next power of 2 - 1)\r\n", (unsigned long)time);
+    debugPrintf("* %-20s %8s %8s %8s %8s %8s %6s\r\n", "scope", "count", "mean", "p50", "p99", "max", "time%");
+
+    for (int16_t i = -1; i < size; i++) {
+        const RemoteDebugProfiler::Scope& scope = (i < 0) ? _profiler.getLoop() : _profiler.getScope(order[i]);
+        if (scope.count == 0) {
+            continue;
+        }
+        char percent[12] = "-";
+        if (i >= 0 && time > 0) {
+            uint32_t permille = (uint32_t)(RemoteDebugProfiler::getTotal(scope) / time);  // micros / millis
+            snprintf(percent, sizeof(percent), "%lu.%lu", (unsigned long)(permille / 10), (unsigned long)(permille % 10));
+        }
+        debugPrintf("* %-20s %8lu %8lu %8lu %8lu %8lu %6s\r\n", (i < 0) ? "(loop)" : scope.name, (unsigned long)scope.count,
+                    (unsigned long)(RemoteDebugProfiler::getTotal(scope) / scope.count), (unsigned long)RemoteDebugProfiler::percentile(scope, 50),
+                    (unsigned long)RemoteDebugProfiler::percentile(scope, 99), (unsigned long)scope.max, percent);
+    }
+
+    if (_profiler.getLoop().count > 1) {
+        debugPrintf("* Debug: loop jitter %lu us (mean change between two loops)\r\n", (unsigned long)_profiler.getJitter());
+    }
+    if (size == DEBUG_SCOPES_SIZE) {
+        debugPrintf("* Debug: table of scopes full (%d), the next ones are not measured\r\n", DEBUG_SCOPES_SIZE);
+    }
+    if (_profiler.getBusy() > 0) {
+        debugPrintf("* Debug: %lu calls not measured, a scope was added by other task\r\n", (unsigned long)_profiler.getBusy());
+    }
+}
+#endif
+
 // Silence
 
 void RemoteDebug::silence(boolean activate, boolean showMessage, boolean fromBreak, uint32_t timeout) {
@@ -1397,7 +2558,7 @@ void RemoteDebug::silence(boolean activate, boolean showMessage, boolean fromBre
         if (activate) {
             debugPrintln("* Debug now is in silent mode!");
 #if not WEBSOCKET_DISABLED
-            if (_connectedWS) {
+            if (_clientCommand >= 0 && _clients[_clientCommand].type == CLIENT_WS) {
                 debugPrintln("* Press button \"Silence\" or another command to return show debugs");
             } else {
                 debugPrintln("* Press s again or another command to return show debugs");
@@ -1417,10 +2578,13 @@ void RemoteDebug::silence(boolean activate, boolean showMessage, boolean fromBre
 
 #if not WEBSOCKET_DISABLED
 
-    // Send status to app
+    // Send status to apps
 
-    if (_connectedWS) {
-        DebugWS.printf("$app:S:%c\n", ((_silence) ? '1' : '0'));
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (_clients[client].type == CLIENT_WS) {
+            DebugWS.select(_clients[client].num);
+            DebugWS.printf("$app:S:%c\n", ((_silence) ? '1' : '0'));
+        }
     }
 
 #endif
@@ -1430,50 +2594,66 @@ boolean RemoteDebug::isSilence() {
     return _silence;
 }
 
-// Format numbers
 
-String RemoteDebug::formatNumber(uint32_t value, uint8_t size, char insert) {
-    // Putting zeroes in left
+#if not WEBSOCKET_DISABLED
 
-    String ret = "";
+///////  routines
 
-    for (uint8_t i = 1; i <= size; i++) {
-        uint32_t max = pow(10, i);
-        if (value < max) {
-            for (uint8_t j = (size - i); j > 0; j--) {
-                ret.concat(insert);
-            }
-            break;
+// Web app connected - as a telnet client, if there is a free one
+
+void RemoteDebug::wsOnConnect(int8_t num) {
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (_clients[client].type == CLIENT_NONE) {
+            _clients[client].type = CLIENT_WS;
+            _clients[client].num = num;
+
+            onConnection(client);
+            return;
         }
     }
 
-    ret.concat(value);
-
-    return ret;
+    D("wsOnConnect no more clients")
+    DebugWS.select(num);
+    DebugWS.println("* Too many clients connected, closing ...");
+    DebugWS.disconnect(num);
 }
 
-#if not WEBSOCKET_DISABLED
+void RemoteDebug::wsOnDisconnect(int8_t num) {
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (_clients[client].type == CLIENT_WS && _clients[client].num == num) {
+            _clients[client].type = CLIENT_NONE;  // Already disconnected
+            updateClients();
+        }
+    }
+}
 
-///////  routines
+// Process user command over
 
-// Process user command over telnet or
+void RemoteDebug::wsOnReceive(int8_t num, const char* command) {  // @suppress("Unused function declaration")
+    for (uint8_t client = 0; client < DEBUG_MAX_CLIENTS; client++) {
+        if (_clients[client].type != CLIENT_WS || _clients[client].num != num) {
+            continue;
+        }
 
-void RemoteDebug::wsOnReceive(const char* command) {  // @suppress("Unused function declaration")
+        // Process the command
 
-    // Process the command
+        _command = command;
+        _lastCommand = _command;  // Store the last command
+        _clientCommand = client;  // Answer to this client
 
-    _command = command;
-    _lastCommand = _command;  // Store the last command
+        D("wsOnReceive cmd: %s", command);
 
-    D("wsOnReceive cmd: %s", command);
+        // Is app commands
+        if (_command == "$app") {
+            D("wsOnReceive app command")
+            // RemoteDebug connected, send info
+            wsSendInfo();
+        } else {  // Normal commands
+            processCommand();
+        }
 
-    // Is app commands
-    if (_command == "$app") {
-        D("wsOnReceive app command")
-        // RemoteDebug connected, send info
-        wsSendInfo();
-    } else {  // Normal commands
-        processCommand();
+        _clientCommand = -1;
+        return;
     }
 }
 
@@ -1487,8 +2667,8 @@ void RemoteDebug::wsSendInfo() {
     char features;
     char dbgEnabled;
 
-    // Not connected ?
-    if (!_connectedWS) {
+    // Not from a web app ?
+    if (_clientCommand < 0 || _clients[_clientCommand].type != CLIENT_WS) {
         D("wsSendInfo not connected")
         return;
     }
@@ -1517,6 +2697,7 @@ void RemoteDebug::wsSendInfo() {
     board = "ESP8266";
 #endif
 
+    DebugWS.select(_clients[_clientCommand].num);
     DebugWS.println();  // Workaround to not get dirty "[0m" ???
     DebugWS.printf("$app:V:%s:%s:%c:%du:%c:N\n", version.c_str(), board.c_str(), features, getFreeMemory(), dbgEnabled);
 
@@ -1528,9 +2709,10 @@ void RemoteDebug::wsSendInfo() {
 }
 
 void RemoteDebug::wsSendLevelInfo() {
-    // Send debug level info to app
-    if (_connectedWS) {
-        DebugWS.printf("$app:L:%u\n", _clientDebugLevel);
+    // Send debug level info to app (of the command)
+    if (_clientCommand >= 0 && _clients[_clientCommand].type == CLIENT_WS) {
+        DebugWS.select(_clients[_clientCommand].num);
+        DebugWS.printf("$app:L:%u\n", _clients[_clientCommand].debugLevel);
     }
 }
 
@@ -1576,7 +2758,9 @@ void RemoteDebug::sendTelnetCommand(uint8_t command, uint8_t option) {
     // Send a command to the telnet client
 
     debugPrintf("%c%c%c", TELNET_IAC, command, option);
-    TelnetClient.flush();
+    if (_clientCommand >= 0 && _clients[_clientCommand].type == CLIENT_TELNET) {
+        TelnetClients[_clientCommand].flush();
+    }
 }
 #endif
 
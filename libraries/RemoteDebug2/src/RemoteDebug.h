@@ -83,6 +83,8 @@
 #include "Arduino.h"
 #include "Print.h"
 
+#include <type_traits>
+
 // ESP8266 or ESP32 ?
 #if defined(ESP8266)
 #include <ESP8266WiFi.h>
@@ -92,8 +94,47 @@
 #error "Only for ESP8266 or ESP32"
 #endif
 
+#include "RemoteDebugFilter.h"
+
+#ifdef DEBUG_SPOOL
+#include "RemoteDebugSpool.h"
+#endif
+
+#ifdef DEBUG_LOG_RECORDS
+#include "RemoteDebugLog.h"
+#endif
+
+#ifdef DEBUG_SCOPES
+#include "RemoteDebugProfiler.h"
+#endif
+
 ////// Shortcuts macros
 
+// Deferred logs: FNV-1a hash of the format string, at compile time
+constexpr uint32_t debugFormatHash(const char* format, uint32_t hash = 2166136261u) {
+    return (*format) ? debugFormatHash(format + 1, (hash ^ (uint8_t)*format) * 16777619u) : hash;
+}
+#define DEBUG_FORMAT_ID(fmt) (std::integral_constant<uint32_t, debugFormatHash(fmt)>::value)
+
+// Profiler: time of the rest of the block in the scope name (a literal), see the command scopes
+#ifdef DEBUG_SCOPES
+#define DEBUG_SCOPE_CONCAT_(a, b) a##b
+#define DEBUG_SCOPE_CONCAT(a, b) DEBUG_SCOPE_CONCAT_(a, b)
+#define DEBUG_SCOPE(name)                                                                        \
+    static uint8_t DEBUG_SCOPE_CONCAT(_debugScopeSlot, __LINE__) = RemoteDebugProfiler::BUSY_SLOT; \
+    RemoteDebugScope DEBUG_SCOPE_CONCAT(_debugScope, __LINE__)(Debug.getProfiler(),                \
+                                                               Debug.getProfiler().slot(DEBUG_SCOPE_CONCAT(_debugScopeSlot, __LINE__), name))
+#else
+#define DEBUG_SCOPE(name)
+#endif
+
+// Print of the debug macros
+#ifdef DEBUG_DEFERRED  // Only id of the format, time and arguments are sent
+#define rdebugPrintf(fmt, ...) Debug.deferred(DEBUG_FORMAT_ID(fmt), fmt, ##__VA_ARGS__)
+#else
+#define rdebugPrintf(fmt, ...) Debug.printf(fmt, ##__VA_ARGS__)
+#endif
+
 // Auto function for debug macros?
 #ifndef DEBUG_DISABLE_AUTO_FUNC  // With auto func
 
@@ -103,19 +144,19 @@
 #ifdef DEBUG_AUTO_CORE
 
 #define rdebugA(fmt, ...) \
-    if (Debug.isActive(Debug.ANY)) Debug.printf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
+    if (Debug.isActive(Debug.ANY)) rdebugPrintf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
 #define rdebugP(fmt, ...) \
-    if (Debug.isActive(Debug.PROFILER)) Debug.printf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
+    if (Debug.isActive(Debug.PROFILER)) rdebugPrintf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
 #define rdebugV(fmt, ...) \
-    if (Debug.isActive(Debug.VERBOSE)) Debug.printf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
+    if (Debug.isActive(Debug.VERBOSE)) rdebugPrintf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
 #define rdebugD(fmt, ...) \
-    if (Debug.isActive(Debug.DEBUG)) Debug.printf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
+    if (Debug.isActive(Debug.DEBUG)) rdebugPrintf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
 #define rdebugI(fmt, ...) \
-    if (Debug.isActive(Debug.INFO)) Debug.printf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
+    if (Debug.isActive(Debug.INFO)) rdebugPrintf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
 #define rdebugW(fmt, ...) \
-    if (Debug.isActive(Debug.WARNING)) Debug.printf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
+    if (Debug.isActive(Debug.WARNING)) rdebugPrintf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
 #define rdebugE(fmt, ...) \
-    if (Debug.isActive(Debug.ERROR)) Debug.printf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
+    if (Debug.isActive(Debug.ERROR)) rdebugPrintf("(%s)(C%d) " fmt, __func__, xPortGetCoreID(), ##__VA_ARGS__)
 
 #endif // DEBUG_AUTO_CORE
 #endif // ESP32
@@ -123,38 +164,38 @@
 #ifndef DEBUG_AUTO_CORE  // No auto core or for ESP8266
 
 #define rdebugA(fmt, ...) \
-    if (Debug.isActive(Debug.ANY)) Debug.printf("(%s) " fmt, __func__, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.ANY)) rdebugPrintf("(%s) " fmt, __func__, ##__VA_ARGS__)
 #define rdebugP(fmt, ...) \
-    if (Debug.isActive(Debug.PROFILER)) Debug.printf("(%s) " fmt, __func__, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.PROFILER)) rdebugPrintf("(%s) " fmt, __func__, ##__VA_ARGS__)
 #define rdebugV(fmt, ...) \
-    if (Debug.isActive(Debug.VERBOSE)) Debug.printf("(%s) " fmt, __func__, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.VERBOSE)) rdebugPrintf("(%s) " fmt, __func__, ##__VA_ARGS__)
 #define rdebugD(fmt, ...) \
-    if (Debug.isActive(Debug.DEBUG)) Debug.printf("(%s) " fmt, __func__, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.DEBUG)) rdebugPrintf("(%s) " fmt, __func__, ##__VA_ARGS__)
 #define rdebugI(fmt, ...) \
-    if (Debug.isActive(Debug.INFO)) Debug.printf("(%s) " fmt, __func__, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.INFO)) rdebugPrintf("(%s) " fmt, __func__, ##__VA_ARGS__)
 #define rdebugW(fmt, ...) \
-    if (Debug.isActive(Debug.WARNING)) Debug.printf("(%s) " fmt, __func__, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.WARNING)) rdebugPrintf("(%s) " fmt, __func__, ##__VA_ARGS__)
 #define rdebugE(fmt, ...) \
-    if (Debug.isActive(Debug.ERROR)) Debug.printf("(%s) " fmt, __func__, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.ERROR)) rdebugPrintf("(%s) " fmt, __func__, ##__VA_ARGS__)
 
 #endif
 
 #else  // Without auto func
 
 #define rdebugA(fmt, ...) \
-    if (Debug.isActive(Debug.ANY)) Debug.printf(fmt, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.ANY)) rdebugPrintf(fmt, ##__VA_ARGS__)
 #define rdebugP(fmt, ...) \
-    if (Debug.isActive(Debug.PROFILER)) Debug.printf(fmt, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.PROFILER)) rdebugPrintf(fmt, ##__VA_ARGS__)
 #define rdebugV(fmt, ...) \
-    if (Debug.isActive(Debug.VERBOSE)) Debug.printf(fmt, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.VERBOSE)) rdebugPrintf(fmt, ##__VA_ARGS__)
 #define rdebugD(fmt, ...) \
-    if (Debug.isActive(Debug.DEBUG)) Debug.printf(fmt, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.DEBUG)) rdebugPrintf(fmt, ##__VA_ARGS__)
 #define rdebugI(fmt, ...) \
-    if (Debug.isActive(Debug.INFO)) Debug.printf(fmt, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.INFO)) rdebugPrintf(fmt, ##__VA_ARGS__)
 #define rdebugW(fmt, ...) \
-    if (Debug.isActive(Debug.WARNING)) Debug.printf(fmt, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.WARNING)) rdebugPrintf(fmt, ##__VA_ARGS__)
 #define rdebugE(fmt, ...) \
-    if (Debug.isActive(Debug.ERROR)) Debug.printf(fmt, ##__VA_ARGS__)
+    if (Debug.isActive(Debug.ERROR)) rdebugPrintf(fmt, ##__VA_ARGS__)
 
 #endif
 
@@ -222,7 +263,57 @@
 #define rprintAln(x, ...) \
     if (Debug.isActive(Debug.ANY)) Debug.println(x, ##__VA_ARGS__)
 
+// Levels below REMOTEDEBUG_MIN_LEVEL are not compiled (nor their format strings)
+#if REMOTEDEBUG_MIN_LEVEL > 0  // Profiler
+#undef rdebugP
+#define rdebugP(...)
+#endif
+#if REMOTEDEBUG_MIN_LEVEL > 1  // Verbose
+#undef rdebugV
+#undef rprintV
+#undef rprintVln
+#define rdebugV(...)
+#define rprintV(...)
+#define rprintVln(...)
+#endif
+#if REMOTEDEBUG_MIN_LEVEL > 2  // Debug
+#undef rdebugD
+#undef rprintD
+#undef rprintDln
+#define rdebugD(...)
+#define rprintD(...)
+#define rprintDln(...)
+#endif
+#if REMOTEDEBUG_MIN_LEVEL > 3  // Info
+#undef rdebugI
+#undef rprintI
+#undef rprintIln
+#define rdebugI(...)
+#define rprintI(...)
+#define rprintIln(...)
+#endif
+#if REMOTEDEBUG_MIN_LEVEL > 4  // Warning
+#undef rdebugW
+#undef rprintW
+#undef rprintWln
+#define rdebugW(...)
+#define rprintW(...)
+#define rprintWln(...)
+#endif
+#if REMOTEDEBUG_MIN_LEVEL > 5  // Error
+#undef rdebugE
+#undef rprintE
+#undef rprintEln
+#define rdebugE(...)
+#define rprintE(...)
+#define rprintEln(...)
+#endif
+
 ///// Class
+#ifdef DEBUG_LOG_RECORDS
+class RemoteDebugRecord;
+#endif
+
 class RemoteDebug : public Print {
    public:
     // Constructor
@@ -262,9 +353,46 @@ class RemoteDebug : public Print {
     void silence(boolean activate, boolean showMessage = true, boolean fromBreak = false, uint32_t timeout = 0);
     boolean isSilence();
 
-    void onConnection(boolean connected);
-
     boolean isConnected();
+    uint8_t getClientsConnected();  // Telnet and web app clients
+
+#ifdef DEBUG_RING_SIZE
+    uint32_t getRingOverflows();  // Messages dropped, the ring was full
+#endif
+
+    // Output to the clients: a telnet client gets only what its TCP window takes (no wait),
+    // the rest waits in its send buffer, messages without room there are dropped (slow client)
+    struct SendStats {
+        uint32_t bytes = 0;       // Sent
+        uint32_t writes = 0;      // Writes with data sent
+        uint32_t partial = 0;     // Writes of a part of the buffer (window full)
+        uint32_t dropped = 0;     // Bytes dropped
+        uint64_t latency = 0;     // Time of the oldest byte in the buffer, by write (micros)
+        uint32_t latencyMax = 0;  // The longest one (micros)
+    };
+    const SendStats& getSendStats();
+
+#ifdef DEBUG_SPOOL
+    // Spool of the logs of this level on the flash (filesystem mounted by the sketch)
+    boolean setSpool(fs::FS& fs, uint8_t debugLevel = INFO);
+    void showSpool();  // To the client of the command, else to all clients (a piece by handle)
+    const RemoteDebugSpool::Stats& getSpoolStats();
+#endif
+
+#ifdef DEBUG_LOG_RECORDS
+    // Structured log: Debug.log(Debug.INFO).kv("temp", t).kv("fan", s);
+    // the record is sent at the end of the statement (keys as literals are not copied)
+    RemoteDebugRecord log(uint8_t debugLevel);
+    uint32_t getLogDropped();  // Records dropped: too big, or a record of other task in progress
+#endif
+
+#ifdef DEBUG_SCOPES
+    // Timing scopes (DEBUG_SCOPE) and loop time
+    RemoteDebugProfiler& getProfiler() {
+        return _profiler;
+    }
+    void showScopes();  // To the client of the command, else to all clients
+#endif
 
 #ifdef DEBUGGER_ENABLED
     // For Simple software debugger - based on SerialDebug Library
@@ -273,12 +401,28 @@ class RemoteDebug : public Print {
 #endif
 
 #if not WEBSOCKET_DISABLED
-    void wsOnReceive(const char* command);
+    void wsOnConnect(int8_t num);
+    void wsOnDisconnect(int8_t num);
+    void wsOnReceive(int8_t num, const char* command);
     void wsSendInfo();
     void wsSendLevelInfo();
 #endif
     boolean wsIsConnected();
 
+    // Deferred log - the format is not done here, but by extras/decode_deferred.py
+    // id is DEBUG_FORMAT_ID(format), the format must be a literal (it is sent once per connection)
+    template <typename... Args>
+    void deferred(uint32_t id, const char* format, Args... args) {
+        if (_silence) {
+            return;
+        }
+        DeferredRecord record;
+        deferredBegin(record, id, format);
+        int unused[] = { 0, (deferredArg(record, args), 0)... };
+        (void)unused;
+        deferredEnd(record);
+    }
+
     // Print
     virtual size_t write(uint8_t);
     virtual size_t write(const uint8_t* buffer, size_t size);  // Insert due a write bug w/ latest Esp8266 SDK - 17/08/18
@@ -300,17 +444,14 @@ class RemoteDebug : public Print {
 
    private:
     String _hostName = "";        // Host name
-    boolean _connected = false;   // Client is connected ?
+    boolean _connected = false;   // Telnet client is connected ?
     String _password = "";        // Password
-    boolean _passwordOk = false;  // Password request ? - 18/07/18
-    uint8_t _passwordAttempt = 0;
     boolean _silence = false;                        // Silence mode ?
     uint32_t _silenceTimeout = 0;                    // Silence timeout
-    uint8_t _clientDebugLevel = DEBUG;               // Level setted by user in web app or telnet client
+    uint8_t _debugLevel = DEBUG;                     // Level of begin: for new clients and serial
+    uint8_t _clientDebugLevel = DEBUG;               // Lowest level of the clients (and serial)
     uint8_t _lastDebugLevel = DEBUG;                 // Last Level setted by active()
     uint32_t _lastTimePrint = millis();              // Last time print a line
-    uint8_t _levelBeforeProfiler = DEBUG;            // Last Level before Profiler level
-    uint32_t _levelProfilerDisable = 0;              // time in millis to disable the profiler level
     uint32_t _autoLevelProfiler = 0;                 // Automatic change to profiler level if time between handles is greater than n millis
     boolean _showTime = false;                       // Show time in millis
     boolean _showProfiler = false;                   // Show time between messages
@@ -324,19 +465,111 @@ class RemoteDebug : public Print {
     uint32_t connectionTimeout = MAX_TIME_INACTIVE;  // Connection Timeout
     String _command = "";                            // Command received
     String _lastCommand = "";                        // Last Command received
-    uint32_t _lastTimeCommand = millis();            // Last time command received
     String _helpProjectCmds = "";                    // Help of comands setted by project (sketch)
     void (*_callbackProjectCmds)() = NULL;           // Callable for projects commands
     void (*_callbackNewClient)() = NULL;             // Callable for when have a new client connected
-    String _filter = "";                             // Filter
-    boolean _filterActive = false;
-    String _bufferPrint = "";  // Buffer of print write to WiFi
 
+    // Buffer of print write to WiFi - one line: prefix, text, CR/LF and color reset
+    char _bufferPrint[BUFFER_PREFIX + BUFFER_PRINT + 2 + sizeof(COLOR_RESET)];
+    uint16_t _sizeBufferPrint = 0;  // Size of it
+    uint16_t _sizePrefix = 0;       // Size of the prefix in it
+    uint32_t _elapsedPrint = 0;     // Profiler time of the line in it
+    uint8_t _levelPrint = DEBUG;    // Debug level of the line in it
+    uint32_t _timePrint = 0;        // Time of the line in it
+
+#ifdef DEBUG_SPOOL
+    RemoteDebugSpool _spool;       // Logs on the flash
+    uint8_t _spoolLevel = INFO;    // Level of them
+    RemoteDebugSpool::Cursor _spoolCursor;  // Command spool in process
+    boolean _spoolShow = false;
+    int8_t _spoolClient = -1;               // Its client, -1: all
+    void showSpoolNext();
+    boolean spoolRoom(size_t size);
+    static boolean spoolLine(void* arg, uint8_t level, uint32_t time, const char* text, size_t size);
+    void spoolSend(const char* text, size_t size);
+#endif
+
+#ifdef DEBUG_LOG_RECORDS
+    // Structured logs: one record at a time, in a fixed buffer (see RemoteDebugLog.h)
+    friend class RemoteDebugRecord;
+    RemoteDebugArena _logArena;
+    JsonDocument _logDoc{ &_logArena };
+    uint8_t _logBuffer[DEBUG_LOG_SIZE];  // Record serialized
+    uint8_t _logLevel = DEBUG;           // Level of the record
+    boolean _logBusy = false;            // A record in progress
+    uint32_t _logDropped = 0;            // Records dropped
+    boolean _lineRecord = false;         // Line of a record: not to the web app (it has the binary frame)
+    void logEnd();
+    void writeRecord(const uint8_t* record, size_t size, uint8_t debugLevel, uint32_t time);
+#endif
+
+#ifdef DEBUG_SCOPES
+    RemoteDebugProfiler _profiler;  // Timing scopes
+#endif
+
+#ifdef DEBUG_RING_SIZE
+    // Ring of messages written by all tasks, handle() is the only reader
+    // Each message: header (size, level, flags), time and the data, aligned to 8 bytes
+    uint8_t _ring[DEBUG_RING_SIZE] __attribute__((aligned(8)));
+    uint32_t _ringHead = 0;           // Position reserved by the writers (atomic)
+    uint32_t _ringTail = 0;           // Position read by handle() (atomic)
+    uint32_t _ringOverflows = 0;      // Messages dropped (atomic)
+    uint32_t _ringOverflowsShow = 0;  // Messages dropped already shown
+
+    // Start of a line of a task (print, then println), pushed as one message when the line is complete
+    struct RingLine {
+        const void* task = NULL;  // Task that has it (atomic)
+        uint16_t size = 0;
+        uint8_t level = 0;  // Of its first print
+        uint8_t data[DEBUG_RING_LINE];
+    };
+    RingLine _ringLines[DEBUG_RING_LINES];
+#endif
+
+    // Deferred log: id and pointer of the format, arguments with a type (see extras/decode_deferred.py)
+    struct DeferredRecord {
+        uint8_t data[DEBUG_DEFERRED_SIZE];
+        uint16_t size;
+        boolean full;
+    };
+    // Deferred logs sent in a connection (telnet client or serial)
+    struct DeferredState {
+        uint32_t sent[DEBUG_DEFERRED_FORMATS] = {};  // Ids of the formats sent, by slot
+        uint32_t time = 0;                           // Time of the last log sent
+    };
+    DeferredState _deferredSerial;
+
+    SendStats _sendStats;  // Output to the clients
+
+    // Clients (telnet and web app), each with its own debug level and filter
+    // A line is formatted once and copied to the send buffer of each client that wants it
+    static const uint8_t CLIENT_NONE = 0;    // Free
+    static const uint8_t CLIENT_TELNET = 1;  // Telnet, in TelnetClients (RemoteDebug.cpp)
+    static const uint8_t CLIENT_WS = 2;      // Web app, a client of the websocket server
+
+    struct DebugClient {
+        uint8_t type = CLIENT_NONE;
+        int8_t num = -1;                        // Number in the websocket server (web app)
+        uint8_t debugLevel = DEBUG;             // Level setted by user in web app or telnet client
+        uint8_t levelBeforeProfiler = DEBUG;    // Last Level before Profiler level
+        uint32_t levelProfilerDisable = 0;      // time in millis to disable the profiler level
+        boolean passwordOk = false;             // Password request ? - 18/07/18
+        uint8_t passwordAttempt = 0;
+        String command = "";                    // Command being received (telnet)
+        uint32_t lastTimeCommand = 0;           // Last time command received
+        RemoteDebugFilter filter;               // Filter, compiled
+        DeferredState deferred;                 // Deferred logs (telnet)
 #ifdef CLIENT_BUFFERING
-    String _bufferSend = "";       // Buffer to send data to web app or telnet client
-    uint16_t _sizeBufferSend = 0;  // Size of it
-    uint32_t _lastTimeSend = 0;    // Last time command send data
+        char bufferSend[MAX_SIZE_SEND];  // Buffer to send data to web app or telnet client
+        uint16_t sizeBufferSend = 0;     // Size of it
+        uint32_t lastTimeSend = 0;       // Last time command send data
+        uint32_t timeBuffer = 0;         // Time of the oldest byte in the buffer (micros)
 #endif
+        uint32_t dropped = 0;      // Bytes dropped, the client is too slow
+        uint32_t droppedShow = 0;  // Dropped already told to the client
+    };
+    DebugClient _clients[DEBUG_MAX_CLIENTS];
+    int8_t _clientCommand = -1;  // Client of the command in process, -1: messages go to all the clients
 
 #ifdef DEBUGGER_ENABLED
     //	// For Simple software debugger - based on SerialDebug Library
@@ -349,7 +582,63 @@ class RemoteDebug : public Print {
     //////// Privates
     void showHelp();
     void processCommand();
-    String formatNumber(uint32_t value, uint8_t size, char insert = '0');
+    void writeBuffer(const uint8_t* buffer, size_t size, uint8_t debugLevel, uint32_t time);
+    void beginLine(boolean connected, uint8_t debugLevel, uint32_t time);
+    size_t flushLine(boolean connected);
+    void sendData(uint8_t client, const uint8_t* data, size_t size);
+    size_t clientWrite(uint8_t client, const uint8_t* data, size_t size);
+    Print* clientPrint(uint8_t client);
+    boolean clientReady(uint8_t client);
+    void onConnection(uint8_t client);
+    void closeClient(uint8_t client);
+    void updateClients();
+
+    void deferredBegin(DeferredRecord& record, uint32_t id, const char* format);
+    void deferredEnd(DeferredRecord& record);
+    void deferredPut(DeferredRecord& record, char type, const void* value, size_t size);
+    void deferredVarint(DeferredRecord& record, char type, uint64_t value);
+    void writeDeferred(const uint8_t* record, size_t size, uint8_t debugLevel, uint32_t time);
+    void writeDeferred(DeferredState& state, int8_t client, uint32_t id, const char* format, const uint8_t* args, size_t size, uint8_t debugLevel, uint32_t time);
+    boolean sendFrame(int8_t client, char type, const uint8_t* data1, size_t size1, const uint8_t* data2, size_t size2);  // Client -1: serial
+    void dropFrame(int8_t client, size_t size);
+
+    // Arguments of a deferred log, by type
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type deferredArg(DeferredRecord& record, T value) {
+        int64_t aux = value;
+        deferredVarint(record, 'i', ((uint64_t)aux << 1) ^ (uint64_t)(aux >> 63));  // Zigzag
+    }
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type deferredArg(DeferredRecord& record, T value) {
+        deferredVarint(record, 'u', value);
+    }
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type deferredArg(DeferredRecord& record, T value) {
+        double aux = value;
+        deferredPut(record, 'd', &aux, sizeof(aux));
+    }
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type deferredArg(DeferredRecord& record, T value) {
+        deferredArg(record, (int32_t)value);
+    }
+    void deferredArg(DeferredRecord& record, const char* value);
+    void deferredArg(DeferredRecord& record, const void* value) {
+        deferredVarint(record, 'u', (uintptr_t)value);
+    }
+
+#ifdef DEBUG_RING_SIZE
+    boolean pushRing(const uint8_t* buffer, size_t size, uint8_t debugLevel, uint32_t flags = 0);
+    void pushRingParts(const uint8_t* buffer, size_t size, uint8_t debugLevel);
+    RingLine* findRingLine();
+    RingLine* takeRingLine();
+    void pushRingLine(RingLine* line);
+    void drainRing();
+#endif
+#ifdef CLIENT_BUFFERING
+    void sendBuffer(uint8_t client);
+    boolean roomSend(uint8_t client, size_t size);
+    void copySend(uint8_t client, const uint8_t* data, size_t size);
+#endif
     boolean isCRLF(char character);
     uint32_t getFreeMemory();
 
@@ -358,6 +647,37 @@ class RemoteDebug : public Print {
 #endif
 };
 
+#ifdef DEBUG_LOG_RECORDS
+// Record of Debug.log(), sent by the destructor (end of the statement)
+class RemoteDebugRecord {
+   public:
+    explicit RemoteDebugRecord(RemoteDebug* debug) : _debug(debug) {}
+    RemoteDebugRecord(RemoteDebugRecord&& other) : _debug(other._debug) {
+        other._debug = NULL;
+    }
+    RemoteDebugRecord(const RemoteDebugRecord&) = delete;
+    RemoteDebugRecord& operator=(const RemoteDebugRecord&) = delete;
+
+    ~RemoteDebugRecord() {
+        if (_debug) {
+            _debug->logEnd();
+        }
+    }
+
+    // Key and value, NULL record (not active) -> nothing
+    template <typename K, typename T>
+    RemoteDebugRecord& kv(const K& key, const T& value) {
+        if (_debug) {
+            _debug->_logDoc[key] = value;
+        }
+        return *this;
+    }
+
+   private:
+    RemoteDebug* _debug;
+};
+#endif
+
 #else  // DEBUG_DISABLED
 
 // Disable debug macros
@@ -405,6 +725,8 @@ class RemoteDebug : public Print {
 
 #define debugHandle()
 
+#define DEBUG_SCOPE(name)
+
 // Note all of Debug. codes need uses "#ifndef DEBUG_DISABLED"
 // For example, the initialization codes and:
 
@@ -53,6 +53,14 @@
 // Disable auto function for debug macros? (uncomment this if not want this)
 // #define DEBUG_DISABLE_AUTO_FUNC true
 
+// Minimum debug level compiled: the macros of the levels below it (debugV, rdebugD, rprintD ...)
+// are removed with their format strings, the others are still filtered by the level of the client
+// 0 profiler (all), 1 verbose, 2 debug, 3 info, 4 warning, 5 error, 6 none - debugA is always compiled
+// Can also be set in the build flags (-DREMOTEDEBUG_MIN_LEVEL=3)
+#ifndef REMOTEDEBUG_MIN_LEVEL
+#define REMOTEDEBUG_MIN_LEVEL 0
+#endif
+
 // Simple password request - left commented if not need this - 18/07/18
 // Notes:
 // It is very simple feature, only text, no cryptography,
@@ -63,6 +71,17 @@
 // Can be by project, just call setPassword method
 #define REMOTEDEBUG_PWD_ATTEMPTS 3
 
+// Clients at the same time (telnet and web app), each one with its own debug level and filter
+// Each one takes MAX_SIZE_SEND bytes of RAM for its send buffer
+// Can be by project, just define it before include this file
+#ifndef DEBUG_MAX_CLIENTS
+#ifdef ESP32
+#define DEBUG_MAX_CLIENTS 4
+#else
+#define DEBUG_MAX_CLIENTS 2
+#endif
+#endif
+
 // Maximum time for inactivity (em milliseconds)
 // Default: 10 minutes
 // Comment it if you not want this
@@ -73,6 +92,19 @@
 // Can be by project, just define it before include this file
 #define BUFFER_PRINT 150
 
+// Room for the prefix of a line (colors, debug level, time and profiler)
+#define BUFFER_PREFIX 80
+
+// Filter of a client (command filter), compiled once: terms and size of their texts
+// Each client takes about 36 bytes by term + the size
+// Can be by project, just define it before include this file
+#ifndef DEBUG_FILTER_TERMS
+#define DEBUG_FILTER_TERMS 4
+#endif
+#ifndef DEBUG_FILTER_SIZE
+#define DEBUG_FILTER_SIZE 48
+#endif
+
 // Should the help text be displayed on connection.
 // Enabled by default, comment to disable
 #define SHOW_HELP true
@@ -85,6 +117,73 @@
 #define MAX_SIZE_SEND 1460  // Maximum size of packet (limit of TCP/IP)
 #endif
 
+// Lock-free ring for the writes of all tasks and cores (ESP32)
+// Print only copies the message to the ring, handle() sends it to telnet, web app and serial
+// Comment this to send from the task that prints (only one task can print)
+#ifdef ESP32
+#define DEBUG_RING_SIZE 4096        // Size of the ring (power of 2)
+#define DEBUG_RING_DRAIN_TIME 2000  // Maximum time to send messages of the ring in one handle (micros)
+#define DEBUG_RING_LINES 4          // Tasks with a line not complete at the same time (print, then println)
+#define DEBUG_RING_LINE 128         // Start of a line kept until its end, longer ones are sent in parts
+#endif
+
+// Deferred logs: debug macros send only an id of the format, the time and the arguments
+// in binary frames, the text is done by extras/decode_deferred.py (telnet or serial, not the web app)
+// Uncomment this to enable it (or use Debug.deferred for some logs)
+// #define DEBUG_DEFERRED true
+#define DEBUG_DEFERRED_SIZE 128    // Maximum size of the arguments of a log
+#define DEBUG_DEFERRED_FORMATS 64  // Formats sent once per connection (up to 255, more are sent again each time)
+
+// Spool of the logs on the flash (SPIFFS or LittleFS, mounted by the sketch), call Debug.setSpool(SPIFFS)
+// The lines of the level of setSpool are kept, with no client connected too (boot, before a crash),
+// the command spool shows them. A ring of files, written in pages from a buffer in RAM
+// Uncomment this to enable it
+// #define DEBUG_SPOOL true
+#ifdef DEBUG_SPOOL
+#ifndef DEBUG_SPOOL_PATH
+#define DEBUG_SPOOL_PATH "/rdlog"  // Files /rdlog0, /rdlog1 ...
+#endif
+#ifndef DEBUG_SPOOL_SEGMENTS
+#define DEBUG_SPOOL_SEGMENTS 4  // Files of the ring
+#endif
+#ifndef DEBUG_SPOOL_SEGMENT_SIZE
+#define DEBUG_SPOOL_SEGMENT_SIZE 16384  // Size of a file, the spool keeps (segments - 1) * size bytes at least
+#endif
+#ifndef DEBUG_SPOOL_PAGE
+#define DEBUG_SPOOL_PAGE 256  // Buffer in RAM, written at once (a page of SPIFFS)
+#endif
+#ifndef DEBUG_SPOOL_FLUSH_TIME
+#define DEBUG_SPOOL_FLUSH_TIME 5000  // Maximum time of a line in the buffer (millis), errors are written at once
+#endif
+#ifndef DEBUG_SPOOL_SYNC_TIME
+#define DEBUG_SPOOL_SYNC_TIME 30000  // Maximum time between flushes of the file (millis), errors are flushed at once
+#endif
+#endif
+
+// Structured logs: Debug.log(Debug.INFO).kv("temp", t).kv("fan", s) - needs ArduinoJson 7
+// The record is serialized once, with no String: binary frames to the web app,
+// a JSON line to telnet, serial and the spool
+// Uncomment this to enable it
+// #define DEBUG_LOG_RECORDS true
+#ifdef DEBUG_LOG_RECORDS
+#ifndef DEBUG_LOG_SIZE
+#define DEBUG_LOG_SIZE 256  // Maximum size of a record serialized (MessagePack and JSON), bigger ones are dropped
+#endif
+// #define DEBUG_LOG_MSGPACK true  // MessagePack in the frames of the web app, instead of JSON
+#endif
+
+// Profiler: DEBUG_SCOPE("name") in a block measures the rest of it (micros), with a histogram
+// by scope in a fixed table, and the time between the calls of handle() (loop time and jitter)
+// The command scopes shows them. A scope costs two micros() and some adds, it can stay enabled
+// Uncomment this to enable it
+// #define DEBUG_SCOPES true
+#ifdef DEBUG_SCOPES
+#ifndef DEBUG_SCOPES_SIZE
+#define DEBUG_SCOPES_SIZE 16  // Scopes in the table (the next ones are not measured)
+#endif
+#define DEBUG_SCOPES_BUCKETS 20  // Histogram: 0, 1, 2-3, 4-7 ... us, the last one from 2^18 us (262 ms)
+#endif
+
 // Enable if you test features yet in development
 // #define ALPHA_VERSION true
 
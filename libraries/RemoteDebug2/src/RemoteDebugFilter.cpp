@@ -0,0 +1,219 @@
+///// RemoteDebug configuration
+#include "RemoteDebugCfg.h"
+
+// Debug enabled ?
+#ifndef DEBUG_DISABLED
+
+/////// Includes
+#include "RemoteDebugFilter.h"  // Filter of the lines, compiled once
+
+#include <string.h>
+
+// Levels of the term level:, by the value of the debug level (RemoteDebug.h)
+static const char FILTER_LEVELS[] = "pvdiwea";
+
+// ASCII lower case, without locale
+static inline uint8_t lowerCase(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+void RemoteDebugFilter::clear() {
+    _count = 0;
+    _includes = 0;
+    _functions = 0;
+    _levels = 0;
+    _active = false;
+}
+
+boolean RemoteDebugFilter::compile(const char* filter) {
+    clear();
+
+    uint8_t used = 0;  // Of _patterns
+    const char* pos = filter;
+    const char* end = filter + strlen(filter);
+
+    // Spaces at the ends are not part of it
+    while (*pos == ' ') {
+        pos++;
+    }
+    while (end > pos && end[-1] == ' ') {
+        end--;
+    }
+    if (pos == end) {
+        return true;
+    }
+
+    boolean ok = true;
+    boolean word = (memchr(pos, ' ', end - pos) == NULL);
+    boolean terms = memchr(pos, '|', end - pos) || memchr(pos, '"', end - pos) ||
+                    (word && (strncmp(pos, "fn:", 3) == 0 || strncmp(pos, "-fn:", 4) == 0 || strncmp(pos, "level:", 6) == 0));
+    if (!terms) {  // One text
+        ok = addPattern(TERM_INCLUDE, pos, end - pos, false, used);
+        pos = end;
+    }
+
+    // Terms separated by |, not in "..."
+    while (ok && pos < end) {
+        const char* term = pos;
+        boolean quoted = false;
+        while (pos < end && (quoted || *pos != '|')) {
+            if (*pos == '"') {
+                quoted = !quoted;
+            }
+            pos++;
+        }
+        ok = addTerm(term, pos - term, used);
+        if (pos < end) {  // |
+            pos++;
+        }
+    }
+
+    if (!ok) {
+        clear();
+        return false;
+    }
+    _active = (_count > 0 || _levels != 0);
+    return true;
+}
+
+// A term, without the spaces around it
+
+boolean RemoteDebugFilter::addTerm(const char* text, size_t size, uint8_t& used) {
+    while (size > 0 && *text == ' ') {
+        text++;
+        size--;
+    }
+    while (size > 0 && text[size - 1] == ' ') {
+        size--;
+    }
+
+    boolean exclude = false;
+    if (size > 1 && *text == '-') {
+        exclude = true;
+        text++;
+        size--;
+    }
+    if (size > 0 && *text == '"') {  // Text as it is
+        const char* end = (const char*)memchr(text + 1, '"', size - 1);
+        size = end ? (size_t)(end - text - 1) : size - 1;
+        return addPattern(exclude ? TERM_EXCLUDE : TERM_INCLUDE, text + 1, size, false, used);
+    }
+    if (size > 3 && strncmp(text, "fn:", 3) == 0) {
+        return addPattern(exclude ? TERM_EXCLUDE : TERM_FUNCTION, text + 3, size - 3, true, used);
+    }
+    if (!exclude && size > 6 && strncmp(text, "level:", 6) == 0) {
+        for (size_t i = 6; i < size; i++) {
+            const char* level = strchr(FILTER_LEVELS, lowerCase(text[i]));
+            if (level == NULL || *level == 0) {
+                return false;
+            }
+            _levels |= (1 << (level - FILTER_LEVELS));
+        }
+        return true;
+    }
+    return addPattern(exclude ? TERM_EXCLUDE : TERM_INCLUDE, text, size, false, used);
+}
+
+// Pattern in lower case and its skip table
+
+boolean RemoteDebugFilter::addPattern(uint8_t type, const char* text, size_t size, boolean function, uint8_t& used) {
+    if (size == 0) {  // Ignored ("")
+        return true;
+    }
+    size_t sizePattern = size + (function ? 2 : 0);  // (name)
+    if (_count == DEBUG_FILTER_TERMS || used + sizePattern > DEBUG_FILTER_SIZE) {
+        return false;
+    }
+
+    Term& term = _terms[_count++];
+    term.type = type;
+    term.start = used;
+    term.size = sizePattern;
+
+    char* pattern = _patterns + used;
+    size_t i = 0;
+    if (function) {
+        pattern[i++] = '(';
+    }
+    for (size_t j = 0; j < size; j++) {
+        pattern[i++] = lowerCase(text[j]);
+    }
+    if (function) {
+        pattern[i++] = ')';
+    }
+    used += sizePattern;
+
+    // Shift by the last character of the window: its last place in the pattern (not the last one),
+    // the characters with the same 5 bits take the smallest shift
+    memset(term.skip, sizePattern, sizeof(term.skip));
+    for (i = 0; i + 1 < sizePattern; i++) {
+        term.skip[(uint8_t)pattern[i] & 0x1F] = sizePattern - 1 - i;
+    }
+
+    if (type == TERM_INCLUDE) {
+        _includes++;
+    } else if (type == TERM_FUNCTION) {
+        _functions++;
+    }
+    return true;
+}
+
+// Boyer-Moore-Horspool, case insensitive
+
+boolean RemoteDebugFilter::find(const Term& term, const char* line, size_t size) const {
+    const char* pattern = _patterns + term.start;
+    size_t last = term.size - 1;
+
+    if (term.size > size) {
+        return false;
+    }
+    for (size_t i = 0; i + last < size;) {
+        uint8_t c = lowerCase(line[i + last]);
+        if (c == (uint8_t)pattern[last]) {
+            size_t j = last;
+            while (j > 0 && lowerCase(line[i + j - 1]) == (uint8_t)pattern[j - 1]) {
+                j--;
+            }
+            if (j == 0) {
+                return true;
+            }
+        }
+        i += term.skip[c & 0x1F];
+    }
+    return false;
+}
+
+boolean RemoteDebugFilter::match(const char* line, size_t size, uint8_t level) const {
+    if (!matchLevel(level)) {
+        return false;
+    }
+
+    // One of the texts, one of the functions, none of the excluded
+    boolean include = (_includes == 0);
+    boolean function = (_functions == 0);
+
+    for (uint8_t i = 0; i < _count && !include; i++) {
+        if (_terms[i].type == TERM_INCLUDE) {
+            include = find(_terms[i], line, size);
+        }
+    }
+    if (!include) {
+        return false;
+    }
+    for (uint8_t i = 0; i < _count && !function; i++) {
+        if (_terms[i].type == TERM_FUNCTION) {
+            function = find(_terms[i], line, size);
+        }
+    }
+    if (!function) {
+        return false;
+    }
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_terms[i].type == TERM_EXCLUDE && find(_terms[i], line, size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif  // DEBUG_DISABLED
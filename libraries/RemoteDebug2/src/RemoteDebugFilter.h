@@ -0,0 +1,94 @@
+/*
+ * Header for RemoteDebugFilter
+ *
+ * Filter of the lines of RemoteDebug (command filter or setFilter),
+ * compiled once and matched over the line buffer, without copy or heap
+ *
+ * MIT License
+ *
+ */
+
+#ifndef REMOTEDEBUGFILTER_H_
+#define REMOTEDEBUGFILTER_H_
+#pragma once
+
+///// RemoteDebug configuration
+#include "RemoteDebugCfg.h"
+
+// Debug enabled ?
+#ifndef DEBUG_DISABLED
+
+#include "Arduino.h"
+
+#if DEBUG_FILTER_SIZE > 255
+#error "DEBUG_FILTER_SIZE must be 255 or less"
+#endif
+
+// A filter is one text, spaces included (as the version 4.0.0): the line has this text (case insensitive)
+//
+// With a | or a " in it, it is terms separated by | (spaces around them are not part of them):
+//
+//   text          the line has this text, one of them if more
+//   "text"        the same, the text can have | or spaces at its ends
+//   -text         the line has not this text (-"text" too)
+//   fn:name       the line is of the function name (debugX macros), one of them if more
+//   -fn:name      the line is not of the function name
+//   level:wie     only the lines of these levels (p v d i w e a)
+//
+// fn:name, -fn:name and level:wie alone are a term too (no text has them)
+//
+// The texts are searched by Boyer-Moore-Horspool, with a skip table of 32 entries
+// (low 5 bits of the lower case character: letters do not collide)
+
+class RemoteDebugFilter {
+   public:
+    // Compile the filter, false if it has too many terms or is too long (the filter is then empty)
+    boolean compile(const char* filter);
+
+    void clear();
+
+    boolean isActive() const {
+        return _active;
+    }
+
+    // The line (without its prefix) of this debug level pass the filter ?
+    boolean match(const char* line, size_t size, uint8_t level) const;
+
+    // Only the level:wie terms (deferred logs, no text to search)
+    boolean matchLevel(uint8_t level) const {
+        return _levels == 0 || (level <= 7 && (_levels & (1 << level)));
+    }
+
+    // Terms on the text of the line (not level:wie only) ?
+    boolean hasText() const {
+        return _count > 0;
+    }
+
+   private:
+    static const uint8_t TERM_INCLUDE = 0;   // text
+    static const uint8_t TERM_FUNCTION = 1;  // fn:name, searched as "(name)"
+    static const uint8_t TERM_EXCLUDE = 2;   // -text or -fn:name
+
+    struct Term {
+        uint8_t type;
+        uint8_t start;     // Of the pattern in _patterns (lower case)
+        uint8_t size;
+        uint8_t skip[32];  // Shift by the last character of the window
+    };
+
+    Term _terms[DEBUG_FILTER_TERMS];
+    char _patterns[DEBUG_FILTER_SIZE];
+    uint8_t _count = 0;       // Terms
+    uint8_t _includes = 0;    // Terms by type
+    uint8_t _functions = 0;
+    uint8_t _levels = 0;      // Bits of the levels shown, 0: all
+    boolean _active = false;
+
+    boolean addTerm(const char* text, size_t size, uint8_t& used);
+    boolean addPattern(uint8_t type, const char* text, size_t size, boolean function, uint8_t& used);
+    boolean find(const Term& term, const char* line, size_t size) const;
+};
+
+#endif  // DEBUG_DISABLED
+
+#endif /* REMOTEDEBUGFILTER_H_ */
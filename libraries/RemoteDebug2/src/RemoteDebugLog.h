@@ -0,0 +1,88 @@
+/*
+ * Header for RemoteDebugLog
+ *
+ * Memory of the structured logs of RemoteDebug (Debug.log(level).kv(key, value)):
+ * the JsonDocument of a record takes its memory from a fixed buffer,
+ * emptied for each record (no heap)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef REMOTEDEBUGLOG_H_
+#define REMOTEDEBUGLOG_H_
+#pragma once
+
+///// RemoteDebug configuration
+#include "RemoteDebugCfg.h"
+
+// Debug enabled ?
+#ifndef DEBUG_DISABLED
+
+// Only if enabled
+#ifdef DEBUG_LOG_RECORDS
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <ArduinoJson.h>  // https://arduinojson.org (version 7)
+
+// A pool of ArduinoJson (ARDUINOJSON_POOL_CAPACITY slots of 2 pointers) and the strings copied
+#ifndef DEBUG_LOG_ARENA
+#define DEBUG_LOG_ARENA (ARDUINOJSON_POOL_CAPACITY * 2 * sizeof(void*) + 256)
+#endif
+
+class RemoteDebugArena : public ArduinoJson::Allocator {
+   public:
+    void* allocate(size_t size) override {
+        size = (size + 7) & ~(size_t)7;
+        if (_used + size > sizeof(_buffer)) {  // Full -> the document overflows
+            return nullptr;
+        }
+        _last = _used;
+        _used += size;
+        return _buffer + _last;
+    }
+
+    void deallocate(void* ptr) override {
+        (void)ptr;  // All at once by reset
+    }
+
+    void* reallocate(void* ptr, size_t size) override {
+        if (!ptr) {
+            return allocate(size);
+        }
+        if (ptr == _buffer + _last) {  // The last one: in place
+            size = (size + 7) & ~(size_t)7;
+            if (_last + size > sizeof(_buffer)) {
+                return nullptr;
+            }
+            _used = _last + size;
+            return ptr;
+        }
+        size_t max = _used - ((uint8_t*)ptr - _buffer);  // At most until the end
+        void* aux = allocate(size);
+        if (aux) {
+            memcpy(aux, ptr, (size < max) ? size : max);
+        }
+        return aux;
+    }
+
+    // Empty, for the next record
+    void reset() {
+        _used = 0;
+        _last = 0;
+    }
+
+   private:
+    alignas(8) uint8_t _buffer[DEBUG_LOG_ARENA];
+    size_t _used = 0;
+    size_t _last = 0;  // Begin of the last block
+};
+
+#endif  // DEBUG_LOG_RECORDS
+
+#endif  // DEBUG_DISABLED
+
+#endif /* REMOTEDEBUGLOG_H_ */
@@ -0,0 +1,132 @@
+///// RemoteDebug configuration
+#include "RemoteDebugCfg.h"
+
+// Debug enabled ?
+#ifndef DEBUG_DISABLED
+
+// Only if enabled
+#ifdef DEBUG_SCOPES
+
+/////// Includes
+#include "RemoteDebugProfiler.h"  // Timing scopes
+
+#include <string.h>
+
+// Internal debug macro - recommended stay disable
+#define D(fmt, ...)
+// use the following line to enable debug
+// #define D(fmt, ...) Serial.printf("rdprof: " fmt "\n", ##__VA_ARGS__);  // Serial debug
+
+// Slot of a scope, added if it is new (once by DEBUG_SCOPE, the lock is not in the path of the times).
+// No wait for the lock: the task adding a scope can have a lower priority on the same core,
+// this call is not measured and the DEBUG_SCOPE asks again the next time
+
+uint8_t RemoteDebugProfiler::slot(const char* name) {
+#ifdef ESP32
+    if (__atomic_test_and_set(&_lock, __ATOMIC_ACQUIRE)) {
+        D("scope %s busy, other is added", name)
+        __atomic_add_fetch(&_busy, 1, __ATOMIC_RELAXED);
+        return BUSY_SLOT;
+    }
+#endif
+
+    uint8_t ret = NO_SLOT;
+    for (uint8_t slot = 0; slot < _size; slot++) {
+        if (strcmp(_scopes[slot].name, name) == 0) {
+            ret = slot;
+            break;
+        }
+    }
+    if (ret == NO_SLOT && _size < DEBUG_SCOPES_SIZE) {
+        ret = _size;
+        _scopes[ret].name = name;
+        __atomic_store_n(&_size, _size + 1, __ATOMIC_RELEASE);
+        D("scope %u: %s", ret, name)
+    }
+
+#ifdef ESP32
+    __atomic_clear(&_lock, __ATOMIC_RELEASE);
+#endif
+    return ret;
+}
+
+// Time between the calls, and its change (jitter)
+
+void RemoteDebugProfiler::loop(uint32_t time) {
+    if (_loopStarted) {
+        uint32_t elapsed = time - _lastLoop;
+        if (_loop.count > 0) {
+            _jitter += (elapsed > _lastElapsed) ? elapsed - _lastElapsed : _lastElapsed - elapsed;
+        }
+        record(_loop, elapsed);
+        _lastElapsed = elapsed;
+    } else {  // Report from here
+        _timeReset = millis();
+    }
+    _lastLoop = time;
+    _loopStarted = true;
+}
+
+void RemoteDebugProfiler::reset() {
+    for (uint8_t slot = 0; slot < _size; slot++) {
+        Scope& scope = _scopes[slot];
+        scope.count = 0;
+        scope.total = 0;
+        scope.totalHigh = 0;
+        scope.max = 0;
+        memset(scope.histogram, 0, sizeof(scope.histogram));
+    }
+    _loop = Scope();
+    _busy = 0;
+    _jitter = 0;
+    _loopStarted = false;
+}
+
+uint32_t RemoteDebugProfiler::getJitter() const {
+    return (_loop.count > 1) ? (uint32_t)(_jitter / (_loop.count - 1)) : 0;
+}
+
+uint32_t RemoteDebugProfiler::getTime() const {
+    return (_loopStarted) ? millis() - _timeReset : 0;
+}
+
+// Insertion sort, few scopes
+
+uint8_t RemoteDebugProfiler::sorted(uint8_t* order) const {
+    uint8_t size = __atomic_load_n(&_size, __ATOMIC_ACQUIRE);
+
+    for (uint8_t i = 0; i < size; i++) {
+        uint8_t j = i;
+        while (j > 0 && getTotal(_scopes[order[j - 1]]) < getTotal(_scopes[i])) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    return size;
+}
+
+uint32_t RemoteDebugProfiler::percentile(const Scope& scope, uint8_t percent) {
+    uint32_t count = 0;
+    for (uint32_t value : scope.histogram) {
+        count += value;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = ((uint64_t)count * percent + 99) / 100;  // Values up to it
+    uint64_t seen = 0;
+    for (uint8_t bucket = 0; bucket < DEBUG_SCOPES_BUCKETS - 1; bucket++) {
+        seen += scope.histogram[bucket];
+        if (seen >= rank) {
+            uint32_t bound = (bucket) ? (1UL << bucket) - 1 : 0;
+            return (bound < scope.max) ? bound : scope.max;
+        }
+    }
+    return scope.max;
+}
+
+#endif  // DEBUG_SCOPES
+
+#endif  // DEBUG_DISABLED
@@ -0,0 +1,163 @@
+/*
+ * Header for RemoteDebugProfiler
+ *
+ * Timing scopes of RemoteDebug (DEBUG_SCOPE), with a histogram by scope in a fixed table,
+ * and the time between the calls of handle() (loop and jitter)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef REMOTEDEBUGPROFILER_H_
+#define REMOTEDEBUGPROFILER_H_
+#pragma once
+
+///// RemoteDebug configuration
+#include "RemoteDebugCfg.h"
+
+// Debug enabled ?
+#ifndef DEBUG_DISABLED
+
+// Only if enabled
+#ifdef DEBUG_SCOPES
+
+#include "Arduino.h"
+
+#if DEBUG_SCOPES_SIZE > 254
+#error "DEBUG_SCOPES_SIZE must be 254 or less"
+#endif
+
+// A scope has a name (a literal, the same name in two places is the same scope), the times measured
+// (micros) are added to it: count, total, max and a histogram by powers of 2
+//
+//   bucket 0: 0 us, bucket n: 2^(n-1) to 2^n - 1 us, the last one: more
+//
+// The percentiles are the upper bound of their bucket. On ESP32 the adds are atomic (tasks in both cores),
+// of 32 bits only (no libatomic): the total has its carries in a second counter.
+
+class RemoteDebugProfiler {
+   public:
+    static const uint8_t NO_SLOT = 0xFF;    // Table full, the scope is not measured
+    static const uint8_t BUSY_SLOT = 0xFE;  // Other task is adding a scope, asked again by the next call
+
+    struct Scope {
+        const char* name = NULL;
+        uint32_t count = 0;
+        uint32_t total = 0;      // micros, low part
+        uint32_t totalHigh = 0;  // Carries of total
+        uint32_t max = 0;
+        uint32_t histogram[DEBUG_SCOPES_BUCKETS] = {};
+    };
+
+    // Slot of a scope by name, BUSY_SLOT if other task is adding one
+    uint8_t slot(const char* name);
+
+    // Slot kept by a DEBUG_SCOPE (static, BUSY_SLOT at first): asked while the table was busy
+    uint8_t slot(uint8_t& cache, const char* name) {
+        uint8_t slot = __atomic_load_n(&cache, __ATOMIC_RELAXED);
+        if (slot == BUSY_SLOT) {
+            slot = this->slot(name);
+            __atomic_store_n(&cache, slot, __ATOMIC_RELAXED);
+        }
+        return slot;
+    }
+
+    // Time of a scope (micros)
+    void add(uint8_t slot, uint32_t elapsed) {
+        if (slot < DEBUG_SCOPES_SIZE) {
+            record(_scopes[slot], elapsed);
+        }
+    }
+
+    // Time between the calls (handle)
+    void loop(uint32_t time);
+
+    // Times to zero, the scopes are kept
+    void reset();
+
+    uint8_t size() const {
+        return _size;
+    }
+    uint32_t getBusy() const {  // Calls not measured, the table was busy
+        return _busy;
+    }
+    const Scope& getScope(uint8_t slot) const {
+        return _scopes[slot];
+    }
+    const Scope& getLoop() const {
+        return _loop;
+    }
+    uint32_t getJitter() const;  // Mean change of the loop time (micros)
+    uint32_t getTime() const;    // Since the reset (millis)
+
+    // Slots ordered by the total time, returns the size
+    uint8_t sorted(uint8_t* order) const;
+
+    // Total of a scope (micros)
+    static uint64_t getTotal(const Scope& scope) {
+        return ((uint64_t)scope.totalHigh << 32) | scope.total;
+    }
+
+    // Upper bound of the bucket of the percentile, max for the last one
+    static uint32_t percentile(const Scope& scope, uint8_t percent);
+
+   private:
+    Scope _scopes[DEBUG_SCOPES_SIZE];
+    uint8_t _size = 0;
+    boolean _lock = false;  // Adding a scope
+    uint32_t _busy = 0;     // Calls with the lock taken by other task
+
+    Scope _loop;                // Time between the calls of loop
+    uint32_t _lastLoop = 0;     // Time of the last call
+    uint32_t _lastElapsed = 0;  // Time of the last loop
+    uint64_t _jitter = 0;       // Sum of the changes of the loop time
+    boolean _loopStarted = false;
+    uint32_t _timeReset = 0;    // First loop after the reset (millis)
+
+    static void record(Scope& scope, uint32_t elapsed) {
+        uint8_t bucket = (elapsed) ? 32 - __builtin_clz(elapsed) : 0;
+        if (bucket >= DEBUG_SCOPES_BUCKETS) {
+            bucket = DEBUG_SCOPES_BUCKETS - 1;
+        }
+#ifdef ESP32
+        __atomic_add_fetch(&scope.count, 1, __ATOMIC_RELAXED);
+        if (__atomic_fetch_add(&scope.total, elapsed, __ATOMIC_RELAXED) > UINT32_MAX - elapsed) {
+            __atomic_add_fetch(&scope.totalHigh, 1, __ATOMIC_RELAXED);
+        }
+        __atomic_add_fetch(&scope.histogram[bucket], 1, __ATOMIC_RELAXED);
+        uint32_t max = __atomic_load_n(&scope.max, __ATOMIC_RELAXED);
+        while (elapsed > max && !__atomic_compare_exchange_n(&scope.max, &max, elapsed, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+#else  // One task
+        scope.count++;
+        if (scope.total > UINT32_MAX - elapsed) {
+            scope.totalHigh++;
+        }
+        scope.total += elapsed;
+        scope.histogram[bucket]++;
+        if (elapsed > scope.max) {
+            scope.max = elapsed;
+        }
+#endif
+    }
+};
+
+// Measures the rest of the block (see DEBUG_SCOPE in RemoteDebug.h)
+class RemoteDebugScope {
+   public:
+    RemoteDebugScope(RemoteDebugProfiler& profiler, uint8_t slot) : _profiler(profiler), _slot(slot), _start(micros()) {}
+    ~RemoteDebugScope() {
+        _profiler.add(_slot, micros() - _start);
+    }
+
+   private:
+    RemoteDebugProfiler& _profiler;
+    uint8_t _slot;
+    uint32_t _start;
+};
+
+#endif  // DEBUG_SCOPES
+
+#endif  // DEBUG_DISABLED
+
+#endif /* REMOTEDEBUGPROFILER_H_ */
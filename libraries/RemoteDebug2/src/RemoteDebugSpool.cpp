@@ -0,0 +1,357 @@
+///// RemoteDebug configuration
+#include "RemoteDebugCfg.h"
+
+// Debug enabled ?
+#ifndef DEBUG_DISABLED
+
+// Only if enabled
+#ifdef DEBUG_SPOOL
+
+/////// Includes
+#include "RemoteDebugSpool.h"  // Spool of the logs on the flash
+
+#include "RemoteDebug.h"  // Debug levels
+
+#include <string.h>
+
+// Internal debug macro - recommended stay disable
+#define D(fmt, ...)
+// use the following line to enable debug
+// #define D(fmt, ...) Serial.printf("rdspool: " fmt "\n", ##__VA_ARGS__);  // Serial debug
+
+// Header of the files and of the records
+static const uint8_t SPOOL_MAGIC[4] = { 'R', 'D', 'S', '1' };
+static const size_t SPOOL_HEADER = 8;
+static const size_t SPOOL_RECORD = 6;
+
+// Text of a record: fits in the buffer, size in one byte
+static const size_t SPOOL_TEXT_MAX = (DEBUG_SPOOL_PAGE - SPOOL_RECORD < 255) ? DEBUG_SPOOL_PAGE - SPOOL_RECORD : 255;
+
+static void putUint32(uint8_t* buffer, uint32_t value) {
+    for (uint8_t i = 0; i < 4; i++) {
+        buffer[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint32_t getUint32(const uint8_t* buffer) {
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+void RemoteDebugSpool::path(char* path, size_t size, uint8_t segment) {
+    snprintf(path, size, "%s%u", DEBUG_SPOOL_PATH, segment);
+}
+
+// Open the spool: the file with the last sequence is the current one
+
+boolean RemoteDebugSpool::begin(fs::FS& fs) {
+    end();
+    _fs = &fs;
+
+    uint8_t header[SPOOL_HEADER];
+    boolean found = false;
+
+    for (uint8_t segment = 0; segment < DEBUG_SPOOL_SEGMENTS; segment++) {
+        char name[32];
+        path(name, sizeof(name), segment);
+        if (!fs.exists(name)) {
+            continue;
+        }
+        fs::File file = fs.open(name, "r");
+        if (file && file.read(header, sizeof(header)) == sizeof(header) && memcmp(header, SPOOL_MAGIC, sizeof(SPOOL_MAGIC)) == 0) {
+            uint32_t sequence = getUint32(header + 4);
+            if (!found || (int32_t)(sequence - _sequence) > 0) {
+                found = true;
+                _segment = segment;
+                _sequence = sequence;
+            }
+        }
+        file.close();
+    }
+
+    if (found) {  // Append to it, if its last record is complete
+        char name[32];
+        path(name, sizeof(name), _segment);
+        fs::File file = fs.open(name, "r");
+        uint32_t size = file ? file.size() : 0;
+        uint32_t complete = completeSize(file);
+        file.close();
+
+        if (complete == size) {
+            _file = fs.open(name, "a");
+            _sizeSegment = _file ? _file.size() : 0;
+        } else {  // Cut by a crash, the reader stops there
+            D("segment %u cut at %u of %u", _segment, complete, size)
+            openSegment((_segment + 1) % DEBUG_SPOOL_SEGMENTS, _sequence + 1);
+        }
+    }
+    if (!_file && !openSegment(0, _sequence + 1)) {
+        D("no file, spool disabled")
+        _fs = NULL;
+        return false;
+    }
+    D("segment %u sequence %u size %u", _segment, _sequence, _sizeSegment)
+
+    write(LEVEL_BOOT, millis(), "", 0);
+    return true;
+}
+
+void RemoteDebugSpool::end() {
+    if (_fs) {
+        flush(true);
+        _file.close();
+        _fs = NULL;
+    }
+}
+
+// Truncate a file and use it
+
+boolean RemoteDebugSpool::openSegment(uint8_t segment, uint32_t sequence) {
+    char name[32];
+    path(name, sizeof(name), segment);
+
+    _file.close();
+    _file = _fs->open(name, "w");
+    if (!_file) {
+        return false;
+    }
+
+    uint8_t header[SPOOL_HEADER];
+    memcpy(header, SPOOL_MAGIC, sizeof(SPOOL_MAGIC));
+    putUint32(header + 4, sequence);
+    _file.write(header, sizeof(header));
+    _stats.written += sizeof(header);
+
+    _segment = segment;
+    _sequence = sequence;
+    _sizeSegment = sizeof(header);
+    return true;
+}
+
+// Size of the header and the complete records of a file (in the buffer)
+
+uint32_t RemoteDebugSpool::completeSize(fs::File& file) {
+    if (!file || file.read(_buffer, SPOOL_HEADER) != SPOOL_HEADER) {
+        return 0;
+    }
+
+    uint32_t complete = SPOOL_HEADER;
+    size_t size = 0;
+    int count;
+    while ((count = file.read(_buffer + size, sizeof(_buffer) - size)) > 0) {
+        size += count;
+
+        size_t pos = 0;
+        while (pos + SPOOL_RECORD <= size && pos + SPOOL_RECORD + _buffer[pos + 5] <= size) {
+            pos += SPOOL_RECORD + _buffer[pos + 5];
+        }
+        complete += pos;
+        memmove(_buffer, _buffer + pos, size - pos);
+        size -= pos;
+    }
+    return complete;
+}
+
+// Add a record to the buffer, write it if it is full
+
+void RemoteDebugSpool::write(uint8_t level, uint32_t time, const char* text, size_t size) {
+    if (!_fs || _reading) {
+        _stats.dropped++;
+        return;
+    }
+
+    if (size > SPOOL_TEXT_MAX) {
+        size = SPOOL_TEXT_MAX;
+    }
+    if (_sizeBuffer + SPOOL_RECORD + size > sizeof(_buffer)) {
+        flush();
+    }
+    if (_sizeBuffer == 0) {
+        _timeBuffer = millis();
+    }
+
+    uint8_t* record = _buffer + _sizeBuffer;
+    record[0] = level;
+    putUint32(record + 1, time);
+    record[5] = (uint8_t)size;
+    memcpy(record + SPOOL_RECORD, text, size);
+    _sizeBuffer += SPOOL_RECORD + size;
+
+    _stats.lines++;
+    _stats.bytes += SPOOL_RECORD + size;
+
+    if (level == RemoteDebug::ERROR || level == LEVEL_BOOT) {  // Error: before a crash ?
+        flush(true);
+    }
+}
+
+// One write of the buffer, to the next file if this one is full
+
+void RemoteDebugSpool::flush(boolean sync) {
+    if (!_fs || _sizeBuffer == 0) {
+        return;
+    }
+
+    uint32_t start = micros();
+
+    if (_sizeSegment + _sizeBuffer > DEBUG_SPOOL_SEGMENT_SIZE) {
+        if (!openSegment((_segment + 1) % DEBUG_SPOOL_SEGMENTS, _sequence + 1)) {
+            D("error opening the next file")
+            _stats.dropped++;
+            _sizeBuffer = 0;
+            return;
+        }
+    }
+
+    size_t written = _file.write(_buffer, _sizeBuffer);
+    if (sync || (millis() - _timeSync) >= DEBUG_SPOOL_SYNC_TIME) {
+        _file.flush();
+        _timeSync = millis();
+        _stats.syncs++;
+    }
+    _sizeSegment += written;
+    _sizeBuffer = 0;
+
+    uint32_t elapsed = micros() - start;
+    _stats.written += written;
+    _stats.flushes++;
+    _stats.flushTime += elapsed;
+    if (elapsed > _stats.flushTimeMax) {
+        _stats.flushTimeMax = elapsed;
+    }
+}
+
+void RemoteDebugSpool::handle() {
+    if (_sizeBuffer > 0 && (millis() - _timeBuffer) >= DEBUG_SPOOL_FLUSH_TIME) {
+        flush();
+    }
+}
+
+// Read the files from the oldest one (the next of the current), in the buffer
+
+struct ReadAll {
+    RemoteDebugSpool::Callback callback;
+    void* arg;
+};
+
+static boolean readAll(void* arg, uint8_t level, uint32_t time, const char* text, size_t size) {
+    ReadAll& all = *(ReadAll*)arg;
+    return all.callback(all.arg, level, time, text, size);
+}
+
+void RemoteDebugSpool::read(Callback callback, void* arg) {
+    Cursor cursor;
+    ReadAll all = { callback, arg };
+
+    readBegin(cursor);
+    read(cursor, readAll, &all);
+}
+
+// The files follow the ring with the next sequence: the ones not found (or used again) are skipped
+
+void RemoteDebugSpool::readBegin(Cursor& cursor) {
+    flush();
+
+    cursor.segment = (_segment + 1) % DEBUG_SPOOL_SEGMENTS;
+    cursor.sequence = _sequence - (DEBUG_SPOOL_SEGMENTS - 1);
+    cursor.offset = SPOOL_HEADER;
+    cursor.endSequence = _sequence;
+    cursor.endOffset = _sizeSegment;
+}
+
+boolean RemoteDebugSpool::read(Cursor& cursor, Callback callback, void* arg) {
+    if (!_fs) {
+        return false;
+    }
+    flush();
+    _reading = true;
+
+    boolean taken = true;
+    while (taken && (int32_t)(cursor.sequence - cursor.endSequence) <= 0) {
+        char name[32];
+        path(name, sizeof(name), cursor.segment);
+        uint32_t end = (cursor.sequence == cursor.endSequence) ? cursor.endOffset : UINT32_MAX;
+
+        fs::File file;
+        if (_fs->exists(name)) {
+            file = _fs->open(name, "r");
+        }
+        if (file && file.read(_buffer, SPOOL_HEADER) == SPOOL_HEADER && memcmp(_buffer, SPOOL_MAGIC, sizeof(SPOOL_MAGIC)) == 0 &&
+            getUint32(_buffer + 4) == cursor.sequence && file.seek(cursor.offset)) {
+            size_t size = 0;
+            int count;
+            while (taken && cursor.offset < end && (count = file.read(_buffer + size, sizeof(_buffer) - size)) > 0) {
+                size += count;
+
+                // Records complete in the buffer, the rest is moved to the begin
+                size_t pos = 0;
+                while (pos + SPOOL_RECORD <= size && pos + SPOOL_RECORD + _buffer[pos + 5] <= size && cursor.offset + pos < end) {
+                    const uint8_t* record = _buffer + pos;
+                    if (!callback(arg, record[0], getUint32(record + 1), (const char*)record + SPOOL_RECORD, record[5])) {
+                        taken = false;
+                        break;
+                    }
+                    pos += SPOOL_RECORD + record[5];
+                }
+                cursor.offset += pos;
+                memmove(_buffer, _buffer + pos, size - pos);
+                size -= pos;
+            }
+        }
+        file.close();
+
+        if (taken) {  // Next file
+            cursor.segment = (cursor.segment + 1) % DEBUG_SPOOL_SEGMENTS;
+            cursor.sequence++;
+            cursor.offset = SPOOL_HEADER;
+        }
+    }
+
+    _reading = false;
+    return !taken;
+}
+
+// Remove the files, the next sequence is used
+
+void RemoteDebugSpool::clear() {
+    if (!_fs) {
+        return;
+    }
+    _sizeBuffer = 0;
+    _file.close();
+    for (uint8_t segment = 0; segment < DEBUG_SPOOL_SEGMENTS; segment++) {
+        char name[32];
+        path(name, sizeof(name), segment);
+        if (_fs->exists(name)) {
+            _fs->remove(name);
+        }
+    }
+    if (!openSegment(0, _sequence + 1)) {
+        _fs = NULL;
+    }
+}
+
+uint32_t RemoteDebugSpool::size() {
+    if (!_fs) {
+        return 0;
+    }
+    uint32_t size = _sizeBuffer;
+
+    for (uint8_t segment = 0; segment < DEBUG_SPOOL_SEGMENTS; segment++) {
+        if (segment == _segment) {
+            size += _sizeSegment;
+            continue;
+        }
+        char name[32];
+        path(name, sizeof(name), segment);
+        if (_fs->exists(name)) {
+            fs::File file = _fs->open(name, "r");
+            size += file ? file.size() : 0;
+            file.close();
+        }
+    }
+    return size;
+}
+
+#endif  // DEBUG_SPOOL
+
+#endif  // DEBUG_DISABLED
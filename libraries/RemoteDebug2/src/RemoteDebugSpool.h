@@ -0,0 +1,135 @@
+/*
+ * Header for RemoteDebugSpool
+ *
+ * Spool of the logs of RemoteDebug on the flash (SPIFFS or LittleFS),
+ * to see the logs of the boot or before a crash, when no client was connected
+ *
+ * MIT License
+ *
+ */
+
+#ifndef REMOTEDEBUGSPOOL_H_
+#define REMOTEDEBUGSPOOL_H_
+#pragma once
+
+///// RemoteDebug configuration
+#include "RemoteDebugCfg.h"
+
+// Debug enabled ?
+#ifndef DEBUG_DISABLED
+
+// Only if enabled
+#ifdef DEBUG_SPOOL
+
+#include "Arduino.h"
+
+#include <FS.h>
+
+#if DEBUG_SPOOL_PAGE < 64 || DEBUG_SPOOL_PAGE > 4096
+#error "DEBUG_SPOOL_PAGE must be between 64 and 4096"
+#endif
+
+// Segmented ring of files: DEBUG_SPOOL_PATH0 ... DEBUG_SPOOL_PATH(n-1), only appended.
+// When a file has DEBUG_SPOOL_SEGMENT_SIZE bytes, the next one (the oldest) is truncated and used.
+//
+//   file:    'R' 'D' 'S' '1', sequence (4, little endian, the file with the last one is the current)
+//   record:  level (1, 0xFF: boot), time (4, millis), size (1), text
+//
+// The records are staged in a buffer of DEBUG_SPOOL_PAGE bytes, written when it is full,
+// after DEBUG_SPOOL_FLUSH_TIME or at once for an error. The same buffer is used to read the files.
+// The file is flushed (index of the file on the flash) for an error or a boot, else at most
+// each DEBUG_SPOOL_SYNC_TIME: a flush by page would write the index for each page.
+// A record cut by a crash ends the file: the next boot continues in the next file.
+
+class RemoteDebugSpool {
+   public:
+    static const uint8_t LEVEL_BOOT = 0xFF;  // Record of a boot (no text)
+
+    // Measurements of the writes, see the command spool stats
+    struct Stats {
+        uint32_t lines = 0;         // Records
+        uint32_t bytes = 0;         // Of the records
+        uint32_t written = 0;       // Bytes written to the files (with the headers)
+        uint32_t flushes = 0;       // Writes of the buffer
+        uint32_t syncs = 0;         // Flushes of the file
+        uint32_t flushTime = 0;     // Total time of them (micros)
+        uint32_t flushTimeMax = 0;  // The longest one (micros)
+        uint32_t dropped = 0;       // Records not written (reading or error of the file)
+    };
+
+    // Record read, the text is in the buffer of the spool (valid only in the callback)
+    // Returns false to stop: no room for it, the record is read again by the next read
+    typedef boolean (*Callback)(void* arg, uint8_t level, uint32_t time, const char* text, size_t size);
+
+    // Position of a read in pieces (the command spool sends what the window of the client takes)
+    struct Cursor {
+        uint8_t segment = 0;       // File in read
+        uint32_t sequence = 0;     // Its sequence (the file was used again if it is other)
+        uint32_t offset = 0;       // Next record in it
+        uint32_t endSequence = 0;  // Current file at the begin of the read
+        uint32_t endOffset = 0;    // and its size then (the records after it are shown as written)
+    };
+
+    // Open the spool in a filesystem mounted by the sketch, add a record of boot
+    boolean begin(fs::FS& fs);
+
+    // Write what is in the buffer and close it
+    void end();
+
+    boolean isActive() const {
+        return _fs != NULL;
+    }
+
+    // Add a record (text without the new line)
+    void write(uint8_t level, uint32_t time, const char* text, size_t size);
+
+    // Write the buffer to the file, and flush the file if sync
+    void flush(boolean sync = false);
+
+    // Write the buffer after DEBUG_SPOOL_FLUSH_TIME (in handle)
+    void handle();
+
+    // Read all the records, from the oldest
+    void read(Callback callback, void* arg);
+
+    // Read in pieces: from the oldest record up to the last one written now,
+    // the records from the cursor until the callback stops, returns false at the end
+    void readBegin(Cursor& cursor);
+    boolean read(Cursor& cursor, Callback callback, void* arg);
+
+    // Remove the files
+    void clear();
+
+    // Bytes in the files and in the buffer
+    uint32_t size();
+
+    const Stats& getStats() const {
+        return _stats;
+    }
+
+   private:
+    fs::FS* _fs = NULL;
+    fs::File _file;
+    uint8_t _segment = 0;        // Current file
+    uint32_t _sequence = 0;      // Of the current file
+    uint32_t _sizeSegment = 0;   // Size of the current file
+    boolean _reading = false;    // The buffer is used to read
+
+    uint8_t _buffer[DEBUG_SPOOL_PAGE];
+    uint16_t _sizeBuffer = 0;
+    uint32_t _timeBuffer = 0;    // Time of the first record in the buffer (millis)
+    uint32_t _timeSync = 0;      // Last flush of the file (millis)
+    boolean _sync = false;       // An error in the buffer: flush the file with it
+
+    Stats _stats;
+
+    void path(char* path, size_t size, uint8_t segment);
+    boolean openSegment(uint8_t segment, uint32_t sequence);
+    uint32_t completeSize(fs::File& file);
+};
+
+#endif  // DEBUG_SPOOL
+
+#endif  // DEBUG_DISABLED
+
+#endif /* REMOTEDEBUGSPOOL_H_ */
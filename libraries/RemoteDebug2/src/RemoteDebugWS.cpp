@@ -29,8 +29,8 @@
 static WebSocketsServer WebSocketServer(WEBSOCKET_PORT);  // Websocket server on port 81
 
 // Variables used by webSocketEvent
-static int8_t _webSocketConnected = WS_NOT_CONNECTED;  // Client is connected ?
-static RemoteDebugWSCallbacks* _callbacks;             // callbacks to RemoteDebug
+static int8_t _webSocketClient = WS_NOT_CONNECTED;  // Client of the writes (select)
+static RemoteDebugWSCallbacks* _callbacks;          // callbacks to RemoteDebug
 
 // Initialize the socket server
 void RemoteDebugWS::begin(RemoteDebugWSCallbacks* callbacks) {
@@ -50,37 +50,25 @@ void RemoteDebugWS::stop() {
     // Finalize  (RemoteDebugApp)
 
     WebSocketServer.close();
-    _webSocketConnected = WS_NOT_CONNECTED;
+    _webSocketClient = WS_NOT_CONNECTED;
     D("socket server stopped")
 }
 
 void RemoteDebugWS::disconnectAllClients() {
-    // Disconnect all clients
+    // Disconnect all clients (the events call onDisconnect)
+    select(WS_NOT_CONNECTED);
     WebSocketServer.disconnect();
-
-    // Disconnected
-    _webSocketConnected = WS_NOT_CONNECTED;
-
-    // Callback
-    if (_callbacks) {
-        _callbacks->onDisconnect();
-    }
     D("disconnectAllClients")
 }
 
-void RemoteDebugWS::disconnect() {
-    D("disconnect")
-    // Disconnect actual clients
-    if (_webSocketConnected != WS_NOT_CONNECTED) {
-        WebSocketServer.disconnect(_webSocketConnected);
-
-        // Disconnected
-        _webSocketConnected = WS_NOT_CONNECTED;
-
-        // Callback
-        if (_callbacks) {
-            _callbacks->onDisconnect();
+void RemoteDebugWS::disconnect(int8_t num) {
+    D("disconnect %d", num)
+    // Disconnect the client (the event calls onDisconnect)
+    if (num != WS_NOT_CONNECTED) {
+        if (num == _webSocketClient) {
+            select(WS_NOT_CONNECTED);
         }
+        WebSocketServer.disconnect(num);
     }
 }
 
@@ -91,10 +79,40 @@ void RemoteDebugWS::handle() {
 
 // Is connected ?
 boolean RemoteDebugWS::isConnected() {
-    return (_webSocketConnected != WS_NOT_CONNECTED);
+    return (WebSocketServer.connectedClients() > 0);
 }
 
 // Print
+// Lines are sent as text messages to the client selected, buffered in a fixed buffer
+static char _bufferWS[BUFFER_PREFIX + BUFFER_PRINT];
+static size_t _sizeBufferWS = 0;
+
+void RemoteDebugWS::select(int8_t num) {
+    if (num == _webSocketClient) {
+        return;
+    }
+
+    // Rest of a line to the client before
+    if (_sizeBufferWS > 0 && _webSocketClient != WS_NOT_CONNECTED) {
+        WebSocketServer.sendTXT(_webSocketClient, _bufferWS, _sizeBufferWS);
+    }
+    _sizeBufferWS = 0;
+    _webSocketClient = num;
+}
+
+// Binary message to a client, after the rest of a line to it
+
+void RemoteDebugWS::sendBinary(int8_t num, const uint8_t* data, size_t size) {
+    if (num == WS_NOT_CONNECTED) {
+        return;
+    }
+    if (num == _webSocketClient && _sizeBufferWS > 0) {
+        WebSocketServer.sendTXT(_webSocketClient, _bufferWS, _sizeBufferWS);
+        _sizeBufferWS = 0;
+    }
+    WebSocketServer.sendBIN(num, data, size);
+}
+
 size_t RemoteDebugWS::write(const uint8_t* buffer, size_t size) {
     if (size != 0) {
         D("write: %u characters", size)
@@ -103,31 +121,29 @@ size_t RemoteDebugWS::write(const uint8_t* buffer, size_t size) {
     }
 
     for (size_t i = 0; i < size; i++) {
-        write((uint8_t)buffer[i]);
-    }
+        uint8_t character = buffer[i];
 
-    return size;
-}
+        // Process
+        if (character == '\n' || _sizeBufferWS == sizeof(_bufferWS)) {
+            if (_webSocketClient != WS_NOT_CONNECTED) {
+                D("write send buf[%u]", _sizeBufferWS);
+                WebSocketServer.sendTXT(_webSocketClient, _bufferWS, _sizeBufferWS);
+            }
 
-size_t RemoteDebugWS::write(uint8_t character) {
-    static String buffer = "";
-    size_t ret = 0;
-
-    // Process
-    if (character == '\n') {
-        if (_webSocketConnected != WS_NOT_CONNECTED) {
-            D("write send buf[%u]: %s", buffer.length(), buffer.c_str());
-            WebSocketServer.sendTXT(_webSocketConnected, buffer.c_str(), buffer.length());
+            // Empty the buffer
+            _sizeBufferWS = 0;
         }
 
-        // Empty the buffer
-        ret = buffer.length();
-        buffer = "";
-    } else if (character != '\r' && isPrintable(character)) {
-        buffer.concat((char)character);
+        if (character != '\n' && character != '\r' && isPrintable(character)) {
+            _bufferWS[_sizeBufferWS++] = (char)character;
+        }
     }
 
-    return ret;
+    return size;
+}
+
+size_t RemoteDebugWS::write(uint8_t character) {
+    return write(&character, 1);
 }
 
 // Destructor
@@ -138,46 +154,35 @@ RemoteDebugWS::~RemoteDebugWS() {
 /////// WebSocket to comunicate with RemoteDebugApp
 void webSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t payloadlength) {  // When a WebSocket message is received
 
-    IPAddress localip;
-
     switch (type) {
         case WStype_DISCONNECTED:  // if the websocket is disconnected
 
             D("[%u] Disconnected!", num);
 
             // Disconnected
-            _webSocketConnected = WS_NOT_CONNECTED;
+            if (num == _webSocketClient) {
+                _webSocketClient = WS_NOT_CONNECTED;
+                _sizeBufferWS = 0;
+            }
 
             // Callback
             if (_callbacks) {
-                _callbacks->onDisconnect();
+                _callbacks->onDisconnect(num);
             }
 
             break;
         case WStype_CONNECTED:  // if a new websocket connection is established
         {
-#ifdef D
-            IPAddress ip = WebSocketServer.remoteIP(num);
-            D("[%u] Connected from %d.%d.%d.%d url: %s", num, ip[0], ip[1], ip[2], ip[3], payload);
-#endif
-
-            // Have in another connection
-            // One connection to reduce overheads
-            if (num != _webSocketConnected) {
-                D("Another connection, closing ...")
-                WebSocketServer.sendTXT(_webSocketConnected, "* Closing client connection ...");
-                WebSocketServer.disconnect(_webSocketConnected);
-            }
+            D("[%u] Connected url: %s", num, payload);
 
-            // Set as connected
-            _webSocketConnected = num;
+            // More than one connection: RemoteDebug closes it if it has no free client
 
             // Send initial message
-            WebSocketServer.sendTXT(_webSocketConnected, "$app:I");
+            WebSocketServer.sendTXT(num, "$app:I");
 
             // Callback
             if (_callbacks) {
-                _callbacks->onConnect();
+                _callbacks->onConnect(num);
             }
         } break;
 
@@ -191,7 +196,7 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t payload
 
             // Callback
             if (_callbacks) {
-                _callbacks->onReceive((const char*)payload);
+                _callbacks->onReceive(num, (const char*)payload);
             }
 
         } break;
@@ -199,11 +204,8 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t payload
         case WStype_ERROR:  // if new text data is received
             D("Error")
             // Disconnected
-            _webSocketConnected = WS_NOT_CONNECTED;
-
-            // Callback
             if (_callbacks) {
-                _callbacks->onDisconnect();
+                _callbacks->onDisconnect(num);
             }
 
             break;
@@ -216,11 +218,8 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t payload
         default:
             D("WStype %x not handled ", type)
             // Disconnected
-            _webSocketConnected = WS_NOT_CONNECTED;
-
-            // Callback
             if (_callbacks) {
-                _callbacks->onDisconnect();
+                _callbacks->onDisconnect(num);
             }
     }
 }
@@ -50,9 +50,9 @@
 class RemoteDebugWSCallbacks {
    public:
     virtual ~RemoteDebugWSCallbacks() {}
-    virtual void onConnect() = 0;
-    virtual void onDisconnect() = 0;
-    virtual void onReceive(const char* message) = 0;
+    virtual void onConnect(uint8_t num) = 0;
+    virtual void onDisconnect(uint8_t num) = 0;
+    virtual void onReceive(uint8_t num, const char* message) = 0;
 };
 
 ///// Main Class
@@ -61,9 +61,11 @@ class RemoteDebugWS : public Print {
     void begin(RemoteDebugWSCallbacks* callbacks);
     void stop();
     void disconnectAllClients();
-    void disconnect();
+    void disconnect(int8_t num);
     boolean isConnected();
     void handle();
+    void select(int8_t num);  // Client of the next writes
+    void sendBinary(int8_t num, const uint8_t* data, size_t size);  // Binary message (structured logs)
 
     // Print
     virtual size_t write(uint8_t);
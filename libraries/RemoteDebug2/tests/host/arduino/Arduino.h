@@ -0,0 +1,48 @@
+/*
+ * Arduino.h for the host build of RemoteDebug (Linux / macOS)
+ *
+ * The Arduino core API of the WebSockets host build (String, Print, millis ...)
+ * with Serial, ESP and the core id of the ESP32.
+ *
+ * MIT License
+ *
+ */
+
+#ifndef HOST_REMOTEDEBUG_ARDUINO_H_
+#define HOST_REMOTEDEBUG_ARDUINO_H_
+
+// Arduino.h of the WebSockets host build
+#include_next <Arduino.h>
+
+#include "Esp.h"
+
+typedef bool boolean;
+
+///// Serial - output is counted and dropped
+
+class HardwareSerial : public Print {
+   public:
+    void begin(unsigned long baud) {
+        (void)baud;
+    }
+    size_t write(uint8_t character) {
+        return write(&character, 1);
+    }
+    size_t write(const uint8_t* buffer, size_t size) {
+        (void)buffer;
+        bytes += size;
+        return size;
+    }
+    using Print::write;
+
+    size_t bytes = 0;  // Bytes written
+};
+
+extern HardwareSerial Serial;
+
+// ESP32 -> Multicore
+inline int xPortGetCoreID() {
+    return 1;
+}
+
+#endif /* HOST_REMOTEDEBUG_ARDUINO_H_ */
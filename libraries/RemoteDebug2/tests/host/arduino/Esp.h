@@ -0,0 +1,29 @@
+/*
+ * Esp.h for the host build of RemoteDebug
+ *
+ * MIT License
+ *
+ */
+
+#ifndef HOST_REMOTEDEBUG_ESP_H_
+#define HOST_REMOTEDEBUG_ESP_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+class EspClass {
+   public:
+    uint32_t getFreeHeap() {
+        return 200000;
+    }
+    const char* getSdkVersion() {
+        return "host";
+    }
+    void restart() {
+        exit(0);
+    }
+};
+
+extern EspClass ESP;
+
+#endif /* HOST_REMOTEDEBUG_ESP_H_ */
@@ -0,0 +1,68 @@
+/*
+ * FS.cpp for the host build of RemoteDebug
+ *
+ * MIT License
+ *
+ */
+
+#include "FS.h"
+
+#include <string.h>
+
+namespace fs {
+
+// Appended at the end (the modes of RemoteDebugSpool: "w" and "a")
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!_data || size == 0) {
+        return 0;
+    }
+    _data->insert(_data->end(), buffer, buffer + size);
+    _position = _data->size();
+    _dirty = true;
+
+    FS::Stats& stats = _fs->stats;
+    stats.writes++;
+    stats.bytes += size;
+    stats.programmed += size;
+    return size;
+}
+
+int File::read(uint8_t* buffer, size_t size) {
+    if (!_data || _position >= _data->size()) {
+        return 0;
+    }
+    if (size > _data->size() - _position) {
+        size = _data->size() - _position;
+    }
+    memcpy(buffer, _data->data() + _position, size);
+    _position += size;
+    return size;
+}
+
+void File::flush() {
+    if (_data && _dirty) {
+        _fs->stats.programmed += FS::PAGE;  // Index of the file
+        _fs->stats.flushes++;
+        _dirty = false;
+    }
+}
+
+File FS::open(const char* path, const char* mode) {
+    File file;
+    auto found = _files.find(path);
+
+    if (mode[0] == 'w' || (mode[0] == 'a' && found == _files.end())) {
+        file._data = std::make_shared<std::vector<uint8_t>>();
+        _files[path] = file._data;
+        stats.programmed += PAGE;  // Header of the file
+    } else if (found != _files.end()) {
+        file._data = found->second;
+    }
+    if (file._data && mode[0] == 'a') {
+        file._position = file._data->size();
+    }
+    file._fs = this;
+    return file;
+}
+
+}  // namespace fs
@@ -0,0 +1,93 @@
+/*
+ * FS.h for the host build of RemoteDebug
+ *
+ * Files in memory, with the API of the FS of the ESP8266 / ESP32 cores used by RemoteDebugSpool.
+ * The writes are counted as a flash with SPIFFS would do them (FS::Stats): the data is programmed
+ * after the data of the last page, each flush writes a new page of the index of the file (its size)
+ * and each new file a page of header.
+ *
+ * MIT License
+ *
+ */
+
+#ifndef HOST_REMOTEDEBUG_FS_H_
+#define HOST_REMOTEDEBUG_FS_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+namespace fs {
+
+class FS;
+
+class File {
+   public:
+    File() {}
+
+    explicit operator bool() const {
+        return _data != nullptr;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size);
+    size_t write(uint8_t character) {
+        return write(&character, 1);
+    }
+    int read(uint8_t* buffer, size_t size);
+    bool seek(uint32_t position) {
+        if (!_data || position > _data->size()) {
+            return false;
+        }
+        _position = position;
+        return true;
+    }
+    size_t size() const {
+        return _data ? _data->size() : 0;
+    }
+    void flush();
+    void close() {
+        _data = nullptr;
+    }
+
+   private:
+    friend class FS;
+
+    std::shared_ptr<std::vector<uint8_t>> _data;
+    size_t _position = 0;
+    bool _dirty = false;  // Written since the last flush
+    FS* _fs = nullptr;
+};
+
+class FS {
+   public:
+    static const size_t PAGE = 256;  // Page of SPIFFS
+
+    struct Stats {
+        size_t writes = 0;      // Calls
+        size_t bytes = 0;       // Of the data
+        size_t programmed = 0;  // Bytes programmed in the flash: data, index and headers
+        size_t flushes = 0;     // With data
+    };
+    Stats stats;
+
+    File open(const char* path, const char* mode = "r");
+    bool exists(const char* path) {
+        return _files.count(path) > 0;
+    }
+    bool remove(const char* path) {
+        return _files.erase(path) > 0;
+    }
+
+   private:
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> _files;
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif /* HOST_REMOTEDEBUG_FS_H_ */
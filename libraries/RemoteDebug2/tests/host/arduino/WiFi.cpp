@@ -0,0 +1,20 @@
+/*
+ * Globals of the host build of RemoteDebug
+ *
+ * MIT License
+ *
+ */
+
+#include "WiFi.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+
+size_t WiFiClient::bytes = 0;
+size_t WiFiClient::writes = 0;
+bool WiFiClient::capture = false;
+std::string WiFiClient::received;
+std::vector<WiFiClient::Connection> WiFiClient::connections;
+
+std::deque<int> WiFiServer::_pending;
@@ -0,0 +1,157 @@
+/*
+ * WiFi.h for the host build of RemoteDebug
+ *
+ * No network: telnet clients are connected with WiFiServer::connectClient(),
+ * the bytes sent to them go to WiFiClient::received (and to their connection),
+ * the input of a connection is read by RemoteDebug as commands.
+ * The window of a connection (free space of the TCP send buffer) can be limited, as a slow client.
+ *
+ * MIT License
+ *
+ */
+
+#ifndef HOST_REMOTEDEBUG_WIFI_H_
+#define HOST_REMOTEDEBUG_WIFI_H_
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include "IPAddress.h"
+
+///// Client - bytes written are counted, and kept if capture is set
+///// Each connection has an id: its state is shared by the copies of the client
+
+class WiFiClient : public Stream {
+   public:
+    uint8_t connected() {
+        return _id >= 0 && connections[_id].connected;
+    }
+    explicit operator bool() {
+        return connected();
+    }
+    void stop() {
+        if (_id >= 0) {
+            connections[_id].connected = false;
+        }
+    }
+    void setNoDelay(bool noDelay) {
+        (void)noDelay;
+    }
+    IPAddress remoteIP() {  // One host by connection, unless connected with the host of another
+        return IPAddress(10, 0, 0, (_id >= 0) ? connections[_id].host : 0);
+    }
+
+    int available() {
+        return (_id >= 0) ? connections[_id].input.length() : 0;
+    }
+    int read() {
+        if (available() == 0) {
+            return -1;
+        }
+        char character = connections[_id].input[0];
+        connections[_id].input.erase(0, 1);
+        return (uint8_t)character;
+    }
+    int peek() {
+        return (available() > 0) ? (uint8_t)connections[_id].input[0] : -1;
+    }
+
+    int availableForWrite() {
+        return (_id >= 0 && connections[_id].window >= 0) ? connections[_id].window : 5744;  // 4 segments
+    }
+
+    size_t write(uint8_t character) {
+        return write(&character, 1);
+    }
+    size_t write(const uint8_t* buffer, size_t size) {
+        if (_id >= 0 && connections[_id].window >= 0) {  // Limited: the stack takes only the window
+            size = ((int)size < connections[_id].window) ? size : connections[_id].window;
+            connections[_id].window -= size;
+        }
+        bytes += size;
+        writes++;
+        if (capture) {
+            received.append((const char*)buffer, size);
+            if (_id >= 0) {
+                connections[_id].received.append((const char*)buffer, size);
+            }
+        }
+        return size;
+    }
+    using Print::write;
+
+    struct Connection {
+        bool connected = true;
+        uint8_t host = 0;
+        std::string input;     // Bytes to read (sent by the test)
+        std::string received;  // Bytes sent to this connection, if capture is set
+        int window = -1;       // Free bytes of the TCP window, -1: no limit
+    };
+
+    static size_t bytes;          // Bytes sent to the clients
+    static size_t writes;         // Calls of write
+    static bool capture;          // Keep the bytes in received ?
+    static std::string received;  // Bytes sent, if capture is set
+    static std::vector<Connection> connections;
+
+   private:
+    friend class WiFiServer;
+    int _id = -1;
+};
+
+///// Server - accepts the clients connected by connectClient()
+
+class WiFiServer {
+   public:
+    explicit WiFiServer(uint16_t port)
+        : _port(port) {}
+
+    void begin() {}
+    void stop() {}
+    void setNoDelay(bool noDelay) {
+        (void)noDelay;
+    }
+
+    bool hasClient() {
+        return !_pending.empty();
+    }
+    WiFiClient available() {
+        WiFiClient client;
+        if (!_pending.empty()) {
+            client._id = _pending.front();
+            _pending.pop_front();
+        }
+        return client;
+    }
+
+    // Connect a client, accepted in the next RemoteDebug::handle()
+    // Returns the id of the connection (in WiFiClient::connections)
+    // sameHostAs: id of a connection from the same host (reconnect), else a new host
+    static int connectClient(int sameHostAs = -1) {
+        WiFiClient::Connection connection;
+        connection.host = (sameHostAs >= 0) ? WiFiClient::connections[sameHostAs].host : (uint8_t)(WiFiClient::connections.size() % 250 + 1);
+        WiFiClient::connections.push_back(connection);
+        _pending.push_back(WiFiClient::connections.size() - 1);
+        return WiFiClient::connections.size() - 1;
+    }
+
+   private:
+    uint16_t _port;
+    static std::deque<int> _pending;
+};
+
+class WiFiClass {
+   public:
+    IPAddress localIP() {
+        return IPAddress(127, 0, 0, 1);
+    }
+    String macAddress() {
+        return "00:00:00:00:00:00";
+    }
+};
+
+extern WiFiClass WiFi;
+
+#endif /* HOST_REMOTEDEBUG_WIFI_H_ */
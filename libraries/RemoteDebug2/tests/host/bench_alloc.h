@@ -0,0 +1,85 @@
+/*
+ * bench_alloc.h - heap allocations and time of the benchmarks (host build)
+ *
+ *  - allocations counts operator new (String on the host) and malloc / realloc
+ *    (linked with -Wl,--wrap=malloc -Wl,--wrap=realloc and BENCH_WRAP_MALLOC on Linux)
+ *  - now() is the monotonic time in us
+ *
+ * it replaces the global operator new / delete: included by the file of main() only.
+ *
+ * MIT License
+ *
+ */
+
+#ifndef BENCH_ALLOC_H_
+#define BENCH_ALLOC_H_
+#pragma once
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <new>
+
+static size_t allocations = 0;
+
+#ifdef BENCH_WRAP_MALLOC
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+}
+#define BENCH_MALLOC(size) __real_malloc(size)
+#else
+#define BENCH_MALLOC(size) malloc(size)
+#endif
+
+// The free of BENCH_MALLOC, not inlined: the compiler does not see free() on a pointer of operator new
+__attribute__((noinline)) static void benchFree(void* ptr) {
+    free(ptr);
+}
+
+void* operator new(size_t size) {
+    allocations++;
+    void* ptr = BENCH_MALLOC(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    benchFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    benchFree(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    benchFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    benchFree(ptr);
+}
+
+static unsigned long now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+#endif /* BENCH_ALLOC_H_ */
@@ -0,0 +1,83 @@
+/*
+ * bench_level.cpp - compile-time minimum level of the debug macros (host build)
+ *
+ * the loop of a sketch like ota_basic: handle() and a few verbose / debug logs each loop,
+ * info every 1000 loops, the telnet client at level INFO.
+ * CMakeLists.txt builds it twice: bench_level_0 with all the levels (the runtime check only)
+ * and bench_level_3 with REMOTEDEBUG_MIN_LEVEL=3 (verbose and debug not compiled).
+ * check_min_level.cmake checks the format strings in both and compares size and loops/s.
+ *
+ * run with --quick for a short smoke run.
+ *
+ * MIT License
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "RemoteDebug.h"
+
+// not destroyed at exit, the telnet client of RemoteDebug.cpp can be gone before
+RemoteDebug& Debug = *new RemoteDebug();
+
+///// Sketch
+
+static uint32_t loops = 0;
+static int sensor = 0;
+
+static void readSensor() {
+    sensor = (sensor * 1103515245 + 12345) & 0x7FFF;
+    debugV("min level: verbose sensor %d", sensor);
+    rprintV("min level: verbose print ");
+    rprintVln(sensor);
+}
+
+static void doSomething() {
+    debugD("min level: debug loop %u, sensor %d", loops, sensor);
+    if (sensor > 0x7000) {
+        debugD("min level: debug sensor high %d (%d%%)", sensor, sensor * 100 / 0x7FFF);
+    }
+    if (loops % 1000 == 0) {
+        debugI("min level: info %u loops", loops);
+    }
+}
+
+static void loop() {
+    Debug.handle();
+    readSensor();
+    doSomething();
+    loops++;
+}
+
+///// Bench
+
+static unsigned long now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+int main(int argc, char** argv) {
+    bool quick = (argc > 1 && strcmp(argv[1], "--quick") == 0);
+
+    Debug.begin("host", RemoteDebug::INFO);
+    WiFiServer::connectClient();
+    Debug.handle();
+    if (!Debug.isConnected()) {
+        printf("telnet client not connected\n");
+        return 1;
+    }
+
+    const uint32_t count = quick ? 200000 : 5000000;
+    unsigned long start = now();
+    while (loops < count) {
+        loop();
+    }
+    double elapsed = (now() - start) / 1e6;
+
+    printf("min level %d %10.0f loops/s %6.1f ns/loop %8zu bytes sent\n", REMOTEDEBUG_MIN_LEVEL, count / elapsed,
+           elapsed * 1e9 / count, WiFiClient::bytes);
+    return 0;
+}
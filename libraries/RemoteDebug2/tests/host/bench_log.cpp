@@ -0,0 +1,154 @@
+/*
+ * bench_log.cpp - structured logs of RemoteDebug (DEBUG_LOG_RECORDS, host build)
+ *
+ *  - Debug.log(level).kv(key, value) gives a JSON line to the telnet client,
+ *    with the level of the client and its filter, records too big are dropped and counted
+ *  - heap allocations and ns/record against the String concatenation of a sketch,
+ *    and the size of a record in JSON and in MessagePack (the binary frames of the web app)
+ *
+ * on the host String is a std::string (short Strings need no heap, less than the Arduino cores).
+ *
+ * run with --quick for a short smoke run.
+ *
+ * MIT License
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <new>
+#include <string>
+
+#include "RemoteDebug.h"
+#include "bench_alloc.h"
+
+// not destroyed at exit, the telnet client of RemoteDebug.cpp can be gone before
+RemoteDebug& Debug = *new RemoteDebug();
+
+static bool quick = false;
+
+///// Records to a telnet client
+
+static bool checkRecords() {
+    Debug.begin("host", RemoteDebug::DEBUG);
+    Debug.showDebugLevel(true);
+
+    WiFiClient::capture = true;
+    int id = WiFiServer::connectClient();
+    Debug.handle();
+    std::string& received = WiFiClient::connections[id].received;
+    received = "";
+
+    const char* name = "fan";
+    Debug.print("before ");
+    Debug.log(RemoteDebug::INFO).kv("temp", 21.5).kv(name, "on").kv("rpm", 1200);
+    Debug.log(RemoteDebug::VERBOSE).kv("hidden", 1);  // Below the level of the client
+    char big[DEBUG_LOG_SIZE];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = 0;
+    Debug.log(RemoteDebug::ERROR).kv("big", (const char*)big);  // Too big -> dropped
+    Debug.handle();
+    delay(DELAY_TO_SEND + 1);  // Buffer of the client sent
+    Debug.handle();
+
+    const char* expected = "(D) before \r\n(I) {\"time\":";
+    bool ok = received.compare(0, strlen(expected), expected) == 0 &&
+              received.find(",\"level\":\"I\",\"temp\":21.5,\"fan\":\"on\",\"rpm\":1200}\r\n") != std::string::npos &&
+              received.find("hidden") == std::string::npos && received.find("xxx") == std::string::npos && Debug.getLogDropped() == 1;
+
+    // Filter of the client over the JSON
+    received = "";
+    WiFiClient::connections[id].input = "filter off\r\n";
+    Debug.handle();
+    received = "";
+    Debug.log(RemoteDebug::INFO).kv("fan", "on");
+    Debug.log(RemoteDebug::INFO).kv("fan", "off");
+    Debug.handle();
+    delay(DELAY_TO_SEND + 1);
+    Debug.handle();
+    ok = ok && received.find("\"on\"") == std::string::npos && received.find("\"off\"") != std::string::npos;
+
+    WiFiClient::capture = false;
+    Debug.setNoFilter();
+
+    if (!ok) {
+        printf("check %-24s FAILED\n%s\n", "records", received.c_str());
+        return false;
+    }
+    printf("check %-24s ok\n", "records");
+    return true;
+}
+
+///// ns/record and allocations
+
+static void bench(int records) {
+    const char* passes[] = { "log().kv()", "String + println", "printf" };
+
+    for (int pass = 0; pass < 3; pass++) {
+        size_t before = allocations;
+        size_t bytes = WiFiClient::bytes;
+        unsigned long start = now();
+
+        for (int i = 0; i < records; i++) {
+            int temp = 200 + i % 50;
+            int rpm = 1000 + i % 700;
+            const char* fan = (i & 1) ? "on" : "off";
+            if (pass == 0) {
+                Debug.log(RemoteDebug::INFO).kv("temp", temp).kv("fan", fan).kv("rpm", rpm);
+            } else if (pass == 1) {
+                String line = "temp=";
+                line += temp;
+                line += " fan=";
+                line += fan;
+                line += " rpm=";
+                line += rpm;
+                if (Debug.isActive(Debug.INFO)) {
+                    Debug.println(line);
+                }
+            } else {
+                debugI("temp=%d fan=%s rpm=%d", temp, fan, rpm);
+            }
+            if (i % 16 == 15) {
+                Debug.handle();
+            }
+        }
+        Debug.handle();
+
+        unsigned long us = now() - start;
+        printf("%-20s %8.1f ns/record %6.2f allocations/record %6.1f bytes/record\n", passes[pass], us * 1000.0 / records,
+               (double)(allocations - before) / records, (double)(WiFiClient::bytes - bytes) / records);
+    }
+}
+
+///// JSON and MessagePack of a record
+
+static void sizes() {
+    RemoteDebugArena arena;
+    JsonDocument doc(&arena);
+    doc["time"] = 123456;
+    doc["level"] = "I";
+    doc["temp"] = 21.5;
+    doc["fan"] = "on";
+    doc["rpm"] = 1200;
+
+    char json[DEBUG_LOG_SIZE];
+    uint8_t msgpack[DEBUG_LOG_SIZE];
+    size_t sizeJson = serializeJson(doc, json, sizeof(json));
+    size_t sizeMsgPack = serializeMsgPack(doc, msgpack, sizeof(msgpack));
+    printf("%-20s %4zu bytes JSON %4zu bytes MessagePack (%s)\n", "record", sizeJson, sizeMsgPack, json);
+}
+
+int main(int argc, char** argv) {
+    quick = (argc > 1 && strcmp(argv[1], "--quick") == 0);
+
+    bool ok = checkRecords();
+
+    // A client, the output is counted only
+    bench(quick ? 2000 : 200000);
+    sizes();
+
+    return ok ? 0 : 1;
+}
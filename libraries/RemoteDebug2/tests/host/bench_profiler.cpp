@@ -0,0 +1,281 @@
+/*
+ * bench_profiler.cpp - timing scopes of RemoteDebug (DEBUG_SCOPES, host build)
+ *
+ *  - histogram and percentiles of a scope, the same name in two places is one scope
+ *  - threads in the same scope: no time lost (atomic adds, as the tasks of the ESP32),
+ *    two new scopes at once: both measured (the table busy only for a call)
+ *  - command scopes: the loop, then the scopes with more time first, scopes reset
+ *  - cost of a DEBUG_SCOPE against the two micros() it takes and an empty block
+ *
+ * run with --quick for a short smoke run.
+ *
+ * MIT License
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RemoteDebug.h"
+
+// not destroyed at exit, the telnet client of RemoteDebug.cpp can be gone before
+RemoteDebug& Debug = *new RemoteDebug();
+
+static bool quick = false;
+
+static unsigned long now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static void busy(uint32_t us) {
+    uint32_t start = micros();
+    while (micros() - start < us) {
+    }
+}
+
+///// Histogram and percentiles
+
+static bool checkHistogram() {
+    RemoteDebugProfiler profiler;
+    uint8_t slot = profiler.slot("a");
+    bool ok = slot == 0 && profiler.slot("b") == 1 && profiler.slot(std::string("a").c_str()) == 0;
+
+    for (int i = 0; i < 98; i++) {
+        profiler.add(slot, 10);  // Bucket 8 - 15
+    }
+    profiler.add(slot, 0);
+    profiler.add(slot, 5000);  // Bucket 4096 - 8191
+
+    const RemoteDebugProfiler::Scope& scope = profiler.getScope(slot);
+    ok = ok && scope.count == 100 && scope.total == 5980 && scope.max == 5000 && scope.histogram[0] == 1 && scope.histogram[4] == 98 &&
+         scope.histogram[13] == 1 && RemoteDebugProfiler::percentile(scope, 1) == 0 && RemoteDebugProfiler::percentile(scope, 50) == 15 &&
+         RemoteDebugProfiler::percentile(scope, 99) == 15 && RemoteDebugProfiler::percentile(scope, 100) == 5000;
+
+    profiler.add(profiler.slot("b"), 100000);
+    uint8_t order[DEBUG_SCOPES_SIZE];
+    ok = ok && profiler.sorted(order) == 2 && order[0] == 1 && order[1] == 0;
+
+    // Total over 32 bits (carries)
+    uint8_t slotLong = profiler.slot("long");
+    profiler.add(slotLong, 4000000000UL);
+    profiler.add(slotLong, 4000000000UL);
+    ok = ok && RemoteDebugProfiler::getTotal(profiler.getScope(slotLong)) == 8000000000ULL && profiler.sorted(order) == 3 && order[0] == slotLong;
+
+    // Full table: not measured
+    for (int i = 0; i < DEBUG_SCOPES_SIZE + 2; i++) {
+        static char names[DEBUG_SCOPES_SIZE + 2][8];
+        snprintf(names[i], sizeof(names[i]), "s%d", i);
+        profiler.add(profiler.slot(names[i]), 1);
+    }
+    ok = ok && profiler.size() == DEBUG_SCOPES_SIZE && profiler.slot("more") == RemoteDebugProfiler::NO_SLOT;
+
+    profiler.reset();
+    ok = ok && profiler.getScope(slot).count == 0 && profiler.percentile(profiler.getScope(slot), 50) == 0 && profiler.slot("a") == slot;
+
+    if (!ok) {
+        printf("check %-24s FAILED\n", "histogram");
+        return false;
+    }
+    printf("check %-24s ok\n", "histogram");
+    return true;
+}
+
+///// Threads in the same scope
+
+static bool checkThreads() {
+    RemoteDebugProfiler profiler;
+    const int threads = 4;
+    const int count = quick ? 20000 : 200000;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&profiler, count, t]() {
+            uint8_t slot = profiler.slot("shared");
+            for (int i = 0; i < count; i++) {
+                profiler.add(slot, (uint32_t)(i % 64) + t);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    const RemoteDebugProfiler::Scope& scope = profiler.getScope(0);
+    uint32_t sum = 0;
+    for (uint32_t value : scope.histogram) {
+        sum += value;
+    }
+    if (profiler.size() != 1 || scope.count != (uint32_t)(threads * count) || sum != scope.count || scope.max != 63 + threads - 1) {
+        printf("check %-24s FAILED: %u of %d\n", "threads", scope.count, threads * count);
+        return false;
+    }
+    printf("check %-24s ok\n", "threads");
+    return true;
+}
+
+///// Two new scopes at once: the one that finds the table busy is added by its next call
+
+static bool checkFirstCalls() {
+    const int rounds = quick ? 10 : 100;
+    const int count = 1000;
+    uint32_t busy = 0;
+    bool ok = true;
+
+    // Long names: the lock is held for most of the time of the first thread (one core too)
+    static const std::string first = std::string(4 * 1024, 'x') + "first";
+    static const std::string second = std::string(4 * 1024, 'x') + "second";
+
+    for (int round = 0; round < rounds && ok; round++) {
+        RemoteDebugProfiler profiler;
+        uint8_t cache = RemoteDebugProfiler::BUSY_SLOT;  // Static of the DEBUG_SCOPE of the second thread
+        int state = 0;  // 1: first thread in its calls, 2: second thread done
+        uint32_t calls = 0;
+        uint32_t callsScope = 0;
+
+        // Scopes reached the first time, each call takes the lock
+        std::thread adding([&profiler, &state, &calls]() {
+            do {
+                profiler.add(profiler.slot(first.c_str()), 1);
+                calls++;
+                int started = 0;
+                __atomic_compare_exchange_n(&state, &started, 1, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            } while (__atomic_load_n(&state, __ATOMIC_ACQUIRE) != 2);
+        });
+        std::thread scope([&profiler, &cache, &state, &callsScope, count]() {
+            while (__atomic_load_n(&state, __ATOMIC_ACQUIRE) == 0) {
+            }
+            for (int i = 0; i < count || cache == RemoteDebugProfiler::BUSY_SLOT; i++) {  // Until added (one core: the other task runs)
+                profiler.add(profiler.slot(cache, second.c_str()), 1);
+                callsScope++;
+                if (cache == RemoteDebugProfiler::BUSY_SLOT) {
+                    std::this_thread::yield();
+                }
+            }
+            __atomic_store_n(&state, 2, __ATOMIC_RELEASE);
+        });
+        adding.join();
+        scope.join();
+
+        // Both measured, but the calls with the table busy
+        uint32_t measured = 0;
+        for (uint8_t slot = 0; slot < profiler.size(); slot++) {
+            measured += profiler.getScope(slot).count;
+        }
+        ok = profiler.size() == 2 && cache == 1 && measured + profiler.getBusy() == calls + callsScope;
+        busy += profiler.getBusy();
+    }
+
+    if (!ok) {
+        printf("check %-24s FAILED\n", "first calls at once");
+        return false;
+    }
+    printf("check %-24s ok (%u calls with the table busy in %d rounds)\n", "first calls at once", busy, rounds);
+    return true;
+}
+
+///// Command scopes
+
+static void readSensors() {
+    DEBUG_SCOPE("readSensors");
+    busy(300);
+}
+
+static void sendMqtt() {
+    DEBUG_SCOPE("sendMqtt");
+    busy(20);
+}
+
+static bool checkCommand() {
+    Debug.begin("host", RemoteDebug::DEBUG);
+
+    WiFiClient::capture = true;
+    int id = WiFiServer::connectClient();
+    Debug.handle();
+    std::string& received = WiFiClient::connections[id].received;
+
+    for (int i = 0; i < 20; i++) {
+        Debug.handle();
+        readSensors();
+        sendMqtt();
+        {
+            DEBUG_SCOPE("sendMqtt");  // The same scope
+            busy(20);
+        }
+    }
+    received = "";
+    WiFiClient::connections[id].input = "scopes\r\n";
+    Debug.handle();
+    std::string report = received;
+
+    delay(510);  // Commands in less than 500 ms are ignored (processCommand)
+    WiFiClient::connections[id].input = "scopes reset\r\n";
+    Debug.handle();
+    delay(510);
+    received = "";
+    WiFiClient::connections[id].input = "scopes\r\n";
+    Debug.handle();
+    WiFiClient::capture = false;
+
+    size_t loop = report.find("* (loop)");
+    size_t sensors = report.find("* readSensors");
+    size_t mqtt = report.find("* sendMqtt                   40");
+    bool ok = loop != std::string::npos && sensors != std::string::npos && mqtt != std::string::npos && loop < sensors && sensors < mqtt &&
+              report.find("loop jitter") != std::string::npos && received.find("readSensors") == std::string::npos &&
+              received.find("(loop)") == std::string::npos;
+    Debug.disconnect();
+
+    if (!ok) {
+        printf("check %-24s FAILED\n%s\n%s\n", "command scopes", report.c_str(), received.c_str());
+        return false;
+    }
+    printf("check %-24s ok\n%s", "command scopes", report.c_str());
+    return true;
+}
+
+///// Cost of a scope
+
+static volatile uint32_t sink = 0;
+
+static void bench(int count) {
+    const char* passes[] = { "empty block", "two micros()", "DEBUG_SCOPE" };
+
+    for (int pass = 0; pass < 3; pass++) {
+        unsigned long start = now();
+
+        for (int i = 0; i < count; i++) {
+            if (pass == 0) {
+                sink = sink + 1;
+            } else if (pass == 1) {
+                uint32_t begin = micros();
+                sink = sink + 1;
+                sink = sink + (micros() - begin);
+            } else {
+                DEBUG_SCOPE("bench");
+                sink = sink + 1;
+            }
+        }
+
+        unsigned long us = now() - start;
+        printf("%-20s %8.1f ns/block\n", passes[pass], us * 1000.0 / count);
+    }
+}
+
+int main(int argc, char** argv) {
+    quick = (argc > 1 && strcmp(argv[1], "--quick") == 0);
+
+    bool ok = checkHistogram();
+    ok = checkThreads() && ok;
+    ok = checkFirstCalls() && ok;
+    ok = checkCommand() && ok;
+
+    bench(quick ? 200000 : 20000000);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,298 @@
+/*
+ * bench_spool.cpp - spool of the logs on the flash (DEBUG_SPOOL, host build)
+ *
+ *  - the lines of the spool level are kept with no client connected,
+ *    a client gets them with the command spool, as its window frees up
+ *  - after a crash: the errors are on the flash, the lines still in the buffer are lost,
+ *    a record cut by the crash ends its file (the next boot writes to the next one)
+ *  - ring of files: the last lines are kept, in order
+ *  - write amplification (bytes programmed in the flash / bytes of the records) and flushes,
+ *    line by line against the buffer of a page, see arduino/FS.h for the model of SPIFFS.
+ *    The time of a flush here is the one of the files in memory, on the board see the command spool stats.
+ *
+ * run with --quick for a short smoke run.
+ *
+ * MIT License
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "RemoteDebug.h"
+
+// not destroyed at exit, the telnet client of RemoteDebug.cpp can be gone before
+RemoteDebug& Debug = *new RemoteDebug();
+
+static bool quick = false;
+
+static unsigned long now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static size_t count(const std::string& text, const char* what) {
+    size_t found = 0;
+    for (size_t pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1)) {
+        found++;
+    }
+    return found;
+}
+
+// Lines read from a spool
+static boolean collect(void* arg, uint8_t level, uint32_t time, const char* text, size_t size) {
+    (void)time;
+    std::vector<std::string>& lines = *(std::vector<std::string>*)arg;
+    lines.push_back((level == RemoteDebugSpool::LEVEL_BOOT) ? "boot" : std::string(text, size));
+    return true;
+}
+
+///// Through RemoteDebug: kept with no client, shown by the command spool
+
+static bool checkDebug() {
+    fs::FS flash;
+    Debug.begin("host", RemoteDebug::DEBUG);
+    if (!Debug.setSpool(flash, RemoteDebug::INFO) || Debug.isActive(RemoteDebug::DEBUG) || !Debug.isActive(RemoteDebug::INFO)) {
+        printf("check %-24s FAILED: active with no client\n", "spool");
+        return false;
+    }
+
+    for (int i = 0; i < 50; i++) {
+        debugI("spool line %d", i);
+        debugD("not in the spool %d", i);
+    }
+    debugE("spool error");
+    // Deferred logs (DEBUG_DEFERRED): the spool has the text all the same
+    debugI("types: %c %5.2f %-6s| %x %d %lld %u %s %%", 'z', 3.14159, "ab", 0xbeefu, -42, -5000000000LL, 7u, "end");
+    char types[128];
+    snprintf(types, sizeof(types), "types: %c %5.2f %-6s| %x %d %lld %u %s %%\r\n", 'z', 3.14159, "ab", 0xbeefu, -42, -5000000000LL, 7u, "end");
+    Debug.handle();
+
+    WiFiClient::capture = true;
+    int id = WiFiServer::connectClient();
+    Debug.handle();
+    std::string& received = WiFiClient::connections[id].received;
+    if (received.find("bytes of logs in the spool") == std::string::npos) {
+        printf("check %-24s FAILED: message on connection\n", "spool");
+        return false;
+    }
+
+    received = "";
+    WiFiClient::connections[id].input = "spool\r\n";
+    Debug.handle();
+    delay(510);  // Commands in less than 500 ms are ignored (processCommand)
+    WiFiClient::connections[id].input = "spool stats\r\n";
+    Debug.handle();
+    WiFiClient::capture = false;
+
+    if (count(received, "(I t:") != 51 || count(received, "spool line ") != 50 || count(received, "not in the spool") != 0 ||
+        received.find("(E t:") == std::string::npos || received.find("* ---- boot ----") == std::string::npos ||
+        received.find("end of the spool") < received.find("spool error") || received.find(types) == std::string::npos ||
+        received.find("* Debug: spool 53 lines") == std::string::npos) {
+        printf("check %-24s FAILED: command spool\n%s\n", "spool", received.c_str());
+        return false;
+    }
+
+    // Slow client: the spool is sent by handle() as the window frees up, no line dropped
+    for (int i = 0; i < 300; i++) {
+        debugI("window line %d", i);
+        if (i % 16 == 15) {
+            Debug.handle();  // The ring
+        }
+    }
+    Debug.handle();
+    delay(DELAY_TO_SEND + 1);
+    Debug.handle();
+    RemoteDebug::SendStats before = Debug.getSendStats();
+    WiFiClient::capture = true;
+    received = "";
+    delay(510);
+    WiFiClient::connections[id].input = "spool\r\n";
+    int loops = 0;
+    for (; loops < 1000 && received.find("end of the spool") == std::string::npos; loops++) {
+        WiFiClient::connections[id].window = 256;
+        Debug.handle();
+        delay(1);  // The rest of the loop, the last piece is sent after DELAY_TO_SEND
+    }
+    WiFiClient::connections[id].window = -1;
+    WiFiClient::capture = false;
+
+    bool ok = count(received, "spool line ") == 50 && count(received, "window line ") == 300 && loops > 1 &&
+              Debug.getSendStats().dropped == before.dropped && received.find("bytes dropped") == std::string::npos;
+    size_t pos = 0;
+    for (int i = 0; i < 300 && ok; i++) {
+        pos = received.find("window line " + std::to_string(i) + "\r\n", pos);
+        ok = pos != std::string::npos;
+    }
+    if (!ok) {
+        printf("check %-24s FAILED: command spool, window of 256 bytes (%d loops)\n%s\n", "spool", loops, received.c_str());
+        return false;
+    }
+    Debug.disconnect();
+
+    printf("check %-24s ok (%zu bytes of spool in %d loops, window of 256 bytes)\n", "spool", received.size(), loops);
+    return true;
+}
+
+///// Crash: no flush, the next boot finds the errors
+
+static bool checkCrash() {
+    fs::FS flash;
+
+    RemoteDebugSpool* before = new RemoteDebugSpool();  // Not ended, as a crash
+    before->begin(flash);
+    for (int i = 0; i < 3; i++) {
+        before->write(RemoteDebug::INFO, i, "info", 4);
+    }
+    before->write(RemoteDebug::ERROR, 3, "error", 5);
+    before->write(RemoteDebug::INFO, 4, "lost", 4);
+
+    RemoteDebugSpool after;
+    after.begin(flash);
+    std::vector<std::string> lines;
+    after.read(collect, &lines);
+
+    const std::vector<std::string> expected = { "boot", "info", "info", "info", "error", "boot" };
+    if (lines != expected) {
+        printf("check %-24s FAILED: %zu lines after the crash\n", "spool crash", lines.size());
+        return false;
+    }
+    after.write(RemoteDebug::ERROR, 5, "torn", 4);
+    after.end();
+
+    // Crash in the write of a record: a part of it in the file
+    File file = flash.open(DEBUG_SPOOL_PATH "0", "a");
+    const uint8_t part[] = { RemoteDebug::ERROR, 6, 0, 0, 0, 20, 'c', 'u', 't' };
+    file.write(part, sizeof(part));
+    file.close();
+
+    RemoteDebugSpool again;
+    again.begin(flash);
+    again.write(RemoteDebug::ERROR, 7, "again", 5);
+    lines.clear();
+    again.read(collect, &lines);
+
+    const std::vector<std::string> torn = { "boot", "info", "info", "info", "error", "boot", "torn", "boot", "again" };
+    if (lines != torn) {
+        printf("check %-24s FAILED: %zu lines after a cut record\n", "spool crash", lines.size());
+        return false;
+    }
+    printf("check %-24s ok\n", "spool crash");
+    return true;
+}
+
+///// Ring of files: the last lines, in order
+
+static bool checkRing() {
+    fs::FS flash;
+    RemoteDebugSpool spool;
+    spool.begin(flash);
+
+    const int total = DEBUG_SPOOL_SEGMENTS * DEBUG_SPOOL_SEGMENT_SIZE / 20 * 2;  // More than the files have
+    for (int i = 0; i < total; i++) {
+        char line[32];
+        int size = snprintf(line, sizeof(line), "ring line %06d", i);
+        spool.write(RemoteDebug::INFO, i, line, size);
+    }
+
+    std::vector<std::string> lines;
+    spool.read(collect, &lines);
+    size_t minimum = (DEBUG_SPOOL_SEGMENTS - 1) * DEBUG_SPOOL_SEGMENT_SIZE / 22;
+    bool ok = lines.size() >= minimum && lines.back() == "ring line " + std::to_string(1000000 + total - 1).substr(1);
+    for (size_t i = 1; i < lines.size() && ok; i++) {
+        ok = atoi(lines[i].c_str() + 10) == atoi(lines[i - 1].c_str() + 10) + 1;
+    }
+    if (!ok || spool.size() > DEBUG_SPOOL_SEGMENTS * DEBUG_SPOOL_SEGMENT_SIZE) {
+        printf("check %-24s FAILED: %zu lines\n", "spool ring", lines.size());
+        return false;
+    }
+    printf("check %-24s ok (%zu of %d lines)\n", "spool ring", lines.size(), total);
+    return true;
+}
+
+///// Write amplification and flushes
+
+// One line of a sketch
+static int formatLine(char* line, size_t size, int i) {
+    static const char* const names[] = { "sensor", "wifi", "mqtt", "Relay" };
+    return snprintf(line, size, "(loop) value %d of %s: %u ms, rssi -%d dBm", i, names[i % 4], (unsigned)(i * 7), 40 + i % 50);
+}
+
+static void report(const char* name, const fs::FS& flash, size_t logged, size_t flushes, unsigned long flushTime, unsigned long flushTimeMax,
+                   unsigned long us, int lines) {
+    printf("%-32s %6.2f amplification %7zu flushes %7zu file flushes %7.1f bytes/flush %6.2f us/flush (max %lu) %6.1f ns/line\n",
+           name, (double)flash.stats.programmed / logged, flushes, flash.stats.flushes, (double)flash.stats.programmed / (flushes ? flushes : 1),
+           flushes ? (double)flushTime / flushes : 0.0, flushTimeMax, us * 1000.0 / lines);
+}
+
+// Without the buffer: each line written and flushed
+static void benchLineByLine(int lines) {
+    fs::FS flash;
+    File file = flash.open(DEBUG_SPOOL_PATH "0", "w");
+    size_t logged = 0;
+    unsigned long flushTime = 0;
+    unsigned long flushTimeMax = 0;
+
+    unsigned long start = now();
+    for (int i = 0; i < lines; i++) {
+        uint8_t record[6 + 64];
+        int size = formatLine((char*)record + 6, sizeof(record) - 6, i);
+        record[0] = RemoteDebug::INFO;
+        memcpy(record + 1, &i, 4);
+        record[5] = size;
+
+        unsigned long begin = now();
+        file.write(record, 6 + size);
+        file.flush();
+        unsigned long elapsed = now() - begin;
+        flushTime += elapsed;
+        flushTimeMax = (elapsed > flushTimeMax) ? elapsed : flushTimeMax;
+        logged += 6 + size;
+    }
+    report("line by line (write + flush)", flash, logged, flash.stats.flushes, flushTime, flushTimeMax, now() - start, lines);
+}
+
+// With the buffer of a page: flushed when full, each n lines (the time of flush at a rate of lines)
+// or for each error
+static void benchSpool(const char* name, int lines, int flushEvery, int errorEvery) {
+    fs::FS flash;
+    RemoteDebugSpool spool;
+    spool.begin(flash);
+    flash.stats = fs::FS::Stats();
+
+    unsigned long start = now();
+    for (int i = 0; i < lines; i++) {
+        char line[64];
+        int size = formatLine(line, sizeof(line), i);
+        uint8_t level = (errorEvery && i % errorEvery == errorEvery - 1) ? RemoteDebug::ERROR : RemoteDebug::INFO;
+        spool.write(level, i, line, size);
+        if (flushEvery && i % flushEvery == flushEvery - 1) {
+            spool.flush();
+        }
+    }
+    unsigned long us = now() - start;
+
+    const RemoteDebugSpool::Stats& stats = spool.getStats();
+    report(name, flash, stats.bytes - 6, stats.flushes - 1, stats.flushTime, stats.flushTimeMax, us, lines);  // Without the boot
+}
+
+int main(int argc, char** argv) {
+    quick = (argc > 1 && strcmp(argv[1], "--quick") == 0);
+
+    bool ok = checkDebug();
+    ok = checkCrash() && ok;
+    ok = checkRing() && ok;
+
+    const int lines = quick ? 2000 : 200000;
+    benchLineByLine(lines);
+    benchSpool("page buffer", lines, 0, 0);
+    benchSpool("page buffer, 1 error / 10 lines", lines, 0, 10);
+    benchSpool("page buffer, 1 line/s (5 s)", lines, 5, 0);
+
+    return ok ? 0 : 1;
+}
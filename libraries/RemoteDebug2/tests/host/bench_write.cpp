@@ -0,0 +1,1110 @@
+/*
+ * bench_write.cpp - benchmark of the write path of RemoteDebug (host build)
+ *
+ *  - lines/s and heap allocations per line of RemoteDebug::write,
+ *    against the write path of the version 4.0.0 (String per character, LegacyDebug below)
+ *  - the output of both is compared first (telnet client, no time and profiler)
+ *  - deferred logs: lines/s and bytes/line of Debug.deferred against Debug.printf,
+ *    --deferred-out name writes name.bin (stream) and name.txt (the text expected from
+ *    extras/decode_deferred.py --no-time)
+ *  - ring (DEBUG_RING_SIZE): threads print while the main thread calls handle(), each one with
+ *    its level and a line in three prints, every line must arrive complete, in order and with
+ *    the level of its thread, or be counted by getRingOverflows()
+ *  - clients: each one gets the lines of its level and filter and the answers of its commands,
+ *    and the cost of the fan-out to 1, 4 and 8 clients
+ *  - filter: RemoteDebugFilter against a plain search, and ns/line against the search
+ *    of the version 4.0.0 (lower case copy of the line and indexOf) and an in place search
+ *  - slow client: handle() sends what is buffered with no more writes, only what the TCP window
+ *    takes is written, the lines without room are dropped whole and told to the client
+ *    (deferred logs: whole frames, a log after its format);
+ *    lines dropped and time in the buffer with a window of some bytes by loop
+ *
+ * on the host String is a std::string: short Strings need no heap, the 4.0.0 path
+ * allocates less here than with the String of the Arduino cores.
+ *
+ * run with --quick for a short smoke run.
+ *
+ * MIT License
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RemoteDebug.h"
+#include "bench_alloc.h"
+
+// not destroyed at exit, the telnet client of RemoteDebug.cpp can be gone before
+RemoteDebug& Debug = *new RemoteDebug();
+
+static bool quick = false;
+
+///// Write path of the version 4.0.0, telnet client with CLIENT_BUFFERING
+
+class LegacyDebug : public Print {
+   public:
+    uint8_t _lastDebugLevel = RemoteDebug::DEBUG;
+    uint32_t _lastTimePrint = millis();
+    boolean _showTime = false;
+    boolean _showProfiler = false;
+    uint32_t _minTimeShowProfiler = 0;
+    boolean _showDebugLevel = true;
+    boolean _showColors = false;
+    boolean _newLine = true;
+    String _filter = "";
+    boolean _filterActive = false;
+    String _bufferPrint = "";
+    String _bufferSend = "";
+    uint16_t _sizeBufferSend = 0;
+    uint32_t _lastTimeSend = 0;
+    WiFiClient* _client = NULL;
+
+    void setFilter(String filter) {
+        _filter = filter;
+        _filter.toLowerCase();
+        _filterActive = true;
+    }
+
+    void sendBuffer() {
+        _client->print(_bufferSend);
+        _bufferSend = "";
+        _sizeBufferSend = 0;
+        _lastTimeSend = millis();
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            write((uint8_t)buffer[i]);
+        }
+        return size;
+    }
+
+    size_t write(uint8_t character) {
+        uint32_t elapsed = 0;
+        size_t ret = 0;
+        String colorLevel = "";
+
+        if (_newLine) {
+            String show = "";
+
+            if (_showColors) {
+                switch (_lastDebugLevel) {
+                    case RemoteDebug::VERBOSE:
+                        show = COLOR_VERBOSE;
+                        break;
+                    case RemoteDebug::DEBUG:
+                        show = COLOR_DEBUG;
+                        break;
+                    case RemoteDebug::INFO:
+                        show = COLOR_INFO;
+                        break;
+                    case RemoteDebug::WARNING:
+                        show = COLOR_WARNING;
+                        break;
+                    case RemoteDebug::ERROR:
+                        show = COLOR_ERROR;
+                        break;
+                }
+                colorLevel = show;
+            }
+            if (_showDebugLevel) {
+                switch (_lastDebugLevel) {
+                    case RemoteDebug::PROFILER:
+                        show.concat("(P");
+                        break;
+                    case RemoteDebug::VERBOSE:
+                        show.concat("(V");
+                        break;
+                    case RemoteDebug::DEBUG:
+                        show.concat("(D");
+                        break;
+                    case RemoteDebug::INFO:
+                        show.concat("(I");
+                        break;
+                    case RemoteDebug::WARNING:
+                        show.concat("(W");
+                        break;
+                    case RemoteDebug::ERROR:
+                        show.concat("(E");
+                        break;
+                }
+            }
+            if (_showTime) {
+                if (show != "") {
+                    show.concat(" ");
+                }
+                show.concat("t:");
+                show.concat(millis());
+                show.concat("ms");
+            }
+            if (_showProfiler) {
+                elapsed = (millis() - _lastTimePrint);
+                boolean resetColors = false;
+                if (show != "") {
+                    show.concat(" ");
+                }
+                if (_showColors) {
+                    if (elapsed < 250) {
+                        ;
+                    } else if (elapsed < 1000) {
+                        show.concat(COLOR_BLACK);
+                        show.concat(COLOR_BACKGROUND_GREEN);
+                        resetColors = true;
+                    } else if (elapsed < 3000) {
+                        show.concat(COLOR_BLACK);
+                        show.concat(COLOR_BACKGROUND_YELLOW);
+                        resetColors = true;
+                    } else if (elapsed < 5000) {
+                        show.concat(COLOR_WHITE);
+                        show.concat(COLOR_BACKGROUND_MAGENTA);
+                        resetColors = true;
+                    } else {
+                        show.concat(COLOR_WHITE);
+                        show.concat(COLOR_BACKGROUND_RED);
+                        resetColors = true;
+                    }
+                }
+                show.concat("p:^");
+                show.concat(formatNumber(elapsed, 4));
+                show.concat("ms");
+                if (resetColors) {
+                    show.concat(COLOR_RESET);
+                    show.concat(colorLevel);
+                }
+                _lastTimePrint = millis();
+            }
+            if (show != "") {
+                show.concat(") ");
+                _bufferPrint = show;
+            }
+            _newLine = false;
+        }
+
+        boolean doPrint = false;
+
+        if (character == '\n') {
+            _bufferPrint.concat("\r");
+            _newLine = true;
+            doPrint = true;
+        } else if (_bufferPrint.length() == BUFFER_PRINT) {
+            doPrint = true;
+        }
+
+        _bufferPrint.concat((char)character);
+
+        if (doPrint) {
+            boolean noPrint = false;
+
+            if (_showProfiler && elapsed < _minTimeShowProfiler) {
+                noPrint = true;
+            } else if (_filterActive) {
+                String aux = _bufferPrint;
+                aux.toLowerCase();
+
+                if (aux.indexOf(_filter) == -1) {
+                    noPrint = true;
+                }
+            }
+
+            if (noPrint == false) {
+                if (_showColors) _bufferPrint.concat(COLOR_RESET);
+
+                uint8_t size = _bufferPrint.length();
+
+                if ((_sizeBufferSend + size) >= MAX_SIZE_SEND) {
+                    sendBuffer();
+                }
+                _bufferSend.concat(_bufferPrint);
+                _sizeBufferSend += size;
+
+                if ((millis() - _lastTimeSend) >= DELAY_TO_SEND) {
+                    sendBuffer();
+                }
+            }
+
+            ret = _bufferPrint.length();
+            _bufferPrint = "";
+        }
+        return ret;
+    }
+
+    String formatNumber(uint32_t value, uint8_t size, char insert = '0') {
+        String ret = "";
+
+        for (uint8_t i = 1; i <= size; i++) {
+            uint32_t max = pow(10, i);
+            if (value < max) {
+                for (uint8_t j = (size - i); j > 0; j--) {
+                    ret.concat(insert);
+                }
+                break;
+            }
+        }
+
+        ret.concat(value);
+
+        return ret;
+    }
+};
+
+static LegacyDebug Legacy;
+static WiFiClient LegacyClient;
+
+///// Settings of both
+
+struct Setting {
+    const char* name;
+    boolean time;
+    boolean profiler;
+    boolean colors;
+    const char* filter;
+};
+
+static void apply(const Setting& setting) {
+    Debug.showTime(setting.time);
+    Debug.showProfiler(setting.profiler);
+    Debug.showColors(setting.colors);
+    if (setting.filter) {
+        Debug.setFilter(setting.filter);
+    } else {
+        Debug.setNoFilter();
+    }
+
+    Legacy._showTime = setting.time;
+    Legacy._showProfiler = setting.profiler;
+    Legacy._showColors = setting.colors;
+    Legacy._filterActive = false;
+    if (setting.filter) {
+        Legacy.setFilter(setting.filter);
+    }
+}
+
+// One line of a sketch, as debugX() does
+static const char* const names[] = { "sensor", "wifi", "mqtt", "Relay" };
+#define LINE_FORMAT "(%s) value %d of %s: %u ms, rssi -%d dBm\n"
+#define LINE_ARGS(i) "loop", i, names[i % 4], (unsigned)(i * 7), 40 + i % 50
+
+// The loop of a sketch: handle() sends the ring
+static void loop(bool debug, int i) {
+#ifdef DEBUG_RING_SIZE
+    if (debug && i % 16 == 15) {
+        Debug.handle();
+    }
+#else
+    (void)debug;
+    (void)i;
+#endif
+}
+
+static void writeLine(Print& out, uint8_t level, int i) {
+    if (&out == &Legacy) {
+        Legacy._lastDebugLevel = level;
+    } else {
+        Debug.isActive(level);
+    }
+    out.printf(LINE_FORMAT, LINE_ARGS(i));
+    loop(&out == &Debug, i);
+}
+
+// The same with a deferred log
+static void writeDeferred(uint8_t level, int i) {
+    Debug.isActive(level);
+    Debug.deferred(DEBUG_FORMAT_ID(LINE_FORMAT), LINE_FORMAT, LINE_ARGS(i));
+    loop(true, i);
+}
+
+// Send what is buffered to the client (DELAY_TO_SEND)
+// the ring goes to the send buffer in one handle(), to the client in the next one
+static void flushBoth() {
+    for (int i = 0; i < 2; i++) {
+        delay(DELAY_TO_SEND + 1);
+        Debug.handle();
+    }
+    Legacy.sendBuffer();
+}
+
+///// Output of both is the same
+
+static bool check(const Setting& setting) {
+    apply(setting);
+    flushBoth();
+
+    WiFiClient::capture = true;
+    WiFiClient::received = "";
+    for (int i = 0; i < 100; i++) {
+        writeLine(Debug, RemoteDebug::DEBUG + i % 4, i);
+    }
+    // Long line, broken at BUFFER_PRINT
+    Debug.isActive(RemoteDebug::INFO);
+    Debug.println(std::string(BUFFER_PRINT, 'x').c_str());
+    flushBoth();
+    std::string current = WiFiClient::received;
+
+    WiFiClient::received = "";
+    for (int i = 0; i < 100; i++) {
+        writeLine(Legacy, RemoteDebug::DEBUG + i % 4, i);
+    }
+    Legacy._lastDebugLevel = RemoteDebug::INFO;
+    Legacy.println(std::string(BUFFER_PRINT, 'x').c_str());
+    flushBoth();
+    std::string legacy = WiFiClient::received;
+    WiFiClient::capture = false;
+
+    // The long line (not there with a filter): the prefix is not counted in BUFFER_PRINT now
+    std::string::size_type a = current.rfind("(I) x");
+    std::string::size_type b = legacy.rfind("(I) x");
+    if (a == std::string::npos) {
+        a = current.length();
+    }
+    if (b == std::string::npos) {
+        b = legacy.length();
+    }
+    if (a == 0 || current.compare(0, a, legacy, 0, b) != 0) {
+        printf("check %-24s FAILED: output differs\n", setting.name);
+        return false;
+    }
+    std::string rest = current.substr(a);
+    rest.erase(std::remove(rest.begin(), rest.end(), '\r'), rest.end());
+    if (a < current.length() && rest.find(std::string(BUFFER_PRINT, 'x')) == std::string::npos) {
+        printf("check %-24s FAILED: long line\n", setting.name);
+        return false;
+    }
+    printf("check %-24s ok (%zu bytes)\n", setting.name, a);
+    return true;
+}
+
+///// lines/s and allocations per line
+
+static void bench(const Setting& setting) {
+    const int count = quick ? 2000 : 200000;
+
+    apply(setting);
+    flushBoth();
+
+    for (int pass = 0; pass < 2; pass++) {
+        Print& out = pass ? (Print&)Debug : (Print&)Legacy;
+        size_t bytes = WiFiClient::bytes;
+        size_t before = allocations;
+        unsigned long start = now();
+        for (int i = 0; i < count; i++) {
+            writeLine(out, RemoteDebug::DEBUG + i % 4, i);
+        }
+        unsigned long us = now() - start;
+        size_t allocs = allocations - before;
+        flushBoth();
+
+        double rate = us ? count / (us / 1000000.0) : 0;
+        printf("%-8s %-24s %10.0f lines/s %6.2f allocations/line %6.1f bytes/line\n", pass ? "current" : "4.0.0", setting.name, rate,
+               (double)allocs / count, (double)(WiFiClient::bytes - bytes) / count);
+    }
+}
+
+///// Deferred logs
+
+static void benchDeferred() {
+    const int count = quick ? 2000 : 200000;
+
+    apply({ "level", false, false, false, NULL });
+    flushBoth();
+
+    for (int pass = 0; pass < 2; pass++) {
+        size_t bytes = WiFiClient::bytes;
+        size_t before = allocations;
+        unsigned long start = now();
+        for (int i = 0; i < count; i++) {
+            if (pass) {
+                writeDeferred(RemoteDebug::DEBUG + i % 4, i);
+            } else {
+                writeLine(Debug, RemoteDebug::DEBUG + i % 4, i);
+            }
+        }
+        flushBoth();
+        unsigned long us = now() - start;
+
+        double rate = us ? count / (us / 1000000.0) : 0;
+        printf("%-8s %-24s %10.0f lines/s %6.2f allocations/line %6.1f bytes/line\n", pass ? "deferred" : "printf", "level", rate,
+               (double)(allocations - before) / count, (double)(WiFiClient::bytes - bytes) / count);
+    }
+}
+
+// Stream of deferred logs and the text expected from the decoder
+static bool writeDeferredStream(const char* name) {
+    // New connection: the formats are sent again
+    Debug.disconnect();
+    WiFiServer::connectClient();
+    Debug.handle();
+    apply({ "level", false, false, false, NULL });
+    flushBoth();
+
+    std::string expected;
+    char text[256];
+    WiFiClient::capture = true;
+    WiFiClient::received = "";
+
+    for (int i = 0; i < 50; i++) {
+        uint8_t level = RemoteDebug::DEBUG + i % 4;
+        writeDeferred(level, i);
+        snprintf(text, sizeof(text), "(%c) " LINE_FORMAT, "PVDIWE"[level], LINE_ARGS(i));
+        expected += text;
+        expected.replace(expected.length() - 1, 1, "\r\n");
+    }
+
+#define TYPES_FORMAT "types: %c %5.2f %-6s| %x %d %lld %u %s %%\n"
+#define TYPES_ARGS 'A', -3.14159, "ab", 0xBEEFu, -42, -1234567890123LL, (uint8_t)200, (const char*)NULL
+    Debug.isActive(RemoteDebug::ERROR);
+    Debug.deferred(DEBUG_FORMAT_ID(TYPES_FORMAT), TYPES_FORMAT, TYPES_ARGS);
+    snprintf(text, sizeof(text), "(E) " TYPES_FORMAT, 'A', -3.14159, "ab", 0xBEEFu, -42, -1234567890123LL, 200u, "(null)");
+    expected += text;
+    expected.replace(expected.length() - 1, 1, "\r\n");
+
+    flushBoth();
+    WiFiClient::capture = false;
+
+    std::string binary = std::string(name) + ".bin";
+    std::string txt = std::string(name) + ".txt";
+    FILE* file = fopen(binary.c_str(), "wb");
+    FILE* fileText = fopen(txt.c_str(), "wb");
+    if (!file || !fileText) {
+        printf("deferred: cannot write %s\n", name);
+        return false;
+    }
+    fwrite(WiFiClient::received.data(), 1, WiFiClient::received.length(), file);
+    fwrite(expected.data(), 1, expected.length(), fileText);
+    fclose(file);
+    fclose(fileText);
+    printf("deferred: %zu bytes in %s, %zu bytes of text in %s\n", WiFiClient::received.length(), binary.c_str(), expected.length(), txt.c_str());
+    return true;
+}
+
+#ifdef DEBUG_RING_SIZE
+///// Threads print, the main thread is the loop of the sketch
+
+static bool benchThreads(int threads) {
+    const int count = quick ? 2000 : 100000;
+
+    apply({ "level", false, false, false, NULL });
+    Debug.isActive(RemoteDebug::DEBUG);
+    flushBoth();
+
+    WiFiClient::capture = true;
+    WiFiClient::received = "";
+    uint32_t overflows = Debug.getRingOverflows();
+    std::atomic<int> running(threads);
+
+    unsigned long start = now();
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; t++) {
+        writers.emplace_back([t, count, &running]() {
+            // Each task with its level, a line in three prints
+            uint8_t level = RemoteDebug::DEBUG + t % 4;
+            for (int i = 0; i < count; i++) {
+                if (Debug.isActive(level)) {
+                    Debug.print("task ");
+                    Debug.printf("%d line %07d", t, i);
+                    Debug.println(" of the task, padding to a usual length");
+                }
+                if (i % 64 == 63) {
+                    std::this_thread::yield();
+                }
+            }
+            running--;
+        });
+    }
+    while (running > 0) {
+        Debug.handle();
+    }
+    unsigned long us = now() - start;
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    flushBoth();
+    WiFiClient::capture = false;
+    overflows = Debug.getRingOverflows() - overflows;
+
+    // Lines complete and in order for each task
+    std::vector<int> last(threads, -1);
+    size_t lines = 0;
+    size_t pos = 0;
+    const std::string& received = WiFiClient::received;
+    while (pos < received.length()) {
+        size_t end = received.find("\r\n", pos);
+        if (end == std::string::npos) {
+            printf("threads %d FAILED: line not complete\n", threads);
+            return false;
+        }
+        std::string line = received.substr(pos, end - pos);
+        pos = end + 2;
+        if (line.find("* Debug: ") == 0) {
+            continue;
+        }
+        int t, i;
+        char level;
+        char padding[64];
+        if (sscanf(line.c_str(), "(%c) task %d line %d of the task, %63[^\r]", &level, &t, &i, padding) != 4 || t < 0 || t >= threads ||
+            i <= last[t] || level != "DIWE"[t % 4] || strcmp(padding, "padding to a usual length") != 0) {
+            printf("threads %d FAILED: \"%s\"\n", threads, line.c_str());
+            return false;
+        }
+        last[t] = i;
+        lines++;
+    }
+    if (lines + overflows != (size_t)threads * count) {
+        printf("threads %d FAILED: %zu lines + %u dropped, %d written\n", threads, lines, overflows, threads * count);
+        return false;
+    }
+
+    // Lines sent, a printing thread can fill the ring faster than handle() sends it (on one core)
+    double rate = us ? lines / (us / 1000000.0) : 0;
+    printf("ring     %d threads %16s %10.0f lines/s %6.2f%% dropped\n", threads, "", rate, 100.0 * overflows / (threads * count));
+    return true;
+}
+#endif
+
+///// Clients: each one with its level and filter, a line is formatted once for all
+
+// Only these clients connected (accepted by handle), with their commands
+static std::vector<int> connectClients(const std::vector<std::string>& commands) {
+    Debug.disconnect();
+    std::vector<int> ids;
+    for (size_t c = 0; c < commands.size(); c++) {
+        ids.push_back(WiFiServer::connectClient());
+        Debug.handle();
+    }
+    for (size_t c = 0; c < commands.size(); c++) {  // After the connection, its input is emptied
+        WiFiClient::connections[ids[c]].input = commands[c];
+    }
+    Debug.handle();
+    return ids;
+}
+
+static size_t countLines(const std::string& received, const char* text, bool withText) {
+    size_t lines = 0;
+    size_t pos = 0;
+    while ((pos = received.find(") value ", pos)) != std::string::npos) {
+        size_t begin = received.rfind('\n', pos);
+        size_t end = received.find('\n', pos);
+        std::string line = received.substr((begin == std::string::npos) ? 0 : begin + 1, end - begin);
+        std::transform(line.begin(), line.end(), line.begin(), ::tolower);
+        if ((line.find(text) != std::string::npos) == withText) {
+            lines++;
+        }
+        pos = end;
+    }
+    return lines;
+}
+
+static bool checkClients() {
+    apply({ "level", false, false, false, NULL });
+    WiFiClient::capture = true;
+
+    // Commands answered to their client only
+    std::vector<int> ids = connectClients({ "", "filter WIFI\r\n", "e\r\n" });
+    if (Debug.getClientsConnected() != 3 || WiFiClient::connections[ids[0]].received.find("* Debug") != std::string::npos ||
+        WiFiClient::connections[ids[1]].received.find("* Debug: Filter active: WIFI") == std::string::npos ||
+        WiFiClient::connections[ids[2]].received.find("* Debug level set to Error") == std::string::npos) {
+        printf("check %-24s FAILED: commands\n", "clients");
+        return false;
+    }
+
+    for (int id : ids) {
+        WiFiClient::connections[id].received = "";
+    }
+    for (int i = 0; i < 100; i++) {
+        writeLine(Debug, RemoteDebug::DEBUG + i % 4, i);
+    }
+    flushBoth();
+
+    // All / only wifi / only errors
+    const std::string& all = WiFiClient::connections[ids[0]].received;
+    const std::string& wifi = WiFiClient::connections[ids[1]].received;
+    const std::string& errors = WiFiClient::connections[ids[2]].received;
+    if (countLines(all, "", true) != 100 || countLines(wifi, "wifi", true) != 25 || countLines(wifi, "wifi", false) != 0 ||
+        countLines(errors, "(e)", true) != 25 || countLines(errors, "(e)", false) != 0) {
+        printf("check %-24s FAILED: lines of each client\n", "clients");
+        return false;
+    }
+
+    // No more clients than DEBUG_MAX_CLIENTS, a client of the same host takes the place of the old one
+    std::vector<std::string> commands(DEBUG_MAX_CLIENTS + 1);
+    ids = connectClients(commands);
+    int last = ids.back();
+    if (Debug.getClientsConnected() != DEBUG_MAX_CLIENTS || WiFiClient::connections[last].connected ||
+        WiFiClient::connections[last].received.find("* Too many clients") == std::string::npos) {
+        printf("check %-24s FAILED: too many clients\n", "clients");
+        return false;
+    }
+    int again = WiFiServer::connectClient(ids[0]);
+    Debug.handle();
+    if (Debug.getClientsConnected() != DEBUG_MAX_CLIENTS || WiFiClient::connections[ids[0]].connected || !WiFiClient::connections[again].connected) {
+        printf("check %-24s FAILED: reconnect\n", "clients");
+        return false;
+    }
+    WiFiClient::capture = false;
+
+    printf("check %-24s ok\n", "clients");
+    return true;
+}
+
+// Cost of the fan-out: the same lines to 1, 4 or 8 clients, without and with a filter by client
+static void benchClients(int clients) {
+    const int count = quick ? 2000 : 200000;
+
+    std::vector<std::string> commands;
+    for (int c = 0; c < clients; c++) {
+        commands.push_back(std::string("filter ") + names[c % 4] + "\r\n");
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 0) {
+            connectClients(std::vector<std::string>(clients));
+        } else {
+            connectClients(commands);
+        }
+        flushBoth();
+
+        size_t bytes = WiFiClient::bytes;
+        unsigned long start = now();
+        for (int i = 0; i < count; i++) {
+            writeLine(Debug, RemoteDebug::DEBUG + i % 4, i);
+        }
+        unsigned long us = now() - start;
+        flushBoth();
+
+        char name[32];
+        snprintf(name, sizeof(name), "%d %s", clients, pass ? "filter by client" : "all");
+        double rate = us ? count / (us / 1000000.0) : 0;
+        printf("%-8s %-24s %10.0f lines/s %6.1f ns/line/client %6.1f bytes/line\n", "clients", name, rate, us * 1000.0 / count / clients,
+               (double)(WiFiClient::bytes - bytes) / count);
+    }
+}
+
+///// Filter compiled once (Boyer-Moore-Horspool), over the line without copy
+
+struct FilterCase {
+    const char* filter;
+    const char* line;
+    uint8_t level;
+    bool match;
+};
+
+// Case insensitive search, as the version 4.0.0 but without copy
+static bool plainFind(const std::string& text, const std::string& pattern) {
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return lower.find(pattern) != std::string::npos;
+}
+
+static bool checkFilter() {
+    const FilterCase cases[] = {
+        { "wifi", "value 1 of WiFi: 7 ms", RemoteDebug::DEBUG, true },
+        { "WIFI", "value 1 of wifi: 7 ms", RemoteDebug::DEBUG, true },
+        { "wifi", "value 2 of mqtt: 14 ms", RemoteDebug::DEBUG, false },
+        { "wifi mqtt", "value 2 of mqtt: 14 ms", RemoteDebug::DEBUG, false },  // One text, as 4.0.0
+        { "of mqtt: 14", "value 2 of mqtt: 14 ms", RemoteDebug::DEBUG, true },
+        { "rssi -45 dbm", "value 5, rssi -45 dBm", RemoteDebug::DEBUG, true },
+        { " wifi ", "value 1 of wifi: 7 ms", RemoteDebug::DEBUG, true },
+        { "-mqtt", "value 2 of -mqtt", RemoteDebug::DEBUG, true },
+        { "wifi|mqtt", "value 2 of mqtt: 14 ms", RemoteDebug::DEBUG, true },
+        { "wifi | mqtt", "value 2 of mqtt: 14 ms", RemoteDebug::DEBUG, true },
+        { "wifi | mqtt", "value 3 of http: 21 ms", RemoteDebug::DEBUG, false },
+        { "-\"mqtt\"", "value 2 of mqtt: 14 ms", RemoteDebug::DEBUG, false },
+        { "-\"mqtt\"", "value 1 of wifi: 7 ms", RemoteDebug::DEBUG, true },
+        { "wifi | -ms", "value 1 of wifi: 7 ms", RemoteDebug::DEBUG, false },
+        { "\"of wifi\"", "value 1 of wifi: 7 ms", RemoteDebug::DEBUG, true },
+        { "\"of wifi\"", "of mqtt, wifi", RemoteDebug::DEBUG, false },
+        { "\"a|b\"", "x a|b", RemoteDebug::DEBUG, true },
+        { "\"a|b\"", "x a", RemoteDebug::DEBUG, false },
+        { "fn:loop", "(loop) value 1", RemoteDebug::DEBUG, true },
+        { "fn:loop", "(looper) value 1", RemoteDebug::DEBUG, false },
+        { "fn:loop|wifi", "(loop) value 2 of mqtt", RemoteDebug::DEBUG, false },
+        { "-fn:setup", "(setup) value 1", RemoteDebug::DEBUG, false },
+        { "level:we", "value 1", RemoteDebug::ERROR, true },
+        { "level:we", "value 1", RemoteDebug::DEBUG, false },
+        { "level:I | wifi", "value 1 of wifi", RemoteDebug::INFO, true },
+        { "level:I wifi", "level:i wifi", RemoteDebug::DEBUG, true },  // With a space: one text
+        { "p0", "xxp0x", RemoteDebug::DEBUG, true },  // '0' and 'p' have the same skip entry
+        { "wifi", "wif", RemoteDebug::DEBUG, false },
+        { "  ", "value 1", RemoteDebug::DEBUG, true },
+    };
+    RemoteDebugFilter filter;
+    for (const FilterCase& c : cases) {
+        if (!filter.compile(c.filter) || filter.match(c.line, strlen(c.line), c.level) != c.match) {
+            printf("check %-24s FAILED: '%s' on '%s'\n", "filter", c.filter, c.line);
+            return false;
+        }
+    }
+    if (filter.compile("a|b|c|d|e") || filter.compile(std::string(DEBUG_FILTER_SIZE + 1, 'a').c_str()) ||
+        filter.compile("level:x") || filter.isActive()) {
+        printf("check %-24s FAILED: too long\n", "filter");
+        return false;
+    }
+
+    // Against a plain search: few characters, patterns which nearly match
+    srand(1);
+    const char alphabet[] = "aAbB0p ";
+    for (int i = 0; i < 20000; i++) {
+        std::string line, pattern;
+        for (int j = rand() % 40; j > 0; j--) {
+            line += alphabet[rand() % (sizeof(alphabet) - 1)];
+        }
+        for (int j = 1 + rand() % 5; j > 0; j--) {
+            pattern += alphabet[rand() % (sizeof(alphabet) - 1)];  // Spaces are part of the text
+        }
+        if (pattern.front() == ' ' || pattern.back() == ' ') {  // Not at the ends
+            pattern.front() = pattern.back() = 'p';
+        }
+        filter.compile(pattern.c_str());
+        std::transform(pattern.begin(), pattern.end(), pattern.begin(), ::tolower);
+        if (filter.match(line.c_str(), line.length(), RemoteDebug::DEBUG) != plainFind(line, pattern)) {
+            printf("check %-24s FAILED: '%s' on '%s'\n", "filter", pattern.c_str(), line.c_str());
+            return false;
+        }
+    }
+
+    printf("check %-24s ok\n", "filter");
+    return true;
+}
+
+// ns/line of the search only, over the lines of the benchmark
+static void benchFilter(const char* text) {
+    const int count = quick ? 20000 : 2000000;
+    const int lines = 64;
+
+    std::vector<std::string> buffers;
+    for (int i = 0; i < lines; i++) {
+        char line[BUFFER_PRINT];
+        snprintf(line, sizeof(line), "(D) " LINE_FORMAT, LINE_ARGS(i));
+        buffers.push_back(line);
+    }
+    String lowerText = text;
+    lowerText.toLowerCase();
+    RemoteDebugFilter filter;
+    filter.compile(text);  // One text
+
+    for (int pass = 0; pass < 3; pass++) {
+        size_t found = 0;
+        size_t before = allocations;
+        unsigned long start = now();
+        for (int i = 0; i < count; i++) {
+            const std::string& line = buffers[i % lines];
+            if (pass == 0) {  // 4.0.0: lower case copy and indexOf
+                String aux = line.c_str();
+                aux.toLowerCase();
+                found += (aux.indexOf(lowerText) != -1);
+            } else if (pass == 1) {  // In place, compared at each position
+                const char* filterText = lowerText.c_str();
+                size_t sizeFilter = lowerText.length();
+                boolean match = false;
+                for (size_t p = 0; p + sizeFilter <= line.length() && !match; p++) {
+                    size_t j = 0;
+                    while (j < sizeFilter && tolower((uint8_t)line[p + j]) == filterText[j]) {
+                        j++;
+                    }
+                    match = (j == sizeFilter);
+                }
+                found += match;
+            } else {
+                found += filter.match(line.c_str(), line.length(), RemoteDebug::DEBUG);
+            }
+        }
+        unsigned long us = now() - start;
+
+        static const char* const passes[] = { "4.0.0", "in place", "compiled" };
+        char name[40];
+        snprintf(name, sizeof(name), "filter %s", text);
+        printf("%-8s %-24s %10.1f ns/line %6.2f allocations/line %5.1f%% shown\n", passes[pass], name, us * 1000.0 / count,
+               (double)(allocations - before) / count, found * 100.0 / count);
+    }
+}
+
+///// Slow client: writes sized to the window, lines dropped when the buffer is full
+
+static bool checkSlowClient() {
+    apply({ "level", false, false, false, NULL });
+    std::vector<int> ids = connectClients({ "" });
+    WiFiClient::capture = true;
+    WiFiClient::Connection& connection = WiFiClient::connections[ids[0]];
+    connection.received = "";
+
+    // Logs stop: the last line is sent by handle()
+    writeLine(Debug, RemoteDebug::DEBUG, 0);
+    Debug.handle();
+    delay(DELAY_TO_SEND + 1);
+    Debug.handle();
+    bool ok = countLines(connection.received, "", true) == 1;
+
+    // Window full, then a few bytes free by loop, then all
+    RemoteDebug::SendStats before = Debug.getSendStats();
+    connection.window = 0;
+    for (int i = 1; i <= 200; i++) {
+        writeLine(Debug, RemoteDebug::DEBUG, i);
+        Debug.handle();
+    }
+    for (int i = 201; i <= 400; i++) {
+        connection.window = 100;
+        writeLine(Debug, RemoteDebug::DEBUG, i);
+        Debug.handle();
+    }
+    connection.window = -1;
+    flushBoth();
+    WiFiClient::capture = false;
+    const RemoteDebug::SendStats& after = Debug.getSendStats();
+
+    // Complete lines in order, the bytes dropped are told
+    unsigned long told = 0;
+    int last = -1;
+    size_t pos = 0;
+    size_t end;
+    while (ok && (end = connection.received.find("\r\n", pos)) != std::string::npos) {
+        std::string line = connection.received.substr(pos, end - pos);
+        unsigned long dropped;
+        int i;
+        char expected[128];
+        if (sscanf(line.c_str(), "* Debug: %lu bytes dropped", &dropped) == 1) {
+            told += dropped;
+        } else if (sscanf(line.c_str(), "(D) (loop) value %d", &i) == 1 && i > last) {
+            snprintf(expected, sizeof(expected), "(D) " LINE_FORMAT, LINE_ARGS(i));
+            ok = (line + "\n" == expected);
+            last = i;
+        } else {
+            ok = false;
+        }
+        pos = end + 2;
+    }
+    ok = ok && pos == connection.received.size() && last == 400 && told > 0 && told == after.dropped - before.dropped &&
+         after.partial > before.partial;
+
+    if (!ok) {
+        printf("check %-24s FAILED\n%s\n", "slow client", connection.received.c_str());
+        return false;
+    }
+    printf("check %-24s ok (%lu bytes dropped)\n", "slow client", told);
+    return true;
+}
+
+// The same with deferred logs: frames whole or dropped, the drops told between two frames,
+// a log only after the format of its slot (a new format while the window is full)
+#define SLOW_FORMAT "slow client %d\n"
+
+static bool checkSlowClientDeferred() {
+    apply({ "level", false, false, false, NULL });
+    std::vector<int> ids = connectClients({ "" });
+    WiFiClient::capture = true;
+    WiFiClient::Connection& connection = WiFiClient::connections[ids[0]];
+    connection.received = "";
+
+    RemoteDebug::SendStats before = Debug.getSendStats();
+    connection.window = 0;
+    for (int i = 0; i < 400; i++) {
+        if (i >= 200) {
+            connection.window = 100;
+        }
+        writeDeferred(RemoteDebug::DEBUG, i);
+        if (i % 100 == 99) {  // New format, with the buffer full
+            Debug.deferred(DEBUG_FORMAT_ID(SLOW_FORMAT), SLOW_FORMAT, i);
+        }
+        Debug.handle();
+    }
+    connection.window = -1;
+    flushBoth();
+    Debug.deferred(DEBUG_FORMAT_ID(SLOW_FORMAT), SLOW_FORMAT, 400);
+    flushBoth();
+    WiFiClient::capture = false;
+    const RemoteDebug::SendStats& after = Debug.getSendStats();
+
+    const std::string& received = connection.received;
+    bool slots[256] = {};
+    unsigned long told = 0;
+    size_t logs = 0;
+    char type = 0;
+    size_t pos = 0;
+    bool ok = true;
+    while (ok && pos < received.size()) {
+        if ((uint8_t)received[pos] != 0x1E) {  // Text: only the bytes dropped
+            size_t end = received.find("\r\n", pos);
+            unsigned long dropped;
+            ok = end != std::string::npos && sscanf(received.c_str() + pos, "* Debug: %lu bytes dropped", &dropped) == 1;
+            told += dropped;
+            pos = end + 2;
+            continue;
+        }
+        type = received[pos + 1];
+        size_t size = 0;
+        size_t head = pos + 2;
+        for (int shift = 0; head < received.size(); shift += 7) {
+            uint8_t byte = received[head++];
+            size |= (size_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        uint8_t slot = received[head];
+        ok = head + size <= received.size() && (type == 'F' || (type == 'L' && slots[slot]));
+        slots[slot] = slots[slot] || type == 'F';
+        logs += (type == 'L');
+        pos = head + size;
+    }
+    ok = ok && pos == received.size() && type == 'L' && logs > 0 && told > 0 && told == after.dropped - before.dropped;
+
+    if (!ok) {
+        printf("check %-24s FAILED at %zu of %zu bytes\n", "slow client deferred", pos, received.size());
+        return false;
+    }
+    printf("check %-24s ok (%zu logs, %lu bytes dropped)\n", "slow client deferred", logs, told);
+    return true;
+}
+
+// Levels of the deferred logs ('L' frames) received
+static std::string deferredLevels(const std::string& received) {
+    std::string levels;
+    size_t pos = 0;
+    while ((pos = received.find('\x1E', pos)) != std::string::npos && pos + 4 < received.size()) {
+        char type = received[pos + 1];
+        size_t size = 0;
+        size_t head = pos + 2;
+        for (int shift = 0; head < received.size(); shift += 7) {
+            uint8_t byte = received[head++];
+            size |= (size_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        if (type == 'L' && head + 1 < received.size()) {
+            levels += (char)('0' + received[head + 1]);  // After the slot
+        }
+        pos = head + size;
+    }
+    return levels;
+}
+
+// The deferred logs have no text: only the level:wie of the filter is used
+static bool checkFilterDeferred() {
+    apply({ "level", false, false, false, NULL });
+    WiFiClient::capture = true;
+    std::vector<int> ids = connectClients({ "", "filter level:e\r\n", "filter level:wi | wifi\r\n" });
+    for (int id : ids) {
+        WiFiClient::connections[id].received = "";
+    }
+    for (int i = 0; i < 100; i++) {
+        writeDeferred(RemoteDebug::DEBUG + i % 4, i);
+    }
+    flushBoth();
+    WiFiClient::capture = false;
+
+    std::string all = deferredLevels(WiFiClient::connections[ids[0]].received);
+    std::string errors = deferredLevels(WiFiClient::connections[ids[1]].received);
+    std::string infos = deferredLevels(WiFiClient::connections[ids[2]].received);
+    char error = '0' + RemoteDebug::ERROR;
+    if (all.size() != 100 || errors != std::string(25, error) || infos.size() != 50 || infos.find(error) != std::string::npos ||
+        infos.find('0' + RemoteDebug::DEBUG) != std::string::npos) {
+        printf("check %-24s FAILED: %zu / %zu / %zu logs\n", "filter deferred", all.size(), errors.size(), infos.size());
+        return false;
+    }
+    printf("check %-24s ok\n", "filter deferred");
+    return true;
+}
+
+// Lines dropped and time in the buffer with a window of some bytes free by loop (16 lines)
+static void benchSlowClient(int window) {
+    const int count = quick ? 2000 : 200000;
+    std::vector<int> ids = connectClients({ "" });
+    WiFiClient::Connection& connection = WiFiClient::connections[ids[0]];
+    RemoteDebug::SendStats before = Debug.getSendStats();
+    size_t bytes = WiFiClient::bytes;
+
+    for (int i = 0; i < count; i++) {
+        if (i % 16 == 0) {
+            connection.window = window;
+        }
+        writeLine(Debug, RemoteDebug::DEBUG, i);
+    }
+    connection.window = -1;
+    flushBoth();
+
+    const RemoteDebug::SendStats& after = Debug.getSendStats();
+    uint32_t writes = after.writes - before.writes;
+    printf("slow client %5d bytes/loop %6.2f%% bytes dropped %8.1f bytes/write %8.1f us in the buffer\n", window,
+           100.0 * (after.dropped - before.dropped) / (after.dropped - before.dropped + WiFiClient::bytes - bytes),
+           writes ? (double)(after.bytes - before.bytes) / writes : 0.0, writes ? (double)(after.latency - before.latency) / writes : 0.0);
+}
+
+int main(int argc, char** argv) {
+    const char* deferredOut = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        } else if (strcmp(argv[i], "--deferred-out") == 0 && i + 1 < argc) {
+            deferredOut = argv[++i];
+        }
+    }
+
+    Debug.begin("host");
+    WiFiServer::connectClient();
+    Debug.handle();
+    if (!Debug.isConnected()) {
+        printf("telnet client not connected\n");
+        return 1;
+    }
+    LegacyClient = WiFiClient(Debug.getTelnetClient()[0]);
+    Legacy._client = &LegacyClient;
+
+    const Setting checks[] = {
+        { "level", false, false, false, NULL },
+        { "level colors", false, false, true, NULL },
+        { "level colors filter", false, false, true, "WIFI" },
+    };
+    bool ok = true;
+    for (const Setting& setting : checks) {
+        ok = check(setting) && ok;
+    }
+
+    const Setting settings[] = {
+        { "level", false, false, false, NULL },
+        { "level time profiler", true, true, false, NULL },
+        { "all colors", true, true, true, NULL },
+        { "filter (1 of 4 shown)", false, false, false, "wifi" },
+    };
+    for (const Setting& setting : settings) {
+        bench(setting);
+    }
+
+    benchDeferred();
+    if (deferredOut) {
+        ok = writeDeferredStream(deferredOut) && ok;
+    }
+
+#ifdef DEBUG_RING_SIZE
+    for (int threads : { 1, 2, 4 }) {
+        ok = benchThreads(threads) && ok;
+    }
+#endif
+
+    ok = checkFilter() && ok;
+    for (const char* text : { "wifi", "rssi -45 dbm" }) {
+        benchFilter(text);
+    }
+
+    ok = checkClients() && ok;
+    for (int clients : { 1, 4, 8 }) {
+        benchClients(clients);
+    }
+
+    ok = checkSlowClient() && ok;
+    ok = checkSlowClientDeferred() && ok;
+    ok = checkFilterDeferred() && ok;
+    for (int window : { 256, 1024, 4096 }) {
+        benchSlowClient(window);
+    }
+
+    return ok ? 0 : 1;
+}
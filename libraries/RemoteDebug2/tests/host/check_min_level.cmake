@@ -0,0 +1,40 @@
+# REMOTEDEBUG_MIN_LEVEL: the format strings of the levels below it must not be in the binary
+#
+#   cmake -DALL=bench_level_0 -DMIN=bench_level_3 [-DOBJECTS=all.o;min.o] [-DARGS=--quick] -P check_min_level.cmake
+
+function(check binary text expected)
+    file(STRINGS ${binary} found REGEX "${text}")
+    if(found AND NOT expected)
+        message(FATAL_ERROR "${binary}: \"${text}\" compiled")
+    elseif(NOT found AND expected)
+        message(FATAL_ERROR "${binary}: \"${text}\" not found")
+    endif()
+endfunction()
+
+check(${ALL} "min level: verbose" TRUE)
+check(${ALL} "min level: debug" TRUE)
+check(${ALL} "min level: info" TRUE)
+check(${MIN} "min level: verbose" FALSE)
+check(${MIN} "min level: debug" FALSE)
+check(${MIN} "min level: info" TRUE)
+
+# size of the sketch: object files if given (the binaries are rounded to pages)
+if(OBJECTS)
+    list(GET OBJECTS 0 sizeAll)
+    list(GET OBJECTS 1 sizeMin)
+else()
+    set(sizeAll ${ALL})
+    set(sizeMin ${MIN})
+endif()
+file(SIZE ${sizeAll} sizeAll)
+file(SIZE ${sizeMin} sizeMin)
+math(EXPR saved "${sizeAll} - ${sizeMin}")
+message(STATUS "size: ${sizeAll} bytes with all the levels, ${sizeMin} with info and above (${saved} less)")
+
+foreach(binary ${ALL} ${MIN})
+    execute_process(COMMAND ${binary} ${ARGS} RESULT_VARIABLE result OUTPUT_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${binary}: ${output}")
+    endif()
+    message(STATUS "${output}")
+endforeach()
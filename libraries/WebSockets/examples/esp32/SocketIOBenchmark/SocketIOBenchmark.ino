@@ -0,0 +1,129 @@
+/*
+ * SocketIOBenchmark.ino
+ *
+ *  Created on: 19.10.2026
+ *
+ * throughput of 1 KB Socket.IO events:
+ *  - String:        serializeJson to a String, sendEVENT(String)
+ *  - JsonDocument:  sendEVENT(doc), serialized behind the reserved header room
+ *  - header room:   own buffer with SIO_MAX_HEADER_SIZE reserved, sendEVENT(buffer, length, true)
+ */
+
+#include <Arduino.h>
+
+#include <WiFi.h>
+#include <WiFiMulti.h>
+
+#include <ArduinoJson.h>
+
+#include <WebSocketsClient.h>
+#include <SocketIOclient.h>
+
+WiFiMulti WiFiMulti;
+SocketIOclient socketIO;
+
+#define USE_SERIAL Serial
+
+#define EVENTS 200
+
+JsonDocument doc;
+
+void buildEvent() {
+    JsonArray array = doc.to<JsonArray>();
+    array.add("telemetry");
+    JsonArray samples = array.add<JsonArray>();
+    // about 1 KB serialized
+    for(int i = 0; i < 40; i++) {
+        JsonObject sample = samples.add<JsonObject>();
+        sample["t"]       = 1700000000UL + i;
+        sample["v"]       = 20.0 + i * 0.25;
+    }
+}
+
+void report(const char * name, uint32_t time, size_t length, uint32_t minHeap) {
+    uint32_t perEvent = time / EVENTS;
+    uint32_t kbps     = time ? (uint32_t)((uint64_t)length * EVENTS * 1000000ULL / 1024 / time) : 0;
+    USE_SERIAL.printf("[BENCH] %-12s %u byte: %5u us/event %5u KB/s min heap %u\n", name, (unsigned)length, perEvent, kbps, minHeap);
+}
+
+void benchmark() {
+    size_t length = measureJson(doc);
+    uint32_t minHeap;
+    uint32_t start;
+
+    // String
+    minHeap = ESP.getFreeHeap();
+    start   = micros();
+    for(int i = 0; i < EVENTS; i++) {
+        String output;
+        serializeJson(doc, output);
+        socketIO.sendEVENT(output);
+        minHeap = min(minHeap, ESP.getFreeHeap());
+    }
+    report("String", micros() - start, length, minHeap);
+
+    // JsonDocument
+    minHeap = ESP.getFreeHeap();
+    start   = micros();
+    for(int i = 0; i < EVENTS; i++) {
+        socketIO.sendEVENT(doc);
+        minHeap = min(minHeap, ESP.getFreeHeap());
+    }
+    report("JsonDocument", micros() - start, length, minHeap);
+
+    // header room, buffer is reused
+    uint8_t * buffer = (uint8_t *)malloc(SIO_MAX_HEADER_SIZE + length + 1);
+    minHeap          = ESP.getFreeHeap();
+    start            = micros();
+    for(int i = 0; i < EVENTS; i++) {
+        serializeJson(doc, (char *)(buffer + SIO_MAX_HEADER_SIZE), length + 1);
+        socketIO.sendEVENT(buffer, length, true);
+        minHeap = min(minHeap, ESP.getFreeHeap());
+    }
+    report("header room", micros() - start, length, minHeap);
+    free(buffer);
+}
+
+void socketIOEvent(socketIOmessageType_t type, uint8_t * payload, size_t length) {
+    switch(type) {
+        case sIOtype_DISCONNECT:
+            USE_SERIAL.printf("[IOc] Disconnected!\n");
+            break;
+        case sIOtype_CONNECT:
+            USE_SERIAL.printf("[IOc] Connected to url: %s\n", payload);
+
+            // join default namespace (no auto join in Socket.IO V3)
+            socketIO.send(sIOtype_CONNECT, "/");
+
+            benchmark();
+            break;
+        default:
+            break;
+    }
+}
+
+void setup() {
+    USE_SERIAL.begin(115200);
+
+    USE_SERIAL.println();
+    USE_SERIAL.println();
+    USE_SERIAL.println();
+
+    buildEvent();
+
+    WiFiMulti.addAP("SSID", "passpasspass");
+
+    while(WiFiMulti.run() != WL_CONNECTED) {
+        delay(100);
+    }
+
+    // server address, port and URL
+    socketIO.begin("10.11.100.100", 8880, "/socket.io/?EIO=4");
+
+    // event handler
+    socketIO.onEvent(socketIOEvent);
+}
+
+void loop() {
+    socketIO.loop();
+}
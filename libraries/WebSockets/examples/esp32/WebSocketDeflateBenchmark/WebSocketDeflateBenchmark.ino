@@ -0,0 +1,134 @@
+/*
+ * WebSocketDeflateBenchmark.ino
+ *
+ *  Created on: 19.10.2026
+ *
+ * measures ratio, time and memory of the permessage-deflate settings
+ * for a typical telemetry JSON message and starts a server with compression enabled
+ */
+
+#include <Arduino.h>
+
+#include <WiFi.h>
+#include <WiFiMulti.h>
+
+#include <WebSocketsServer.h>
+
+extern "C" {
+#include <librawdeflate/rawdeflate.h>
+}
+
+WiFiMulti WiFiMulti;
+WebSocketsServer webSocket = WebSocketsServer(81);
+
+#define USE_SERIAL Serial
+
+#define RUNS 20
+
+String telemetry;
+
+void buildTelemetry() {
+    telemetry = "[";
+    for(int i = 0; i < 100; i++) {
+        if(i) {
+            telemetry += ",";
+        }
+        telemetry += "{\"id\":" + String(i);
+        telemetry += ",\"ts\":" + String(1700000000UL + i * 10);
+        telemetry += ",\"temperature\":" + String(20.0 + (i % 17) * 0.25, 2);
+        telemetry += ",\"humidity\":" + String(40 + (i % 23));
+        telemetry += ",\"rssi\":" + String(-40 - (i % 31));
+        telemetry += ",\"status\":\"" + String((i % 5) ? "ok" : "warn") + "\"}";
+    }
+    telemetry += "]";
+}
+
+void benchmark(uint8_t windowBits, uint8_t hashBits) {
+    size_t inLen   = telemetry.length();
+    size_t work    = rawdeflate_work_size(windowBits, hashBits);
+    void * workPtr = malloc(work);
+    uint8_t * out  = (uint8_t *)malloc(inLen);
+
+    if(!workPtr || !out) {
+        USE_SERIAL.printf("[BENCH] %2u/%2u not enough heap (%u)\n", windowBits, hashBits, work);
+        free(workPtr);
+        free(out);
+        return;
+    }
+
+    size_t outLen  = 0;
+    uint32_t start = micros();
+    for(int i = 0; i < RUNS; i++) {
+        outLen = rawdeflate_compress_message((const uint8_t *)telemetry.c_str(), inLen, out, inLen, windowBits, hashBits, WEBSOCKETS_DEFLATE_MAX_CHAIN, workPtr);
+    }
+    uint32_t deflateTime = (micros() - start) / RUNS;
+    free(workPtr);
+
+    uint8_t * inflated = NULL;
+    size_t inflatedLen = 0;
+    uint32_t heap      = ESP.getFreeHeap();
+    uint32_t minHeap   = heap;
+    start              = micros();
+    for(int i = 0; i < RUNS; i++) {
+        rawdeflate_inflate_message(out, outLen, &inflated, &inflatedLen, WEBSOCKETS_MAX_DATA_SIZE);
+        minHeap = min(minHeap, ESP.getFreeHeap());
+        free(inflated);
+    }
+    uint32_t inflateTime = (micros() - start) / RUNS;
+    free(out);
+
+    USE_SERIAL.printf("[BENCH] window %2u hash %2u: %u -> %u byte (%u.%02u:1) deflate %6u us inflate %5u us work %6u byte inflate heap %u byte\n",
+        windowBits, hashBits, inLen, outLen, outLen ? inLen / outLen : 0, outLen ? (inLen * 100 / outLen) % 100 : 0,
+        deflateTime, inflateTime, work, heap - minHeap);
+}
+
+void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length) {
+    switch(type) {
+        case WStype_DISCONNECTED:
+            USE_SERIAL.printf("[%u] Disconnected!\n", num);
+            break;
+        case WStype_CONNECTED:
+            USE_SERIAL.printf("[%u] Connected url: %s deflate: %d\n", num, payload, webSocket.isDeflate(num));
+            break;
+        case WStype_TEXT:
+            // answer every message with the telemetry, compressed if the client supports it
+            webSocket.sendTXT(num, telemetry);
+            break;
+        default:
+            break;
+    }
+}
+
+void setup() {
+    USE_SERIAL.begin(115200);
+
+    USE_SERIAL.println();
+    USE_SERIAL.println();
+    USE_SERIAL.println();
+
+    buildTelemetry();
+
+    USE_SERIAL.printf("[BENCH] telemetry %u byte, free heap %u\n", telemetry.length(), ESP.getFreeHeap());
+    benchmark(8, 8);
+    benchmark(10, 10);
+    benchmark(12, 12);
+    benchmark(15, 15);
+
+    WiFiMulti.addAP("SSID", "passpasspass");
+
+    while(WiFiMulti.run() != WL_CONNECTED) {
+        delay(100);
+    }
+
+    WSdeflateConfig_t config;
+    config.windowBits = 10;
+    config.hashBits   = 10;
+
+    webSocket.enableDeflate(config);
+    webSocket.begin();
+    webSocket.onEvent(webSocketEvent);
+}
+
+void loop() {
+    webSocket.loop();
+}
@@ -0,0 +1,141 @@
+/*
+ * WebSocketSendBenchmark.ino
+ *
+ *  Created on: 19.10.2026
+ *
+ * counts heap allocations and socket writes (TCP segments with NoDelay) per frame
+ * for sendBIN with and without reserved header room, the results are printed
+ * when a client connects (e.g. the browser console: new WebSocket("ws://<ip>:81/"))
+ */
+
+#include <Arduino.h>
+
+#include <WiFi.h>
+#include <WiFiMulti.h>
+
+#include <WebSocketsServer.h>
+
+#include <esp_heap_caps.h>
+
+#define USE_SERIAL Serial
+
+#define FRAMES 100
+
+class CountingWebSocketsServer : public WebSocketsServer {
+  public:
+    CountingWebSocketsServer(uint16_t port)
+        : WebSocketsServer(port) {
+    }
+
+    uint32_t writes;
+    uint32_t allocs;
+    size_t blocks;
+
+    void reset() {
+        writes = 0;
+        allocs = 0;
+        blocks = allocatedBlocks();
+    }
+
+    static size_t allocatedBlocks() {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+        return info.allocated_blocks;
+    }
+
+  protected:
+    size_t write(WSclient_t * client, uint8_t * out, size_t n) override {
+        writes++;
+        // a buffer allocated by sendFrame is still alive while it is written
+        if(allocatedBlocks() > blocks) {
+            allocs++;
+        }
+        return WebSocketsServer::write(client, out, n);
+    }
+
+    size_t writev(WSclient_t * client, WSiovec_t * iov, uint8_t count) override {
+        uint32_t before = writes;
+        size_t ret      = WebSocketsServer::writev(client, iov, count);
+        if(writes == before) {
+            // send by the socket writev
+            writes++;
+        }
+        return ret;
+    }
+};
+
+WiFiMulti WiFiMulti;
+CountingWebSocketsServer webSocket = CountingWebSocketsServer(81);
+
+const size_t sizes[] = { 16, 125, 512, 1200, 4096 };
+
+void benchmark(uint8_t num) {
+    for(size_t s = 0; s < (sizeof(sizes) / sizeof(sizes[0])); s++) {
+        size_t length = sizes[s];
+
+        // payload with WEBSOCKETS_HEADER_ROOM reserved in front
+        uint8_t * buffer  = (uint8_t *)malloc(WEBSOCKETS_HEADER_ROOM + length);
+        uint8_t * payload = buffer + WEBSOCKETS_HEADER_ROOM;
+        memset(payload, 'x', length);
+
+        webSocket.reset();
+        uint32_t start = micros();
+        for(int i = 0; i < FRAMES; i++) {
+            webSocket.sendBIN(num, (const uint8_t *)payload, length);
+        }
+        uint32_t time   = (micros() - start) / FRAMES;
+        uint32_t writes = webSocket.writes;
+        uint32_t allocs = webSocket.allocs;
+
+        webSocket.reset();
+        start = micros();
+        for(int i = 0; i < FRAMES; i++) {
+            webSocket.sendBIN(num, buffer, length, true);
+        }
+        uint32_t timeRoom   = (micros() - start) / FRAMES;
+        uint32_t writesRoom = webSocket.writes;
+        uint32_t allocsRoom = webSocket.allocs;
+
+        USE_SERIAL.printf("[BENCH] %4u byte: sendBIN %u.%02u writes %u.%02u allocs %4u us | header room %u.%02u writes %u.%02u allocs %4u us\n",
+            length,
+            writes / FRAMES, writes % FRAMES, allocs / FRAMES, allocs % FRAMES, time,
+            writesRoom / FRAMES, writesRoom % FRAMES, allocsRoom / FRAMES, allocsRoom % FRAMES, timeRoom);
+
+        free(buffer);
+    }
+}
+
+void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length) {
+    switch(type) {
+        case WStype_DISCONNECTED:
+            USE_SERIAL.printf("[%u] Disconnected!\n", num);
+            break;
+        case WStype_CONNECTED:
+            USE_SERIAL.printf("[%u] Connected url: %s\n", num, payload);
+            benchmark(num);
+            break;
+        default:
+            break;
+    }
+}
+
+void setup() {
+    USE_SERIAL.begin(115200);
+
+    USE_SERIAL.println();
+    USE_SERIAL.println();
+    USE_SERIAL.println();
+
+    WiFiMulti.addAP("SSID", "passpasspass");
+
+    while(WiFiMulti.run() != WL_CONNECTED) {
+        delay(100);
+    }
+
+    webSocket.begin();
+    webSocket.onEvent(webSocketEvent);
+}
+
+void loop() {
+    webSocket.loop();
+}
@@ -0,0 +1,92 @@
+/*
+ * WebSocketClientSSLResume.ino
+ *
+ *  Created on: 19.10.2026
+ *
+ * reconnects to a wss server every few seconds and prints the time of the
+ * TLS handshake, full (first connect) against resumed (session of the last connection)
+ *
+ * TLS session resumption needs BearSSL (ESP8266 / RP2040)
+ */
+
+#include <Arduino.h>
+
+#include <ESP8266WiFi.h>
+#include <ESP8266WiFiMulti.h>
+
+#include <WebSocketsClient.h>
+
+ESP8266WiFiMulti WiFiMulti;
+WebSocketsClient webSocket;
+
+#define USE_SERIAL Serial
+
+// connections of each kind and their summed TLS time (us)
+uint32_t fullCount      = 0;
+uint32_t fullTime       = 0;
+uint32_t resumedCount   = 0;
+uint32_t resumedTime    = 0;
+unsigned long connected = 0;
+
+void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
+    switch(type) {
+        case WStype_DISCONNECTED:
+            USE_SERIAL.printf("[WSc] Disconnected!\n");
+            connected = 0;
+            break;
+        case WStype_CONNECTED: {
+            const WSconnectTiming_t & t = webSocket.getConnectTiming();
+            if(t.tlsSession) {
+                resumedCount++;
+                resumedTime += t.tls;
+            } else {
+                fullCount++;
+                fullTime += t.tls;
+            }
+            USE_SERIAL.printf("[WSc] Connected, %s handshake: tls %u us upgrade %u us total %u us heap %u\n", t.tlsSession ? "resumed" : "full", t.tls, t.upgrade, t.total, ESP.getFreeHeap());
+            if(fullCount && resumedCount) {
+                USE_SERIAL.printf("[WSc] avg tls full %u us (%u) resumed %u us (%u)\n", fullTime / fullCount, fullCount, resumedTime / resumedCount, resumedCount);
+            }
+            connected = millis();
+        } break;
+        default:
+            break;
+    }
+}
+
+void setup() {
+    USE_SERIAL.begin(115200);
+
+    USE_SERIAL.println();
+    USE_SERIAL.println();
+    USE_SERIAL.println();
+
+    for(uint8_t t = 4; t > 0; t--) {
+        USE_SERIAL.printf("[SETUP] BOOT WAIT %d...\n", t);
+        USE_SERIAL.flush();
+        delay(1000);
+    }
+
+    WiFiMulti.addAP("SSID", "passpasspass");
+
+    while(WiFiMulti.run() != WL_CONNECTED) {
+        delay(100);
+    }
+
+    webSocket.beginSSL("echo.websocket.org", 443, "/");
+    webSocket.onEvent(webSocketEvent);
+
+    // 0.5s, 1s, 2s ... up to 30s while the server is not reachable, +- 50%
+    webSocket.setReconnectInterval(500);
+    webSocket.setReconnectBackoff(30000, 50);
+}
+
+void loop() {
+    webSocket.loop();
+
+    // close the connection after 3s to measure the next handshake
+    if(connected && (millis() - connected) > 3000) {
+        connected = 0;
+        webSocket.disconnect();
+    }
+}
@@ -67,7 +67,8 @@ void SocketIOclient::configureEIOping(bool disableHeartbeat) {
 }
 
 void SocketIOclient::initClient(void) {
-    if(_client.cUrl.indexOf("EIO=4") != -1) {
+    _isEIO4 = (_client.cUrl.indexOf("EIO=4") != -1);
+    if(_isEIO4) {
         DEBUG_WEBSOCKETS("[wsIOc] found EIO=4 disable EIO ping on client\n");
         configureEIOping(true);
     }
@@ -81,6 +82,136 @@ void SocketIOclient::onEvent(SocketIOclientEvent cbEvent) {
     _cbEvent = cbEvent;
 }
 
+/**
+ * register a handler for a event, replaces the handler if the event is already registered.
+ * EVENT packets of registered events go to the handler, all other messages to the onEvent callback.
+ * Note: the handlers can not be changed from inside a handler
+ * @param event const char *  event name
+ * @param handler SocketIOeventHandler
+ * @return true if ok, false if the table is full (SIO_EVENT_HANDLER_MAX)
+ */
+bool SocketIOclient::on(const char * event, SocketIOeventHandler handler) {
+    if(!event || !event[0]) {
+        return false;
+    }
+    size_t length = strlen(event);
+    uint32_t hash = hashEvent(event, length);
+
+    int slot = findHandler(event, length, hash);
+    if(slot >= 0) {
+        _handlers[slot].handler = handler;
+        return true;
+    }
+
+    // keep one slot free, a lookup ends at a free slot
+    if(_handlerCount >= (SIO_EVENT_HANDLER_MAX - 1)) {
+        DEBUG_WEBSOCKETS("[wsIOc] no room for event handler %s\n", event);
+        return false;
+    }
+
+    for(uint8_t i = 0; i < SIO_EVENT_HANDLER_MAX; i++) {
+        slot = (hash + i) & (SIO_EVENT_HANDLER_MAX - 1);
+        // free or removed slot
+        if(!_handlers[slot].used || _handlers[slot].name.length() == 0) {
+            _handlers[slot].hash    = hash;
+            _handlers[slot].name    = event;
+            _handlers[slot].handler = handler;
+            _handlers[slot].used    = true;
+            _handlerCount++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * remove the handler of a event
+ * @param event const char *
+ * @return true if the event was registered
+ */
+bool SocketIOclient::off(const char * event) {
+    if(!event || !event[0]) {
+        return false;
+    }
+    size_t length = strlen(event);
+    int slot      = findHandler(event, length, hashEvent(event, length));
+    if(slot < 0) {
+        return false;
+    }
+    // the slot stays used so lookups of events behind it go on
+    _handlers[slot].name    = "";
+    _handlers[slot].handler = nullptr;
+    _handlerCount--;
+    return true;
+}
+
+/**
+ * FNV-1a hash of the event name
+ * @param name const char *
+ * @param length size_t
+ * @return uint32_t
+ */
+uint32_t SocketIOclient::hashEvent(const char * name, size_t length) {
+    uint32_t hash = 2166136261UL;
+    for(size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/**
+ * find the slot of a event in the handler table
+ * @param name const char *  not null terminated
+ * @param length size_t
+ * @param hash uint32_t  hashEvent(name, length)
+ * @return slot or -1
+ */
+int SocketIOclient::findHandler(const char * name, size_t length, uint32_t hash) {
+    for(uint8_t i = 0; i < SIO_EVENT_HANDLER_MAX; i++) {
+        int slot = (hash + i) & (SIO_EVENT_HANDLER_MAX - 1);
+        if(!_handlers[slot].used) {
+            return -1;
+        }
+        if(_handlers[slot].hash == hash && _handlers[slot].name.length() == length && memcmp(_handlers[slot].name.c_str(), name, length) == 0) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+/**
+ * run the handler of a EVENT packet
+ * @param payload uint8_t *  Socket.IO packet (starts with the type)
+ * @param length size_t
+ * @return true if a handler was found
+ */
+bool SocketIOclient::dispatchEvent(uint8_t * payload, size_t length) {
+    if(_handlerCount == 0) {
+        return false;
+    }
+
+    SocketIOpacket_t packet;
+    if(!SocketIOargs::parsePacket(payload, length, &packet) || packet.type != sIOtype_EVENT) {
+        return false;
+    }
+
+    SocketIOargs args(packet.data, packet.length);
+    size_t nameLength;
+    const char * name = args.event(&nameLength);
+    if(!name) {
+        return false;
+    }
+
+    int slot = findHandler(name, nameLength, hashEvent(name, nameLength));
+    if(slot < 0) {
+        return false;
+    }
+
+    _handlers[slot].handler(args, packet);
+    return true;
+}
+
 bool SocketIOclient::isConnected(void) {
     return WebSocketsClient::isConnected();
 }
@@ -103,34 +234,78 @@ void SocketIOclient::disconnect(void) {
  * @param type socketIOmessageType_t
  * @param payload uint8_t *
  * @param length size_t
- * @param headerToPayload bool (see sendFrame for more details)
+ * @param headerToPayload bool  payload has SIO_MAX_HEADER_SIZE (16) Byte reserved at the beginning (see sendFrame for more details)
  * @return true if ok
  */
 bool SocketIOclient::send(socketIOmessageType_t type, uint8_t * payload, size_t length, bool headerToPayload) {
-    bool ret = false;
-    if(length == 0) {
-        length = strlen((const char *)payload);
+    if(length == 0 && payload) {
+        length = strlen((const char *)(payload + (headerToPayload ? SIO_MAX_HEADER_SIZE : 0)));
     }
     if(clientIsConnected(&_client) && _client.status == WSC_CONNECTED) {
         if(!headerToPayload) {
-            // webSocket Header
-            ret = WebSocketsClient::sendFrameHeader(&_client, WSop_text, length + 2, true);
-            // Engine.IO / Socket.IO Header
-            if(ret) {
-                uint8_t buf[3] = { eIOtype_MESSAGE, type, 0x00 };
-                ret            = WebSocketsClient::write(&_client, buf, 2);
-            }
-            if(ret && payload && length > 0) {
-                ret = WebSocketsClient::write(&_client, payload, length);
-            }
-            return ret;
+            // webSocket Header, Engine.IO / Socket.IO Header and payload with one write
+            uint8_t buf[2] = { eIOtype_MESSAGE, type };
+            return sendPrefixed(WSop_text, &buf[0], 2, payload, length);
         } else {
-            // TODO implement
+            // Engine.IO / Socket.IO Header directly in front of the payload, the webSocket Header is added by sendFrame
+            payload[EIO_MAX_HEADER_SIZE - 1] = eIOtype_MESSAGE;
+            payload[SIO_MAX_HEADER_SIZE - 1] = type;
+            return WebSocketsClient::sendFrame(&_client, WSop_text, payload, length + 2, true, true);
         }
     }
     return false;
 }
 
+/**
+ * send a frame made of a prefix and the payload with one write, the payload is not copied
+ * @param opcode WSopcode_t
+ * @param prefix const uint8_t *  Engine.IO / Socket.IO Header
+ * @param prefixLength size_t
+ * @param payload const uint8_t *
+ * @param length size_t
+ * @return true if ok
+ */
+bool SocketIOclient::sendPrefixed(WSopcode_t opcode, const uint8_t * prefix, size_t prefixLength, const uint8_t * payload, size_t length) {
+    uint8_t maskKey[4]                         = { 0x00, 0x00, 0x00, 0x00 };
+    uint8_t header[WEBSOCKETS_MAX_HEADER_SIZE] = { 0 };
+    WSiovec_t iov[3];
+    uint8_t count = 0;
+
+    if(!prefix) {
+        prefixLength = 0;
+    }
+    if(!payload) {
+        length = 0;
+    }
+
+    size_t total = createHeader(&header[0], opcode, (prefixLength + length), _client.cIsClient, maskKey, true);
+    WEBSOCKETS_METRIC_ADD(&_client, framesOut, 1);
+
+    iov[count].data   = &header[0];
+    iov[count].length = total;
+    count++;
+
+    if(prefixLength > 0) {
+        iov[count].data   = prefix;
+        iov[count].length = prefixLength;
+        count++;
+    }
+
+    if(length > 0) {
+        iov[count].data   = payload;
+        iov[count].length = length;
+        count++;
+    }
+
+    // written directly, the frames collected by enableCoalescing go first
+    if(_client.cTxLength > 0) {
+        flushCoalesced(&_client);
+    }
+
+    total += prefixLength + length;
+    return (writev(&_client, &iov[0], count) == total);
+}
+
 bool SocketIOclient::send(socketIOmessageType_t type, const uint8_t * payload, size_t length) {
     return send(type, (uint8_t *)payload, length);
 }
@@ -175,6 +350,45 @@ bool SocketIOclient::sendEVENT(String & payload) {
     return sendEVENT((uint8_t *)payload.c_str(), payload.length());
 }
 
+/**
+ * send a binary event with attachments
+ * the attachments are send as binary frames after the event, without copying them
+ * @param payload uint8_t *  event array with placeholders e.g. ["upload",{"_placeholder":true,"num":0}]
+ * @param length size_t
+ * @param attachments const WSiovec_t *  data of the attachments (num 0 ... count - 1)
+ * @param count uint8_t  number of attachments
+ * @return true if ok
+ */
+bool SocketIOclient::sendBinaryEVENT(uint8_t * payload, size_t length, const WSiovec_t * attachments, uint8_t count) {
+    if(length == 0 && payload) {
+        length = strlen((const char *)payload);
+    }
+    if(!clientIsConnected(&_client) || _client.status != WSC_CONNECTED) {
+        return false;
+    }
+
+    // Engine.IO / Socket.IO Header with the number of attachments "45<count>-"
+    char prefix[8];
+    size_t prefixLength = snprintf(prefix, sizeof(prefix), "%c%c%u-", eIOtype_MESSAGE, sIOtype_BINARY_EVENT, count);
+
+    bool ret = sendPrefixed(WSop_text, (const uint8_t *)&prefix[0], prefixLength, payload, length);
+
+    // EIO=3 marks binary messages with the type as raw byte, EIO=4 sends the data only
+    uint8_t binaryType = (eIOtype_MESSAGE - '0');
+    for(uint8_t i = 0; (i < count) && ret; i++) {
+        if(_isEIO4) {
+            ret = sendPrefixed(WSop_binary, NULL, 0, attachments[i].data, attachments[i].length);
+        } else {
+            ret = sendPrefixed(WSop_binary, &binaryType, 1, attachments[i].data, attachments[i].length);
+        }
+    }
+    return ret;
+}
+
+bool SocketIOclient::sendBinaryEVENT(const char * payload, const WSiovec_t * attachments, uint8_t count) {
+    return sendBinaryEVENT((uint8_t *)payload, 0, attachments, count);
+}
+
 void SocketIOclient::loop(void) {
     WebSocketsClient::loop();
     unsigned long t = millis();
@@ -224,6 +438,9 @@ void SocketIOclient::handleCbEvent(WStype_t type, uint8_t * payload, size_t leng
                     switch(ioType) {
                         case sIOtype_EVENT:
                             DEBUG_WEBSOCKETS("[wsIOc] get event (%d): %s\n", lData, data);
+                            if(dispatchEvent(&payload[1], length - 1)) {
+                                return;
+                            }
                             break;
                         case sIOtype_CONNECT:
                             DEBUG_WEBSOCKETS("[wsIOc] connected (%d): %s\n", lData, data);
@@ -259,6 +476,391 @@ void SocketIOclient::handleCbEvent(WStype_t type, uint8_t * payload, size_t leng
         case WStype_FRAGMENT_FIN:
         case WStype_PING:
         case WStype_PONG:
+        case WStype_STREAM:
+        case WStype_MESSAGE:
             break;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * parse the header of a Socket.IO packet, nothing is copied
+ * @param payload const uint8_t *  packet (after the Engine.IO type) e.g. 2/chat,12["event",1]
+ * @param length size_t
+ * @param packet SocketIOpacket_t *
+ * @return true if ok
+ */
+bool SocketIOargs::parsePacket(const uint8_t * payload, size_t length, SocketIOpacket_t * packet) {
+    const char * p   = (const char *)payload;
+    const char * end = p + length;
+
+    if(length < 1 || *p < sIOtype_CONNECT || *p > sIOtype_BINARY_ACK) {
+        return false;
+    }
+    packet->type = (socketIOmessageType_t)*p++;
+
+    // <attachments>-
+    packet->attachments = 0;
+    if(packet->type == sIOtype_BINARY_EVENT || packet->type == sIOtype_BINARY_ACK) {
+        unsigned int attachments = 0;
+        const char * start       = p;
+        while(p < end && *p >= '0' && *p <= '9' && attachments <= 0xFF) {
+            attachments = attachments * 10 + (*p++ - '0');
+        }
+        if(p == start || p >= end || *p != '-' || attachments > 0xFF) {
+            return false;
+        }
+        packet->attachments = attachments;
+        p++;
+    }
+
+    // /<namespace>,
+    packet->nsp       = "/";
+    packet->nspLength = 1;
+    if(p < end && *p == '/') {
+        packet->nsp = p;
+        while(p < end && *p != ',') {
+            p++;
+        }
+        packet->nspLength = p - packet->nsp;
+        if(p < end) {
+            p++;
+        }
+    }
+
+    // <ack id>
+    packet->ackId = -1;
+    if(p < end && *p >= '0' && *p <= '9') {
+        uint32_t ackId = 0;
+        while(p < end && *p >= '0' && *p <= '9') {
+            ackId = ackId * 10 + (*p++ - '0');
+            if(ackId > 0x7FFFFFFF) {
+                return false;
+            }
+        }
+        packet->ackId = ackId;
+    }
+
+    packet->data   = p;
+    packet->length = end - p;
+    return true;
+}
+
+SocketIOargs::SocketIOargs(const char * data, size_t length)
+    : _data(data)
+    , _end(data + length)
+    , _cursor(NULL)
+    , _cursorIndex(-2) {
+}
+
+const char * SocketIOargs::skipSpace(const char * p, const char * end) {
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * find the end of a JSON value
+ * @param p const char *  first char of the value
+ * @param end const char *
+ * @return the char behind the value, NULL if the value is incomplete
+ */
+const char * SocketIOargs::skipValue(const char * p, const char * end) {
+    if(p >= end) {
+        return NULL;
+    }
+
+    if(*p == '"') {
+        p++;
+        while(p < end) {
+            if(*p == '\\') {
+                p++;
+                if(p >= end) {
+                    return NULL;
+                }
+            } else if(*p == '"') {
+                return p + 1;
+            }
+            p++;
+        }
+        return NULL;
+    }
+
+    if(*p == '[' || *p == '{') {
+        int depth = 0;
+        while(p < end) {
+            if(*p == '"') {
+                p = skipValue(p, end);
+                if(!p) {
+                    return NULL;
+                }
+                continue;
+            }
+            if(*p == '[' || *p == '{') {
+                depth++;
+            } else if(*p == ']' || *p == '}') {
+                if(--depth == 0) {
+                    return p + 1;
+                }
+            }
+            p++;
+        }
+        return NULL;
+    }
+
+    // number, true, false, null
+    const char * start = p;
+    while(p < end && *p != ',' && *p != ']' && *p != '}' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+        p++;
+    }
+    return (p > start) ? p : NULL;
+}
+
+/**
+ * find the start of a element of the array, the scan goes on from the last position
+ * @param index int16_t  -1 for the event name
+ * @return first char of the element or NULL
+ */
+const char * SocketIOargs::seek(int16_t index) {
+    if(_cursorIndex == -2 || index < _cursorIndex) {
+        const char * p = skipSpace(_data, _end);
+        if(p >= _end || *p != '[') {
+            return NULL;
+        }
+        p = skipSpace(p + 1, _end);
+        if(p >= _end || *p == ']') {
+            return NULL;
+        }
+        _cursor      = p;
+        _cursorIndex = -1;
+    }
+
+    const char * p = _cursor;
+    while(_cursorIndex < index) {
+        p = skipValue(p, _end);
+        if(!p) {
+            return NULL;
+        }
+        p = skipSpace(p, _end);
+        if(p >= _end || *p != ',') {
+            return NULL;
+        }
+        p = skipSpace(p + 1, _end);
+        if(p >= _end) {
+            return NULL;
+        }
+        _cursor = p;
+        _cursorIndex++;
+    }
+    return p;
+}
+
+/**
+ * name of the event, the JSON escapes are not decoded
+ * @param length size_t *
+ * @return const char *  not null terminated, NULL if the data is not a event array
+ */
+const char * SocketIOargs::event(size_t * length) {
+    const char * p = seek(-1);
+    if(!p || *p != '"') {
+        return NULL;
+    }
+    const char * end = skipValue(p, _end);
+    if(!end) {
+        return NULL;
+    }
+    *length = (end - p) - 2;
+    return p + 1;
+}
+
+/**
+ * number of arguments, scans the whole array
+ * @return uint8_t
+ */
+uint8_t SocketIOargs::count(void) {
+    uint8_t n = 0;
+    while(n < 0xFF && seek(n)) {
+        n++;
+    }
+    return n;
+}
+
+/**
+ * raw JSON of a argument
+ * @param index uint8_t
+ * @param arg SocketIOarg_t *
+ * @return false if there is no such argument
+ */
+bool SocketIOargs::get(uint8_t index, SocketIOarg_t * arg) {
+    const char * p = seek(index);
+    if(!p) {
+        return false;
+    }
+    const char * end = skipValue(p, _end);
+    if(!end) {
+        return false;
+    }
+    arg->data   = p;
+    arg->length = end - p;
+    return true;
+}
+
+bool SocketIOargs::isNull(uint8_t index) {
+    SocketIOarg_t arg;
+    return get(index, &arg) && arg.length == 4 && memcmp(arg.data, "null", 4) == 0;
+}
+
+bool SocketIOargs::isString(uint8_t index) {
+    SocketIOarg_t arg;
+    return get(index, &arg) && arg.data[0] == '"';
+}
+
+long SocketIOargs::getInt(uint8_t index, long defaultValue) {
+    SocketIOarg_t arg;
+    char number[24];
+    if(!get(index, &arg) || arg.length >= sizeof(number)) {
+        return defaultValue;
+    }
+    memcpy(number, arg.data, arg.length);
+    number[arg.length] = 0;
+    char * end;
+    long value = strtol(number, &end, 10);
+    return (end == number) ? defaultValue : value;
+}
+
+double SocketIOargs::getFloat(uint8_t index, double defaultValue) {
+    SocketIOarg_t arg;
+    char number[32];
+    if(!get(index, &arg) || arg.length >= sizeof(number)) {
+        return defaultValue;
+    }
+    memcpy(number, arg.data, arg.length);
+    number[arg.length] = 0;
+    char * end;
+    double value = strtod(number, &end);
+    return (end == number) ? defaultValue : value;
+}
+
+bool SocketIOargs::getBool(uint8_t index, bool defaultValue) {
+    SocketIOarg_t arg;
+    if(!get(index, &arg)) {
+        return defaultValue;
+    }
+    if(arg.length == 4 && memcmp(arg.data, "true", 4) == 0) {
+        return true;
+    }
+    if(arg.length == 5 && memcmp(arg.data, "false", 5) == 0) {
+        return false;
+    }
+    return defaultValue;
+}
+
+/**
+ * value of 4 hex digits, invalid digits count as 0
+ */
+static uint32_t decodeHex4(const char * p, const char * end) {
+    uint32_t code = 0;
+    for(uint8_t i = 0; i < 4; i++) {
+        char h = (p + i < end) ? (p[i] | 0x20) : '0';
+        code <<= 4;
+        if(h >= '0' && h <= '9') {
+            code |= h - '0';
+        } else if(h >= 'a' && h <= 'f') {
+            code |= h - 'a' + 10;
+        }
+    }
+    return code;
+}
+
+/**
+ * decode a string argument (JSON escapes, \\u as UTF-8)
+ * @param index uint8_t
+ * @param buffer char *  is always null terminated
+ * @param size size_t  size of the buffer
+ * @return length of the string in the buffer, 0 if the argument is not a string
+ */
+size_t SocketIOargs::getString(uint8_t index, char * buffer, size_t size) {
+    SocketIOarg_t arg;
+    if(size == 0) {
+        return 0;
+    }
+    buffer[0] = 0;
+    if(!get(index, &arg) || arg.data[0] != '"') {
+        return 0;
+    }
+
+    const char * p   = arg.data + 1;
+    const char * end = arg.data + arg.length - 1;
+    size_t n         = 0;
+    while(p < end && n < size - 1) {
+        if(*p != '\\') {
+            buffer[n++] = *p++;
+            continue;
+        }
+        p++;
+        char c = *p++;
+        switch(c) {
+            case 'b':
+                c = '\b';
+                break;
+            case 'f':
+                c = '\f';
+                break;
+            case 'n':
+                c = '\n';
+                break;
+            case 'r':
+                c = '\r';
+                break;
+            case 't':
+                c = '\t';
+                break;
+            case 'u': {
+                uint32_t code = decodeHex4(p, end);
+                p = ((end - p) > 4) ? p + 4 : end;
+                // surrogate pair
+                if(code >= 0xD800 && code <= 0xDBFF && (end - p) >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    uint32_t low = decodeHex4(p + 2, end);
+                    if(low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    }
+                }
+                uint8_t utf8[4];
+                uint8_t len;
+                if(code < 0x80) {
+                    utf8[0] = code;
+                    len     = 1;
+                } else if(code < 0x800) {
+                    utf8[0] = 0xC0 | (code >> 6);
+                    utf8[1] = 0x80 | (code & 0x3F);
+                    len     = 2;
+                } else if(code < 0x10000) {
+                    utf8[0] = 0xE0 | (code >> 12);
+                    utf8[1] = 0x80 | ((code >> 6) & 0x3F);
+                    utf8[2] = 0x80 | (code & 0x3F);
+                    len     = 3;
+                } else {
+                    utf8[0] = 0xF0 | (code >> 18);
+                    utf8[1] = 0x80 | ((code >> 12) & 0x3F);
+                    utf8[2] = 0x80 | ((code >> 6) & 0x3F);
+                    utf8[3] = 0x80 | (code & 0x3F);
+                    len     = 4;
+                }
+                if(n + len > size - 1) {
+                    buffer[n] = 0;
+                    return n;
+                }
+                memcpy(&buffer[n], utf8, len);
+                n += len;
+                continue;
+            }
+            default:
+                // \" \\ \/
+                break;
+        }
+        buffer[n++] = c;
+    }
+    buffer[n] = 0;
+    return n;
+}
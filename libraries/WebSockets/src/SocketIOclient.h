@@ -36,6 +36,85 @@ typedef enum {
     sIOtype_BINARY_ACK   = '6',
 } socketIOmessageType_t;
 
+#ifndef SIO_EVENT_HANDLER_MAX
+#define SIO_EVENT_HANDLER_MAX (16)    ///< size of the event handler table (power of 2), holds SIO_EVENT_HANDLER_MAX - 1 events
+#endif
+
+/**
+ * Socket.IO packet header, parsed in place (the pointers point into the received payload)
+ * <type>[<attachments>-][<namespace>,][<ack id>][<data>]
+ */
+typedef struct {
+    socketIOmessageType_t type;
+    const char * nsp;       ///< namespace "/" if not send
+    size_t nspLength;
+    int32_t ackId;          ///< -1 no ack requested
+    uint8_t attachments;    ///< binary attachments, only for sIOtype_BINARY_EVENT / sIOtype_BINARY_ACK
+    const char * data;      ///< JSON data e.g. ["event",{"value":1}]
+    size_t length;
+} SocketIOpacket_t;
+
+/**
+ * one JSON value of an event, not decoded
+ */
+typedef struct {
+    const char * data;
+    size_t length;
+} SocketIOarg_t;
+
+/**
+ * arguments of an event, the JSON array is only scanned as far as needed
+ * and only the arguments which are read are decoded.
+ * index 0 is the first argument after the event name.
+ */
+class SocketIOargs {
+  public:
+    SocketIOargs(const char * data, size_t length);
+
+    const char * event(size_t * length);
+
+    uint8_t count(void);
+    bool get(uint8_t index, SocketIOarg_t * arg);
+
+    bool isNull(uint8_t index);
+    bool isString(uint8_t index);
+    long getInt(uint8_t index, long defaultValue = 0);
+    double getFloat(uint8_t index, double defaultValue = 0);
+    bool getBool(uint8_t index, bool defaultValue = false);
+    size_t getString(uint8_t index, char * buffer, size_t size);
+
+#ifdef ARDUINOJSON_VERSION_MAJOR
+    /**
+     * decode one argument with ArduinoJson (include ArduinoJson.h before SocketIOclient.h)
+     * @param index uint8_t
+     * @param doc JsonDocument &
+     * @return DeserializationError
+     */
+    DeserializationError deserialize(uint8_t index, JsonDocument & doc) {
+        SocketIOarg_t arg;
+        if(!get(index, &arg)) {
+            return DeserializationError::EmptyInput;
+        }
+        return deserializeJson(doc, arg.data, arg.length);
+    }
+#endif
+
+    static bool parsePacket(const uint8_t * payload, size_t length, SocketIOpacket_t * packet);
+
+  protected:
+    const char * _data;
+    const char * _end;
+
+    // scan position: start of argument _cursorIndex, the event name is -1
+    const char * _cursor;
+    int16_t _cursorIndex;
+
+    const char * seek(int16_t index);
+
+    static const char * skipSpace(const char * p, const char * end);
+    static const char * skipValue(const char * p, const char * end);
+};
+
 class SocketIOclient : protected WebSocketsClient {
   public:
 #ifdef __AVR__
@@ -44,6 +123,12 @@ class SocketIOclient : protected WebSocketsClient {
     typedef std::function<void(socketIOmessageType_t type, uint8_t * payload, size_t length)> SocketIOclientEvent;
 #endif
 
+#ifdef __AVR__
+    typedef void (*SocketIOeventHandler)(SocketIOargs & args, const SocketIOpacket_t & packet);
+#else
+    typedef std::function<void(SocketIOargs & args, const SocketIOpacket_t & packet)> SocketIOeventHandler;
+#endif
+
     SocketIOclient(void);
     virtual ~SocketIOclient(void);
 
@@ -65,6 +150,9 @@ class SocketIOclient : protected WebSocketsClient {
     bool isConnected(void);
 
     void onEvent(SocketIOclientEvent cbEvent);
+
+    bool on(const char * event, SocketIOeventHandler handler);
+    bool off(const char * event);
     void disconnect(void);
 
     bool sendEVENT(uint8_t * payload, size_t length = 0, bool headerToPayload = false);
@@ -73,6 +161,50 @@ class SocketIOclient : protected WebSocketsClient {
     bool sendEVENT(const char * payload, size_t length = 0);
     bool sendEVENT(String & payload);
 
+#ifdef ARDUINOJSON_VERSION_MAJOR
+    /**
+     * send a event array, the document is serialized directly behind the reserved header room
+     * of the buffer and send with one write (include ArduinoJson.h before SocketIOclient.h)
+     * @param doc const JsonDocument &  e.g. ["event", {"value": 1}]
+     * @param buffer uint8_t *  room for SIO_MAX_HEADER_SIZE bytes, the document and its null terminator
+     * @param size size_t  of the buffer
+     * @return true if ok, false if the document does not fit
+     */
+    bool sendEVENT(const JsonDocument & doc, uint8_t * buffer, size_t size) {
+        if(size <= SIO_MAX_HEADER_SIZE + 1) {
+            return false;
+        }
+        size_t room   = size - SIO_MAX_HEADER_SIZE;
+        size_t length = serializeJson(doc, (char *)(buffer + SIO_MAX_HEADER_SIZE), room);
+        if(length == 0 || length >= room - 1) {
+            // cut (a document of exactly room - 1 bytes can not be told apart)
+            return false;
+        }
+        return send(sIOtype_EVENT, buffer, length, true);
+    }
+
+    /**
+     * send a event array, convenience for the one above: measures the document
+     * and allocates the buffer for each event (include ArduinoJson.h before SocketIOclient.h)
+     * @param doc const JsonDocument &  e.g. ["event", {"value": 1}]
+     * @return true if ok
+     */
+    bool sendEVENT(const JsonDocument & doc) {
+        size_t length    = measureJson(doc);
+        uint8_t * buffer = (uint8_t *)malloc(SIO_MAX_HEADER_SIZE + length + 1);
+        if(!buffer) {
+            return false;
+        }
+        serializeJson(doc, (char *)(buffer + SIO_MAX_HEADER_SIZE), length + 1);
+        bool ret = send(sIOtype_EVENT, buffer, length, true);
+        free(buffer);
+        return ret;
+    }
+#endif
+
+    bool sendBinaryEVENT(uint8_t * payload, size_t length, const WSiovec_t * attachments, uint8_t count);
+    bool sendBinaryEVENT(const char * payload, const WSiovec_t * attachments, uint8_t count);
+
     bool send(socketIOmessageType_t type, uint8_t * payload, size_t length = 0, bool headerToPayload = false);
     bool send(socketIOmessageType_t type, const uint8_t * payload, size_t length = 0);
     bool send(socketIOmessageType_t type, char * payload, size_t length = 0, bool headerToPayload = false);
@@ -88,8 +220,22 @@ class SocketIOclient : protected WebSocketsClient {
 
   protected:
     bool _disableHeartbeat  = false;
+    bool _isEIO4            = false;
     uint64_t _lastHeartbeat = 0;
     SocketIOclientEvent _cbEvent;
+
+    struct {
+        uint32_t hash = 0;
+        String name;    ///< empty if removed
+        SocketIOeventHandler handler;
+        bool used = false;
+    } _handlers[SIO_EVENT_HANDLER_MAX];
+    uint8_t _handlerCount = 0;
+
+    static uint32_t hashEvent(const char * name, size_t length);
+    int findHandler(const char * name, size_t length, uint32_t hash);
+    bool dispatchEvent(uint8_t * payload, size_t length);
+
     virtual void runIOCbEvent(socketIOmessageType_t type, uint8_t * payload, size_t length) {
         if(_cbEvent) {
             _cbEvent(type, payload, length);
@@ -98,6 +244,8 @@ class SocketIOclient : protected WebSocketsClient {
 
     void initClient(void);
 
+    bool sendPrefixed(WSopcode_t opcode, const uint8_t * prefix, size_t prefixLength, const uint8_t * payload, size_t length);
+
     // Handeling events from websocket layer
     virtual void runCbEvent(WStype_t type, uint8_t * payload, size_t length) {
         handleCbEvent(type, payload, length);
@@ -59,6 +59,39 @@ extern "C" {
 
 #endif
 
+extern "C" {
+#include "libutf8/utf8.h"
+}
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+extern "C" {
+#include "librawdeflate/rawdeflate.h"
+}
+#endif
+
+#ifdef WEBSOCKETS_HAS_WRITEV
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_POSIX)
+#include <sys/uio.h>
+#define WEBSOCKETS_WRITEV(fd, iov, count) ::writev(fd, iov, count)
+#else
+#include <lwip/sockets.h>
+#define WEBSOCKETS_WRITEV(fd, iov, count) lwip_writev(fd, iov, count)
+#endif
+#endif
+
+// max buffers of one writev call
+#define WEBSOCKETS_WRITEV_MAX (4)
+
+// buffer sizes of the pool classes, a payload of 2^n byte and its 0 terminator fit
+static const size_t poolClassSize[WEBSOCKETS_POOL_CLASSES] = { 64 + 1, 256 + 1, 1024 + 1, 4096 + 1 };
+
+// bytes in front of a pool buffer, holds the size class (keeps the payload aligned)
+#define WEBSOCKETS_POOL_PREFIX (8)
+#define WEBSOCKETS_POOL_UNPOOLED (0xFF)
+
+// heartbeat ping payload: "HB" and micros() when it was send
+#define WEBSOCKETS_HB_PING_SIZE (6)
+
 /**
  *
  * @param client WSclient_t *  ptr to the client struct
@@ -89,8 +122,9 @@ void WebSockets::clientDisconnect(WSclient_t * client, uint16_t code, char * rea
  * @param mask bool             add dummy mask to the frame (needed for web browser)
  * @param maskkey uint8_t[4]    key used for payload
  * @param fin bool              can be used to send data in more then one frame (set fin on the last frame)
+ * @param rsv1 bool             set for compressed messages (permessage-deflate)
  */
-uint8_t WebSockets::createHeader(uint8_t * headerPtr, WSopcode_t opcode, size_t length, bool mask, uint8_t maskKey[4], bool fin) {
+uint8_t WebSockets::createHeader(uint8_t * headerPtr, WSopcode_t opcode, size_t length, bool mask, uint8_t maskKey[4], bool fin, bool rsv1) {
     uint8_t headerSize;
     // calculate header Size
     if(length < 126) {
@@ -112,6 +146,9 @@ uint8_t WebSockets::createHeader(uint8_t * headerPtr, WSopcode_t opcode, size_t
     if(fin) {
         *headerPtr |= bit(7);    ///< set Fin
     }
+    if(rsv1) {
+        *headerPtr |= bit(6);    ///< set RSV1 (compressed)
+    }
     *headerPtr |= opcode;    ///< set opcode
     headerPtr++;
 
@@ -179,6 +216,12 @@ bool WebSockets::sendFrameHeader(WSclient_t * client, WSopcode_t opcode, size_t
     uint8_t buffer[WEBSOCKETS_MAX_HEADER_SIZE] = { 0 };
 
     uint8_t headerSize = createHeader(&buffer[0], opcode, length, client->cIsClient, maskKey, fin);
+    WEBSOCKETS_METRIC_ADD(client, framesOut, 1);
+
+    // the payload follows directly, the collected frames have to be written first
+    if(client->cTxLength > 0) {
+        flushCoalesced(client);
+    }
 
     if(write(client, &buffer[0], headerSize) != headerSize) {
         return false;
@@ -194,7 +237,7 @@ bool WebSockets::sendFrameHeader(WSclient_t * client, WSopcode_t opcode, size_t
  * @param payload uint8_t *     ptr to the payload
  * @param length size_t         length of the payload
  * @param fin bool              can be used to send data in more then one frame (set fin on the last frame)
- * @param headerToPayload bool  set true if the payload has reserved 14 Byte at the beginning to dynamically add the Header (payload neet to be in RAM!)
+ * @param headerToPayload bool  set true if the payload has reserved WEBSOCKETS_HEADER_ROOM (14) Byte at the beginning to dynamically add the Header (payload neet to be in RAM!)
  * @return true if ok
  */
 bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, bool fin, bool headerToPayload) {
@@ -215,6 +258,14 @@ bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * pay
         DEBUG_WEBSOCKETS("[WS][%d][sendFrame] text: %s\n", client->num, (payload + (headerToPayload ? 14 : 0)));
     }
 
+    WEBSOCKETS_METRIC_ADD(client, framesOut, 1);
+#ifdef WEBSOCKETS_METRICS
+    if(opcode == WSop_ping) {
+        client->mPingStart = micros();
+        client->mPingOpen  = true;
+    }
+#endif
+
     uint8_t maskKey[4]                         = { 0x00, 0x00, 0x00, 0x00 };
     uint8_t buffer[WEBSOCKETS_MAX_HEADER_SIZE] = { 0 };
 
@@ -222,8 +273,26 @@ bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * pay
     uint8_t * headerPtr;
     uint8_t * payloadPtr = payload;
     bool useInternBuffer = false;
+    bool rsv1            = false;
     bool ret             = true;
 
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    // only complete data messages are compressed, fragmented ones are send as they are
+    // (not the empty one, also with minSize 0: deflatePayload needs length > 0)
+    if(client->cIsDeflate && fin && (opcode == WSop_text || opcode == WSop_binary) && length > 0 && length >= client->cDeflate.minSize) {
+        size_t deflateLength = 0;
+        uint8_t * dataPtr    = deflatePayload(client, (payload + (headerToPayload ? WEBSOCKETS_MAX_HEADER_SIZE : 0)), length, &deflateLength);
+        if(dataPtr) {
+            DEBUG_WEBSOCKETS("[WS][%d][sendFrame] deflate %u -> %u\n", client->num, length, deflateLength);
+            length          = deflateLength;
+            headerToPayload = true;
+            useInternBuffer = true;
+            rsv1            = true;
+            payloadPtr      = dataPtr;
+        }
+    }
+#endif
+
     // calculate header Size
     if(length < 126) {
         headerSize = 2;
@@ -237,12 +306,47 @@ bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * pay
         headerSize += 4;
     }
 
+    // small data frames are collected and written together (enableCoalescing)
+    bool coalesce = (client->cTxSize > 0 && (opcode == WSop_text || opcode == WSop_binary || opcode == WSop_continuation) && (headerSize + length) <= client->cTxSize);
+    if(coalesce && !client->cTxBuffer) {
+        client->cTxBuffer = (uint8_t *)malloc(client->cTxSize);
+        coalesce          = (client->cTxBuffer != NULL);
+    }
+
+    if(coalesce) {
+        ret = coalesceFrame(client, opcode, (payloadPtr ? (payloadPtr + (headerToPayload ? WEBSOCKETS_MAX_HEADER_SIZE : 0)) : NULL), length, headerSize, fin, rsv1);
+        if(useInternBuffer) {
+            poolFree(payloadPtr);
+        }
+        return ret;
+    }
+
+    // control frames and big frames keep their order behind the collected ones
+    if(client->cTxLength > 0) {
+        flushCoalesced(client);
+    }
+
+    // the client needs a copy of the payload to mask it with a random key,
+    // small frames are copied on the stack, the others up to 1400 byte to a pool buffer (one TCP package)
+#if(WEBSOCKETS_WRITEV_STACK_SIZE > 0)
+    uint8_t stackBuffer[WEBSOCKETS_MAX_HEADER_SIZE + WEBSOCKETS_WRITEV_STACK_SIZE];
+#endif
+    bool useStackBuffer = false;
+    if(client->cIsClient && !headerToPayload && length > 0) {
+        uint8_t * dataPtr = NULL;
+#if(WEBSOCKETS_WRITEV_STACK_SIZE > 0)
+        if(length <= WEBSOCKETS_WRITEV_STACK_SIZE) {
+            dataPtr        = &stackBuffer[0];
+            useStackBuffer = true;
+        }
+#endif
 #ifdef WEBSOCKETS_USE_BIG_MEM
-    // only for ESP since AVR has less HEAP
-    // try to send data in one TCP package (only if some free Heap is there)
-    if(!headerToPayload && ((length > 0) && (length < 1400)) && (GET_FREE_HEAP > 6000)) {
-        DEBUG_WEBSOCKETS("[WS][%d][sendFrame] pack to one TCP package...\n", client->num);
-        uint8_t * dataPtr = (uint8_t *)malloc(length + WEBSOCKETS_MAX_HEADER_SIZE);
+        // only for ESP since AVR has less HEAP (only if some free Heap is there)
+        if(!dataPtr && length < 1400 && GET_FREE_HEAP > 6000) {
+            DEBUG_WEBSOCKETS("[WS][%d][sendFrame] pack to one TCP package...\n", client->num);
+            dataPtr = poolAlloc(length + WEBSOCKETS_MAX_HEADER_SIZE);
+        }
+#endif
         if(dataPtr) {
             memcpy((dataPtr + WEBSOCKETS_MAX_HEADER_SIZE), payload, length);
             headerToPayload = true;
@@ -250,7 +354,6 @@ bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * pay
             payloadPtr      = dataPtr;
         }
     }
-#endif
 
     // set Header Pointer
     if(headerToPayload) {
@@ -268,7 +371,7 @@ bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * pay
         }
     }
 
-    createHeader(headerPtr, opcode, length, client->cIsClient, maskKey, fin);
+    createHeader(headerPtr, opcode, length, client->cIsClient, maskKey, fin, rsv1);
 
     if(client->cIsClient && useInternBuffer) {
         uint8_t * dataMaskPtr;
@@ -296,26 +399,31 @@ bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * pay
             ret = false;
         }
     } else {
-        // send header
-        if(write(client, &buffer[0], headerSize) != headerSize) {
-            ret = false;
-        }
+        // send header and payload together, without copying the payload
+        WSiovec_t iov[2];
+        uint8_t count   = 1;
+        size_t expected = headerSize;
+
+        iov[0].data   = &buffer[0];
+        iov[0].length = headerSize;
 
         if(payloadPtr && length > 0) {
-            // send payload
-            if(write(client, &payloadPtr[0], length) != length) {
-                ret = false;
-            }
+            iov[1].data   = payloadPtr;
+            iov[1].length = length;
+            expected += length;
+            count++;
+        }
+
+        if(writev(client, &iov[0], count) != expected) {
+            ret = false;
         }
     }
 
     DEBUG_WEBSOCKETS("[WS][%d][sendFrame] sending Frame Done (%luus).\n", client->num, (micros() - start));
 
-#ifdef WEBSOCKETS_USE_BIG_MEM
-    if(useInternBuffer && payloadPtr) {
-        free(payloadPtr);
+    if(useInternBuffer && !useStackBuffer) {
+        poolFree(payloadPtr);
     }
-#endif
 
     return ret;
 }
@@ -325,8 +433,15 @@ bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * pay
  * @param client WSclient_t *  ptr to the client struct
  */
 void WebSockets::headerDone(WSclient_t * client) {
-    client->status    = WSC_CONNECTED;
-    client->cWsRXsize = 0;
+    client->status      = WSC_CONNECTED;
+    client->cWsRXsize   = 0;
+    client->cUtf8Text   = false;
+    client->cUtf8State  = UTF8_ACCEPT;
+    client->lastPing    = millis();
+    client->lastRx      = client->lastPing;
+    client->hb          = WSheartbeat_t();
+    client->hb.interval = client->pingInterval;
+    client->hb.timeout  = client->pongTimeout;
     DEBUG_WEBSOCKETS("[WS][%d][headerDone] Header Handling Done.\n", client->num);
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
     client->cHttpLine = "";
@@ -364,19 +479,19 @@ bool WebSockets::handleWebsocketWaitFor(WSclient_t * client, size_t size) {
     }
 
     DEBUG_WEBSOCKETS("[WS][%d][handleWebsocketWaitFor] size: %d cWsRXsize: %d\n", client->num, size, client->cWsRXsize);
-    readCb(client, &client->cWsHeader[client->cWsRXsize], (size - client->cWsRXsize), std::bind([](WebSockets * server, size_t size, WSclient_t * client, bool ok) {
+    // the lambda only captures two pointers, std::function can hold it without heap allocation
+    readCb(client, &client->cWsHeader[client->cWsRXsize], (size - client->cWsRXsize), [this, size](WSclient_t * client, bool ok) {
         DEBUG_WEBSOCKETS("[WS][%d][handleWebsocketWaitFor][readCb] size: %d ok: %d\n", client->num, size, ok);
         if(ok) {
             client->cWsRXsize = size;
-            server->handleWebsocketCb(client);
+            handleWebsocketCb(client);
         } else {
             DEBUG_WEBSOCKETS("[WS][%d][readCb] failed.\n", client->num);
             client->cWsRXsize = 0;
             // timeout or error
-            server->clientDisconnect(client, 1002);
+            clientDisconnect(client, 1002);
         }
-    },
-                                                                                          this, size, std::placeholders::_1, std::placeholders::_2));
+    });
     return false;
 }
 
@@ -435,12 +550,42 @@ void WebSockets::handleWebsocketCb(WSclient_t * client) {
     DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] fin: %u rsv1: %u rsv2: %u rsv3 %u  opCode: %u\n", client->num, header->fin, header->rsv1, header->rsv2, header->rsv3, header->opCode);
     DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] mask: %u payloadLen: %u\n", client->num, header->mask, header->payloadLen);
 
-    if(header->payloadLen > WEBSOCKETS_MAX_DATA_SIZE) {
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    bool rsv1Allowed = client->cIsDeflate && (header->opCode == WSop_text || header->opCode == WSop_binary);
+#else
+    bool rsv1Allowed = false;
+#endif
+
+    if(header->rsv1 && !rsv1Allowed) {
+        DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] RSV1 set but not negotiated!\n", client->num);
+        clientDisconnect(client, 1002);
+        return;
+    }
+
+    // frame of a fragmented message the library collects (enableReassembly)
+    bool reassemble = (client->cRaMaxSize > 0 && header->opCode <= WSop_binary && (!header->fin || header->opCode == WSop_continuation));
+
+    if(header->rsv1 && !header->fin && !reassemble) {
+        DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] fragmented compressed messages are not supported!\n", client->num);
+        clientDisconnect(client, 1003);
+        return;
+    }
+
+    // big data frames can be delivered in chunks, compressed ones need the full payload
+    bool stream = (client->cStreamChunkSize > 0 && header->payloadLen > client->cStreamChunkSize && header->payloadLen != 0xFFFFFFFF && !header->rsv1 && !reassemble && (header->opCode == WSop_text || header->opCode == WSop_binary || header->opCode == WSop_continuation));
+
+    if(!stream && header->payloadLen > WEBSOCKETS_MAX_DATA_SIZE) {
         DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] payload too big! (%u)\n", client->num, header->payloadLen);
         clientDisconnect(client, 1009);
         return;
     }
 
+    if(reassemble && header->payloadLen > (client->cRaMaxSize - client->cRaLength)) {
+        DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] reassembled message too big! (%u + %u)\n", client->num, client->cRaLength, header->payloadLen);
+        clientDisconnect(client, 1009);
+        return;
+    }
+
     if(header->mask) {
         headerLen += 4;
         if(!handleWebsocketWaitFor(client, headerLen)) {
@@ -450,16 +595,32 @@ void WebSockets::handleWebsocketCb(WSclient_t * client) {
         buffer += 4;
     }
 
+    // any frame shows that the peer is alive, the adaptive heartbeat does not need a pong then
+    client->lastRx = millis();
+    if(client->maxPingInterval) {
+        client->pongReceived = true;
+    }
+
+    WEBSOCKETS_METRIC_ADD(client, framesIn, 1);
+    WEBSOCKETS_METRIC_ADD(client, bytesIn, headerLen + header->payloadLen);
+
+    if(stream) {
+        handleWebsocketStream(client);
+        return;
+    }
+
     if(header->payloadLen > 0) {
         // if text data we need one more
-        payload = (uint8_t *)malloc(header->payloadLen + 1);
+        payload = poolAlloc(header->payloadLen + 1);
 
         if(!payload) {
             DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] to less memory to handle payload %d!\n", client->num, header->payloadLen);
             clientDisconnect(client, 1011);
             return;
         }
-        readCb(client, payload, header->payloadLen, std::bind(&WebSockets::handleWebsocketPayloadCb, this, std::placeholders::_1, std::placeholders::_2, payload));
+        readCb(client, payload, header->payloadLen, [this, payload](WSclient_t * client, bool ok) {
+            handleWebsocketPayloadCb(client, ok, payload);
+        });
     } else {
         handleWebsocketPayloadCb(client, true, NULL);
     }
@@ -468,10 +629,16 @@ void WebSockets::handleWebsocketCb(WSclient_t * client) {
 void WebSockets::handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t * payload) {
     WSMessageHeader_t * header = &client->cWsHeaderDecode;
     if(ok) {
+        // compressed text is validated after inflate
+        bool text = (client->cValidateUtf8 && !header->rsv1 && utf8Begin(client));
+
         if(header->payloadLen > 0) {
             payload[header->payloadLen] = 0x00;
 
-            if(header->mask) {
+            if(text) {
+                // decode XOR and validate in one pass
+                client->cUtf8State = utf8_unmask_validate(payload, header->payloadLen, (header->mask ? header->maskKey : NULL), 0, client->cUtf8State);
+            } else if(header->mask) {
                 // decode XOR
                 for(size_t i = 0; i < header->payloadLen; i++) {
                     payload[i] = (payload[i] ^ header->maskKey[i % 4]);
@@ -479,6 +646,41 @@ void WebSockets::handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t
             }
         }
 
+        if(text && !utf8Done(client, header->fin)) {
+            poolFree(payload);
+            client->cWsRXsize = 0;
+            clientDisconnect(client, 1007);
+            return;
+        }
+
+        // fragmented message, the library collects the frames (enableReassembly)
+        if(client->cRaMaxSize && header->opCode <= WSop_binary && (!header->fin || header->opCode == WSop_continuation || client->cRaOpcode != WSop_continuation)) {
+            if(!reassembleFrame(client, payload)) {
+                return;
+            }
+            // reset input
+            client->cWsRXsize = 0;
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
+            // register callback for next message
+            handleWebsocketWaitFor(client, 2);
+#endif
+            return;
+        }
+
+        // the application can keep the pooled payload (adoptPayload)
+        _rxPayload = payload;
+        _rxAdopted = false;
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+        if(header->rsv1) {
+            _rxPayload = NULL;
+            payload    = inflatePayload(client, header->opCode, payload, &header->payloadLen);
+            if(!payload) {
+                return;
+            }
+        }
+#endif
+
         switch(header->opCode) {
             case WSop_text:
                 DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] text: %s\n", client->num, payload);
@@ -495,7 +697,13 @@ void WebSockets::handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t
                 break;
             case WSop_pong:
                 DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] get pong (%s)\n", client->num, payload ? (const char *)payload : "");
-                client->pongReceived = true;
+                handleHBPong(client, payload, header->payloadLen);
+#ifdef WEBSOCKETS_METRICS
+                if(client->mPingOpen) {
+                    WEBSOCKETS_METRIC_RECORD(client, rtt, micros() - client->mPingStart);
+                    client->mPingOpen = false;
+                }
+#endif
                 messageReceived(client, header->opCode, payload, header->payloadLen, header->fin);
                 break;
             case WSop_close: {
@@ -519,9 +727,16 @@ void WebSockets::handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t
                 break;
         }
 
-        if(payload) {
+        if(payload == _rxPayload) {
+            if(!_rxAdopted) {
+                poolFree(payload);
+            }
+        } else if(payload) {
+            // inflated message
             free(payload);
         }
+        _rxPayload = NULL;
+        _rxAdopted = false;
 
         // reset input
         client->cWsRXsize = 0;
@@ -532,10 +747,316 @@ void WebSockets::handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t
 
     } else {
         DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] missing data!\n", client->num);
-        free(payload);
+        poolFree(payload);
+        clientDisconnect(client, 1002);
+    }
+}
+
+/**
+ * receive the payload of a data frame in chunks of cStreamChunkSize
+ * only one chunk buffer is allocated, the data is unmasked chunk by chunk
+ * @param client WSclient_t *  ptr to the client struct
+ */
+void WebSockets::handleWebsocketStream(WSclient_t * client) {
+    WSMessageHeader_t * header = &client->cWsHeaderDecode;
+
+    // if text data we need one more
+    uint8_t * buffer = poolAlloc(client->cStreamChunkSize + 1);
+    if(!buffer) {
+        DEBUG_WEBSOCKETS("[WS][%d][handleWebsocketStream] to less memory to handle chunk %d!\n", client->num, client->cStreamChunkSize);
+        clientDisconnect(client, 1011);
+        return;
+    }
+
+    DEBUG_WEBSOCKETS("[WS][%d][handleWebsocketStream] payloadLen: %u chunk: %u\n", client->num, header->payloadLen, client->cStreamChunkSize);
+    client->cStreamOffset = 0;
+
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
+    readCb(client, buffer, std::min(client->cStreamChunkSize, header->payloadLen), [this, buffer](WSclient_t * client, bool ok) {
+        handleWebsocketStreamCb(client, ok, buffer);
+    });
+#else
+    bool more;
+    do {
+        size_t len = std::min(client->cStreamChunkSize, (header->payloadLen - client->cStreamOffset));
+        if(!readCb(client, buffer, len, NULL)) {
+            DEBUG_WEBSOCKETS("[WS][%d][handleWebsocketStream] missing data!\n", client->num);
+            poolFree(buffer);
+            clientDisconnect(client, 1002);
+            return;
+        }
+        more = handleWebsocketStreamChunk(client, buffer);
+    } while(more);
+
+    poolFree(buffer);
+#endif
+}
+
+/**
+ * unmask and deliver one received chunk
+ * @param client WSclient_t *  ptr to the client struct
+ * @param buffer uint8_t *  chunk buffer (cStreamChunkSize + 1 byte)
+ * @return true if more data of the frame has to be read
+ */
+bool WebSockets::handleWebsocketStreamChunk(WSclient_t * client, uint8_t * buffer) {
+    WSMessageHeader_t * header = &client->cWsHeaderDecode;
+    WSstreamChunk_t chunk;
+
+    chunk.opcode = header->opCode;
+    chunk.fin    = header->fin;
+    chunk.offset = client->cStreamOffset;
+    chunk.total  = header->payloadLen;
+    chunk.data   = buffer;
+    chunk.length = std::min(client->cStreamChunkSize, (header->payloadLen - client->cStreamOffset));
+
+    bool text = (client->cValidateUtf8 && (chunk.offset > 0 ? client->cUtf8Text : utf8Begin(client)));
+
+    if(text) {
+        // the mask continues over the chunk borders, a UTF-8 sequence too
+        client->cUtf8State = utf8_unmask_validate(buffer, chunk.length, (header->mask ? header->maskKey : NULL), chunk.offset, client->cUtf8State);
+    } else if(header->mask) {
+        // the mask continues over the chunk borders
+        uint8_t k = (chunk.offset & 0x03);
+        for(size_t i = 0; i < chunk.length; i++) {
+            buffer[i] ^= header->maskKey[k];
+            k = ((k + 1) & 0x03);
+        }
+    }
+    buffer[chunk.length] = 0x00;
+
+    client->cStreamOffset += chunk.length;
+
+    if(text && !utf8Done(client, (header->fin && client->cStreamOffset >= header->payloadLen))) {
+        client->cStreamOffset = 0;
+        client->cWsRXsize     = 0;
+        clientDisconnect(client, 1007);
+        return false;
+    }
+
+    streamReceived(client, &chunk);
+
+    // the application can close the connection from the event
+    if(client->status != WSC_CONNECTED) {
+        return false;
+    }
+
+    if(client->cStreamOffset < header->payloadLen) {
+        return true;
+    }
+
+    // frame done, reset input
+    client->cStreamOffset = 0;
+    client->cWsRXsize     = 0;
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
+    // register callback for next message
+    handleWebsocketWaitFor(client, 2);
+#endif
+    return false;
+}
+
+/**
+ * called for every received data frame before its payload is unmasked
+ * @param client WSclient_t *  ptr to the client struct
+ * @return true if the frame is part of a text message
+ */
+bool WebSockets::utf8Begin(WSclient_t * client) {
+    WSMessageHeader_t * header = &client->cWsHeaderDecode;
+    if(header->opCode == WSop_text) {
+        client->cUtf8Text  = true;
+        client->cUtf8State = UTF8_ACCEPT;
+        return true;
+    }
+    return (header->opCode == WSop_continuation && client->cUtf8Text);
+}
+
+/**
+ * check the validator state after the text data is unmasked
+ * @param client WSclient_t *  ptr to the client struct
+ * @param last bool  end of the message
+ * @return false if the text is no valid UTF-8
+ */
+bool WebSockets::utf8Done(WSclient_t * client, bool last) {
+    if(client->cUtf8State == UTF8_REJECT || (last && client->cUtf8State != UTF8_ACCEPT)) {
+        DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] text is no valid UTF-8!\n", client->num);
+        client->cUtf8Text = false;
+        return false;
+    }
+    if(last) {
+        client->cUtf8Text = false;
+    }
+    return true;
+}
+
+/**
+ * add the payload of a data frame to the message being reassembled, no data is copied
+ * @param client WSclient_t *  ptr to the client struct
+ * @param payload uint8_t *  unmasked payload (pool buffer, owned by the message now)
+ * @return false if the connection is closed
+ */
+bool WebSockets::reassembleFrame(WSclient_t * client, uint8_t * payload) {
+    WSMessageHeader_t * header = &client->cWsHeaderDecode;
+
+    // a continuation needs a started message, a new message needs none
+    if((header->opCode == WSop_continuation) == (client->cRaOpcode == WSop_continuation)) {
+        DEBUG_WEBSOCKETS("[WS][%d][reassembly] unexpected opcode %d!\n", client->num, header->opCode);
+        poolFree(payload);
+        client->cWsRXsize = 0;
+        clientDisconnect(client, 1002);
+        return false;
+    }
+
+    if(header->opCode != WSop_continuation) {
+        client->cRaOpcode = header->opCode;
+        client->cRaRsv1   = header->rsv1;
+    }
+
+    if(header->payloadLen > 0) {
+        // the part list grows, the data stays in the frame buffers
+        if(client->cRaCount == client->cRaCapacity) {
+            size_t capacity   = client->cRaCapacity ? (client->cRaCapacity * 2) : 8;
+            WSiovec_t * parts = (WSiovec_t *)realloc(client->cRaParts, capacity * sizeof(WSiovec_t));
+            if(!parts) {
+                DEBUG_WEBSOCKETS("[WS][%d][reassembly] to less memory for %u parts!\n", client->num, capacity);
+                poolFree(payload);
+                client->cWsRXsize = 0;
+                clientDisconnect(client, 1011);
+                return false;
+            }
+            client->cRaParts    = parts;
+            client->cRaCapacity = capacity;
+        }
+        client->cRaParts[client->cRaCount].data   = payload;
+        client->cRaParts[client->cRaCount].length = header->payloadLen;
+        client->cRaCount++;
+        client->cRaLength += header->payloadLen;
+    } else {
+        poolFree(payload);
+    }
+
+    if(header->fin) {
+        reassemblyDone(client);
+    }
+    return true;
+}
+
+/**
+ * deliver the reassembled message
+ *  - more than one part: WStype_MESSAGE with the part list, or joined into one buffer (cRaContiguous)
+ *  - one part: its buffer as it is, the application can keep it (adoptPayload)
+ *  - compressed: joined and inflated
+ * @param client WSclient_t *  ptr to the client struct
+ */
+void WebSockets::reassemblyDone(WSclient_t * client) {
+    WSopcode_t opcode = client->cRaOpcode;
+    size_t length     = client->cRaLength;
+    uint8_t * payload = NULL;
+
+    DEBUG_WEBSOCKETS("[WS][%d][reassembly] message done, %u byte in %u parts\n", client->num, length, client->cRaCount);
+
+    if(client->cRaCount > 1 && !client->cRaContiguous && !client->cRaRsv1) {
+        WSmessage_t message;
+        message.opcode = opcode;
+        message.parts  = client->cRaParts;
+        message.count  = client->cRaCount;
+        message.length = length;
+        messageReassembled(client, &message);
+    } else {
+        if(client->cRaCount == 1) {
+            payload = (uint8_t *)client->cRaParts[0].data;
+            client->cRaCount = 0;
+        } else if(client->cRaCount > 1) {
+            payload = poolAlloc(length + 1);
+            if(!payload) {
+                DEBUG_WEBSOCKETS("[WS][%d][reassembly] to less memory to join %u byte!\n", client->num, length);
+                freeReassembly(client);
+                clientDisconnect(client, 1011);
+                return;
+            }
+            uint8_t * p = payload;
+            for(size_t i = 0; i < client->cRaCount; i++) {
+                memcpy(p, client->cRaParts[i].data, client->cRaParts[i].length);
+                p += client->cRaParts[i].length;
+            }
+            payload[length] = 0x00;
+        }
+    }
+
+    // give the frame buffers back, the part list is kept for the next message
+    for(size_t i = 0; i < client->cRaCount; i++) {
+        poolFree((uint8_t *)client->cRaParts[i].data);
+    }
+    bool compressed   = client->cRaRsv1;
+    client->cRaCount  = 0;
+    client->cRaLength = 0;
+    client->cRaOpcode = WSop_continuation;
+    client->cRaRsv1   = false;
+
+    if(!payload && length > 0) {
+        // delivered as WStype_MESSAGE
+        return;
+    }
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    if(compressed) {
+        payload = inflatePayload(client, opcode, payload, &length);
+        if(payload) {
+            messageReceived(client, opcode, payload, length, true);
+            free(payload);
+        }
+        return;
+    }
+#else
+    UNUSED(compressed);
+#endif
+
+    _rxPayload = payload;
+    _rxAdopted = false;
+    messageReceived(client, opcode, payload, length, true);
+    if(!_rxAdopted) {
+        poolFree(payload);
+    }
+    _rxPayload = NULL;
+    _rxAdopted = false;
+}
+
+/**
+ * drop a message being reassembled and free the part list (connection closed or reassembly disabled)
+ * @param client WSclient_t *  ptr to the client struct
+ */
+void WebSockets::freeReassembly(WSclient_t * client) {
+    for(size_t i = 0; i < client->cRaCount; i++) {
+        poolFree((uint8_t *)client->cRaParts[i].data);
+    }
+    free(client->cRaParts);
+    client->cRaParts    = NULL;
+    client->cRaCount    = 0;
+    client->cRaCapacity = 0;
+    client->cRaLength   = 0;
+    client->cRaOpcode   = WSop_continuation;
+    client->cRaRsv1     = false;
+}
+
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
+void WebSockets::handleWebsocketStreamCb(WSclient_t * client, bool ok, uint8_t * buffer) {
+    WSMessageHeader_t * header = &client->cWsHeaderDecode;
+
+    if(!ok) {
+        DEBUG_WEBSOCKETS("[WS][%d][handleWebsocketStream] missing data!\n", client->num);
+        poolFree(buffer);
         clientDisconnect(client, 1002);
+        return;
+    }
+
+    if(handleWebsocketStreamChunk(client, buffer)) {
+        size_t len = std::min(client->cStreamChunkSize, (header->payloadLen - client->cStreamOffset));
+        readCb(client, buffer, len, [this, buffer](WSclient_t * client, bool ok) {
+            handleWebsocketStreamCb(client, ok, buffer);
+        });
+    } else {
+        poolFree(buffer);
     }
 }
+#endif
 
 /**
  * generate the key for Sec-WebSocket-Accept
@@ -547,13 +1068,17 @@ String WebSockets::acceptKey(String & clientKey) {
 #ifdef ESP8266
     sha1(clientKey + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11", &sha1HashBin[0]);
 #elif defined(ESP32)
-    String data = clientKey + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
-    esp_sha(SHA1, (unsigned char *)data.c_str(), data.length(), &sha1HashBin[0]);
+    // a valid key has 24 characters, longer keys can not match anyway
+    char data[64 + 36];
+    size_t keyLength = std::min((size_t)clientKey.length(), (size_t)64);
+    memcpy(&data[0], clientKey.c_str(), keyLength);
+    memcpy(&data[keyLength], "258EAFA5-E914-47DA-95CA-C5AB0DC85B11", 36);
+    esp_sha(SHA1, (unsigned char *)&data[0], keyLength + 36, &sha1HashBin[0]);
 #else
-    clientKey += "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
     SHA1_CTX ctx;
     SHA1Init(&ctx);
     SHA1Update(&ctx, (const unsigned char *)clientKey.c_str(), clientKey.length());
+    SHA1Update(&ctx, (const unsigned char *)"258EAFA5-E914-47DA-95CA-C5AB0DC85B11", 36);
     SHA1Final(&sha1HashBin[0], &ctx);
 #endif
 
@@ -586,49 +1111,159 @@ String WebSockets::base64_encode(uint8_t * data, size_t length) {
     return String("-FAIL-");
 }
 
+WebSockets::~WebSockets(void) {
+    setBufferPoolSize(0);
+}
+
 /**
- * read x byte from tcp or get timeout
- * @param client WSclient_t *
- * @param out  uint8_t * data buffer
- * @param n size_t byte count
- * @return true if ok
+ * get a payload buffer of at least size byte from the pool
+ * @param size size_t
+ * @return uint8_t * buffer, NULL if out of memory
  */
-bool WebSockets::readCb(WSclient_t * client, uint8_t * out, size_t n, WSreadWaitCb cb) {
-#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
-    if(!client->tcp || !client->tcp->connected()) {
-        return false;
+uint8_t * WebSockets::poolAlloc(size_t size) {
+    uint8_t sizeClass = 0;
+    while(sizeClass < WEBSOCKETS_POOL_CLASSES && size > poolClassSize[sizeClass]) {
+        sizeClass++;
     }
 
-    client->tcp->readBytes(out, n, std::bind([](WSclient_t * client, bool ok, WSreadWaitCb cb) {
-        if(cb) {
-            cb(client, ok);
+    uint8_t * block;
+    if(sizeClass < WEBSOCKETS_POOL_CLASSES) {
+        block = _pool.freeList[sizeClass];
+        if(block) {
+            memcpy(&_pool.freeList[sizeClass], block, sizeof(uint8_t *));
+            _pool.cached -= poolClassSize[sizeClass];
+        } else {
+            block = (uint8_t *)malloc(WEBSOCKETS_POOL_PREFIX + poolClassSize[sizeClass]);
         }
-    },
-                                       client, std::placeholders::_1, cb));
+    } else {
+        sizeClass = WEBSOCKETS_POOL_UNPOOLED;
+        block     = (uint8_t *)malloc(WEBSOCKETS_POOL_PREFIX + size);
+    }
 
-#else
-    unsigned long t = millis();
-    ssize_t len;
-    DEBUG_WEBSOCKETS("[readCb] n: %zu t: %lu\n", n, t);
-    while(n > 0) {
-        if(client->tcp == NULL) {
-            DEBUG_WEBSOCKETS("[readCb] tcp is null!\n");
-            if(cb) {
-                cb(client, false);
-            }
-            return false;
-        }
+    if(!block) {
+        return NULL;
+    }
+    block[0] = sizeClass;
+#ifdef WEBSOCKETS_METRICS
+    // size of the buffer for payloadHeap
+    uint32_t blockSize = (sizeClass < WEBSOCKETS_POOL_CLASSES) ? poolClassSize[sizeClass] : size;
+    memcpy(&block[4], &blockSize, sizeof(blockSize));
+    _metrics.payloadHeap += blockSize;
+    if(_metrics.payloadHeap > _metrics.payloadPeak) {
+        _metrics.payloadPeak = _metrics.payloadHeap;
+    }
+#endif
+    return (block + WEBSOCKETS_POOL_PREFIX);
+}
 
-        if(!client->tcp->connected()) {
-            DEBUG_WEBSOCKETS("[readCb] not connected!\n");
-            if(cb) {
-                cb(client, false);
+/**
+ * give a buffer of poolAlloc back, it is kept for reuse while the pool size allows it
+ * @param buffer uint8_t *
+ */
+void WebSockets::poolFree(uint8_t * buffer) {
+    if(!buffer) {
+        return;
+    }
+
+    uint8_t * block   = (buffer - WEBSOCKETS_POOL_PREFIX);
+    uint8_t sizeClass = block[0];
+#ifdef WEBSOCKETS_METRICS
+    uint32_t blockSize;
+    memcpy(&blockSize, &block[4], sizeof(blockSize));
+    _metrics.payloadHeap -= blockSize;
+#endif
+    if(sizeClass < WEBSOCKETS_POOL_CLASSES && (_pool.cached + poolClassSize[sizeClass]) <= _pool.size) {
+        memcpy(block, &_pool.freeList[sizeClass], sizeof(uint8_t *));
+        _pool.freeList[sizeClass] = block;
+        _pool.cached += poolClassSize[sizeClass];
+        return;
+    }
+    free(block);
+}
+
+/**
+ * set how many byte of free receive buffers are kept for reuse
+ * @param size size_t  0 = free the buffers at once
+ */
+void WebSockets::setBufferPoolSize(size_t size) {
+    _pool.size = size;
+    for(uint8_t i = 0; i < WEBSOCKETS_POOL_CLASSES && _pool.cached > size; i++) {
+        while(_pool.freeList[i] && _pool.cached > size) {
+            uint8_t * block = _pool.freeList[i];
+            memcpy(&_pool.freeList[i], block, sizeof(uint8_t *));
+            _pool.cached -= poolClassSize[i];
+            free(block);
+        }
+    }
+}
+
+/**
+ * keep the payload of the running TEXT / BIN / FRAGMENT event after the event returns
+ * the buffer has to be given back with releasePayload()
+ * not possible for compressed messages and streamed chunks (returns false, copy the data)
+ * @param payload uint8_t *  payload of the event
+ * @return true if the payload is now owned by the application
+ */
+bool WebSockets::adoptPayload(uint8_t * payload) {
+    if(!payload || payload != _rxPayload) {
+        return false;
+    }
+    _rxAdopted = true;
+    return true;
+}
+
+/**
+ * give back a payload of adoptPayload()
+ * @param payload uint8_t *
+ */
+void WebSockets::releasePayload(uint8_t * payload) {
+    poolFree(payload);
+}
+
+/**
+ * read x byte from tcp or get timeout
+ * @param client WSclient_t *
+ * @param out  uint8_t * data buffer
+ * @param n size_t byte count
+ * @return true if ok
+ */
+bool WebSockets::readCb(WSclient_t * client, uint8_t * out, size_t n, WSreadWaitCb cb) {
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
+    if(!client->tcp || !client->tcp->connected()) {
+        return false;
+    }
+
+    client->tcp->readBytes(out, n, std::bind([](WSclient_t * client, bool ok, WSreadWaitCb cb) {
+        if(cb) {
+            cb(client, ok);
+        }
+    },
+                                       client, std::placeholders::_1, cb));
+
+#else
+    unsigned long t = millis();
+    ssize_t len;
+    DEBUG_WEBSOCKETS("[readCb] n: %zu t: %lu\n", n, t);
+    while(n > 0) {
+        if(client->tcp == NULL) {
+            DEBUG_WEBSOCKETS("[readCb] tcp is null!\n");
+            if(cb) {
+                cb(client, false);
+            }
+            return false;
+        }
+
+        if(!client->tcp->connected()) {
+            DEBUG_WEBSOCKETS("[readCb] not connected!\n");
+            if(cb) {
+                cb(client, false);
             }
             return false;
         }
 
         if((millis() - t) > WEBSOCKETS_TCP_TIMEOUT) {
             DEBUG_WEBSOCKETS("[readCb] receive TIMEOUT! %lu\n", (millis() - t));
+            WEBSOCKETS_METRIC_ADD(client, readTimeouts, 1);
             if(cb) {
                 cb(client, false);
             }
@@ -676,6 +1311,9 @@ size_t WebSockets::write(WSclient_t * client, uint8_t * out, size_t n) {
     unsigned long t = millis();
     size_t len      = 0;
     size_t total    = 0;
+#ifdef WEBSOCKETS_METRICS
+    unsigned long start = micros();
+#endif
     DEBUG_WEBSOCKETS("[write] n: %zu t: %lu\n", n, t);
     while(n > 0) {
         if(client->tcp == NULL) {
@@ -707,6 +1345,8 @@ size_t WebSockets::write(WSclient_t * client, uint8_t * out, size_t n) {
             WEBSOCKETS_YIELD();
         }
     }
+    WEBSOCKETS_METRIC_ADD(client, bytesOut, total);
+    WEBSOCKETS_METRIC_RECORD(client, sendTime, micros() - start);
     WEBSOCKETS_YIELD();
     return total;
 }
@@ -719,20 +1359,201 @@ size_t WebSockets::write(WSclient_t * client, const char * out) {
     return write(client, (uint8_t *)out, strlen(out));
 }
 
+/**
+ * write more then one buffer, tries to send all in one TCP package
+ * uses writev of the socket if possible, small data is gathered on the stack
+ * @param client WSclient_t *
+ * @param iov WSiovec_t *  buffers to send
+ * @param count uint8_t  number of buffers
+ * @return bytes send
+ */
+size_t WebSockets::writev(WSclient_t * client, WSiovec_t * iov, uint8_t count) {
+    if(client == NULL)
+        return 0;
+    if(iov == NULL || count == 0)
+        return 0;
+    if(count == 1)
+        return write(client, (uint8_t *)iov[0].data, iov[0].length);
+
+    size_t length = 0;
+    size_t total  = 0;
+    for(uint8_t i = 0; i < count; i++) {
+        length += iov[i].length;
+    }
+
+#ifdef WEBSOCKETS_HAS_WRITEV
+#if defined(HAS_SSL)
+    bool native = !client->isSSL;
+#else
+    bool native = true;
+#endif
+    if(native && count <= WEBSOCKETS_WRITEV_MAX && client->tcp && client->tcp->connected()) {
+        struct iovec vec[WEBSOCKETS_WRITEV_MAX];
+        for(uint8_t i = 0; i < count; i++) {
+            vec[i].iov_base = (void *)iov[i].data;
+            vec[i].iov_len  = iov[i].length;
+        }
+#ifdef WEBSOCKETS_METRICS
+        unsigned long start = micros();
+#endif
+        ssize_t len = WEBSOCKETS_WRITEV(client->tcp->fd(), &vec[0], count);
+        DEBUG_WEBSOCKETS("[writev] n: %zu send: %d\n", length, len);
+        if(len > 0) {
+            total = len;
+        }
+        WEBSOCKETS_METRIC_ADD(client, bytesOut, total);
+        WEBSOCKETS_METRIC_RECORD(client, sendTime, micros() - start);
+    }
+#endif
+
+    if(total == 0) {
+#if(WEBSOCKETS_WRITEV_STACK_SIZE > 0)
+        if(length <= WEBSOCKETS_WRITEV_STACK_SIZE) {
+            uint8_t buffer[WEBSOCKETS_WRITEV_STACK_SIZE];
+            uint8_t * ptr = &buffer[0];
+            for(uint8_t i = 0; i < count; i++) {
+                memcpy(ptr, iov[i].data, iov[i].length);
+                ptr += iov[i].length;
+            }
+            return write(client, &buffer[0], length);
+        }
+#endif
+#ifdef WEBSOCKETS_USE_BIG_MEM
+        // no writev, try to send data in one TCP package (only if some free Heap is there)
+        if(length < 1400 && GET_FREE_HEAP > 6000) {
+            uint8_t * dataPtr = poolAlloc(length);
+            if(dataPtr) {
+                uint8_t * ptr = dataPtr;
+                for(uint8_t i = 0; i < count; i++) {
+                    memcpy(ptr, iov[i].data, iov[i].length);
+                    ptr += iov[i].length;
+                }
+                total = write(client, dataPtr, length);
+                poolFree(dataPtr);
+                return total;
+            }
+        }
+#endif
+    }
+
+    // send what is left buffer by buffer
+    size_t skip = total;
+    for(uint8_t i = 0; i < count; i++) {
+        if(skip >= iov[i].length) {
+            skip -= iov[i].length;
+            continue;
+        }
+        size_t n   = (iov[i].length - skip);
+        size_t len = write(client, (uint8_t *)(iov[i].data + skip), n);
+        total += len;
+        skip = 0;
+        if(len != n) {
+            break;
+        }
+    }
+    return total;
+}
+
 /**
  * enable ping/pong heartbeat process
  * @param client WSclient_t *
  * @param pingInterval uint32_t how often ping will be sent
  * @param pongTimeout uint32_t millis after which pong should timout if not received
  * @param disconnectTimeoutCount uint8_t how many timeouts before disconnect, 0=> do not disconnect
+ * @param maxPingInterval uint32_t  0 = fixed interval, else the interval and timeout adapt to the link (up to maxPingInterval / pongTimeout)
  */
-void WebSockets::enableHeartbeat(WSclient_t * client, uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount) {
+void WebSockets::enableHeartbeat(WSclient_t * client, uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount, uint32_t maxPingInterval) {
     if(client == NULL)
         return;
     client->pingInterval           = pingInterval;
     client->pongTimeout            = pongTimeout;
     client->disconnectTimeoutCount = disconnectTimeoutCount;
+    client->maxPingInterval        = (maxPingInterval > pingInterval) ? maxPingInterval : 0;
     client->pongReceived           = false;
+    client->hb.interval            = pingInterval;
+    client->hb.timeout             = pongTimeout;
+}
+
+/**
+ * is it time for the next heartbeat ping
+ * @param client WSclient_t *
+ * @return true if a ping has to be send
+ */
+bool WebSockets::heartbeatDue(WSclient_t * client) {
+    uint32_t now = millis();
+    if((now - client->lastPing) <= client->hb.interval) {
+        return false;
+    }
+    if(client->maxPingInterval) {
+        // adaptive: the timeout can be longer than the interval, handleHBTimeout sends the retry
+        if(!client->pongReceived) {
+            return false;
+        }
+        // frames received since the last ping show that the peer is alive
+        if((now - client->lastRx) <= client->hb.interval) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * send a heartbeat ping, the payload holds the time for the round trip time
+ * @param client WSclient_t *
+ * @return true if ok
+ */
+bool WebSockets::sendHeartbeatPing(WSclient_t * client) {
+    uint32_t now                             = micros();
+    uint8_t payload[WEBSOCKETS_HB_PING_SIZE] = { 'H', 'B', (uint8_t)(now >> 24), (uint8_t)(now >> 16), (uint8_t)(now >> 8), (uint8_t)now };
+    // a late pong of an earlier ping does not answer this one
+    client->hb.pingSent = now;
+    client->hb.pingOpen = true;
+    return sendFrame(client, WSop_ping, payload, sizeof(payload));
+}
+
+/**
+ * a pong is received, if it answers the last heartbeat ping update the round trip time (RFC 6298) and adapt interval and timeout
+ * pongs of other pings (earlier heartbeat pings, sendPing) are ignored
+ * @param client WSclient_t *
+ * @param payload uint8_t *
+ * @param length size_t
+ */
+void WebSockets::handleHBPong(WSclient_t * client, uint8_t * payload, size_t length) {
+    WSheartbeat_t & hb = client->hb;
+
+    if(length != WEBSOCKETS_HB_PING_SIZE || payload[0] != 'H' || payload[1] != 'B') {
+        return;
+    }
+    uint32_t sent = ((uint32_t)payload[2] << 24) | ((uint32_t)payload[3] << 16) | ((uint32_t)payload[4] << 8) | payload[5];
+    if(!hb.pingOpen || sent != hb.pingSent) {
+        DEBUG_WEBSOCKETS("[WS][%d][HB] pong of an other ping ignored\n", client->num);
+        return;
+    }
+    hb.pingOpen          = false;
+    client->pongReceived = true;
+    uint32_t rtt         = micros() - sent;
+
+    if(hb.samples == 0) {
+        hb.srtt   = rtt;
+        hb.rttvar = rtt / 2;
+    } else {
+        uint32_t delta = (rtt > hb.srtt) ? (rtt - hb.srtt) : (hb.srtt - rtt);
+        hb.rttvar      = hb.rttvar - (hb.rttvar >> 2) + (delta >> 2);
+        hb.srtt        = hb.srtt - (hb.srtt >> 3) + (rtt >> 3);
+    }
+    hb.samples++;
+
+    if(client->maxPingInterval) {
+        // timeout like the TCP retransmission timeout, ping less often while the link is good
+        uint32_t timeout = ((hb.srtt + 4 * hb.rttvar) / 1000) + 1;
+        if(timeout < WEBSOCKETS_HB_MIN_TIMEOUT) {
+            timeout = WEBSOCKETS_HB_MIN_TIMEOUT;
+        }
+        hb.timeout  = (timeout < client->pongTimeout) ? timeout : client->pongTimeout;
+        hb.interval = ((hb.interval * 2) < client->maxPingInterval) ? (hb.interval * 2) : client->maxPingInterval;
+    }
+
+    DEBUG_WEBSOCKETS("[WS][%d][HB] rtt: %uus srtt: %uus rttvar: %uus interval: %ums timeout: %ums\n", client->num, rtt, hb.srtt, hb.rttvar, hb.interval, hb.timeout);
 }
 
 /**
@@ -746,9 +1567,20 @@ void WebSockets::handleHBTimeout(WSclient_t * client) {
         if(client->pongReceived) {
             client->pongTimeoutCount = 0;
         } else {
-            if(pi > client->pongTimeout) {    // pong not received in time
+            if(pi > client->hb.timeout) {    // pong not received in time
                 client->pongTimeoutCount++;
-                client->lastPing = millis() - client->pingInterval - 500;    // force ping on the next run
+                WEBSOCKETS_METRIC_ADD(client, pongTimeouts, 1);
+                if(client->maxPingInterval) {
+                    // back to the short interval, wait longer for the next pong
+                    client->hb.interval = client->pingInterval;
+                    client->hb.timeout  = ((client->hb.timeout * 2) < client->pongTimeout) ? (client->hb.timeout * 2) : client->pongTimeout;
+                    // retry at once, the next timeout is counted from this ping
+                    if(sendHeartbeatPing(client)) {
+                        client->lastPing = millis();
+                    }
+                } else {
+                    client->lastPing = millis() - client->hb.interval - 500;    // force ping on the next run
+                }
 
                 DEBUG_WEBSOCKETS("[HBtimeout] pong TIMEOUT! lp=%d millis=%lu pi=%d count=%d\n", client->lastPing, millis(), pi, client->pongTimeoutCount);
 
@@ -760,3 +1592,555 @@ void WebSockets::handleHBTimeout(WSclient_t * client) {
         }
     }
 }
+
+/**
+ * put a data frame into the coalescing buffer, the buffer is written when full or after cTxDelay ms
+ * @param client WSclient_t *   ptr to the client struct
+ * @param opcode WSopcode_t
+ * @param payload uint8_t *     ptr to the payload (is copied)
+ * @param length size_t         length of the payload
+ * @param headerSize uint8_t    size of the frame header
+ * @param fin bool
+ * @param rsv1 bool             payload is compressed
+ * @return true if ok
+ */
+bool WebSockets::coalesceFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, uint8_t headerSize, bool fin, bool rsv1) {
+    bool ret = true;
+
+    if((client->cTxLength + headerSize + length) > client->cTxSize) {
+        ret = flushCoalesced(client);
+    }
+
+    if(client->cTxLength == 0) {
+        client->cTxStart = millis();
+    }
+
+    uint8_t maskKey[4] = { 0x00, 0x00, 0x00, 0x00 };
+    if(client->cIsClient) {
+        // the frame is copied anyway, so it can be masked with a random key
+        for(uint8_t x = 0; x < sizeof(maskKey); x++) {
+            maskKey[x] = random(0xFF);
+        }
+    }
+
+    uint8_t * headerPtr = (client->cTxBuffer + client->cTxLength);
+    uint8_t * dataPtr   = (headerPtr + createHeader(headerPtr, opcode, length, client->cIsClient, maskKey, fin, rsv1));
+
+    if(payload && length > 0) {
+        memcpy(dataPtr, payload, length);
+        if(client->cIsClient) {
+            for(size_t x = 0; x < length; x++) {
+                dataPtr[x] = (dataPtr[x] ^ maskKey[x % 4]);
+            }
+        }
+    }
+
+    client->cTxLength += (headerSize + length);
+    DEBUG_WEBSOCKETS("[WS][%d][sendFrame] coalesced %u byte (%u / %u)\n", client->num, (headerSize + length), client->cTxLength, client->cTxSize);
+
+    if(client->cTxLength >= client->cTxSize) {
+        ret = flushCoalesced(client) && ret;
+    }
+
+    return ret;
+}
+
+/**
+ * write the collected data frames
+ * @param client WSclient_t *   ptr to the client struct
+ * @return true if ok
+ */
+bool WebSockets::flushCoalesced(WSclient_t * client) {
+    if(client->cTxLength == 0) {
+        return true;
+    }
+
+    size_t length     = client->cTxLength;
+    client->cTxLength = 0;
+    return (write(client, client->cTxBuffer, length) == length);
+}
+
+/**
+ * drop the collected data frames and free the buffer (connection closed or coalescing disabled)
+ * @param client WSclient_t *   ptr to the client struct
+ */
+void WebSockets::freeCoalesced(WSclient_t * client) {
+    if(client->cTxBuffer) {
+        free(client->cTxBuffer);
+        client->cTxBuffer = NULL;
+    }
+    client->cTxLength = 0;
+}
+
+/**
+ * write the collected data frames when the first one waited cTxDelay ms
+ * @param client WSclient_t *   ptr to the client struct
+ */
+void WebSockets::handleCoalesceTimeout(WSclient_t * client) {
+    if(client->cTxLength > 0 && (millis() - client->cTxStart) >= client->cTxDelay) {
+        flushCoalesced(client);
+    }
+}
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+
+typedef struct {
+    bool serverNoContextTakeover;
+    bool clientNoContextTakeover;
+    int8_t serverMaxWindowBits;    ///< -1 not set, 0 set without value
+    int8_t clientMaxWindowBits;    ///< -1 not set, 0 set without value
+} WSdeflateParams_t;
+
+/**
+ * parse one permessage-deflate extension offer / response
+ * @param extension String  "permessage-deflate; param; param=value"
+ * @param params WSdeflateParams_t *
+ * @return false if it is no permessage-deflate or has unknown / invalid parameters
+ */
+static bool parseDeflateExtension(String extension, WSdeflateParams_t * params) {
+    params->serverNoContextTakeover = false;
+    params->clientNoContextTakeover = false;
+    params->serverMaxWindowBits     = -1;
+    params->clientMaxWindowBits     = -1;
+
+    int start = 0;
+    int end;
+    bool first = true;
+
+    do {
+        end = extension.indexOf(';', start);
+        String param;
+        if(end < 0) {
+            param = extension.substring(start);
+        } else {
+            param = extension.substring(start, end);
+        }
+        start = end + 1;
+        param.trim();
+
+        if(first) {
+            if(!param.equalsIgnoreCase(WEBSOCKETS_STRING("permessage-deflate"))) {
+                return false;
+            }
+            first = false;
+            continue;
+        }
+
+        String value;
+        int eq = param.indexOf('=');
+        if(eq >= 0) {
+            value = param.substring(eq + 1);
+            param = param.substring(0, eq);
+            param.trim();
+            value.trim();
+            if(value.startsWith("\"") && value.endsWith("\"") && value.length() >= 2) {
+                value = value.substring(1, value.length() - 1);
+            }
+        }
+
+        int8_t bits = 0;
+        if(value.length() > 0) {
+            long v = value.toInt();
+            if(v < 8 || v > 15) {
+                return false;
+            }
+            bits = (int8_t)v;
+        }
+
+        if(param.equalsIgnoreCase(WEBSOCKETS_STRING("server_no_context_takeover"))) {
+            if(params->serverNoContextTakeover || eq >= 0) {
+                return false;
+            }
+            params->serverNoContextTakeover = true;
+        } else if(param.equalsIgnoreCase(WEBSOCKETS_STRING("client_no_context_takeover"))) {
+            if(params->clientNoContextTakeover || eq >= 0) {
+                return false;
+            }
+            params->clientNoContextTakeover = true;
+        } else if(param.equalsIgnoreCase(WEBSOCKETS_STRING("server_max_window_bits"))) {
+            if(params->serverMaxWindowBits >= 0 || bits == 0) {
+                return false;
+            }
+            params->serverMaxWindowBits = bits;
+        } else if(param.equalsIgnoreCase(WEBSOCKETS_STRING("client_max_window_bits"))) {
+            if(params->clientMaxWindowBits >= 0 || (eq >= 0 && bits == 0)) {
+                return false;
+            }
+            params->clientMaxWindowBits = bits;
+        } else {
+            return false;
+        }
+    } while(end >= 0);
+
+    return !first;
+}
+
+/**
+ * permessage-deflate offer of the client
+ * the peer context is never taken over, so a message can be inflated without an extra window buffer
+ * @return String value for Sec-WebSocket-Extensions
+ */
+String WebSockets::deflateOffer(void) {
+    return WEBSOCKETS_STRING("permessage-deflate; server_no_context_takeover; client_no_context_takeover; client_max_window_bits");
+}
+
+/**
+ * server side: pick the first acceptable permessage-deflate offer of the client
+ * @param client WSclient_t *  ptr to the client struct (cExtensions hold the offers)
+ * @param config WSdeflateConfig_t  local settings
+ * @param response String &  value for the Sec-WebSocket-Extensions response header
+ * @return true if permessage-deflate is used on the connection
+ */
+bool WebSockets::deflateNegotiate(WSclient_t * client, const WSdeflateConfig_t & config, String & response) {
+    WSdeflateParams_t params;
+    int start = 0;
+    int end;
+
+    client->cIsDeflate = false;
+
+    do {
+        end = client->cExtensions.indexOf(',', start);
+        String offer;
+        if(end < 0) {
+            offer = client->cExtensions.substring(start);
+        } else {
+            offer = client->cExtensions.substring(start, end);
+        }
+        start = end + 1;
+
+        if(!parseDeflateExtension(offer, &params)) {
+            continue;
+        }
+
+        client->cIsDeflate = true;
+        client->cDeflate   = config;
+        if(params.serverMaxWindowBits > 0 && params.serverMaxWindowBits < config.windowBits) {
+            client->cDeflate.windowBits = params.serverMaxWindowBits;
+        }
+
+        // we do not need the context of the client, this allows inflating without a window buffer
+        response = WEBSOCKETS_STRING("permessage-deflate; server_no_context_takeover; client_no_context_takeover");
+        if(params.serverMaxWindowBits > 0) {
+            response += WEBSOCKETS_STRING("; server_max_window_bits=");
+            response += client->cDeflate.windowBits;
+        }
+
+        DEBUG_WEBSOCKETS("[WS][%d][deflateNegotiate] permessage-deflate window bits: %d\n", client->num, client->cDeflate.windowBits);
+        return true;
+    } while(end >= 0);
+
+    return false;
+}
+
+/**
+ * client side: check the permessage-deflate response of the server
+ * @param client WSclient_t *  ptr to the client struct (cExtensions hold the response)
+ * @param config WSdeflateConfig_t  local settings
+ * @return false if the response is not valid for our offer
+ */
+bool WebSockets::deflateAccept(WSclient_t * client, const WSdeflateConfig_t & config) {
+    WSdeflateParams_t params;
+
+    client->cIsDeflate = false;
+
+    if(client->cExtensions.length() == 0) {
+        // server declined
+        return true;
+    }
+
+    if(!parseDeflateExtension(client->cExtensions, &params)) {
+        return false;
+    }
+
+    // we asked for it, the server has to confirm it
+    if(!params.serverNoContextTakeover) {
+        return false;
+    }
+
+    client->cIsDeflate = true;
+    client->cDeflate   = config;
+    if(params.clientMaxWindowBits > 0 && params.clientMaxWindowBits < config.windowBits) {
+        client->cDeflate.windowBits = params.clientMaxWindowBits;
+    }
+
+    DEBUG_WEBSOCKETS("[WS][%d][deflateAccept] permessage-deflate window bits: %d\n", client->num, client->cDeflate.windowBits);
+    return true;
+}
+
+/**
+ * compress a message payload
+ * @param client WSclient_t *  ptr to the client struct
+ * @param payload uint8_t *  data to compress
+ * @param length size_t  length of the data, > 0 (the output limit is length - 1)
+ * @param outLength size_t *  compressed length
+ * @return pool buffer with WEBSOCKETS_MAX_HEADER_SIZE reserved in front of the compressed data (poolFree it)
+ *         or NULL if there is not enough heap or the data does not get smaller
+ */
+uint8_t * WebSockets::deflatePayload(WSclient_t * client, uint8_t * payload, size_t length, size_t * outLength) {
+    size_t workSize = rawdeflate_work_size(client->cDeflate.windowBits, client->cDeflate.hashBits);
+
+    if(GET_FREE_HEAP < (workSize + length + 6000)) {
+        DEBUG_WEBSOCKETS("[WS][%d][deflatePayload] not enough heap, send uncompressed\n", client->num);
+        return NULL;
+    }
+
+    void * work = malloc(workSize);
+    if(!work) {
+        return NULL;
+    }
+
+    uint8_t * dataPtr = poolAlloc(length + WEBSOCKETS_MAX_HEADER_SIZE);
+    if(dataPtr) {
+        // only use the result if it is smaller then the input
+        *outLength = rawdeflate_compress_message(payload, length, (dataPtr + WEBSOCKETS_MAX_HEADER_SIZE), (length - 1),
+            client->cDeflate.windowBits, client->cDeflate.hashBits, client->cDeflate.maxChain, work);
+        if(*outLength == 0) {
+            poolFree(dataPtr);
+            dataPtr = NULL;
+        }
+    }
+
+    free(work);
+    return dataPtr;
+}
+
+/**
+ * inflate a received compressed message, closes the connection on errors
+ * @param client WSclient_t *   ptr to the client struct
+ * @param opcode WSopcode_t     text is validated after inflate
+ * @param payload uint8_t *     compressed data (pool buffer, is freed)
+ * @param length size_t *       in: compressed length, out: inflated length
+ * @return uint8_t *  inflated data (malloc, 0 terminated) or NULL if the connection is closed
+ */
+uint8_t * WebSockets::inflatePayload(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t * length) {
+    uint8_t * inflated = NULL;
+    size_t inflatedLen = 0;
+    int res            = rawdeflate_inflate_message(payload, *length, &inflated, &inflatedLen, client->cDeflate.maxInflateSize);
+
+    poolFree(payload);
+
+    if(res != RAWDEFLATE_OK) {
+        DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] inflate failed (%d)!\n", client->num, res);
+        client->cWsRXsize = 0;
+        if(res == RAWDEFLATE_ERR_SIZE) {
+            clientDisconnect(client, 1009);
+        } else if(res == RAWDEFLATE_ERR_MEM) {
+            clientDisconnect(client, 1011);
+        } else {
+            clientDisconnect(client, 1007);
+        }
+        return NULL;
+    }
+
+    DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] inflate %u -> %u\n", client->num, *length, inflatedLen);
+    *length = inflatedLen;
+
+    if(client->cValidateUtf8 && opcode == WSop_text && utf8_validate(inflated, inflatedLen, UTF8_ACCEPT) != UTF8_ACCEPT) {
+        DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] text is no valid UTF-8!\n", client->num);
+        free(inflated);
+        client->cWsRXsize = 0;
+        clientDisconnect(client, 1007);
+        return NULL;
+    }
+    return inflated;
+}
+
+#endif
+
+#ifdef WEBSOCKETS_METRICS
+
+WSmetrics_t WebSockets::_metrics;
+
+/**
+ * counters of all connections since start (or resetGlobalMetrics)
+ * @return const WSmetrics_t &
+ */
+const WSmetrics_t & WebSockets::globalMetrics(void) {
+    return _metrics;
+}
+
+/**
+ * clear the global counters, payloadHeap is kept
+ */
+void WebSockets::resetGlobalMetrics(void) {
+    uint32_t payloadHeap = _metrics.payloadHeap;
+    _metrics             = WSmetrics_t();
+    _metrics.payloadHeap = payloadHeap;
+    _metrics.payloadPeak = payloadHeap;
+}
+
+/**
+ * add a value to a histogram
+ * @param histogram WShistogram_t &
+ * @param value uint32_t
+ */
+void WebSockets::metricRecord(WShistogram_t & histogram, uint32_t value) {
+    uint8_t n = value ? (32 - __builtin_clz(value)) : 0;
+    if(n >= WEBSOCKETS_METRICS_BUCKETS) {
+        n = WEBSOCKETS_METRICS_BUCKETS - 1;
+    }
+    histogram.bucket[n]++;
+    histogram.count++;
+    histogram.sum += value;
+    if(value > histogram.max) {
+        histogram.max = value;
+    }
+}
+
+/**
+ * writes JSON or MessagePack, counts the bytes which do not fit
+ */
+typedef struct {
+    uint8_t * buffer;
+    size_t size;
+    size_t length;
+    bool msgpack;
+
+    void put(uint8_t c) {
+        if(length < size) {
+            buffer[length] = c;
+        }
+        length++;
+    }
+
+    void put(const char * text) {
+        while(*text) {
+            put((uint8_t)*text++);
+        }
+    }
+
+    void putBig(uint64_t value, uint8_t bytes) {
+        while(bytes--) {
+            put((uint8_t)(value >> (bytes * 8)));
+        }
+    }
+
+    void number(uint64_t value) {
+        if(msgpack) {
+            if(value < 0x80) {
+                put((uint8_t)value);
+            } else if(value <= 0xFF) {
+                put(0xCC);
+                putBig(value, 1);
+            } else if(value <= 0xFFFF) {
+                put(0xCD);
+                putBig(value, 2);
+            } else if(value <= 0xFFFFFFFF) {
+                put(0xCE);
+                putBig(value, 4);
+            } else {
+                put(0xCF);
+                putBig(value, 8);
+            }
+            return;
+        }
+        char digits[21];
+        uint8_t n = 0;
+        do {
+            digits[n++] = '0' + (value % 10);
+            value /= 10;
+        } while(value);
+        while(n) {
+            put((uint8_t)digits[--n]);
+        }
+    }
+
+    // key of a map entry, first entry of the map without comma
+    void key(const char * name, bool first = false) {
+        if(msgpack) {
+            put(0xA0 | strlen(name));
+            put(name);
+            return;
+        }
+        if(!first) {
+            put(',');
+        }
+        put('"');
+        put(name);
+        put("\":");
+    }
+
+    void beginMap(uint8_t count) {
+        if(msgpack) {
+            put(0x80 | count);
+        } else {
+            put('{');
+        }
+    }
+
+    void endMap(void) {
+        if(!msgpack) {
+            put('}');
+        }
+    }
+
+    void histogram(const WShistogram_t & histogram) {
+        beginMap(4);
+        key("count", true);
+        number(histogram.count);
+        key("sum");
+        number(histogram.sum);
+        key("max");
+        number(histogram.max);
+        key("buckets");
+        if(msgpack) {
+            put(0xDC);
+            putBig(WEBSOCKETS_METRICS_BUCKETS, 2);
+        } else {
+            put('[');
+        }
+        for(uint8_t i = 0; i < WEBSOCKETS_METRICS_BUCKETS; i++) {
+            if(i && !msgpack) {
+                put(',');
+            }
+            number(histogram.bucket[i]);
+        }
+        if(!msgpack) {
+            put(']');
+        }
+        endMap();
+    }
+} WSmetricsWriter_t;
+
+/**
+ * write the counters as compact JSON or MessagePack (a map with the names of WSmetrics_t)
+ * like snprintf the output is cut if the buffer is too small, JSON is 0 terminated if there is room
+ * @param metrics const WSmetrics_t &
+ * @param format WSmetricsFormat_t  WSmetrics_JSON or WSmetrics_MSGPACK
+ * @param buffer uint8_t *  can be NULL to get the size
+ * @param size size_t
+ * @return length of the complete output
+ */
+size_t WebSockets::exportMetrics(const WSmetrics_t & metrics, WSmetricsFormat_t format, uint8_t * buffer, size_t size) {
+    WSmetricsWriter_t writer = { buffer, (buffer ? size : 0), 0, (format == WSmetrics_MSGPACK) };
+
+    writer.beginMap(10);
+    writer.key("framesIn", true);
+    writer.number(metrics.framesIn);
+    writer.key("framesOut");
+    writer.number(metrics.framesOut);
+    writer.key("bytesIn");
+    writer.number(metrics.bytesIn);
+    writer.key("bytesOut");
+    writer.number(metrics.bytesOut);
+    writer.key("readTimeouts");
+    writer.number(metrics.readTimeouts);
+    writer.key("pongTimeouts");
+    writer.number(metrics.pongTimeouts);
+    writer.key("payloadHeap");
+    writer.number(metrics.payloadHeap);
+    writer.key("payloadPeak");
+    writer.number(metrics.payloadPeak);
+    writer.key("sendTime");
+    writer.histogram(metrics.sendTime);
+    writer.key("rtt");
+    writer.histogram(metrics.rtt);
+    writer.endMap();
+
+    if(!writer.msgpack && writer.length < writer.size) {
+        buffer[writer.length] = 0;
+    }
+    return writer.length;
+}
+
+#endif
@@ -85,6 +85,15 @@
 #define WEBSOCKETS_YIELD()
 #define WEBSOCKETS_YIELD_MORE()
 
+#elif defined(WEBSOCKETS_HOST)
+
+// host build (Linux / macOS) for tests and benchmarks, see tests/host
+#define WEBSOCKETS_MAX_DATA_SIZE (15 * 1024)
+#define WEBSOCKETS_USE_BIG_MEM
+#define GET_FREE_HEAP (1024 * 1024)
+#define WEBSOCKETS_YIELD() yield()
+#define WEBSOCKETS_YIELD_MORE() delay(1)
+
 #elif defined(ARDUINO_ARCH_RP2040)
 
 #define WEBSOCKETS_MAX_DATA_SIZE (15 * 1024)
@@ -125,6 +134,57 @@
 #define WEBSOCKETS_TCP_TIMEOUT (5000)
 #endif
 
+// default chunk size for streaming receive (see enableStreaming)
+#ifndef WEBSOCKETS_STREAM_CHUNK_SIZE
+#define WEBSOCKETS_STREAM_CHUNK_SIZE (512)
+#endif
+
+// reassembly of fragmented messages (see enableReassembly), default max size of a message
+#ifndef WEBSOCKETS_REASSEMBLY_SIZE
+#define WEBSOCKETS_REASSEMBLY_SIZE (WEBSOCKETS_MAX_DATA_SIZE)
+#endif
+
+// outbound coalescing (see enableCoalescing), max ms a frame waits and bytes written at once
+#ifndef WEBSOCKETS_COALESCE_DELAY
+#define WEBSOCKETS_COALESCE_DELAY (5)
+#endif
+
+#ifndef WEBSOCKETS_COALESCE_SIZE
+#define WEBSOCKETS_COALESCE_SIZE (1400)
+#endif
+
+// adaptive heartbeat (see enableAdaptiveHeartbeat), lower limit of the pong timeout in ms
+#ifndef WEBSOCKETS_HB_MIN_TIMEOUT
+#define WEBSOCKETS_HB_MIN_TIMEOUT (500)
+#endif
+
+// buffer pool of the received payloads and the send copies (client masking, deflate),
+// bytes of free buffers kept for reuse (0 = buffers are freed at once)
+#ifndef WEBSOCKETS_POOL_SIZE
+#ifdef WEBSOCKETS_USE_BIG_MEM
+#define WEBSOCKETS_POOL_SIZE (8 * 1024)
+#else
+#define WEBSOCKETS_POOL_SIZE (0)
+#endif
+#endif
+
+// size classes of the pool (64, 256, 1024 and 4096 byte), bigger buffers are not pooled
+#define WEBSOCKETS_POOL_CLASSES (4)
+
+// max size of the HTTP request head the server accepts (request line + all header lines)
+#ifndef WEBSOCKETS_MAX_HTTP_HEAD_SIZE
+#define WEBSOCKETS_MAX_HTTP_HEAD_SIZE (4096)
+#endif
+
+// buffer for one HTTP header line of the server (one for all clients), longer lines of unused headers are skipped
+#ifndef WEBSOCKETS_HTTP_LINE_SIZE
+#ifdef WEBSOCKETS_USE_BIG_MEM
+#define WEBSOCKETS_HTTP_LINE_SIZE (256)
+#else
+#define WEBSOCKETS_HTTP_LINE_SIZE (128)
+#endif
+#endif
+
 #define NETWORK_ESP8266_ASYNC (0)
 #define NETWORK_ESP8266 (1)
 #define NETWORK_W5100 (2)
@@ -135,13 +195,28 @@
 #define NETWORK_UNOWIFIR4 (7)
 #define NETWORK_WIFI_NINA (8)
 #define NETWORK_SAMD_SEED (9)
+#define NETWORK_POSIX (10)
 
 // max size of the WS Message Header
 #define WEBSOCKETS_MAX_HEADER_SIZE (14)
 
+// bytes to reserve in front of the payload for sendTXT / sendBIN with headerToPayload = true
+#define WEBSOCKETS_HEADER_ROOM WEBSOCKETS_MAX_HEADER_SIZE
+
+// frames up to this size are gathered on the stack when the network has no writev
+#ifndef WEBSOCKETS_WRITEV_STACK_SIZE
+#ifdef __AVR__
+#define WEBSOCKETS_WRITEV_STACK_SIZE (0)
+#else
+#define WEBSOCKETS_WRITEV_STACK_SIZE (128)
+#endif
+#endif
+
 #if !defined(WEBSOCKETS_NETWORK_TYPE)
 // select Network type based
-#if defined(ESP8266) || defined(ESP31B)
+#if defined(WEBSOCKETS_HOST)
+#define WEBSOCKETS_NETWORK_TYPE NETWORK_POSIX
+#elif defined(ESP8266) || defined(ESP31B)
 #define WEBSOCKETS_NETWORK_TYPE NETWORK_ESP8266
 // #define WEBSOCKETS_NETWORK_TYPE NETWORK_ESP8266_ASYNC
 // #define WEBSOCKETS_NETWORK_TYPE NETWORK_W5100
@@ -286,6 +361,12 @@
 #define WEBSOCKETS_NETWORK_CLASS WiFiClient
 #define WEBSOCKETS_NETWORK_SERVER_CLASS WiFiServer
 
+#elif(WEBSOCKETS_NETWORK_TYPE == NETWORK_POSIX)
+
+#include "PosixTCP.h"
+#define WEBSOCKETS_NETWORK_CLASS PosixTCPClient
+#define WEBSOCKETS_NETWORK_SERVER_CLASS PosixTCPServer
+
 #else
 #error "no network type selected!"
 #endif
@@ -294,6 +375,50 @@
 #define HAS_SSL
 #endif
 
+// network client is a lwip / POSIX socket, header and payload can be send with one writev call
+// and the client can connect (ws) without blocking loop()
+// (WEBSOCKETS_DISABLE_WRITEV gives the send path of the other networks, the host benchmark uses it)
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32_ETH) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_POSIX)
+#ifndef WEBSOCKETS_DISABLE_WRITEV
+#define WEBSOCKETS_HAS_WRITEV
+#endif
+#define WEBSOCKETS_HAS_ASYNC_CONNECT
+#endif
+
+// permessage-deflate (RFC 7692) needs some KB of heap per message
+#if defined(WEBSOCKETS_USE_BIG_MEM) && !defined(WEBSOCKETS_DISABLE_DEFLATE)
+#define WEBSOCKETS_HAS_DEFLATE
+
+// LZ77 window used for compression (8 - 15), 2^x * 2 Byte of heap while sending
+#ifndef WEBSOCKETS_DEFLATE_WINDOW_BITS
+#define WEBSOCKETS_DEFLATE_WINDOW_BITS (10)
+#endif
+
+// match finder hash table (8 - 15), 2^x * 2 Byte of heap while sending
+#ifndef WEBSOCKETS_DEFLATE_HASH_BITS
+#define WEBSOCKETS_DEFLATE_HASH_BITS (10)
+#endif
+
+// match candidates checked per byte, limits the CPU time per message
+#ifndef WEBSOCKETS_DEFLATE_MAX_CHAIN
+#define WEBSOCKETS_DEFLATE_MAX_CHAIN (16)
+#endif
+
+// messages smaller then this are send uncompressed
+#ifndef WEBSOCKETS_DEFLATE_MIN_SIZE
+#define WEBSOCKETS_DEFLATE_MIN_SIZE (64)
+#endif
+#endif
+
+// counters and latency histograms per connection and for all connections (see WSmetrics_t), off by default
+// #define WEBSOCKETS_METRICS
+#ifdef WEBSOCKETS_METRICS
+// buckets of a histogram, bucket n counts values of n bits, the last one all bigger values
+#ifndef WEBSOCKETS_METRICS_BUCKETS
+#define WEBSOCKETS_METRICS_BUCKETS (16)
+#endif
+#endif
+
 // moves all Header strings to Flash (~300 Byte)
 #ifdef WEBSOCKETS_SAVE_RAM
 #define WEBSOCKETS_STRING(var) F(var)
@@ -320,6 +445,8 @@ typedef enum {
     WStype_FRAGMENT_FIN,
     WStype_PING,
     WStype_PONG,
+    WStype_STREAM,
+    WStype_MESSAGE,
 } WStype_t;
 
 typedef enum {
@@ -333,6 +460,23 @@ typedef enum {
                                  ///< %xB-F are reserved for further control frames
 } WSopcode_t;
 
+/**
+ * one buffer of a gathered write (see WebSockets::writev)
+ */
+typedef struct {
+    const uint8_t * data;
+    size_t length;
+} WSiovec_t;
+
+/**
+ * free payload buffers, one list per size class (see WebSockets::poolAlloc)
+ */
+typedef struct {
+    uint8_t * freeList[WEBSOCKETS_POOL_CLASSES] = { NULL };
+    size_t size   = WEBSOCKETS_POOL_SIZE;    ///< max bytes of free buffers kept
+    size_t cached = 0;                       ///< bytes of free buffers kept now
+} WSbufferPool_t;
+
 typedef struct {
     bool fin;
     bool rsv1;
@@ -347,6 +491,97 @@ typedef struct {
     uint8_t * maskKey;
 } WSMessageHeader_t;
 
+/**
+ * one part of a streamed data frame, passed as payload of WStype_STREAM
+ */
+typedef struct {
+    WSopcode_t opcode;    ///< WSop_text, WSop_binary or WSop_continuation
+    bool fin;             ///< fin flag of the frame
+    size_t offset;        ///< position of data in the frame payload
+    size_t total;         ///< payload length of the frame
+    uint8_t * data;       ///< unmasked data (0 terminated)
+    size_t length;        ///< length of data
+} WSstreamChunk_t;
+
+/**
+ * a reassembled fragmented message, passed as payload of WStype_MESSAGE (see enableReassembly)
+ * the parts are the unmasked payloads of the frames (each 0 terminated), valid until the event returns
+ */
+typedef struct {
+    WSopcode_t opcode;         ///< WSop_text or WSop_binary
+    const WSiovec_t * parts;    ///< payloads of the frames in order
+    size_t count;              ///< number of parts
+    size_t length;             ///< length of the message
+} WSmessage_t;
+
+/**
+ * time of the phases of the last client connect (us), see WebSocketsClient::getConnectTiming
+ */
+typedef struct {
+    uint32_t dns     = 0;    ///< host name lookup
+    uint32_t connect = 0;    ///< TCP connect
+    uint32_t tls     = 0;    ///< TCP connect and TLS handshake of wss (one blocking call of the secure client)
+    bool tlsSession  = false;    ///< the TLS session of the last connection was offered for resumption
+    uint32_t upgrade = 0;    ///< HTTP upgrade request until the response is handled
+    uint32_t total   = 0;    ///< start of the attempt until connected
+} WSconnectTiming_t;
+
+/**
+ * heartbeat state of a connection, the round trip time is measured with the timestamp in the ping payload
+ */
+typedef struct {
+    uint32_t srtt     = 0;    ///< smoothed round trip time in us (RFC 6298)
+    uint32_t rttvar   = 0;    ///< round trip time variation in us
+    uint32_t samples  = 0;    ///< pongs of heartbeat pings
+    uint32_t interval = 0;    ///< current ping interval in ms
+    uint32_t timeout  = 0;    ///< current pong timeout in ms
+    uint32_t pingSent = 0;    ///< micros in the payload of the last heartbeat ping, only its pong counts
+    bool pingOpen     = false;    ///< the pong of the last heartbeat ping is not received yet
+} WSheartbeat_t;
+
+#ifdef WEBSOCKETS_METRICS
+/**
+ * distribution of a time, bucket 0 counts 0, bucket n values from 2^(n-1) to 2^n - 1
+ */
+typedef struct {
+    uint32_t count = 0;
+    uint64_t sum   = 0;
+    uint32_t max   = 0;
+    uint32_t bucket[WEBSOCKETS_METRICS_BUCKETS] = { 0 };
+} WShistogram_t;
+
+/**
+ * counters of one connection or of all connections (see WebSockets::globalMetrics), the counters wrap
+ */
+typedef struct {
+    uint32_t framesIn     = 0;    ///< frames received
+    uint32_t framesOut    = 0;    ///< frames send (also the ones collected by enableCoalescing)
+    uint32_t bytesIn      = 0;    ///< frame bytes received (header and payload)
+    uint32_t bytesOut     = 0;    ///< bytes written to the socket (frames and HTTP)
+    uint32_t readTimeouts = 0;    ///< no data for WEBSOCKETS_TCP_TIMEOUT while a frame was read
+    uint32_t pongTimeouts = 0;    ///< heartbeat pongs not received in time
+    uint32_t payloadHeap  = 0;    ///< bytes of receive buffers in use (only global)
+    uint32_t payloadPeak  = 0;    ///< max of payloadHeap (only global)
+    WShistogram_t sendTime;       ///< us per socket write, the time sending blocks loop()
+    WShistogram_t rtt;            ///< us from ping to pong
+} WSmetrics_t;
+
+typedef enum {
+    WSmetrics_JSON,
+    WSmetrics_MSGPACK,
+} WSmetricsFormat_t;
+#endif
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+typedef struct {
+    uint8_t windowBits    = WEBSOCKETS_DEFLATE_WINDOW_BITS;    ///< LZ77 window for sending (8 - 15), the peer may lower it
+    uint8_t hashBits      = WEBSOCKETS_DEFLATE_HASH_BITS;      ///< match finder hash table size (8 - 15)
+    uint16_t maxChain     = WEBSOCKETS_DEFLATE_MAX_CHAIN;      ///< match candidates checked per byte
+    size_t minSize        = WEBSOCKETS_DEFLATE_MIN_SIZE;       ///< smaller messages are send uncompressed
+    size_t maxInflateSize = WEBSOCKETS_MAX_DATA_SIZE;          ///< max size of a received message after decompression
+} WSdeflateConfig_t;
+#endif
+
 typedef struct {
     void init(uint8_t num,
         uint32_t pingInterval,
@@ -368,7 +603,7 @@ typedef struct {
 
 #if defined(HAS_SSL)
     bool isSSL = false;    ///< run in ssl mode
-    WEBSOCKETS_NETWORK_SSL_CLASS * ssl;
+    WEBSOCKETS_NETWORK_SSL_CLASS * ssl = nullptr;
 #endif
 
     String cUrl;           ///< http url
@@ -385,6 +620,33 @@ typedef struct {
     String cExtensions;       ///< client Sec-WebSocket-Extensions
     uint16_t cVersion = 0;    ///< client Sec-WebSocket-Version
 
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    bool cIsDeflate = false;       ///< permessage-deflate negotiated
+    WSdeflateConfig_t cDeflate;    ///< permessage-deflate settings of the connection
+#endif
+
+    size_t cStreamChunkSize = 0;    ///< data frames bigger then this are delivered in chunks (0 = off)
+    size_t cStreamOffset    = 0;    ///< received bytes of the streamed frame
+
+    size_t cRaMaxSize    = 0;                    ///< fragmented messages up to this size are reassembled (0 = off)
+    bool cRaContiguous   = false;                ///< deliver reassembled messages in one buffer (WStype_TEXT / WStype_BIN)
+    WSopcode_t cRaOpcode = WSop_continuation;    ///< opcode of the message being reassembled, WSop_continuation = none
+    bool cRaRsv1         = false;                ///< the message being reassembled is compressed
+    WSiovec_t * cRaParts = NULL;                 ///< payloads of the received frames (pool buffers)
+    size_t cRaCount      = 0;                    ///< parts in cRaParts
+    size_t cRaCapacity   = 0;                    ///< size of cRaParts
+    size_t cRaLength     = 0;                    ///< bytes of the message received
+
+    bool cValidateUtf8 = false;    ///< close with 1007 if a text message is no valid UTF-8
+    bool cUtf8Text     = false;    ///< a fragmented text message is received
+    uint8_t cUtf8State = 0;        ///< UTF-8 validator state of the text message
+
+    uint8_t * cTxBuffer    = NULL;    ///< data frames waiting to be written together
+    size_t cTxLength       = 0;       ///< bytes in cTxBuffer
+    size_t cTxSize         = 0;       ///< size of cTxBuffer, written when full (0 = coalescing off)
+    uint16_t cTxDelay      = 0;       ///< max ms a frame waits in cTxBuffer
+    unsigned long cTxStart = 0;       ///< millis when the first frame was put into cTxBuffer
+
     uint8_t cWsRXsize = 0;                            ///< State of the RX
     uint8_t cWsHeader[WEBSOCKETS_MAX_HEADER_SIZE];    ///< RX WS Message buffer
     WSMessageHeader_t cWsHeaderDecode;
@@ -403,15 +665,46 @@ typedef struct {
     uint32_t pongTimeout           = 0;    // interval in millis after which pong is considered to timeout
     uint8_t disconnectTimeoutCount = 0;    // after how many subsequent pong timeouts discconnect will happen, 0 means "do not disconnect"
     uint8_t pongTimeoutCount       = 0;    // current pong timeout count
+    uint32_t maxPingInterval       = 0;    // adaptive heartbeat: upper limit of the ping interval, 0 means fixed interval
+    uint32_t lastRx                = 0;    // millis when the last frame has been received
+    WSheartbeat_t hb;
 
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
     String cHttpLine;    ///< HTTP header lines
 #endif
 
+    uint16_t cHttpHeadSize = 0;    ///< bytes of the HTTP request head received (server)
+
+#ifdef WEBSOCKETS_METRICS
+    WSmetrics_t metrics;
+    unsigned long mPingStart = 0;        ///< micros when the last ping was send
+    bool mPingOpen           = false;    ///< waiting for the pong
+#endif
+
 } WSclient_t;
 
 class WebSockets {
+  public:
+    virtual ~WebSockets(void);
+
+    bool adoptPayload(uint8_t * payload);
+    void releasePayload(uint8_t * payload);
+    void setBufferPoolSize(size_t size);
+
+#ifdef WEBSOCKETS_METRICS
+    static const WSmetrics_t & globalMetrics(void);
+    static void resetGlobalMetrics(void);
+    static size_t exportMetrics(const WSmetrics_t & metrics, WSmetricsFormat_t format, uint8_t * buffer, size_t size);
+
+    static WSmetrics_t _metrics;    ///< all connections
+    static void metricRecord(WShistogram_t & histogram, uint32_t value);
+#endif
+
   protected:
+    WSbufferPool_t _pool;
+    uint8_t * _rxPayload = NULL;     ///< pooled payload of the running event
+    bool _rxAdopted      = false;    ///< _rxPayload is kept by the application
+
 #ifdef __AVR__
     typedef void (*WSreadWaitCb)(WSclient_t * client, bool ok);
 #else
@@ -424,8 +717,10 @@ class WebSockets {
     void clientDisconnect(WSclient_t * client, uint16_t code, char * reason = NULL, size_t reasonLen = 0);
 
     virtual void messageReceived(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, bool fin) = 0;
+    virtual void streamReceived(WSclient_t * client, WSstreamChunk_t * chunk)                                        = 0;
+    virtual void messageReassembled(WSclient_t * client, WSmessage_t * message)                                      = 0;
 
-    uint8_t createHeader(uint8_t * buf, WSopcode_t opcode, size_t length, bool mask, uint8_t maskKey[4], bool fin);
+    uint8_t createHeader(uint8_t * buf, WSopcode_t opcode, size_t length, bool mask, uint8_t maskKey[4], bool fin, bool rsv1 = false);
     bool sendFrameHeader(WSclient_t * client, WSopcode_t opcode, size_t length = 0, bool fin = true);
     bool sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * payload = NULL, size_t length = 0, bool fin = true, bool headerToPayload = false);
 
@@ -436,18 +731,67 @@ class WebSockets {
     bool handleWebsocketWaitFor(WSclient_t * client, size_t size);
     void handleWebsocketCb(WSclient_t * client);
     void handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t * payload);
+    void handleWebsocketStream(WSclient_t * client);
+    bool handleWebsocketStreamChunk(WSclient_t * client, uint8_t * buffer);
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
+    void handleWebsocketStreamCb(WSclient_t * client, bool ok, uint8_t * buffer);
+#endif
+
+    bool utf8Begin(WSclient_t * client);
+    bool utf8Done(WSclient_t * client, bool last);
+
+    bool reassembleFrame(WSclient_t * client, uint8_t * payload);
+    void reassemblyDone(WSclient_t * client);
+    void freeReassembly(WSclient_t * client);
 
     String acceptKey(String & clientKey);
     String base64_encode(uint8_t * data, size_t length);
 
+    uint8_t * poolAlloc(size_t size);
+    void poolFree(uint8_t * buffer);
+
     bool readCb(WSclient_t * client, uint8_t * out, size_t n, WSreadWaitCb cb);
     virtual size_t write(WSclient_t * client, uint8_t * out, size_t n);
     size_t write(WSclient_t * client, const char * out);
+    virtual size_t writev(WSclient_t * client, WSiovec_t * iov, uint8_t count);
 
-    void enableHeartbeat(WSclient_t * client, uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount);
+    void enableHeartbeat(WSclient_t * client, uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount, uint32_t maxPingInterval = 0);
     void handleHBTimeout(WSclient_t * client);
+    bool heartbeatDue(WSclient_t * client);
+    bool sendHeartbeatPing(WSclient_t * client);
+    void handleHBPong(WSclient_t * client, uint8_t * payload, size_t length);
+
+    bool coalesceFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, uint8_t headerSize, bool fin, bool rsv1);
+    bool flushCoalesced(WSclient_t * client);
+    void freeCoalesced(WSclient_t * client);
+    void handleCoalesceTimeout(WSclient_t * client);
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    String deflateOffer(void);
+    bool deflateNegotiate(WSclient_t * client, const WSdeflateConfig_t & config, String & response);
+    bool deflateAccept(WSclient_t * client, const WSdeflateConfig_t & config);
+    uint8_t * deflatePayload(WSclient_t * client, uint8_t * payload, size_t length, size_t * outLength);
+    uint8_t * inflatePayload(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t * length);
+#endif
 };
 
+#ifdef WEBSOCKETS_METRICS
+#define WEBSOCKETS_METRIC_ADD(client, counter, n) \
+    do {                                          \
+        (client)->metrics.counter += (n);         \
+        WebSockets::_metrics.counter += (n);      \
+    } while(0)
+#define WEBSOCKETS_METRIC_RECORD(client, histogram, value)                     \
+    do {                                                                       \
+        uint32_t metricValue = (value);                                        \
+        WebSockets::metricRecord((client)->metrics.histogram, metricValue);    \
+        WebSockets::metricRecord(WebSockets::_metrics.histogram, metricValue); \
+    } while(0)
+#else
+#define WEBSOCKETS_METRIC_ADD(client, counter, n)
+#define WEBSOCKETS_METRIC_RECORD(client, histogram, value)
+#endif
+
 #ifndef UNUSED
 #define UNUSED(var) (void)(var)
 #endif
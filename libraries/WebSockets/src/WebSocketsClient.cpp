@@ -25,6 +25,22 @@
 #include "WebSockets.h"
 #include "WebSocketsClient.h"
 
+#ifdef WEBSOCKETS_HAS_ASYNC_CONNECT
+#include <errno.h>
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_POSIX)
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#else
+#include <lwip/netdb.h>
+#include <lwip/sockets.h>
+#endif
+#endif
+
 WebSocketsClient::WebSocketsClient() {
     _cbEvent             = NULL;
     _client.num          = 0;
@@ -33,16 +49,64 @@ WebSocketsClient::WebSocketsClient() {
     _reconnectInterval   = 500;
     _port                = 0;
     _host                = "";
+    _connectStart        = 0;
+    _phaseStart          = 0;
+
+    _reconnectMaxInterval = 0;
+    _reconnectDelay       = _reconnectInterval;
+    _reconnectJitter      = 0;
+    _reconnectAttempts    = 0;
+#if defined(SSL_BARESSL)
+    _tlsSessionValid = false;
+#endif
+#ifdef WEBSOCKETS_HAS_ASYNC_CONNECT
+    _connectFd = -1;
+#endif
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    _deflate = false;
+#endif
 }
 
 WebSocketsClient::~WebSocketsClient() {
     disconnect();
+    freeSecureClient();
+}
+
+/**
+ * delete the secure client, it is kept over reconnects
+ */
+void WebSocketsClient::freeSecureClient(void) {
+#if defined(HAS_SSL)
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_WIFI_NINA) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_SAMD_SEED) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_UNOWIFIR4)
+    // does not support delete (no destructor)
+#else
+    if(_client.ssl) {
+        if(_client.tcp == _client.ssl) {
+            _client.tcp = NULL;
+        }
+        delete _client.ssl;
+        _client.ssl = NULL;
+    }
+#endif
+#endif
 }
 
 /**
  * calles to init the Websockets server
  */
 void WebSocketsClient::begin(const char * host, uint16_t port, const char * url, const char * protocol) {
+    // a begin() before: close its connection and free its secure client
+    disconnect();
+    freeSecureClient();
+
+#if defined(SSL_BARESSL)
+    // the session is only valid for the same server
+    if(_host != host || _port != port) {
+        _tlsSession      = BearSSL::Session();
+        _tlsSessionValid = false;
+    }
+#endif
+
     _host = host;
     _port = port;
 #if defined(HAS_SSL)
@@ -235,26 +299,59 @@ void WebSocketsClient::loop(void) {
     }
     WEBSOCKETS_YIELD();
     if(!clientIsConnected(&_client)) {
+#ifdef WEBSOCKETS_HAS_ASYNC_CONNECT
+        if(_connectFd >= 0) {
+            handleConnect();
+            return;
+        }
+#endif
+
         // do not flood the server
-        if((millis() - _lastConnectionFail) < _reconnectInterval) {
+        if((millis() - _lastConnectionFail) < _reconnectDelay) {
             return;
         }
 
+        // wait longer after every failed attempt (setReconnectBackoff)
+        _reconnectDelay = reconnectDelay();
+        if(_reconnectAttempts < 0xFF) {
+            _reconnectAttempts++;
+        }
+
+        _connectTiming = WSconnectTiming_t();
+        _connectStart  = micros();
+
+        bool ssl = false;
 #if defined(HAS_SSL)
-        if(_client.isSSL) {
-            DEBUG_WEBSOCKETS("[WS-Client] connect wss...\n");
-            if(_client.ssl) {
-#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_WIFI_NINA) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_SAMD_SEED) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_UNOWIFIR4)
-                // does not support delete (no destructor)
-#else
-                delete _client.ssl;
+        ssl = _client.isSSL;
 #endif
 
-                _client.ssl = NULL;
+#ifdef WEBSOCKETS_HAS_ASYNC_CONNECT
+        // ws: the TCP connect is checked in the next loop() calls
+        if(!ssl) {
+            if(_client.tcp) {
+                delete _client.tcp;
                 _client.tcp = NULL;
             }
-            _client.ssl = new WEBSOCKETS_NETWORK_SSL_CLASS();
+            if(!startConnect()) {
+                connectFailedCb();
+                _lastConnectionFail = millis();
+            }
+            return;
+        }
+#endif
+
+#if defined(HAS_SSL)
+        if(_client.isSSL) {
+            DEBUG_WEBSOCKETS("[WS-Client] connect wss...\n");
+            // the secure client of the last connection is reused (no new allocation, TLS session)
+            if(!_client.ssl) {
+                _client.ssl = new WEBSOCKETS_NETWORK_SSL_CLASS();
+            }
             _client.tcp = _client.ssl;
+#if defined(ESP32) && (ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(2, 0, 0))
+            // the TLS handshake blocks loop(), do not wait longer then for the TCP connect (default 120s)
+            _client.ssl->setHandshakeTimeout(WEBSOCKETS_TCP_TIMEOUT / 1000);
+#endif
             if(_CA_cert) {
                 DEBUG_WEBSOCKETS("[WS-Client] setting CA certificate");
 #if defined(ESP32)
@@ -291,6 +388,11 @@ void WebSocketsClient::loop(void) {
                 DEBUG_WEBSOCKETS("[WS-Client] setting client certificate and key");
 #endif
             }
+#if defined(SSL_BARESSL)
+            // offer the session of the last connection, the server can skip the full handshake
+            _client.ssl->setSession(&_tlsSession);
+            _connectTiming.tlsSession = _tlsSessionValid;
+#endif
         } else {
             DEBUG_WEBSOCKETS("[WS-Client] connect ws...\n");
             if(_client.tcp) {
@@ -312,11 +414,20 @@ void WebSocketsClient::loop(void) {
             return;
         }
         WEBSOCKETS_YIELD();
+        _phaseStart = micros();
 #if defined(ESP32)
         if(_client.tcp->connect(_host.c_str(), _port, WEBSOCKETS_TCP_TIMEOUT)) {
 #else
         if(_client.tcp->connect(_host.c_str(), _port)) {
 #endif
+            if(ssl) {
+                _connectTiming.tls = (micros() - _phaseStart);
+#if defined(SSL_BARESSL)
+                _tlsSessionValid = true;
+#endif
+            } else {
+                _connectTiming.connect = (micros() - _phaseStart);
+            }
             connectedCb();
             _lastConnectionFail = 0;
         } else {
@@ -329,6 +440,7 @@ void WebSocketsClient::loop(void) {
         if(_client.status == WSC_CONNECTED) {
             handleHBPing();
             handleHBTimeout(&_client);
+            handleCoalesceTimeout(&_client);
         }
     }
 }
@@ -426,6 +538,9 @@ bool WebSocketsClient::sendPing(String & payload) {
  * @param num uint8_t client id
  */
 void WebSocketsClient::disconnect(void) {
+#ifdef WEBSOCKETS_HAS_ASYNC_CONNECT
+    stopConnect();
+#endif
     if(clientIsConnected(&_client)) {
         WebSockets::clientDisconnect(&_client, 1000);
     }
@@ -472,12 +587,63 @@ void WebSocketsClient::setExtraHeaders(const char * extraHeaders) {
  */
 void WebSocketsClient::setReconnectInterval(unsigned long time) {
     _reconnectInterval = time;
+    _reconnectDelay    = time;
+}
+
+/**
+ * double the reconnect interval after every failed attempt up to maxInterval,
+ * a random part (jitter) spreads the reconnects of many clients after a server restart
+ * @param maxInterval unsigned long  max wait in ms (0 = fixed interval)
+ * @param jitter uint8_t  up to jitter % of the wait are subtracted at random
+ */
+void WebSocketsClient::setReconnectBackoff(unsigned long maxInterval, uint8_t jitter) {
+    _reconnectMaxInterval = maxInterval;
+    _reconnectJitter      = std::min(jitter, (uint8_t)100);
+}
+
+/**
+ * wait before the next connect attempt
+ * @return unsigned long  ms
+ */
+unsigned long WebSocketsClient::reconnectDelay(void) {
+    if(_reconnectMaxInterval <= _reconnectInterval) {
+        return _reconnectInterval;
+    }
+
+    unsigned long wait = _reconnectInterval;
+    for(uint8_t i = 0; i < _reconnectAttempts && wait < _reconnectMaxInterval; i++) {
+        wait *= 2;
+    }
+    wait = std::min(wait, _reconnectMaxInterval);
+
+    if(_reconnectJitter) {
+        wait -= random(((wait * _reconnectJitter) / 100) + 1);
+    }
+    return wait;
 }
 
 bool WebSocketsClient::isConnected(void) {
     return (_client.status == WSC_CONNECTED);
 }
 
+/**
+ * time of the phases of the last connect, total is set when the connection is up
+ * @return const WSconnectTiming_t &  dns, connect, tls, upgrade and total in us
+ */
+const WSconnectTiming_t & WebSocketsClient::getConnectTiming(void) {
+    return _connectTiming;
+}
+
+#ifdef WEBSOCKETS_METRICS
+/**
+ * counters of the current (or last) connection, they are cleared on connect
+ * @return const WSmetrics_t &
+ */
+const WSmetrics_t & WebSocketsClient::getMetrics(void) {
+    return _client.metrics;
+}
+#endif
+
 // #################################################################################
 // #################################################################################
 // #################################################################################
@@ -518,6 +684,26 @@ void WebSocketsClient::messageReceived(WSclient_t * client, WSopcode_t opcode, u
     runCbEvent(type, payload, length);
 }
 
+/**
+ * called for every chunk of a streamed data frame
+ * @param client WSclient_t *  ptr to the client struct
+ * @param chunk WSstreamChunk_t *
+ */
+void WebSocketsClient::streamReceived(WSclient_t * client, WSstreamChunk_t * chunk) {
+    UNUSED(client);
+    runCbEvent(WStype_STREAM, (uint8_t *)chunk, chunk->length);
+}
+
+/**
+ * called for a reassembled fragmented message
+ * @param client WSclient_t *  ptr to the client struct
+ * @param message WSmessage_t *
+ */
+void WebSocketsClient::messageReassembled(WSclient_t * client, WSmessage_t * message) {
+    UNUSED(client);
+    runCbEvent(WStype_MESSAGE, (uint8_t *)message, message->length);
+}
+
 /**
  * Disconnect an client
  * @param client WSclient_t *  ptr to the client struct
@@ -529,11 +715,10 @@ void WebSocketsClient::clientDisconnect(WSclient_t * client) {
     if(client->isSSL && client->ssl) {
         if(client->ssl->connected()) {
             client->ssl->flush();
-            client->ssl->stop();
         }
-        event = true;
-        delete client->ssl;
-        client->ssl = NULL;
+        // stop frees the TLS buffers, the object is reused for the next connect
+        client->ssl->stop();
+        event       = true;
         client->tcp = NULL;
     }
 #endif
@@ -561,10 +746,16 @@ void WebSocketsClient::clientDisconnect(WSclient_t * client) {
     client->cCode        = 0;
     client->cKey         = "";
     client->cAccept      = "";
+    client->cExtensions  = "";
     client->cVersion     = 0;
     client->cIsUpgrade   = false;
     client->cIsWebsocket = false;
     client->cSessionId   = "";
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    client->cIsDeflate = false;
+#endif
+    freeCoalesced(client);
+    freeReassembly(client);
 
     client->status      = WSC_NOT_CONNECTED;
     _lastConnectionFail = millis();
@@ -696,9 +887,17 @@ void WebSocketsClient::sendHeader(WSclient_t * client) {
             handshake += client->cProtocol + NEW_LINE;
         }
 
-        if(client->cExtensions.length() > 0) {
+        String extensions = client->cExtensions;
+#ifdef WEBSOCKETS_HAS_DEFLATE
+        if(_deflate) {
+            // cExtensions is filled with the response of the server
+            extensions = deflateOffer();
+        }
+#endif
+
+        if(extensions.length() > 0) {
             handshake += WEBSOCKETS_STRING("Sec-WebSocket-Extensions: ");
-            handshake += client->cExtensions + NEW_LINE;
+            handshake += extensions + NEW_LINE;
         }
     } else {
         handshake += WEBSOCKETS_STRING("Connection: keep-alive\r\n");
@@ -866,10 +1065,26 @@ void WebSocketsClient::handleHeader(WSclient_t * client, String * headerLine) {
             }
         }
 
+#ifdef WEBSOCKETS_HAS_DEFLATE
+        if(ok && _deflate) {
+            ok = deflateAccept(client, _deflateConfig);
+            if(!ok) {
+                DEBUG_WEBSOCKETS("[WS-Client][handleHeader] Sec-WebSocket-Extensions not valid\n");
+            }
+        }
+#endif
+
         if(ok) {
             DEBUG_WEBSOCKETS("[WS-Client][handleHeader] Websocket connection init done.\n");
             headerDone(client);
 
+            _connectTiming.upgrade = (micros() - _phaseStart);
+            _connectTiming.total   = (micros() - _connectStart);
+
+            // the next reconnect starts with the shortest wait again
+            _reconnectAttempts = 0;
+            _reconnectDelay    = reconnectDelay();
+
             runCbEvent(WStype_CONNECTED, (uint8_t *)client->cUrl.c_str(), client->cUrl.length());
 #if(WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
         } else if(client->isSocketIO) {
@@ -899,6 +1114,11 @@ void WebSocketsClient::handleHeader(WSclient_t * client, String * headerLine) {
 void WebSocketsClient::connectedCb() {
     DEBUG_WEBSOCKETS("[WS-Client] connected to %s:%u.\n", _host.c_str(), _port);
 
+#ifdef WEBSOCKETS_METRICS
+    _client.metrics   = WSmetrics_t();
+    _client.mPingOpen = false;
+#endif
+
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
     _client.tcp->onDisconnect(std::bind([](WebSocketsClient * c, AsyncTCPbuffer * obj, WSclient_t * client) -> bool {
         DEBUG_WEBSOCKETS("[WS-Server][%d] Disconnect client\n", client->num);
@@ -920,7 +1140,7 @@ void WebSocketsClient::connectedCb() {
     _client.tcp->setTimeout(WEBSOCKETS_TCP_TIMEOUT);
 #endif
 
-#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_RP2040)
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_RP2040) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_POSIX)
     _client.tcp->setNoDelay(true);
 #endif
 
@@ -943,6 +1163,7 @@ void WebSocketsClient::connectedCb() {
 #endif
 
     // send Header to Server
+    _phaseStart = micros();
     sendHeader(&_client);
 }
 
@@ -950,6 +1171,129 @@ void WebSocketsClient::connectFailedCb() {
     DEBUG_WEBSOCKETS("[WS-Client] connection to %s:%u Failed\n", _host.c_str(), _port);
 }
 
+#ifdef WEBSOCKETS_HAS_ASYNC_CONNECT
+/**
+ * resolve the host and start a non-blocking TCP connect, handleConnect() checks it in loop()
+ * only the connect does not block: the name lookup (getaddrinfo) does,
+ * an IP address or a cached name returns at once, else it can take some seconds
+ * @return true if the connect is in progress
+ */
+bool WebSocketsClient::startConnect(void) {
+    struct addrinfo hints;
+    struct addrinfo * res = NULL;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;    // IPv4 or IPv6, the first address is used
+    hints.ai_socktype = SOCK_STREAM;
+
+    _phaseStart        = micros();
+    int err            = getaddrinfo(_host.c_str(), NULL, &hints, &res);
+    _connectTiming.dns = (micros() - _phaseStart);
+
+    if(err != 0 || !res) {
+        DEBUG_WEBSOCKETS("[WS-Client] DNS lookup of %s failed (%d)\n", _host.c_str(), err);
+        if(res) {
+            freeaddrinfo(res);
+        }
+        return false;
+    }
+
+    struct sockaddr_storage addr;
+    socklen_t addrSize = res->ai_addrlen;
+    int family         = res->ai_family;
+    memset(&addr, 0, sizeof(addr));
+    memcpy(&addr, res->ai_addr, std::min((size_t)addrSize, sizeof(addr)));
+    freeaddrinfo(res);
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_POSIX) || LWIP_IPV6
+    if(family == AF_INET6) {
+        ((struct sockaddr_in6 *)&addr)->sin6_port = htons(_port);
+    } else
+#endif
+    {
+        ((struct sockaddr_in *)&addr)->sin_port = htons(_port);
+    }
+
+    int fd = socket(family, SOCK_STREAM, IPPROTO_TCP);
+    if(fd < 0) {
+        DEBUG_WEBSOCKETS("[WS-Client] socket failed (%d)\n", errno);
+        return false;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    _phaseStart = micros();
+    if(connect(fd, (struct sockaddr *)&addr, addrSize) < 0 && errno != EINPROGRESS) {
+        DEBUG_WEBSOCKETS("[WS-Client] connect failed (%d)\n", errno);
+        close(fd);
+        return false;
+    }
+
+    DEBUG_WEBSOCKETS("[WS-Client] connecting to %s:%u...\n", _host.c_str(), _port);
+    _connectFd = fd;
+    return true;
+}
+
+/**
+ * check the TCP connect started by startConnect() without waiting,
+ * gives up after WEBSOCKETS_TCP_TIMEOUT
+ */
+void WebSocketsClient::handleConnect(void) {
+    fd_set fdset;
+    struct timeval tv = { 0, 0 };
+
+    FD_ZERO(&fdset);
+    FD_SET(_connectFd, &fdset);
+
+    int ret = select(_connectFd + 1, NULL, &fdset, NULL, &tv);
+    if(ret == 0) {
+        if((micros() - _phaseStart) > (WEBSOCKETS_TCP_TIMEOUT * 1000UL)) {
+            DEBUG_WEBSOCKETS("[WS-Client] connect timeout!\n");
+            stopConnect();
+            connectFailedCb();
+            _lastConnectionFail = millis();
+        }
+        return;
+    }
+
+    int err           = 0;
+    socklen_t errSize = sizeof(err);
+    if(ret < 0 || getsockopt(_connectFd, SOL_SOCKET, SO_ERROR, &err, &errSize) < 0 || err != 0) {
+        DEBUG_WEBSOCKETS("[WS-Client] connect failed (%d)\n", err);
+        stopConnect();
+        connectFailedCb();
+        _lastConnectionFail = millis();
+        return;
+    }
+
+    _connectTiming.connect = (micros() - _phaseStart);
+
+    // the network class gets the socket in blocking mode with the options of its own connect:
+    // no delay, keep alive and send / receive timeouts
+    int enable        = 1;
+    struct timeval to = { WEBSOCKETS_TCP_TIMEOUT / 1000, (WEBSOCKETS_TCP_TIMEOUT % 1000) * 1000 };
+    setsockopt(_connectFd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    setsockopt(_connectFd, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+    setsockopt(_connectFd, SOL_SOCKET, SO_RCVTIMEO, &to, sizeof(to));
+    setsockopt(_connectFd, SOL_SOCKET, SO_SNDTIMEO, &to, sizeof(to));
+    fcntl(_connectFd, F_SETFL, fcntl(_connectFd, F_GETFL, 0) & (~O_NONBLOCK));
+    _client.tcp = new WEBSOCKETS_NETWORK_CLASS(_connectFd);
+    _connectFd  = -1;
+
+    connectedCb();
+    _lastConnectionFail = 0;
+}
+
+/**
+ * abort a connect in progress
+ */
+void WebSocketsClient::stopConnect(void) {
+    if(_connectFd >= 0) {
+        close(_connectFd);
+        _connectFd = -1;
+    }
+}
+#endif
+
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
 
 void WebSocketsClient::asyncConnect() {
@@ -1000,10 +1344,9 @@ void WebSocketsClient::asyncConnect() {
 void WebSocketsClient::handleHBPing() {
     if(_client.pingInterval == 0)
         return;
-    uint32_t pi = millis() - _client.lastPing;
-    if(pi > _client.pingInterval) {
+    if(heartbeatDue(&_client)) {
         DEBUG_WEBSOCKETS("[WS-Client] sending HB ping\n");
-        if(sendPing()) {
+        if(sendHeartbeatPing(&_client)) {
             _client.lastPing     = millis();
             _client.pongReceived = false;
         } else {
@@ -1023,9 +1366,129 @@ void WebSocketsClient::enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeo
     WebSockets::enableHeartbeat(&_client, pingInterval, pongTimeout, disconnectTimeoutCount);
 }
 
+/**
+ * enable ping/pong heartbeat process which adapts to the link (see WebSocketsServerCore::enableAdaptiveHeartbeat)
+ * @param pingInterval uint32_t shortest ping interval in ms
+ * @param maxPingInterval uint32_t longest ping interval in ms
+ * @param pongTimeout uint32_t max millis after which pong should timout if not received
+ * @param disconnectTimeoutCount uint8_t how many timeouts before disconnect, 0=> do not disconnect
+ */
+void WebSocketsClient::enableAdaptiveHeartbeat(uint32_t pingInterval, uint32_t maxPingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount) {
+    WebSockets::enableHeartbeat(&_client, pingInterval, pongTimeout, disconnectTimeoutCount, maxPingInterval);
+}
+
+/**
+ * round trip time and current interval / timeout of the heartbeat
+ * @return const WSheartbeat_t &
+ */
+const WSheartbeat_t & WebSocketsClient::getHeartbeat(void) {
+    return _client.hb;
+}
+
 /**
  * disable ping/pong heartbeat process
  */
 void WebSocketsClient::disableHeartbeat() {
     _client.pingInterval = 0;
 }
+
+/**
+ * deliver data frames bigger then chunkSize in parts as WStype_STREAM event,
+ * the payload of the event is a WSstreamChunk_t * (offset / total of the frame)
+ * this allows receiving frames bigger then WEBSOCKETS_MAX_DATA_SIZE with a fixed buffer
+ * @param chunkSize size_t  max bytes per event
+ */
+void WebSocketsClient::enableStreaming(size_t chunkSize) {
+    _client.cStreamChunkSize = chunkSize;
+}
+
+/**
+ * disable streaming receive, data frames are delivered in one piece
+ */
+void WebSocketsClient::disableStreaming(void) {
+    _client.cStreamChunkSize = 0;
+}
+
+/**
+ * collect the frames of fragmented messages and deliver each message once,
+ * the frame buffers are kept in a list, they are not copied into one growing buffer
+ *  - WStype_MESSAGE, the payload of the event is a WSmessage_t * (list of the frame payloads)
+ *  - WStype_TEXT / WStype_BIN if contiguous is set or the message has only one part
+ * fragmented compressed messages are received too, they are delivered as WStype_TEXT / WStype_BIN
+ * frames of these messages are not streamed (enableStreaming)
+ * @param maxSize size_t  bigger messages close the connection with 1009
+ * @param contiguous bool  join the parts into one buffer
+ */
+void WebSocketsClient::enableReassembly(size_t maxSize, bool contiguous) {
+    freeReassembly(&_client);
+    _client.cRaMaxSize    = maxSize;
+    _client.cRaContiguous = contiguous;
+}
+
+/**
+ * deliver the frames of fragmented messages as WStype_FRAGMENT_* events
+ */
+void WebSocketsClient::disableReassembly(void) {
+    enableReassembly(0, false);
+}
+
+/**
+ * validate received text messages (UTF-8), invalid text closes the connection with 1007
+ */
+void WebSocketsClient::enableUtf8Validation(void) {
+    _client.cValidateUtf8 = true;
+}
+
+/**
+ * deliver received text without validation
+ */
+void WebSocketsClient::disableUtf8Validation(void) {
+    _client.cValidateUtf8 = false;
+}
+
+#if(WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
+/**
+ * collect small data frames and write them together, like Nagle for WebSocket frames
+ * control frames and frames bigger then maxSize are written at once (after the collected ones)
+ * @param maxDelay uint16_t  max ms a frame waits, written in loop()
+ * @param maxSize size_t  bytes written at once
+ */
+void WebSocketsClient::enableCoalescing(uint16_t maxDelay, size_t maxSize) {
+    flushCoalesced(&_client);
+    freeCoalesced(&_client);
+    _client.cTxSize  = maxSize;
+    _client.cTxDelay = maxDelay;
+}
+
+/**
+ * write every frame at once
+ */
+void WebSocketsClient::disableCoalescing(void) {
+    enableCoalescing(0, 0);
+}
+#endif
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+/**
+ * offer permessage-deflate (RFC 7692) on the next connect
+ * @param config WSdeflateConfig_t  compression settings
+ */
+void WebSocketsClient::enableDeflate(const WSdeflateConfig_t & config) {
+    _deflate       = true;
+    _deflateConfig = config;
+}
+
+/**
+ * do not offer permessage-deflate on the next connect
+ */
+void WebSocketsClient::disableDeflate(void) {
+    _deflate = false;
+}
+
+/**
+ * @return true if permessage-deflate is used on the connection
+ */
+bool WebSocketsClient::isDeflate(void) {
+    return isConnected() && _client.cIsDeflate;
+}
+#endif
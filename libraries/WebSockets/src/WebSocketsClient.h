@@ -107,12 +107,46 @@ class WebSocketsClient : protected WebSockets {
     void setExtraHeaders(const char * extraHeaders = NULL);
 
     void setReconnectInterval(unsigned long time);
+    void setReconnectBackoff(unsigned long maxInterval, uint8_t jitter = 50);
 
     void enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount);
+    void enableAdaptiveHeartbeat(uint32_t pingInterval, uint32_t maxPingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount);
     void disableHeartbeat();
+    const WSheartbeat_t & getHeartbeat(void);
+
+    void enableStreaming(size_t chunkSize = WEBSOCKETS_STREAM_CHUNK_SIZE);
+    void disableStreaming(void);
+
+    void enableReassembly(size_t maxSize = WEBSOCKETS_REASSEMBLY_SIZE, bool contiguous = false);
+    void disableReassembly(void);
+
+    void enableUtf8Validation(void);
+    void disableUtf8Validation(void);
+
+#if(WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
+    void enableCoalescing(uint16_t maxDelay = WEBSOCKETS_COALESCE_DELAY, size_t maxSize = WEBSOCKETS_COALESCE_SIZE);
+    void disableCoalescing(void);
+#endif
+
+    // receive buffer pool (see WebSockets.cpp)
+    using WebSockets::adoptPayload;
+    using WebSockets::releasePayload;
+    using WebSockets::setBufferPoolSize;
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    void enableDeflate(const WSdeflateConfig_t & config = WSdeflateConfig_t());
+    void disableDeflate(void);
+    bool isDeflate(void);
+#endif
 
     bool isConnected(void);
 
+    const WSconnectTiming_t & getConnectTiming(void);
+
+#ifdef WEBSOCKETS_METRICS
+    const WSmetrics_t & getMetrics(void);
+#endif
+
   protected:
     String _host;
     uint16_t _port;
@@ -154,7 +188,32 @@ class WebSocketsClient : protected WebSockets {
     unsigned long _reconnectInterval;
     unsigned long _lastHeaderSent;
 
+    unsigned long _reconnectMaxInterval;    ///< backoff limit (0 = fixed interval)
+    unsigned long _reconnectDelay;          ///< wait before the next attempt
+    uint8_t _reconnectJitter;               ///< % of the wait that is random
+    uint8_t _reconnectAttempts;             ///< attempts since the last connection was up
+
+#if defined(SSL_BARESSL)
+    BearSSL::Session _tlsSession;    ///< filled by the secure client, offered on reconnect
+    bool _tlsSessionValid;
+#endif
+
+    WSconnectTiming_t _connectTiming;
+    unsigned long _connectStart;    ///< micros at the start of the attempt
+    unsigned long _phaseStart;      ///< micros at the start of the current phase
+
+#ifdef WEBSOCKETS_HAS_ASYNC_CONNECT
+    int _connectFd;    ///< socket of a connect in progress (-1 = none)
+#endif
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    bool _deflate;
+    WSdeflateConfig_t _deflateConfig;
+#endif
+
     void messageReceived(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, bool fin);
+    void streamReceived(WSclient_t * client, WSstreamChunk_t * chunk);
+    void messageReassembled(WSclient_t * client, WSmessage_t * message);
 
     void clientDisconnect(WSclient_t * client);
     bool clientIsConnected(WSclient_t * client);
@@ -169,6 +228,16 @@ class WebSocketsClient : protected WebSockets {
     void connectedCb();
     void connectFailedCb();
 
+    unsigned long reconnectDelay(void);
+
+#ifdef WEBSOCKETS_HAS_ASYNC_CONNECT
+    bool startConnect(void);
+    void handleConnect(void);
+    void stopConnect(void);
+#endif
+
+    void freeSecureClient(void);
+
     void handleHBPing();    // send ping in specified intervals
 
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
@@ -40,6 +40,23 @@ WebSocketsServerCore::WebSocketsServerCore(const String & origin, const String &
     _pingInterval           = 0;
     _pongTimeout            = 0;
     _disconnectTimeoutCount = 0;
+    _maxPingInterval        = 0;
+    _streamChunkSize        = 0;
+    _reassemblySize         = 0;
+    _reassemblyContiguous   = false;
+    _validateUtf8           = false;
+    _coalesceDelay          = 0;
+    _coalesceSize           = 0;
+
+#if(WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
+    _httpLineLength = 0;
+    _httpLineOwner  = WEBSOCKETS_SERVER_CLIENT_MAX;
+    _httpLineStart  = 0;
+#endif
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    _deflate = false;
+#endif
 
     _cbEvent = NULL;
 
@@ -411,6 +428,20 @@ bool WebSocketsServerCore::clientIsConnected(uint8_t num) {
     return clientIsConnected(client);
 }
 
+#ifdef WEBSOCKETS_METRICS
+/**
+ * counters of the connection of a client, they are cleared when a new client gets the number
+ * @param num uint8_t client id
+ * @return const WSmetrics_t *  NULL if num is invalid
+ */
+const WSmetrics_t * WebSocketsServerCore::getMetrics(uint8_t num) {
+    if(num >= WEBSOCKETS_SERVER_CLIENT_MAX) {
+        return NULL;
+    }
+    return &_clients[num].metrics;
+}
+#endif
+
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_RP2040)
 /**
  * get an IP for a client
@@ -458,12 +489,19 @@ WSclient_t * WebSocketsServerCore::newClient(WEBSOCKETS_NETWORK_CLASS * TCPclien
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32)
             client->isSSL = false;
             client->tcp->setNoDelay(true);
+#elif(WEBSOCKETS_NETWORK_TYPE == NETWORK_POSIX)
+            client->tcp->setNoDelay(true);
 #endif
 #if(WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
             // set Timeout for readBytesUntil and readStringUntil
             client->tcp->setTimeout(WEBSOCKETS_TCP_TIMEOUT);
 #endif
-            client->status = WSC_HEADER;
+            client->status        = WSC_HEADER;
+            client->cHttpHeadSize = 0;
+#ifdef WEBSOCKETS_METRICS
+            client->metrics   = WSmetrics_t();
+            client->mPingOpen = false;
+#endif
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_RP2040)
 #ifndef NODEBUG_WEBSOCKETS
             IPAddress ip = client->tcp->remoteIP();
@@ -492,8 +530,16 @@ WSclient_t * WebSocketsServerCore::newClient(WEBSOCKETS_NETWORK_CLASS * TCPclien
             client->pingInterval           = _pingInterval;
             client->pongTimeout            = _pongTimeout;
             client->disconnectTimeoutCount = _disconnectTimeoutCount;
+            client->maxPingInterval        = _maxPingInterval;
             client->lastPing               = millis();
             client->pongReceived           = false;
+            client->cStreamChunkSize       = _streamChunkSize;
+            client->cStreamOffset          = 0;
+            client->cRaMaxSize             = _reassemblySize;
+            client->cRaContiguous          = _reassemblyContiguous;
+            client->cValidateUtf8          = _validateUtf8;
+            client->cTxSize                = _coalesceSize;
+            client->cTxDelay               = _coalesceDelay;
 
             return client;
             break;
@@ -536,6 +582,24 @@ void WebSocketsServerCore::messageReceived(WSclient_t * client, WSopcode_t opcod
     runCbEvent(client->num, type, payload, length);
 }
 
+/**
+ * called for every chunk of a streamed data frame
+ * @param client WSclient_t *  ptr to the client struct
+ * @param chunk WSstreamChunk_t *
+ */
+void WebSocketsServerCore::streamReceived(WSclient_t * client, WSstreamChunk_t * chunk) {
+    runCbEvent(client->num, WStype_STREAM, (uint8_t *)chunk, chunk->length);
+}
+
+/**
+ * called for a reassembled fragmented message
+ * @param client WSclient_t *  ptr to the client struct
+ * @param message WSmessage_t *
+ */
+void WebSocketsServerCore::messageReassembled(WSclient_t * client, WSmessage_t * message) {
+    runCbEvent(client->num, WStype_MESSAGE, (uint8_t *)message, message->length);
+}
+
 /**
  * Discard a native client
  * @param client WSclient_t *  ptr to the client struct contaning the native client "->tcp"
@@ -584,14 +648,26 @@ void WebSocketsServerCore::clientDisconnect(WSclient_t * client) {
     client->cUrl         = "";
     client->cKey         = "";
     client->cProtocol    = "";
+    client->cExtensions  = "";
     client->cVersion     = 0;
     client->cIsUpgrade   = false;
     client->cIsWebsocket = false;
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    client->cIsDeflate = false;
+#endif
 
     client->cWsRXsize = 0;
+    freeCoalesced(client);
+    freeReassembly(client);
 
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
     client->cHttpLine = "";
+#else
+    // the line of the client is dropped, the others can go on
+    if(_httpLineOwner == client->num) {
+        _httpLineLength = 0;
+        _httpLineOwner  = WEBSOCKETS_SERVER_CLIENT_MAX;
+    }
 #endif
 
     client->status = WSC_NOT_CONNECTED;
@@ -666,7 +742,7 @@ WSclient_t * WebSocketsServerCore::handleNewClient(WEBSOCKETS_NETWORK_CLASS * tc
  * Handle incoming Connection Request
  */
 void WebSocketsServer::handleNewClients(void) {
-#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_RP2040)
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_RP2040) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_POSIX)
     while(_server->hasClient()) {
 #endif
 
@@ -684,7 +760,7 @@ void WebSocketsServer::handleNewClients(void) {
 
         handleNewClient(tcpClient);
 
-#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_RP2040)
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_RP2040) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_POSIX)
     }
 #endif
 }
@@ -701,10 +777,9 @@ void WebSocketsServerCore::handleClientData(void) {
             if(len > 0) {
                 // DEBUG_WEBSOCKETS("[WS-Server][%d][handleClientData] len: %d\n", client->num, len);
                 switch(client->status) {
-                    case WSC_HEADER: {
-                        String headerLine = client->tcp->readStringUntil('\n');
-                        handleHeader(client, &headerLine);
-                    } break;
+                    case WSC_HEADER:
+                        handleHeaderData(client);
+                        break;
                     case WSC_CONNECTED:
                         WebSockets::handleWebsocket(client);
                         break;
@@ -717,6 +792,7 @@ void WebSocketsServerCore::handleClientData(void) {
 
             handleHBPing(client);
             handleHBTimeout(client);
+            handleCoalesceTimeout(client);
         }
         WEBSOCKETS_YIELD();
     }
@@ -740,156 +816,368 @@ bool WebSocketsServerCore::hasMandatoryHeader(String headerName) {
  * @param client WSclient_t * ///< pointer to the client struct
  * @param headerLine String ///< the header being read / processed
  */
-void WebSocketsServerCore::handleHeader(WSclient_t * client, String * headerLine) {
-    static const char * NEW_LINE = "\r\n";
-
-    headerLine->trim();    // remove \r
+#if(WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
+/**
+ * read the HTTP request head line by line without blocking
+ * the head is read byte by byte: the bytes after it belong to the WebSocket frames,
+ * they have to stay in the socket (the client reads from the TCP buffer, no extra copy)
+ * @param client WSclient_t *  ptr to the client struct
+ */
+void WebSocketsServerCore::handleHeaderData(WSclient_t * client) {
+    // an other client is in the middle of a line, it gets WEBSOCKETS_TCP_TIMEOUT to end it
+    if(_httpLineOwner != client->num && _httpLineOwner < WEBSOCKETS_SERVER_CLIENT_MAX) {
+        if((millis() - _httpLineStart) < WEBSOCKETS_TCP_TIMEOUT) {
+            return;
+        }
+        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeaderData] header line timeout close.\n", _httpLineOwner);
+        clientDisconnect(&_clients[_httpLineOwner]);
+    }
 
-    if(headerLine->length() > 0) {
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] RX: %s\n", client->num, headerLine->c_str());
+    while(client->status == WSC_HEADER && client->tcp->available() > 0) {
+        int c = client->tcp->read();
+        if(c < 0) {
+            break;
+        }
 
-        // websocket requests always start with GET see rfc6455
-        if(headerLine->startsWith("GET ")) {
-            // cut URL out
-            client->cUrl = headerLine->substring(4, headerLine->indexOf(' ', 4));
+        if(++client->cHttpHeadSize > WEBSOCKETS_MAX_HTTP_HEAD_SIZE) {
+            handleHeaderTooLarge(client);
+            return;
+        }
 
-            // reset non-websocket http header validation state for this client
-            client->cHttpHeadersValid      = true;
-            client->cMandatoryHeadersCount = 0;
+        if(c != '\n') {
+            if(_httpLineLength == 0) {
+                _httpLineOwner = client->num;
+                _httpLineStart = millis();
+            }
+            if(_httpLineLength < sizeof(_httpLine)) {
+                _httpLine[_httpLineLength] = c;
+            }
+            _httpLineLength++;
+            continue;
+        }
 
-        } else if(headerLine->indexOf(':') >= 0) {
-            String headerName  = headerLine->substring(0, headerLine->indexOf(':'));
-            String headerValue = headerLine->substring(headerLine->indexOf(':') + 1);
+        bool truncated = (_httpLineLength >= sizeof(_httpLine));
+        size_t length  = truncated ? (sizeof(_httpLine) - 1) : _httpLineLength;
+        char * line    = &_httpLine[0];
 
-            // remove space in the beginning (RFC2616)
-            if(headerValue[0] == ' ') {
-                headerValue.remove(0, 1);
-            }
+        // the line is handled now, the buffer is free for the other clients
+        _httpLineLength = 0;
+        _httpLineOwner  = WEBSOCKETS_SERVER_CLIENT_MAX;
 
-            if(headerName.equalsIgnoreCase(WEBSOCKETS_STRING("Connection"))) {
-                headerValue.toLowerCase();
-                if(headerValue.indexOf(WEBSOCKETS_STRING("upgrade")) >= 0) {
-                    client->cIsUpgrade = true;
-                }
-            } else if(headerName.equalsIgnoreCase(WEBSOCKETS_STRING("Upgrade"))) {
-                if(headerValue.equalsIgnoreCase(WEBSOCKETS_STRING("websocket"))) {
-                    client->cIsWebsocket = true;
-                }
-            } else if(headerName.equalsIgnoreCase(WEBSOCKETS_STRING("Sec-WebSocket-Version"))) {
-                client->cVersion = headerValue.toInt();
-            } else if(headerName.equalsIgnoreCase(WEBSOCKETS_STRING("Sec-WebSocket-Key"))) {
-                client->cKey = headerValue;
-                client->cKey.trim();    // see rfc6455
-            } else if(headerName.equalsIgnoreCase(WEBSOCKETS_STRING("Sec-WebSocket-Protocol"))) {
-                client->cProtocol = headerValue;
-            } else if(headerName.equalsIgnoreCase(WEBSOCKETS_STRING("Sec-WebSocket-Extensions"))) {
-                client->cExtensions = headerValue;
-            } else if(headerName.equalsIgnoreCase(WEBSOCKETS_STRING("Authorization"))) {
-                client->base64Authorization = headerValue;
-            } else {
-                client->cHttpHeadersValid &= execHttpHeaderValidation(headerName, headerValue);
-                if(_mandatoryHttpHeaderCount > 0 && hasMandatoryHeader(headerName)) {
-                    client->cMandatoryHeadersCount++;
-                }
-            }
+        // remove \r and spaces
+        while(length > 0 && isspace((unsigned char)line[length - 1])) {
+            length--;
+        }
+        while(length > 0 && isspace((unsigned char)line[0])) {
+            line++;
+            length--;
+        }
+        line[length] = 0;
 
+        if(length > 0) {
+            handleHeaderLine(client, line, length, truncated);
         } else {
-            DEBUG_WEBSOCKETS("[WS-Client][handleHeader] Header error (%s)\n", headerLine->c_str());
+            handleHeaderEnd(client);
         }
+    }
+}
+#endif
+
+void WebSocketsServerCore::handleHeader(WSclient_t * client, String * headerLine) {
+    headerLine->trim();    // remove \r
+
+    if(headerLine->length() > 0) {
+        // handled in the String, the line buffer can hold the line of an other client
+        handleHeaderLine(client, &(*headerLine)[0], headerLine->length(), false);
 
         (*headerLine) = "";
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
-        client->tcp->readStringUntil('\n', &(client->cHttpLine), std::bind(&WebSocketsServerCore::handleHeader, this, client, &(client->cHttpLine)));
+        if(client->status == WSC_HEADER) {
+            client->tcp->readStringUntil('\n', &(client->cHttpLine), std::bind(&WebSocketsServerCore::handleHeader, this, client, &(client->cHttpLine)));
+        }
 #endif
     } else {
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] Header read fin.\n", client->num);
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cURL: %s\n", client->num, client->cUrl.c_str());
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cIsUpgrade: %d\n", client->num, client->cIsUpgrade);
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cIsWebsocket: %d\n", client->num, client->cIsWebsocket);
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cKey: %s\n", client->num, client->cKey.c_str());
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cProtocol: %s\n", client->num, client->cProtocol.c_str());
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cExtensions: %s\n", client->num, client->cExtensions.c_str());
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cVersion: %d\n", client->num, client->cVersion);
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - base64Authorization: %s\n", client->num, client->base64Authorization.c_str());
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cHttpHeadersValid: %d\n", client->num, client->cHttpHeadersValid);
-        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cMandatoryHeadersCount: %d\n", client->num, client->cMandatoryHeadersCount);
-
-        bool ok = (client->cIsUpgrade && client->cIsWebsocket);
-
-        if(ok) {
-            if(client->cUrl.length() == 0) {
-                ok = false;
-            }
-            if(client->cKey.length() == 0) {
-                ok = false;
+        handleHeaderEnd(client);
+    }
+}
+
+// the known names and tokens are in flash with WEBSOCKETS_SAVE_RAM (see WEBSOCKETS_STRING)
+#ifdef WEBSOCKETS_SAVE_RAM
+typedef const __FlashStringHelper * WSheaderString_t;
+#define WS_STRLEN(s) strlen_P((PGM_P)(s))
+#define WS_STRNCMP(a, s, n) strncmp_P(a, (PGM_P)(s), n)
+#define WS_STRNCASECMP(a, s, n) strncasecmp_P(a, (PGM_P)(s), n)
+#else
+typedef const char * WSheaderString_t;
+#define WS_STRLEN(s) strlen(s)
+#define WS_STRNCMP(a, s, n) strncmp(a, s, n)
+#define WS_STRNCASECMP(a, s, n) strncasecmp(a, s, n)
+#endif
+
+/**
+ * compare a header name or value (case insensitive)
+ * @param name const char *  header name, length given by nameLength
+ * @param nameLength size_t
+ * @param known WSheaderString_t  known name (WEBSOCKETS_STRING)
+ * @return true if equal
+ */
+static bool headerNameIs(const char * name, size_t nameLength, WSheaderString_t known) {
+    return (WS_STRLEN(known) == nameLength) && (WS_STRNCASECMP(name, known, nameLength) == 0);
+}
+
+/**
+ * search a token in a header value (case insensitive)
+ * @param value const char *
+ * @param token WSheaderString_t  token (WEBSOCKETS_STRING)
+ * @return true if found
+ */
+static bool headerValueContains(const char * value, WSheaderString_t token) {
+    size_t tokenLength = WS_STRLEN(token);
+    for(; *value; value++) {
+        if(WS_STRNCASECMP(value, token, tokenLength) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// headers of the upgrade
+enum {
+    WS_HEADER_CONNECTION,
+    WS_HEADER_UPGRADE,
+    WS_HEADER_VERSION,
+    WS_HEADER_KEY,
+    WS_HEADER_PROTOCOL,
+    WS_HEADER_EXTENSIONS,
+    WS_HEADER_AUTHORIZATION,
+    WS_HEADER_OTHER
+};
+
+static uint8_t headerKind(const char * name, size_t nameLength) {
+    if(headerNameIs(name, nameLength, WEBSOCKETS_STRING("Connection"))) {
+        return WS_HEADER_CONNECTION;
+    } else if(headerNameIs(name, nameLength, WEBSOCKETS_STRING("Upgrade"))) {
+        return WS_HEADER_UPGRADE;
+    } else if(headerNameIs(name, nameLength, WEBSOCKETS_STRING("Sec-WebSocket-Version"))) {
+        return WS_HEADER_VERSION;
+    } else if(headerNameIs(name, nameLength, WEBSOCKETS_STRING("Sec-WebSocket-Key"))) {
+        return WS_HEADER_KEY;
+    } else if(headerNameIs(name, nameLength, WEBSOCKETS_STRING("Sec-WebSocket-Protocol"))) {
+        return WS_HEADER_PROTOCOL;
+    } else if(headerNameIs(name, nameLength, WEBSOCKETS_STRING("Sec-WebSocket-Extensions"))) {
+        return WS_HEADER_EXTENSIONS;
+    } else if(headerNameIs(name, nameLength, WEBSOCKETS_STRING("Authorization"))) {
+        return WS_HEADER_AUTHORIZATION;
+    }
+    return WS_HEADER_OTHER;
+}
+
+/**
+ * handle one line of the HTTP request head
+ * only the headers needed for the upgrade are stored, the line is not copied
+ * @param client WSclient_t *  ptr to the client struct
+ * @param line char *  trimmed line (null terminated, will be modified)
+ * @param length size_t  of the line, the name and the value are found by it
+ * @param truncated bool  line did not fit into the line buffer, rejected with 431 if the server needs it
+ */
+void WebSocketsServerCore::handleHeaderLine(WSclient_t * client, char * line, size_t length, bool truncated) {
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] RX: %s\n", client->num, line);
+
+    // websocket requests always start with GET see rfc6455
+    if(WS_STRNCMP(line, WEBSOCKETS_STRING("GET "), 4) == 0) {
+        if(truncated) {
+            handleHeaderTooLarge(client);
+            return;
+        }
+
+        // cut URL out
+        char * url = line + 4;
+        char * end = (char *)memchr(url, ' ', length - 4);
+        if(end) {
+            *end = 0;
+        }
+        client->cUrl = url;
+
+        // reset non-websocket http header validation state for this client
+        client->cHttpHeadersValid      = true;
+        client->cMandatoryHeadersCount = 0;
+        return;
+    }
+
+    char * value = (char *)memchr(line, ':', length);
+    if(!value) {
+        DEBUG_WEBSOCKETS("[WS-Client][handleHeader] Header error (%s)\n", line);
+        return;
+    }
+
+    size_t nameLength  = value - line;
+    *value++           = 0;
+    size_t valueLength = length - nameLength - 1;
+
+    // remove space in the beginning (RFC2616)
+    if(valueLength > 0 && *value == ' ') {
+        value++;
+        valueLength--;
+    }
+
+    uint8_t header = headerKind(line, nameLength);
+
+    if(truncated) {
+        // a cut value is never used, long unused lines (e.g. Cookie) are skipped
+        if(header != WS_HEADER_OTHER || _httpHeaderValidationFunc || _mandatoryHttpHeaderCount > 0) {
+            handleHeaderTooLarge(client);
+        }
+        return;
+    }
+
+    switch(header) {
+        case WS_HEADER_CONNECTION:
+            if(headerValueContains(value, WEBSOCKETS_STRING("upgrade"))) {
+                client->cIsUpgrade = true;
             }
-            if(client->cVersion != 13) {
-                ok = false;
+            break;
+        case WS_HEADER_UPGRADE:
+            if(headerNameIs(value, valueLength, WEBSOCKETS_STRING("websocket"))) {
+                client->cIsWebsocket = true;
             }
-            if(!client->cHttpHeadersValid) {
-                ok = false;
+            break;
+        case WS_HEADER_VERSION:
+            client->cVersion = atoi(value);
+            break;
+        case WS_HEADER_KEY:
+            // the line is trimmed, see rfc6455
+            client->cKey = value;
+            break;
+        case WS_HEADER_PROTOCOL:
+            client->cProtocol = value;
+            break;
+        case WS_HEADER_EXTENSIONS:
+            // the header can be send more then once
+            if(client->cExtensions.length() > 0) {
+                client->cExtensions += WEBSOCKETS_STRING(", ");
             }
-            if(client->cMandatoryHeadersCount != _mandatoryHttpHeaderCount) {
-                ok = false;
+            client->cExtensions += value;
+            break;
+        case WS_HEADER_AUTHORIZATION:
+            client->base64Authorization = value;
+            break;
+        default:
+            if(_httpHeaderValidationFunc || _mandatoryHttpHeaderCount > 0) {
+                String headerName  = line;
+                String headerValue = value;
+                client->cHttpHeadersValid &= execHttpHeaderValidation(headerName, headerValue);
+                if(_mandatoryHttpHeaderCount > 0 && hasMandatoryHeader(headerName)) {
+                    client->cMandatoryHeadersCount++;
+                }
             }
+            break;
+    }
+}
+
+/**
+ * the HTTP request head is complete, check it and send the handshake response
+ * @param client WSclient_t *  ptr to the client struct
+ */
+void WebSocketsServerCore::handleHeaderEnd(WSclient_t * client) {
+    static const char * NEW_LINE = "\r\n";
+
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] Header read fin.\n", client->num);
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cURL: %s\n", client->num, client->cUrl.c_str());
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cIsUpgrade: %d\n", client->num, client->cIsUpgrade);
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cIsWebsocket: %d\n", client->num, client->cIsWebsocket);
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cKey: %s\n", client->num, client->cKey.c_str());
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cProtocol: %s\n", client->num, client->cProtocol.c_str());
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cExtensions: %s\n", client->num, client->cExtensions.c_str());
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cVersion: %d\n", client->num, client->cVersion);
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - base64Authorization: %s\n", client->num, client->base64Authorization.c_str());
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cHttpHeadersValid: %d\n", client->num, client->cHttpHeadersValid);
+    DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - cMandatoryHeadersCount: %d\n", client->num, client->cMandatoryHeadersCount);
+
+    bool ok = (client->cIsUpgrade && client->cIsWebsocket);
+
+    if(ok) {
+        if(client->cUrl.length() == 0) {
+            ok = false;
+        }
+        if(client->cKey.length() == 0) {
+            ok = false;
+        }
+        if(client->cVersion != 13) {
+            ok = false;
         }
+        if(!client->cHttpHeadersValid) {
+            ok = false;
+        }
+        if(client->cMandatoryHeadersCount != _mandatoryHttpHeaderCount) {
+            ok = false;
+        }
+    }
 
-        if(_base64Authorization.length() > 0) {
-            String auth = WEBSOCKETS_STRING("Basic ");
-            auth += _base64Authorization;
-            if(auth != client->base64Authorization) {
-                DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] HTTP Authorization failed!\n", client->num);
-                handleAuthorizationFailed(client);
-                return;
-            }
+    if(_base64Authorization.length() > 0) {
+        String auth = WEBSOCKETS_STRING("Basic ");
+        auth += _base64Authorization;
+        if(auth != client->base64Authorization) {
+            DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] HTTP Authorization failed!\n", client->num);
+            handleAuthorizationFailed(client);
+            return;
         }
+    }
 
-        if(ok) {
-            DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] Websocket connection incoming.\n", client->num);
+    if(ok) {
+        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] Websocket connection incoming.\n", client->num);
 
-            // generate Sec-WebSocket-Accept key
-            String sKey = acceptKey(client->cKey);
+        // generate Sec-WebSocket-Accept key
+        String sKey = acceptKey(client->cKey);
 
-            DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - sKey: %s\n", client->num, sKey.c_str());
+        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader]  - sKey: %s\n", client->num, sKey.c_str());
 
-            client->status = WSC_CONNECTED;
+        client->status = WSC_CONNECTED;
 
-            String handshake = WEBSOCKETS_STRING(
-                "HTTP/1.1 101 Switching Protocols\r\n"
-                "Server: arduino-WebSocketsServer\r\n"
-                "Upgrade: websocket\r\n"
-                "Connection: Upgrade\r\n"
-                "Sec-WebSocket-Version: 13\r\n"
-                "Sec-WebSocket-Accept: ");
-            handshake += sKey + NEW_LINE;
+        String handshake;
+        handshake.reserve(256);
+        handshake = WEBSOCKETS_STRING(
+            "HTTP/1.1 101 Switching Protocols\r\n"
+            "Server: arduino-WebSocketsServer\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "Sec-WebSocket-Accept: ");
+        handshake += sKey + NEW_LINE;
 
-            if(_origin.length() > 0) {
-                handshake += WEBSOCKETS_STRING("Access-Control-Allow-Origin: ");
-                handshake += _origin + NEW_LINE;
-            }
+        if(_origin.length() > 0) {
+            handshake += WEBSOCKETS_STRING("Access-Control-Allow-Origin: ");
+            handshake += _origin + NEW_LINE;
+        }
 
-            if(client->cProtocol.length() > 0) {
-                handshake += WEBSOCKETS_STRING("Sec-WebSocket-Protocol: ");
-                handshake += _protocol + NEW_LINE;
-            }
+        if(client->cProtocol.length() > 0) {
+            handshake += WEBSOCKETS_STRING("Sec-WebSocket-Protocol: ");
+            handshake += _protocol + NEW_LINE;
+        }
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+        String extensions;
+        if(_deflate && deflateNegotiate(client, _deflateConfig, extensions)) {
+            handshake += WEBSOCKETS_STRING("Sec-WebSocket-Extensions: ");
+            handshake += extensions + NEW_LINE;
+        }
+#endif
 
-            // header end
-            handshake += NEW_LINE;
+        // header end
+        handshake += NEW_LINE;
 
-            DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] handshake %s", client->num, (uint8_t *)handshake.c_str());
+        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] handshake %s", client->num, (uint8_t *)handshake.c_str());
 
-            write(client, (uint8_t *)handshake.c_str(), handshake.length());
+        write(client, (uint8_t *)handshake.c_str(), handshake.length());
 
-            headerDone(client);
+        headerDone(client);
 
-            // send ping
-            WebSockets::sendFrame(client, WSop_ping);
+        // send ping
+        WebSockets::sendFrame(client, WSop_ping);
 
-            runCbEvent(client->num, WStype_CONNECTED, (uint8_t *)client->cUrl.c_str(), client->cUrl.length());
+        runCbEvent(client->num, WStype_CONNECTED, (uint8_t *)client->cUrl.c_str(), client->cUrl.length());
 
-        } else {
-            handleNonWebsocketConnection(client);
-        }
+    } else {
+        handleNonWebsocketConnection(client);
     }
 }
 
@@ -899,10 +1187,9 @@ void WebSocketsServerCore::handleHeader(WSclient_t * client, String * headerLine
 void WebSocketsServerCore::handleHBPing(WSclient_t * client) {
     if(client->pingInterval == 0)
         return;
-    uint32_t pi = millis() - client->lastPing;
-    if(pi > client->pingInterval) {
+    if(heartbeatDue(client)) {
         DEBUG_WEBSOCKETS("[WS-Server][%d] sending HB ping\n", client->num);
-        if(sendPing(client->num)) {
+        if(sendHeartbeatPing(client)) {
             client->lastPing     = millis();
             client->pongReceived = false;
         }
@@ -916,15 +1203,42 @@ void WebSocketsServerCore::handleHBPing(WSclient_t * client) {
  * @param disconnectTimeoutCount uint8_t how many timeouts before disconnect, 0=> do not disconnect
  */
 void WebSocketsServerCore::enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount) {
+    enableAdaptiveHeartbeat(pingInterval, 0, pongTimeout, disconnectTimeoutCount);
+}
+
+/**
+ * enable ping/pong heartbeat process which adapts to the link
+ *  - the round trip time is measured with every pong, the pong timeout follows it (WEBSOCKETS_HB_MIN_TIMEOUT ... pongTimeout)
+ *  - the interval doubles with every pong up to maxPingInterval, after a timeout it starts again at pingInterval
+ *  - no ping is send while frames are received from the client
+ * @param pingInterval uint32_t shortest ping interval in ms
+ * @param maxPingInterval uint32_t longest ping interval in ms
+ * @param pongTimeout uint32_t max millis after which pong should timout if not received
+ * @param disconnectTimeoutCount uint8_t how many timeouts before disconnect, 0=> do not disconnect
+ */
+void WebSocketsServerCore::enableAdaptiveHeartbeat(uint32_t pingInterval, uint32_t maxPingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount) {
     _pingInterval           = pingInterval;
     _pongTimeout            = pongTimeout;
     _disconnectTimeoutCount = disconnectTimeoutCount;
+    _maxPingInterval        = maxPingInterval;
 
     WSclient_t * client;
     for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
         client = &_clients[i];
-        WebSockets::enableHeartbeat(client, pingInterval, pongTimeout, disconnectTimeoutCount);
+        WebSockets::enableHeartbeat(client, pingInterval, pongTimeout, disconnectTimeoutCount, maxPingInterval);
+    }
+}
+
+/**
+ * round trip time and current interval / timeout of the heartbeat of a client
+ * @param num uint8_t client id
+ * @return const WSheartbeat_t *  NULL if num is invalid
+ */
+const WSheartbeat_t * WebSocketsServerCore::getHeartbeat(uint8_t num) {
+    if(num >= WEBSOCKETS_SERVER_CLIENT_MAX) {
+        return NULL;
     }
+    return &_clients[num].hb;
 }
 
 /**
@@ -940,6 +1254,140 @@ void WebSocketsServerCore::disableHeartbeat() {
     }
 }
 
+/**
+ * deliver data frames bigger then chunkSize in parts as WStype_STREAM event,
+ * the payload of the event is a WSstreamChunk_t * (offset / total of the frame)
+ * this allows receiving frames bigger then WEBSOCKETS_MAX_DATA_SIZE with a fixed buffer
+ * @param chunkSize size_t  max bytes per event
+ */
+void WebSocketsServerCore::enableStreaming(size_t chunkSize) {
+    _streamChunkSize = chunkSize;
+
+    WSclient_t * client;
+    for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+        client                   = &_clients[i];
+        client->cStreamChunkSize = chunkSize;
+    }
+}
+
+/**
+ * disable streaming receive, data frames are delivered in one piece
+ */
+void WebSocketsServerCore::disableStreaming(void) {
+    enableStreaming(0);
+}
+
+/**
+ * collect the frames of fragmented messages and deliver each message once,
+ * the frame buffers are kept in a list, they are not copied into one growing buffer
+ *  - WStype_MESSAGE, the payload of the event is a WSmessage_t * (list of the frame payloads)
+ *  - WStype_TEXT / WStype_BIN if contiguous is set or the message has only one part
+ * fragmented compressed messages are received too, they are delivered as WStype_TEXT / WStype_BIN
+ * frames of these messages are not streamed (enableStreaming)
+ * @param maxSize size_t  bigger messages close the connection with 1009
+ * @param contiguous bool  join the parts into one buffer
+ */
+void WebSocketsServerCore::enableReassembly(size_t maxSize, bool contiguous) {
+    _reassemblySize       = maxSize;
+    _reassemblyContiguous = contiguous;
+
+    WSclient_t * client;
+    for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+        client = &_clients[i];
+        freeReassembly(client);
+        client->cRaMaxSize    = maxSize;
+        client->cRaContiguous = contiguous;
+    }
+}
+
+/**
+ * deliver the frames of fragmented messages as WStype_FRAGMENT_* events
+ */
+void WebSocketsServerCore::disableReassembly(void) {
+    enableReassembly(0, false);
+}
+
+/**
+ * validate received text messages (UTF-8), invalid text closes the connection with 1007
+ */
+void WebSocketsServerCore::enableUtf8Validation(void) {
+    _validateUtf8 = true;
+
+    for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+        _clients[i].cValidateUtf8 = true;
+    }
+}
+
+/**
+ * deliver received text without validation
+ */
+void WebSocketsServerCore::disableUtf8Validation(void) {
+    _validateUtf8 = false;
+
+    for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+        _clients[i].cValidateUtf8 = false;
+    }
+}
+
+#if(WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
+/**
+ * collect small data frames and write them together, like Nagle for WebSocket frames
+ * control frames and frames bigger then maxSize are written at once (after the collected ones)
+ * @param maxDelay uint16_t  max ms a frame waits, written in loop()
+ * @param maxSize size_t  bytes written at once (one buffer of this size per client)
+ */
+void WebSocketsServerCore::enableCoalescing(uint16_t maxDelay, size_t maxSize) {
+    _coalesceDelay = maxDelay;
+    _coalesceSize  = maxSize;
+
+    WSclient_t * client;
+    for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+        client = &_clients[i];
+        flushCoalesced(client);
+        freeCoalesced(client);
+        client->cTxSize  = maxSize;
+        client->cTxDelay = maxDelay;
+    }
+}
+
+/**
+ * write every frame at once
+ */
+void WebSocketsServerCore::disableCoalescing(void) {
+    enableCoalescing(0, 0);
+}
+#endif
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+/**
+ * enable permessage-deflate (RFC 7692) for new connections, used if the client offers it
+ * @param config WSdeflateConfig_t  compression settings
+ */
+void WebSocketsServerCore::enableDeflate(const WSdeflateConfig_t & config) {
+    _deflate       = true;
+    _deflateConfig = config;
+}
+
+/**
+ * disable permessage-deflate for new connections
+ */
+void WebSocketsServerCore::disableDeflate(void) {
+    _deflate = false;
+}
+
+/**
+ * @param num uint8_t client id
+ * @return true if permessage-deflate is used by the client
+ */
+bool WebSocketsServerCore::isDeflate(uint8_t num) {
+    if(num >= WEBSOCKETS_SERVER_CLIENT_MAX) {
+        return false;
+    }
+    WSclient_t * client = &_clients[num];
+    return clientIsConnected(client) && client->cIsDeflate;
+}
+#endif
+
 ////////////////////
 // WebSocketServer
 
@@ -88,7 +88,38 @@ class WebSocketsServerCore : protected WebSockets {
     bool clientIsConnected(uint8_t num);
 
     void enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount);
+    void enableAdaptiveHeartbeat(uint32_t pingInterval, uint32_t maxPingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount);
     void disableHeartbeat();
+    const WSheartbeat_t * getHeartbeat(uint8_t num);
+
+    void enableStreaming(size_t chunkSize = WEBSOCKETS_STREAM_CHUNK_SIZE);
+    void disableStreaming(void);
+
+    void enableReassembly(size_t maxSize = WEBSOCKETS_REASSEMBLY_SIZE, bool contiguous = false);
+    void disableReassembly(void);
+
+    void enableUtf8Validation(void);
+    void disableUtf8Validation(void);
+
+#if(WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
+    void enableCoalescing(uint16_t maxDelay = WEBSOCKETS_COALESCE_DELAY, size_t maxSize = WEBSOCKETS_COALESCE_SIZE);
+    void disableCoalescing(void);
+#endif
+
+#ifdef WEBSOCKETS_METRICS
+    const WSmetrics_t * getMetrics(uint8_t num);
+#endif
+
+    // receive buffer pool (see WebSockets.cpp)
+    using WebSockets::adoptPayload;
+    using WebSockets::releasePayload;
+    using WebSockets::setBufferPoolSize;
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    void enableDeflate(const WSdeflateConfig_t & config = WSdeflateConfig_t());
+    void disableDeflate(void);
+    bool isDeflate(uint8_t num);
+#endif
 
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_RP2040)
     IPAddress remoteIP(uint8_t num);
@@ -117,17 +148,45 @@ class WebSocketsServerCore : protected WebSockets {
     uint32_t _pingInterval;
     uint32_t _pongTimeout;
     uint8_t _disconnectTimeoutCount;
+    uint32_t _maxPingInterval;
+
+    size_t _streamChunkSize;
+    size_t _reassemblySize;
+    bool _reassemblyContiguous;
+    bool _validateUtf8;
+
+    uint16_t _coalesceDelay;
+    size_t _coalesceSize;
+
+#if(WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
+    // HTTP request line being read, one buffer for all clients:
+    // a client owns it from the first byte of a line to its end, the others wait (max WEBSOCKETS_TCP_TIMEOUT)
+    char _httpLine[WEBSOCKETS_HTTP_LINE_SIZE];
+    uint16_t _httpLineLength;          ///< length of the current line, can be bigger then the buffer
+    uint8_t _httpLineOwner;            ///< client reading the line, WEBSOCKETS_SERVER_CLIENT_MAX = none
+    unsigned long _httpLineStart;      ///< millis when the line was started
+#endif
+
+#ifdef WEBSOCKETS_HAS_DEFLATE
+    bool _deflate;
+    WSdeflateConfig_t _deflateConfig;
+#endif
 
     void messageReceived(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, bool fin);
+    void streamReceived(WSclient_t * client, WSstreamChunk_t * chunk);
+    void messageReassembled(WSclient_t * client, WSmessage_t * message);
 
     void clientDisconnect(WSclient_t * client);
     bool clientIsConnected(WSclient_t * client);
 
 #if(WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
     void handleClientData(void);
+    void handleHeaderData(WSclient_t * client);
 #endif
 
     void handleHeader(WSclient_t * client, String * headerLine);
+    void handleHeaderLine(WSclient_t * client, char * line, size_t length, bool truncated);
+    void handleHeaderEnd(WSclient_t * client);
 
     void handleHBPing(WSclient_t * client);    // send ping in specified intervals
 
@@ -150,6 +209,22 @@ class WebSocketsServerCore : protected WebSockets {
         clientDisconnect(client);
     }
 
+    /**
+     * called if the HTTP request head or a needed header line is too big.
+     * Note: can be override
+     * @param client WSclient_t *  ptr to the client struct
+     */
+    virtual void handleHeaderTooLarge(WSclient_t * client) {
+        DEBUG_WEBSOCKETS("[WS-Server][%d][handleHeader] header too large close.\n", client->num);
+        client->tcp->write(
+            "HTTP/1.1 431 Request Header Fields Too Large\r\n"
+            "Server: arduino-WebSocket-Server\r\n"
+            "Content-Length: 0\r\n"
+            "Connection: close\r\n"
+            "\r\n");
+        clientDisconnect(client);
+    }
+
     /**
      * called if a non Authorization connection is coming in.
      * Note: can be override
@@ -185,6 +260,7 @@ class WebSocketsServerCore : protected WebSockets {
     /*
      * Called at client socket connect handshake negotiation time for each http header that is not
      * a websocket specific http header (not Connection, Upgrade, Sec-WebSocket-*)
+     * (only if a header validation function or mandatory http headers are set)
      * If the custom httpHeaderValidationFunc returns false for any headerName / headerValue passed, the
      * socket negotiation is considered invalid and the upgrade to websockets request is denied / rejected
      * This mechanism can be used to enable custom authentication schemes e.g. test the value
@@ -0,0 +1,989 @@
+/* ================ rawdeflate.c ================ */
+/*
+ * small raw DEFLATE (RFC 1951) encoder / decoder for permessage-deflate (RFC 7692)
+ *
+ * This file is part of the WebSockets for Arduino.
+ * LGPL-2.1
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rawdeflate.h"
+
+#define MIN_MATCH (3)
+#define MAX_MATCH (258)
+
+#define LITLEN_CODES (286)
+#define DIST_CODES (30)
+#define CODELEN_CODES (19)
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static const uint8_t codelen_order[CODELEN_CODES] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+static uint8_t bit_length(uint32_t v) {
+    uint8_t n = 0;
+    while(v) {
+        n++;
+        v >>= 1;
+    }
+    return n;
+}
+
+static uint16_t reverse_bits(uint16_t code, uint8_t len) {
+    uint16_t r = 0;
+    while(len--) {
+        r = (r << 1) | (code & 1);
+        code >>= 1;
+    }
+    return r;
+}
+
+/* ======================= encoder ======================= */
+
+typedef struct {
+    uint16_t key;
+    uint16_t sym;
+} rd_symfreq;
+
+/* per block state, lives in the work memory to keep the stack small */
+typedef struct {
+    uint16_t litFreq[LITLEN_CODES];
+    uint16_t distFreq[DIST_CODES];
+    uint16_t clFreq[CODELEN_CODES];
+
+    uint8_t litLen[LITLEN_CODES];
+    uint8_t distLen[DIST_CODES];
+    uint8_t clLen[CODELEN_CODES];
+
+    uint16_t litCode[LITLEN_CODES];
+    uint16_t distCode[DIST_CODES];
+    uint16_t clCode[CODELEN_CODES];
+
+    uint8_t rle[LITLEN_CODES + DIST_CODES][2];    /* code length symbol, extra bits value */
+    uint16_t rleCount;
+
+    rd_symfreq sorted[LITLEN_CODES];
+
+    uint8_t tokLen[RAWDEFLATE_BLOCK_TOKENS];      /* literal or match length - 3 */
+    uint16_t tokDist[RAWDEFLATE_BLOCK_TOKENS];    /* 0 for a literal */
+    uint16_t tokCount;
+} rd_block;
+
+typedef struct {
+    uint8_t * out;
+    size_t outPos;
+    size_t outSize;
+    uint32_t bitBuf;
+    uint8_t bitCnt;
+    uint8_t overflow;
+} rd_writer;
+
+size_t rawdeflate_work_size(uint8_t windowBits, uint8_t hashBits) {
+    if(windowBits < RAWDEFLATE_MIN_WINDOW_BITS) windowBits = RAWDEFLATE_MIN_WINDOW_BITS;
+    if(windowBits > RAWDEFLATE_MAX_WINDOW_BITS) windowBits = RAWDEFLATE_MAX_WINDOW_BITS;
+    if(hashBits < RAWDEFLATE_MIN_HASH_BITS) hashBits = RAWDEFLATE_MIN_HASH_BITS;
+    if(hashBits > RAWDEFLATE_MAX_HASH_BITS) hashBits = RAWDEFLATE_MAX_HASH_BITS;
+    return sizeof(rd_block) + (((size_t)1 << hashBits) + ((size_t)1 << windowBits)) * sizeof(uint16_t);
+}
+
+static void put_bits(rd_writer * w, uint32_t bits, uint8_t cnt) {
+    w->bitBuf |= bits << w->bitCnt;
+    w->bitCnt += cnt;
+    while(w->bitCnt >= 8) {
+        if(w->outPos >= w->outSize) {
+            w->overflow = 1;
+            w->bitCnt   = 0;
+            w->bitBuf   = 0;
+            return;
+        }
+        w->out[w->outPos++] = (uint8_t)w->bitBuf;
+        w->bitBuf >>= 8;
+        w->bitCnt -= 8;
+    }
+}
+
+static uint16_t length_symbol(uint16_t len) {
+    uint16_t l = len - MIN_MATCH;
+    uint8_t nb;
+    if(len == MAX_MATCH) {
+        return 285;
+    }
+    if(l < 8) {
+        return 257 + l;
+    }
+    nb = bit_length(l) - 1;
+    return 257 + 4 * (nb - 1) + ((l >> (nb - 2)) & 3);
+}
+
+static uint8_t dist_symbol(uint16_t dist) {
+    uint16_t d = dist - 1;
+    uint8_t nb;
+    if(d < 4) {
+        return (uint8_t)d;
+    }
+    nb = bit_length(d) - 1;
+    return 2 * nb + ((d >> (nb - 1)) & 1);
+}
+
+/*
+ * code lengths for the given frequencies, limited to maxBits
+ * (in-place minimum redundancy algorithm of Moffat and Katajainen)
+ */
+static void build_lengths(rd_symfreq * a, const uint16_t * freq, uint16_t n, uint8_t maxBits, uint8_t * lengths) {
+    uint16_t count[33];
+    uint16_t used = 0;
+    uint16_t i;
+    int root, leaf, next, avbl, depth, cnt;
+    uint32_t total;
+
+    memset(lengths, 0, n);
+    for(i = 0; i < n; i++) {
+        if(freq[i]) {
+            /* insertion sort, ascending frequency */
+            int j = used++;
+            while(j > 0 && a[j - 1].key > freq[i]) {
+                a[j] = a[j - 1];
+                j--;
+            }
+            a[j].key = freq[i];
+            a[j].sym = i;
+        }
+    }
+
+    if(used == 0) {
+        return;
+    }
+    if(used == 1) {
+        lengths[a[0].sym] = 1;
+        return;
+    }
+
+    a[0].key += a[1].key;
+    root = 0;
+    leaf = 2;
+    for(next = 1; next < used - 1; next++) {
+        if(leaf >= used || a[root].key < a[leaf].key) {
+            a[next].key = a[root].key;
+            a[root++].key = (uint16_t)next;
+        } else {
+            a[next].key = a[leaf++].key;
+        }
+        if(leaf >= used || (root < next && a[root].key < a[leaf].key)) {
+            a[next].key = (uint16_t)(a[next].key + a[root].key);
+            a[root++].key = (uint16_t)next;
+        } else {
+            a[next].key = (uint16_t)(a[next].key + a[leaf++].key);
+        }
+    }
+    a[used - 2].key = 0;
+    for(next = used - 3; next >= 0; next--) {
+        a[next].key = a[a[next].key].key + 1;
+    }
+    avbl  = 1;
+    cnt   = 0;
+    depth = 0;
+    root  = used - 2;
+    next  = used - 1;
+    while(avbl > 0) {
+        while(root >= 0 && (int)a[root].key == depth) {
+            cnt++;
+            root--;
+        }
+        while(avbl > cnt) {
+            a[next--].key = (uint16_t)depth;
+            avbl--;
+        }
+        avbl = 2 * cnt;
+        depth++;
+        cnt = 0;
+    }
+
+    /* limit the code length, then fix the Kraft sum */
+    memset(count, 0, sizeof(count));
+    for(i = 0; i < used; i++) {
+        count[a[i].key > maxBits ? maxBits : a[i].key]++;
+    }
+    total = 0;
+    for(i = maxBits; i > 0; i--) {
+        total += (uint32_t)count[i] << (maxBits - i);
+    }
+    while(total != (1u << maxBits)) {
+        count[maxBits]--;
+        for(i = maxBits - 1; i > 0; i--) {
+            if(count[i]) {
+                count[i]--;
+                count[i + 1] += 2;
+                break;
+            }
+        }
+        total--;
+    }
+
+    /* the least frequent symbols get the longest codes */
+    next = 0;
+    for(i = maxBits; i > 0; i--) {
+        for(cnt = count[i]; cnt > 0; cnt--) {
+            lengths[a[next++].sym] = (uint8_t)i;
+        }
+    }
+}
+
+/* canonical codes (RFC 1951 3.2.2), stored bit reversed for the LSB first writer */
+static void build_codes(const uint8_t * lengths, uint16_t n, uint16_t * codes) {
+    uint16_t count[16];
+    uint16_t next[16];
+    uint16_t code = 0;
+    uint16_t i;
+
+    memset(count, 0, sizeof(count));
+    for(i = 0; i < n; i++) {
+        count[lengths[i]]++;
+    }
+    count[0] = 0;
+    for(i = 1; i < 16; i++) {
+        code    = (code + count[i - 1]) << 1;
+        next[i] = code;
+    }
+    for(i = 0; i < n; i++) {
+        if(lengths[i]) {
+            codes[i] = reverse_bits(next[lengths[i]]++, lengths[i]);
+        }
+    }
+}
+
+static void fixed_lengths(rd_block * b) {
+    uint16_t sym;
+    for(sym = 0; sym < 144; sym++) b->litLen[sym] = 8;
+    for(; sym < 256; sym++) b->litLen[sym] = 9;
+    for(; sym < 280; sym++) b->litLen[sym] = 7;
+    for(; sym < LITLEN_CODES; sym++) b->litLen[sym] = 8;
+    for(sym = 0; sym < DIST_CODES; sym++) b->distLen[sym] = 5;
+}
+
+/* bits needed for the tokens of the block with the current code lengths */
+static uint32_t block_bits(const rd_block * b) {
+    uint32_t bits = 0;
+    uint16_t i;
+    for(i = 0; i < LITLEN_CODES; i++) {
+        bits += (uint32_t)b->litFreq[i] * b->litLen[i];
+        if(i >= 257) {
+            bits += (uint32_t)b->litFreq[i] * length_extra[i - 257];
+        }
+    }
+    for(i = 0; i < DIST_CODES; i++) {
+        bits += (uint32_t)b->distFreq[i] * (b->distLen[i] + dist_extra[i]);
+    }
+    return bits;
+}
+
+/* run length encoding of the code lengths (RFC 1951 3.2.7) */
+static void rle_lengths(rd_block * b, const uint8_t * lengths, uint16_t n) {
+    uint16_t i = 0;
+    while(i < n) {
+        uint8_t len  = lengths[i];
+        uint16_t run = 1;
+        while(i + run < n && lengths[i + run] == len) {
+            run++;
+        }
+        i += run;
+
+        if(len == 0) {
+            while(run >= 11) {
+                uint16_t r = run > 138 ? 138 : run;
+                b->rle[b->rleCount][0] = 18;
+                b->rle[b->rleCount][1] = (uint8_t)(r - 11);
+                b->rleCount++;
+                run -= r;
+            }
+            if(run >= 3) {
+                b->rle[b->rleCount][0] = 17;
+                b->rle[b->rleCount][1] = (uint8_t)(run - 3);
+                b->rleCount++;
+                run = 0;
+            }
+        } else if(run >= 4) {
+            b->rle[b->rleCount][0] = len;
+            b->rle[b->rleCount][1] = 0;
+            b->rleCount++;
+            run--;
+            while(run >= 3) {
+                uint16_t r = run > 6 ? 6 : run;
+                b->rle[b->rleCount][0] = 16;
+                b->rle[b->rleCount][1] = (uint8_t)(r - 3);
+                b->rleCount++;
+                run -= r;
+            }
+        }
+        while(run--) {
+            b->rle[b->rleCount][0] = len;
+            b->rle[b->rleCount][1] = 0;
+            b->rleCount++;
+        }
+    }
+}
+
+static void write_block(rd_writer * w, rd_block * b) {
+    static const uint8_t rle_extra[3] = { 2, 3, 7 };
+    uint8_t lengths[LITLEN_CODES + DIST_CODES];
+    uint16_t nlit  = LITLEN_CODES;
+    uint16_t ndist = DIST_CODES;
+    uint16_t ncl   = CODELEN_CODES;
+    uint32_t fixedBits;
+    uint32_t dynBits;
+    uint16_t i;
+
+    memset(b->litFreq, 0, sizeof(b->litFreq));
+    memset(b->distFreq, 0, sizeof(b->distFreq));
+    for(i = 0; i < b->tokCount; i++) {
+        if(b->tokDist[i]) {
+            b->litFreq[length_symbol(b->tokLen[i] + MIN_MATCH)]++;
+            b->distFreq[dist_symbol(b->tokDist[i])]++;
+        } else {
+            b->litFreq[b->tokLen[i]]++;
+        }
+    }
+    b->litFreq[256] = 1;
+
+    fixed_lengths(b);
+    fixedBits = 3 + block_bits(b);
+
+    build_lengths(b->sorted, b->litFreq, LITLEN_CODES, 15, b->litLen);
+    build_lengths(b->sorted, b->distFreq, DIST_CODES, 15, b->distLen);
+
+    while(nlit > 257 && b->litLen[nlit - 1] == 0) nlit--;
+    while(ndist > 1 && b->distLen[ndist - 1] == 0) ndist--;
+    if(b->distLen[0] == 0 && ndist == 1) {
+        /* no distance code used, send one code of one bit */
+        b->distLen[0] = 1;
+    }
+
+    memcpy(lengths, b->litLen, nlit);
+    memcpy(lengths + nlit, b->distLen, ndist);
+    b->rleCount = 0;
+    rle_lengths(b, lengths, nlit + ndist);
+
+    memset(b->clFreq, 0, sizeof(b->clFreq));
+    for(i = 0; i < b->rleCount; i++) {
+        b->clFreq[b->rle[i][0]]++;
+    }
+    build_lengths(b->sorted, b->clFreq, CODELEN_CODES, 7, b->clLen);
+    while(ncl > 4 && b->clLen[codelen_order[ncl - 1]] == 0) ncl--;
+
+    dynBits = 3 + 5 + 5 + 4 + 3 * ncl + block_bits(b);
+    for(i = 0; i < b->rleCount; i++) {
+        uint8_t sym = b->rle[i][0];
+        dynBits += b->clLen[sym] + (sym >= 16 ? rle_extra[sym - 16] : 0);
+    }
+
+    if(dynBits < fixedBits) {
+        /* BFINAL = 0, BTYPE = 10 (dynamic Huffman) */
+        put_bits(w, 0x4, 3);
+        put_bits(w, nlit - 257, 5);
+        put_bits(w, ndist - 1, 5);
+        put_bits(w, ncl - 4, 4);
+        for(i = 0; i < ncl; i++) {
+            put_bits(w, b->clLen[codelen_order[i]], 3);
+        }
+        build_codes(b->clLen, CODELEN_CODES, b->clCode);
+        for(i = 0; i < b->rleCount; i++) {
+            uint8_t sym = b->rle[i][0];
+            put_bits(w, b->clCode[sym], b->clLen[sym]);
+            if(sym >= 16) {
+                put_bits(w, b->rle[i][1], rle_extra[sym - 16]);
+            }
+        }
+    } else {
+        /* BFINAL = 0, BTYPE = 01 (fixed Huffman) */
+        put_bits(w, 0x2, 3);
+        fixed_lengths(b);
+    }
+
+    build_codes(b->litLen, LITLEN_CODES, b->litCode);
+    build_codes(b->distLen, DIST_CODES, b->distCode);
+
+    for(i = 0; i < b->tokCount && !w->overflow; i++) {
+        if(b->tokDist[i]) {
+            uint16_t len  = b->tokLen[i] + MIN_MATCH;
+            uint16_t dist = b->tokDist[i];
+            uint16_t ls   = length_symbol(len);
+            uint8_t ds    = dist_symbol(dist);
+            put_bits(w, b->litCode[ls], b->litLen[ls]);
+            put_bits(w, len - length_base[ls - 257], length_extra[ls - 257]);
+            put_bits(w, b->distCode[ds], b->distLen[ds]);
+            put_bits(w, dist - dist_base[ds], dist_extra[ds]);
+        } else {
+            put_bits(w, b->litCode[b->tokLen[i]], b->litLen[b->tokLen[i]]);
+        }
+    }
+    /* end of block */
+    put_bits(w, b->litCode[256], b->litLen[256]);
+
+    b->tokCount = 0;
+}
+
+static void add_token(rd_writer * w, rd_block * b, uint16_t lenOrLit, uint16_t dist) {
+    b->tokLen[b->tokCount]  = (uint8_t)(dist ? lenOrLit - MIN_MATCH : lenOrLit);
+    b->tokDist[b->tokCount] = dist;
+    b->tokCount++;
+    if(b->tokCount == RAWDEFLATE_BLOCK_TOKENS) {
+        write_block(w, b);
+    }
+}
+
+static uint32_t hash3(const uint8_t * p, uint8_t hashBits) {
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - hashBits);
+}
+
+size_t rawdeflate_compress_message(const uint8_t * in, size_t inLen, uint8_t * out, size_t outSize,
+                                   uint8_t windowBits, uint8_t hashBits, uint16_t maxChain, void * work) {
+    rd_writer w;
+    rd_block * b;
+    uint16_t * head;
+    uint16_t * prev;
+    uint32_t wsize;
+    uint32_t wmask;
+    size_t pos = 0;
+
+    if(windowBits < RAWDEFLATE_MIN_WINDOW_BITS) windowBits = RAWDEFLATE_MIN_WINDOW_BITS;
+    if(windowBits > RAWDEFLATE_MAX_WINDOW_BITS) windowBits = RAWDEFLATE_MAX_WINDOW_BITS;
+    if(hashBits < RAWDEFLATE_MIN_HASH_BITS) hashBits = RAWDEFLATE_MIN_HASH_BITS;
+    if(hashBits > RAWDEFLATE_MAX_HASH_BITS) hashBits = RAWDEFLATE_MAX_HASH_BITS;
+    if(maxChain == 0) maxChain = 1;
+
+    wsize = (uint32_t)1 << windowBits;
+    wmask = wsize - 1;
+    b     = (rd_block *)work;
+    head  = (uint16_t *)(b + 1);
+    prev  = head + ((size_t)1 << hashBits);
+
+    /* positions are stored +1 (0 = empty), stale entries are caught by the match compare */
+    memset(head, 0, ((size_t)1 << hashBits) * sizeof(uint16_t));
+    b->tokCount = 0;
+
+    memset(&w, 0, sizeof(w));
+    w.out     = out;
+    w.outSize = outSize;
+
+    while(pos < inLen && !w.overflow) {
+        uint16_t bestLen  = 0;
+        uint16_t bestDist = 0;
+
+        if(pos + MIN_MATCH <= inLen) {
+            uint32_t h        = hash3(&in[pos], hashBits);
+            uint16_t cand     = head[h];
+            uint16_t chain    = maxChain;
+            uint32_t lastDist = 0;
+            size_t maxLen     = inLen - pos;
+            if(maxLen > MAX_MATCH) maxLen = MAX_MATCH;
+
+            prev[pos & wmask] = cand;
+            head[h]           = (uint16_t)(pos + 1);
+
+            while(cand && chain--) {
+                uint32_t dist = (uint16_t)((pos + 1) - cand);
+                const uint8_t * pa;
+                const uint8_t * pb;
+                size_t len;
+
+                if(dist == 0 || dist <= lastDist || dist > wsize || dist > pos) {
+                    break;
+                }
+                lastDist = dist;
+
+                pa = &in[pos];
+                pb = &in[pos - dist];
+                if(pb[bestLen] == pa[bestLen] && pb[0] == pa[0] && pb[1] == pa[1]) {
+                    len = 2;
+                    while(len < maxLen && pa[len] == pb[len]) {
+                        len++;
+                    }
+                    if(len > bestLen) {
+                        bestLen  = (uint16_t)len;
+                        bestDist = (uint16_t)dist;
+                        if(len == maxLen) {
+                            break;
+                        }
+                    }
+                }
+                cand = prev[(pos - dist) & wmask];
+            }
+        }
+
+        if(bestLen >= MIN_MATCH) {
+            size_t end = pos + bestLen;
+            add_token(&w, b, bestLen, bestDist);
+            /* insert the skipped positions into the hash chains */
+            for(pos++; pos < end; pos++) {
+                if(pos + MIN_MATCH <= inLen) {
+                    uint32_t h        = hash3(&in[pos], hashBits);
+                    prev[pos & wmask] = head[h];
+                    head[h]           = (uint16_t)(pos + 1);
+                }
+            }
+        } else {
+            add_token(&w, b, in[pos], 0);
+            pos++;
+        }
+    }
+
+    if(b->tokCount || inLen == 0) {
+        write_block(&w, b);
+    }
+
+    /* empty stored block (BFINAL = 0, BTYPE = 00), aligned to a byte,
+     * its LEN / NLEN (0x00 0x00 0xff 0xff) is the tail RFC 7692 removes */
+    put_bits(&w, 0, 3);
+    if(w.bitCnt) {
+        put_bits(&w, 0, 8 - w.bitCnt);
+    }
+
+    if(w.overflow) {
+        return 0;
+    }
+    return w.outPos;
+}
+
+/* ======================= decoder ======================= */
+
+#define FAST_BITS (9)
+
+typedef struct {
+    uint16_t count[16];
+    uint16_t symbol[288];
+    uint16_t fast[1 << FAST_BITS]; /* (symbol << 4) | length, 0 = use slow path */
+} rd_huffman;
+
+typedef struct {
+    const uint8_t * in;
+    size_t inLen;
+    size_t inPos;
+    uint32_t bitBuf;
+    uint8_t bitCnt;
+    uint8_t tailPos;
+    uint8_t error;
+
+    uint8_t * out;
+    size_t outLen;
+    size_t outSize;
+    size_t outMax;
+
+    rd_huffman lencode;
+    rd_huffman distcode;
+} rd_reader;
+
+static const uint8_t message_tail[4] = { 0x00, 0x00, 0xff, 0xff };
+
+static int next_byte(rd_reader * r) {
+    if(r->inPos < r->inLen) {
+        return r->in[r->inPos++];
+    }
+    if(r->tailPos < sizeof(message_tail)) {
+        return message_tail[r->tailPos++];
+    }
+    return -1;
+}
+
+static int bytes_left(rd_reader * r) {
+    return (r->inPos < r->inLen) || (r->tailPos < sizeof(message_tail));
+}
+
+static void refill(rd_reader * r) {
+    while(r->bitCnt <= 24) {
+        int c = next_byte(r);
+        if(c < 0) {
+            break;
+        }
+        r->bitBuf |= (uint32_t)c << r->bitCnt;
+        r->bitCnt += 8;
+    }
+}
+
+static uint32_t get_bits(rd_reader * r, uint8_t need) {
+    uint32_t v;
+    if(need == 0) {
+        return 0;
+    }
+    if(r->bitCnt < need) {
+        refill(r);
+        if(r->bitCnt < need) {
+            r->error = 1;
+            return 0;
+        }
+    }
+    v = r->bitBuf & ((1u << need) - 1);
+    r->bitBuf >>= need;
+    r->bitCnt -= need;
+    return v;
+}
+
+static int build_huffman(rd_huffman * h, const uint8_t * length, uint16_t n) {
+    uint16_t offs[16];
+    uint16_t code;
+    int left;
+    uint16_t sym;
+    uint8_t len;
+
+    memset(h->count, 0, sizeof(h->count));
+    memset(h->fast, 0, sizeof(h->fast));
+    for(sym = 0; sym < n; sym++) {
+        h->count[length[sym]]++;
+    }
+    if(h->count[0] == n) {
+        return 0;
+    }
+
+    /* check for an over-subscribed set of lengths */
+    left = 1;
+    for(len = 1; len < 16; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if(left < 0) {
+            return -1;
+        }
+    }
+
+    offs[1] = 0;
+    for(len = 1; len < 15; len++) {
+        offs[len + 1] = offs[len] + h->count[len];
+    }
+    for(sym = 0; sym < n; sym++) {
+        if(length[sym] != 0) {
+            h->symbol[offs[length[sym]]++] = sym;
+        }
+    }
+
+    /* lookup table for the short codes */
+    code = 0;
+    sym  = 0;
+    for(len = 1; len <= FAST_BITS; len++) {
+        uint16_t i;
+        for(i = 0; i < h->count[len]; i++) {
+            uint16_t rev  = reverse_bits(code, len);
+            uint16_t fill = (uint16_t)((h->symbol[sym] << 4) | len);
+            uint16_t k;
+            for(k = rev; k < (1 << FAST_BITS); k += (1 << len)) {
+                h->fast[k] = fill;
+            }
+            code++;
+            sym++;
+        }
+        code <<= 1;
+    }
+    return 0;
+}
+
+static int decode_symbol(rd_reader * r, const rd_huffman * h) {
+    int code  = 0;
+    int first = 0;
+    int index = 0;
+    uint8_t len;
+
+    if(r->bitCnt < FAST_BITS) {
+        refill(r);
+    }
+    if(r->bitCnt >= FAST_BITS) {
+        uint16_t e = h->fast[r->bitBuf & ((1 << FAST_BITS) - 1)];
+        if(e) {
+            r->bitBuf >>= (e & 0xF);
+            r->bitCnt -= (e & 0xF);
+            return e >> 4;
+        }
+    }
+
+    /* canonical decoding bit by bit for the long codes */
+    for(len = 1; len < 16; len++) {
+        int count;
+        code |= (int)get_bits(r, 1);
+        if(r->error) {
+            return -1;
+        }
+        count = h->count[len];
+        if(code - count < first) {
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static int ensure_out(rd_reader * r, size_t need) {
+    size_t size;
+    uint8_t * p;
+
+    if(r->outLen + need <= r->outSize) {
+        return RAWDEFLATE_OK;
+    }
+    if(r->outLen + need > r->outMax) {
+        return RAWDEFLATE_ERR_SIZE;
+    }
+    size = r->outSize ? r->outSize * 2 : 256;
+    while(size < r->outLen + need) {
+        size *= 2;
+    }
+    if(size > r->outMax) {
+        size = r->outMax;
+    }
+    p = (uint8_t *)realloc(r->out, size + 1);
+    if(!p) {
+        return RAWDEFLATE_ERR_MEM;
+    }
+    r->out     = p;
+    r->outSize = size;
+    return RAWDEFLATE_OK;
+}
+
+static int inflate_stored(rd_reader * r) {
+    uint16_t len;
+    uint16_t nlen;
+    int ret;
+
+    /* drop the rest of the current byte, give back the bytes already in the buffer */
+    r->bitBuf >>= (r->bitCnt & 7);
+    r->bitCnt -= (r->bitCnt & 7);
+
+    len  = (uint16_t)get_bits(r, 16);
+    nlen = (uint16_t)get_bits(r, 16);
+    if(r->error || ((uint32_t)len + nlen) != 0xFFFFu) {
+        return RAWDEFLATE_ERR_DATA;
+    }
+
+    ret = ensure_out(r, len);
+    if(ret != RAWDEFLATE_OK) {
+        return ret;
+    }
+    while(len && r->bitCnt) {
+        r->out[r->outLen++] = (uint8_t)get_bits(r, 8);
+        len--;
+    }
+    while(len) {
+        int c = next_byte(r);
+        if(c < 0) {
+            return RAWDEFLATE_ERR_DATA;
+        }
+        r->out[r->outLen++] = (uint8_t)c;
+        len--;
+    }
+    return RAWDEFLATE_OK;
+}
+
+static int inflate_codes(rd_reader * r) {
+    for(;;) {
+        int sym = decode_symbol(r, &r->lencode);
+        if(sym < 0 || r->error) {
+            return RAWDEFLATE_ERR_DATA;
+        }
+        if(sym < 256) {
+            int ret = ensure_out(r, 1);
+            if(ret != RAWDEFLATE_OK) {
+                return ret;
+            }
+            r->out[r->outLen++] = (uint8_t)sym;
+        } else if(sym == 256) {
+            return RAWDEFLATE_OK;
+        } else {
+            size_t len;
+            size_t dist;
+            uint8_t * dst;
+            const uint8_t * src;
+            int ret;
+
+            sym -= 257;
+            if(sym >= 29) {
+                return RAWDEFLATE_ERR_DATA;
+            }
+            len = length_base[sym] + get_bits(r, length_extra[sym]);
+
+            sym = decode_symbol(r, &r->distcode);
+            if(sym < 0 || sym >= 30) {
+                return RAWDEFLATE_ERR_DATA;
+            }
+            dist = dist_base[sym] + get_bits(r, dist_extra[sym]);
+            if(r->error || dist > r->outLen) {
+                return RAWDEFLATE_ERR_DATA;
+            }
+
+            ret = ensure_out(r, len);
+            if(ret != RAWDEFLATE_OK) {
+                return ret;
+            }
+            dst = &r->out[r->outLen];
+            src = dst - dist;
+            r->outLen += len;
+            if(dist >= len) {
+                memcpy(dst, src, len);
+            } else {
+                while(len--) {
+                    *dst++ = *src++;
+                }
+            }
+        }
+    }
+}
+
+static int inflate_fixed(rd_reader * r) {
+    uint8_t lengths[288];
+    uint16_t sym;
+
+    for(sym = 0; sym < 144; sym++) lengths[sym] = 8;
+    for(; sym < 256; sym++) lengths[sym] = 9;
+    for(; sym < 280; sym++) lengths[sym] = 7;
+    for(; sym < 288; sym++) lengths[sym] = 8;
+    build_huffman(&r->lencode, lengths, 288);
+
+    for(sym = 0; sym < 30; sym++) lengths[sym] = 5;
+    build_huffman(&r->distcode, lengths, 30);
+
+    return inflate_codes(r);
+}
+
+static int inflate_dynamic(rd_reader * r) {
+    uint8_t lengths[288 + 32];
+    uint16_t nlen;
+    uint16_t ndist;
+    uint16_t ncode;
+    uint16_t index;
+
+    nlen  = (uint16_t)get_bits(r, 5) + 257;
+    ndist = (uint16_t)get_bits(r, 5) + 1;
+    ncode = (uint16_t)get_bits(r, 4) + 4;
+    if(r->error || nlen > 286 || ndist > 30) {
+        return RAWDEFLATE_ERR_DATA;
+    }
+
+    memset(lengths, 0, sizeof(lengths));
+    for(index = 0; index < ncode; index++) {
+        lengths[codelen_order[index]] = (uint8_t)get_bits(r, 3);
+    }
+    if(r->error || build_huffman(&r->lencode, lengths, 19) != 0) {
+        return RAWDEFLATE_ERR_DATA;
+    }
+
+    index = 0;
+    while(index < nlen + ndist) {
+        int sym = decode_symbol(r, &r->lencode);
+        if(sym < 0 || r->error) {
+            return RAWDEFLATE_ERR_DATA;
+        }
+        if(sym < 16) {
+            lengths[index++] = (uint8_t)sym;
+        } else {
+            uint8_t len = 0;
+            uint16_t rep;
+            if(sym == 16) {
+                if(index == 0) {
+                    return RAWDEFLATE_ERR_DATA;
+                }
+                len = lengths[index - 1];
+                rep = 3 + (uint16_t)get_bits(r, 2);
+            } else if(sym == 17) {
+                rep = 3 + (uint16_t)get_bits(r, 3);
+            } else {
+                rep = 11 + (uint16_t)get_bits(r, 7);
+            }
+            if(r->error || index + rep > nlen + ndist) {
+                return RAWDEFLATE_ERR_DATA;
+            }
+            while(rep--) {
+                lengths[index++] = len;
+            }
+        }
+    }
+
+    /* a block without end of block code is not valid */
+    if(lengths[256] == 0) {
+        return RAWDEFLATE_ERR_DATA;
+    }
+    if(build_huffman(&r->lencode, lengths, nlen) != 0 || build_huffman(&r->distcode, lengths + nlen, ndist) != 0) {
+        return RAWDEFLATE_ERR_DATA;
+    }
+
+    return inflate_codes(r);
+}
+
+int rawdeflate_inflate_message(const uint8_t * in, size_t inLen, uint8_t ** out, size_t * outLen, size_t outMax) {
+    rd_reader * r;
+    int ret  = RAWDEFLATE_OK;
+    int last = 0;
+
+    *out    = NULL;
+    *outLen = 0;
+
+    /* the huffman tables are too big for the stack of small tasks */
+    r = (rd_reader *)malloc(sizeof(rd_reader));
+    if(!r) {
+        return RAWDEFLATE_ERR_MEM;
+    }
+    memset(r, 0, sizeof(rd_reader));
+    r->in     = in;
+    r->inLen  = inLen;
+    r->outMax = outMax;
+
+    ret = ensure_out(r, (inLen * 2 < outMax) ? inLen * 2 : outMax);
+
+    while(ret == RAWDEFLATE_OK && !last) {
+        uint32_t type;
+
+        /* the message ends on a block boundary after the appended empty stored block */
+        if(r->bitCnt < 8 && !bytes_left(r)) {
+            break;
+        }
+
+        last = (int)get_bits(r, 1);
+        type = get_bits(r, 2);
+        if(r->error) {
+            ret = RAWDEFLATE_ERR_DATA;
+            break;
+        }
+
+        switch(type) {
+            case 0:
+                ret = inflate_stored(r);
+                break;
+            case 1:
+                ret = inflate_fixed(r);
+                break;
+            case 2:
+                ret = inflate_dynamic(r);
+                break;
+            default:
+                ret = RAWDEFLATE_ERR_DATA;
+                break;
+        }
+    }
+
+    if(ret == RAWDEFLATE_OK) {
+        if(r->out) {
+            r->out[r->outLen] = 0x00;
+        }
+        *out    = r->out;
+        *outLen = r->outLen;
+    } else {
+        free(r->out);
+    }
+    free(r);
+    return ret;
+}
@@ -0,0 +1,55 @@
+/* ================ rawdeflate.h ================ */
+/*
+ * small raw DEFLATE (RFC 1951) encoder / decoder for permessage-deflate (RFC 7692)
+ *
+ * - every message is compressed / decompressed on its own (no context takeover)
+ * - the encoder uses greedy LZ77 matching and picks fixed or dynamic Huffman codes per block,
+ *   its memory use is given by windowBits and hashBits (see rawdeflate_work_size())
+ * - the decoder supports stored, fixed and dynamic blocks, the decompressed
+ *   message is used as the window, so no extra window buffer is needed
+ *
+ * This file is part of the WebSockets for Arduino.
+ * LGPL-2.1
+ */
+
+#ifndef RAWDEFLATE_H_
+#define RAWDEFLATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RAWDEFLATE_MIN_WINDOW_BITS (8)
+#define RAWDEFLATE_MAX_WINDOW_BITS (15)
+
+#define RAWDEFLATE_MIN_HASH_BITS (8)
+#define RAWDEFLATE_MAX_HASH_BITS (15)
+
+/* LZ77 tokens collected before a block is written (3 byte each) */
+#ifndef RAWDEFLATE_BLOCK_TOKENS
+#define RAWDEFLATE_BLOCK_TOKENS (1024)
+#endif
+
+#define RAWDEFLATE_OK (0)
+#define RAWDEFLATE_ERR_DATA (-1)  /* invalid compressed data */
+#define RAWDEFLATE_ERR_SIZE (-2)  /* output would exceed outMax */
+#define RAWDEFLATE_ERR_MEM (-3)   /* out of memory */
+
+/* bytes of work memory needed by rawdeflate_compress_message() */
+size_t rawdeflate_work_size(uint8_t windowBits, uint8_t hashBits);
+
+/*
+ * compress one message, the output ends with the 0x00 0x00 0xff 0xff tail removed (RFC 7692 7.2.1)
+ * work must point to rawdeflate_work_size(windowBits, hashBits) bytes
+ * returns the compressed length or 0 if the output does not fit in outSize
+ */
+size_t rawdeflate_compress_message(const uint8_t * in, size_t inLen, uint8_t * out, size_t outSize,
+                                   uint8_t windowBits, uint8_t hashBits, uint16_t maxChain, void * work);
+
+/*
+ * decompress one message (the 0x00 0x00 0xff 0xff tail is appended internally)
+ * *out is allocated (and grown) with malloc / realloc, at most outMax + 1 bytes,
+ * the extra byte is left for a string terminator, the caller has to free *out
+ */
+int rawdeflate_inflate_message(const uint8_t * in, size_t inLen, uint8_t ** out, size_t * outLen, size_t outMax);
+
+#endif /* RAWDEFLATE_H_ */
@@ -0,0 +1,148 @@
+/* ================ utf8.c ================ */
+/*
+ * UTF-8 (RFC 3629) validation for WebSocket text frames, see utf8.h
+ *
+ * This file is part of the WebSockets for Arduino.
+ * LGPL-2.1
+ */
+
+#include "utf8.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * state: bit 0-1 continuation bytes still needed, bit 2-4 allowed range of the next byte
+ * (the second byte after E0, ED, F0 and F4 is restricted, RFC 3629 table 3-7)
+ */
+#define RANGE_80_BF (0 << 2)
+#define RANGE_A0_BF (1 << 2)
+#define RANGE_80_9F (2 << 2)
+#define RANGE_90_BF (3 << 2)
+#define RANGE_80_8F (4 << 2)
+
+static const uint8_t rangeLow[5]  = { 0x80, 0xA0, 0x80, 0x90, 0x80 };
+static const uint8_t rangeHigh[5] = { 0xBF, 0xBF, 0x9F, 0xBF, 0x8F };
+
+static uint8_t utf8_step(uint8_t state, uint8_t c) {
+    if(state == UTF8_ACCEPT) {
+        if(c < 0x80) {
+            return UTF8_ACCEPT;
+        }
+        if(c < 0xC2) {
+            /* continuation byte or overlong 2 byte sequence */
+            return UTF8_REJECT;
+        }
+        if(c < 0xE0) {
+            return 1 | RANGE_80_BF;
+        }
+        if(c < 0xF0) {
+            return 2 | (c == 0xE0 ? RANGE_A0_BF : (c == 0xED ? RANGE_80_9F : RANGE_80_BF));
+        }
+        if(c < 0xF5) {
+            return 3 | (c == 0xF0 ? RANGE_90_BF : (c == 0xF4 ? RANGE_80_8F : RANGE_80_BF));
+        }
+        return UTF8_REJECT;
+    }
+
+    if(state == UTF8_REJECT) {
+        return UTF8_REJECT;
+    }
+
+    uint8_t range = (state >> 2);
+    if(c < rangeLow[range] || c > rangeHigh[range]) {
+        return UTF8_REJECT;
+    }
+    /* one byte less needed, the following bytes are 80..BF */
+    return ((state & 0x03) - 1);
+}
+
+/* all bytes of a word have the high bit cleared */
+#define WORD_HIGH_BITS ((size_t)(~(size_t)0 / 0xFF) * 0x80)
+
+uint8_t utf8_unmask_validate(uint8_t * data, size_t length, const uint8_t * maskKey, size_t maskOffset, uint8_t state) {
+    size_t i = 0;
+
+    if(state == UTF8_REJECT) {
+        return UTF8_REJECT;
+    }
+
+#if defined(__SSE2__)
+    {
+        uint8_t maskBytes[16] = { 0 };
+        if(maskKey) {
+            for(size_t k = 0; k < 16; k++) {
+                maskBytes[k] = maskKey[(maskOffset + k) & 3];
+            }
+        }
+        __m128i mask = _mm_loadu_si128((const __m128i *)maskBytes);
+
+        while(i + 16 <= length) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+            if(maskKey) {
+                v = _mm_xor_si128(v, mask);
+                _mm_storeu_si128((__m128i *)(data + i), v);
+            }
+            if(state == UTF8_ACCEPT && _mm_movemask_epi8(v) == 0) {
+                i += 16;
+                continue;
+            }
+            for(size_t k = 0; k < 16; k++) {
+                state = utf8_step(state, data[i + k]);
+            }
+            if(state == UTF8_REJECT) {
+                return UTF8_REJECT;
+            }
+            i += 16;
+        }
+    }
+#endif
+
+    {
+        size_t mask = 0;
+        if(maskKey) {
+            uint8_t maskBytes[sizeof(size_t)];
+            for(size_t k = 0; k < sizeof(size_t); k++) {
+                maskBytes[k] = maskKey[(maskOffset + i + k) & 3];
+            }
+            memcpy(&mask, maskBytes, sizeof(size_t));
+        }
+
+        while(i + sizeof(size_t) <= length) {
+            size_t w;
+            memcpy(&w, data + i, sizeof(size_t));
+            if(maskKey) {
+                w ^= mask;
+                memcpy(data + i, &w, sizeof(size_t));
+            }
+            if(state == UTF8_ACCEPT && (w & WORD_HIGH_BITS) == 0) {
+                i += sizeof(size_t);
+                continue;
+            }
+            for(size_t k = 0; k < sizeof(size_t); k++) {
+                state = utf8_step(state, data[i + k]);
+            }
+            if(state == UTF8_REJECT) {
+                return UTF8_REJECT;
+            }
+            i += sizeof(size_t);
+        }
+    }
+
+    for(; i < length; i++) {
+        if(maskKey) {
+            data[i] ^= maskKey[(maskOffset + i) & 3];
+        }
+        state = utf8_step(state, data[i]);
+    }
+
+    return state;
+}
+
+uint8_t utf8_validate(const uint8_t * data, size_t length, uint8_t state) {
+    /* without mask nothing is written */
+    return utf8_unmask_validate((uint8_t *)data, length, NULL, 0, state);
+}
@@ -0,0 +1,36 @@
+/* ================ utf8.h ================ */
+/*
+ * UTF-8 (RFC 3629) validation for WebSocket text frames (RFC 6455 8.1)
+ *
+ * - the data is checked a machine word at a time (16 byte with SSE2),
+ *   runs of ASCII are skipped, only other bytes go through the state machine
+ * - utf8_unmask_validate() removes the frame mask in the same pass,
+ *   so every payload byte is only read and written once
+ * - the state carries over between calls, a sequence can be split over frames / chunks
+ *
+ * This file is part of the WebSockets for Arduino.
+ * LGPL-2.1
+ */
+
+#ifndef UTF8_H_
+#define UTF8_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UTF8_ACCEPT (0)      /* at a character boundary */
+#define UTF8_REJECT (0xFF)   /* invalid data, stays rejected */
+
+/*
+ * validate length bytes, state is UTF8_ACCEPT at the start of a message
+ * returns the new state, a complete message has to end with UTF8_ACCEPT
+ */
+uint8_t utf8_validate(const uint8_t * data, size_t length, uint8_t state);
+
+/*
+ * unmask (data[i] ^= maskKey[(maskOffset + i) & 3]) and validate length bytes
+ * maskKey can be NULL for unmasked data
+ */
+uint8_t utf8_unmask_validate(uint8_t * data, size_t length, const uint8_t * maskKey, size_t maskOffset, uint8_t state);
+
+#endif /* UTF8_H_ */
@@ -0,0 +1,206 @@
+/**
+ * @file Arduino.cpp
+ * @date 19.10.2026
+ *
+ * minimal Arduino core API for the host test build of the WebSockets library.
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#include "Arduino.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <random>
+
+static uint64_t monotonicMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static const uint64_t startMicros = monotonicMicros();
+
+unsigned long millis(void) {
+    return (unsigned long)((monotonicMicros() - startMicros) / 1000ULL);
+}
+
+unsigned long micros(void) {
+    return (unsigned long)(monotonicMicros() - startMicros);
+}
+
+void delay(unsigned long ms) {
+    if(ms == 0) {
+        sched_yield();
+        return;
+    }
+    usleep(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    usleep(us);
+}
+
+void yield(void) {
+    sched_yield();
+}
+
+static std::minstd_rand rng;
+
+long random(long max) {
+    if(max <= 0) {
+        return 0;
+    }
+    return (long)(rng() % (unsigned long)max);
+}
+
+long random(long min, long max) {
+    if(min >= max) {
+        return min;
+    }
+    return min + random(max - min);
+}
+
+void randomSeed(unsigned long seed) {
+    if(seed != 0) {
+        rng.seed(seed);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// String
+
+bool String::equalsIgnoreCase(const String & s) const {
+    if(_s.length() != s._s.length()) {
+        return false;
+    }
+    for(size_t i = 0; i < _s.length(); i++) {
+        if(tolower((unsigned char)_s[i]) != tolower((unsigned char)s._s[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if(from > to) {
+        std::swap(from, to);
+    }
+    if(from >= _s.length()) {
+        return String();
+    }
+    if(to > _s.length()) {
+        to = _s.length();
+    }
+    return String(_s.substr(from, to - from));
+}
+
+void String::replace(const String & find, const String & replace) {
+    if(find._s.empty()) {
+        return;
+    }
+    size_t pos = 0;
+    while((pos = _s.find(find._s, pos)) != std::string::npos) {
+        _s.replace(pos, find._s.length(), replace._s);
+        pos += replace._s.length();
+    }
+}
+
+void String::trim() {
+    size_t begin = 0;
+    size_t end   = _s.length();
+    while(begin < end && isspace((unsigned char)_s[begin])) {
+        begin++;
+    }
+    while(end > begin && isspace((unsigned char)_s[end - 1])) {
+        end--;
+    }
+    _s = _s.substr(begin, end - begin);
+}
+
+void String::toLowerCase() {
+    for(char & c : _s) {
+        c = tolower((unsigned char)c);
+    }
+}
+
+void String::toUpperCase() {
+    for(char & c : _s) {
+        c = toupper((unsigned char)c);
+    }
+}
+
+long String::toInt() const {
+    return atol(_s.c_str());
+}
+
+// ----------------------------------------------------------------------------
+// Print / Stream
+
+size_t Print::printf(const char * format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if(len < 0) {
+        return 0;
+    }
+    if((size_t)len < sizeof(buf)) {
+        return write((const uint8_t *)buf, len);
+    }
+    char * big = (char *)malloc(len + 1);
+    if(!big) {
+        return 0;
+    }
+    va_start(args, format);
+    vsnprintf(big, len + 1, format, args);
+    va_end(args);
+    size_t n = write((const uint8_t *)big, len);
+    free(big);
+    return n;
+}
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if(c >= 0) {
+            return c;
+        }
+        yield();
+    } while(millis() - start < _timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char * buffer, size_t length) {
+    size_t count = 0;
+    while(count < length) {
+        int c = timedRead();
+        if(c < 0) {
+            break;
+        }
+        *buffer++ = (char)c;
+        count++;
+    }
+    return count;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String ret;
+    int c = timedRead();
+    while(c >= 0 && c != terminator) {
+        ret += (char)c;
+        c = timedRead();
+    }
+    return ret;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file Arduino.h
+ * @date 19.10.2026
+ *
+ * minimal Arduino core API for the host test build of the WebSockets library.
+ * time is taken from CLOCK_MONOTONIC, yield() / delay() map to the scheduler.
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#ifndef HOST_ARDUINO_H_
+#define HOST_ARDUINO_H_
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+
+#define bit(b) (1UL << (b))
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+inline bool isPrintable(int c) {
+    return isprint(c) != 0;
+}
+
+#endif /* HOST_ARDUINO_H_ */
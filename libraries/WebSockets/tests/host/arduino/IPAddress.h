@@ -0,0 +1,51 @@
+/**
+ * @file IPAddress.h
+ * @date 19.10.2026
+ *
+ * minimal Arduino IPAddress for the host test build of the WebSockets library.
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#ifndef HOST_IPADDRESS_H_
+#define HOST_IPADDRESS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "WString.h"
+
+class IPAddress {
+  public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        _address[0] = a;
+        _address[1] = b;
+        _address[2] = c;
+        _address[3] = d;
+    }
+
+    uint8_t operator[](int index) const {
+        return _address[index];
+    }
+    uint8_t & operator[](int index) {
+        return _address[index];
+    }
+
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _address[0], _address[1], _address[2], _address[3]);
+        return String(buf);
+    }
+
+  private:
+    uint8_t _address[4] = { 0, 0, 0, 0 };
+};
+
+#endif /* HOST_IPADDRESS_H_ */
@@ -0,0 +1,288 @@
+/**
+ * @file PosixTCP.cpp
+ * @date 19.10.2026
+ *
+ * WEBSOCKETS_NETWORK_CLASS / WEBSOCKETS_NETWORK_SERVER_CLASS implementation
+ * on top of POSIX sockets, used by the host test build (NETWORK_POSIX).
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#include "PosixTCP.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+struct PosixTCPSocket {
+    int fd = -1;
+    uint8_t rx[POSIXTCP_RX_BUFFER_SIZE];
+    size_t rxPos = 0;
+    size_t rxLen = 0;
+    bool eof     = false;
+
+    ~PosixTCPSocket() {
+        if(fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+static void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+PosixTCPClient::PosixTCPClient() {
+}
+
+PosixTCPClient::PosixTCPClient(int fd) {
+    if(fd >= 0) {
+        _sock     = std::make_shared<PosixTCPSocket>();
+        _sock->fd = fd;
+        setNonBlocking(fd);
+    }
+}
+
+PosixTCPClient::~PosixTCPClient() {
+}
+
+int PosixTCPClient::connect(const char * host, uint16_t port) {
+    return connect(host, port, 5000);
+}
+
+int PosixTCPClient::connect(const char * host, uint16_t port, int32_t timeout) {
+    stop();
+
+    struct addrinfo hints;
+    struct addrinfo * res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if(getaddrinfo(host, service, &hints, &res) != 0 || !res) {
+        return 0;
+    }
+
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if(fd < 0) {
+        freeaddrinfo(res);
+        return 0;
+    }
+    setNonBlocking(fd);
+
+    int r = ::connect(fd, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    if(r < 0 && errno != EINPROGRESS) {
+        ::close(fd);
+        return 0;
+    }
+
+    if(r < 0) {
+        struct pollfd pfd = { fd, POLLOUT, 0 };
+        if(poll(&pfd, 1, timeout) != 1) {
+            ::close(fd);
+            return 0;
+        }
+        int err       = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if(err != 0) {
+            ::close(fd);
+            return 0;
+        }
+    }
+
+    _sock     = std::make_shared<PosixTCPSocket>();
+    _sock->fd = fd;
+    return 1;
+}
+
+bool PosixTCPClient::fill() {
+    if(!_sock || _sock->fd < 0 || _sock->eof) {
+        return false;
+    }
+    if(_sock->rxPos < _sock->rxLen) {
+        return true;
+    }
+    ssize_t n = recv(_sock->fd, _sock->rx, sizeof(_sock->rx), 0);
+    if(n > 0) {
+        _sock->rxPos = 0;
+        _sock->rxLen = n;
+        return true;
+    }
+    if(n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        _sock->eof = true;
+    }
+    return false;
+}
+
+uint8_t PosixTCPClient::connected() {
+    if(!_sock || _sock->fd < 0) {
+        return 0;
+    }
+    if(_sock->rxPos < _sock->rxLen) {
+        return 1;
+    }
+    fill();
+    return (_sock->rxPos < _sock->rxLen) || !_sock->eof;
+}
+
+void PosixTCPClient::stop() {
+    _sock.reset();
+}
+
+void PosixTCPClient::setNoDelay(bool nodelay) {
+    if(_sock && _sock->fd >= 0) {
+        int flag = nodelay ? 1 : 0;
+        setsockopt(_sock->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+}
+
+IPAddress PosixTCPClient::remoteIP() const {
+    if(!_sock || _sock->fd < 0) {
+        return IPAddress();
+    }
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    if(getpeername(_sock->fd, (struct sockaddr *)&addr, &len) != 0) {
+        return IPAddress();
+    }
+    uint32_t ip = ntohl(addr.sin_addr.s_addr);
+    return IPAddress(ip >> 24, ip >> 16, ip >> 8, ip);
+}
+
+int PosixTCPClient::fd() const {
+    return _sock ? _sock->fd : -1;
+}
+
+int PosixTCPClient::available() {
+    if(!fill()) {
+        return 0;
+    }
+    return _sock->rxLen - _sock->rxPos;
+}
+
+int PosixTCPClient::read() {
+    if(!fill()) {
+        return -1;
+    }
+    return _sock->rx[_sock->rxPos++];
+}
+
+int PosixTCPClient::read(uint8_t * buf, size_t size) {
+    if(!fill()) {
+        return -1;
+    }
+    size_t n = std::min(size, _sock->rxLen - _sock->rxPos);
+    memcpy(buf, &_sock->rx[_sock->rxPos], n);
+    _sock->rxPos += n;
+    return n;
+}
+
+int PosixTCPClient::peek() {
+    if(!fill()) {
+        return -1;
+    }
+    return _sock->rx[_sock->rxPos];
+}
+
+size_t PosixTCPClient::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t PosixTCPClient::write(const uint8_t * buf, size_t size) {
+    if(!_sock || _sock->fd < 0) {
+        return 0;
+    }
+    size_t total = 0;
+    while(total < size) {
+        ssize_t n = send(_sock->fd, buf + total, size - total, MSG_NOSIGNAL);
+        if(n > 0) {
+            total += n;
+        } else if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            struct pollfd pfd = { _sock->fd, POLLOUT, 0 };
+            poll(&pfd, 1, 100);
+        } else {
+            break;
+        }
+    }
+    return total;
+}
+
+// ----------------------------------------------------------------------------
+
+PosixTCPServer::PosixTCPServer(uint16_t port)
+    : _port(port) {
+}
+
+PosixTCPServer::~PosixTCPServer() {
+    close();
+}
+
+void PosixTCPServer::begin() {
+    close();
+
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(_fd < 0) {
+        return;
+    }
+
+    int flag = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(_port);
+
+    if(bind(_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(_fd, 64) != 0) {
+        ::close(_fd);
+        _fd = -1;
+        return;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(_fd, (struct sockaddr *)&addr, &len);
+    _port = ntohs(addr.sin_port);
+
+    setNonBlocking(_fd);
+}
+
+bool PosixTCPServer::hasClient() {
+    if(_fd < 0) {
+        return false;
+    }
+    struct pollfd pfd = { _fd, POLLIN, 0 };
+    return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+PosixTCPClient PosixTCPServer::accept() {
+    if(_fd < 0) {
+        return PosixTCPClient();
+    }
+    int fd = ::accept(_fd, NULL, NULL);
+    return PosixTCPClient(fd);
+}
+
+void PosixTCPServer::close() {
+    if(_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * @file PosixTCP.h
+ * @date 19.10.2026
+ *
+ * WEBSOCKETS_NETWORK_CLASS / WEBSOCKETS_NETWORK_SERVER_CLASS implementation
+ * on top of POSIX sockets, used by the host test build (NETWORK_POSIX).
+ * the interface follows the WiFiClient / WiFiServer API the library uses.
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#ifndef HOST_POSIXTCP_H_
+#define HOST_POSIXTCP_H_
+
+#include <memory>
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+#ifndef POSIXTCP_RX_BUFFER_SIZE
+#define POSIXTCP_RX_BUFFER_SIZE (4096)
+#endif
+
+struct PosixTCPSocket;
+
+class PosixTCPClient : public Stream {
+  public:
+    PosixTCPClient();
+    explicit PosixTCPClient(int fd);
+    virtual ~PosixTCPClient();
+
+    int connect(const char * host, uint16_t port);
+    int connect(const char * host, uint16_t port, int32_t timeout);
+
+    uint8_t connected();
+    void stop();
+    void setNoDelay(bool nodelay);
+    IPAddress remoteIP() const;
+    int fd() const;
+
+    virtual int available();
+    virtual int read();
+    virtual int read(uint8_t * buf, size_t size);
+    virtual int peek();
+
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t * buf, size_t size);
+    using Print::write;
+
+    virtual void flush() {}
+
+    explicit operator bool() {
+        return connected();
+    }
+
+  private:
+    std::shared_ptr<PosixTCPSocket> _sock;
+
+    bool fill();
+};
+
+class PosixTCPServer {
+  public:
+    explicit PosixTCPServer(uint16_t port);
+    ~PosixTCPServer();
+
+    void begin();
+    bool hasClient();
+    PosixTCPClient accept();
+    void close();
+    void end() {
+        close();
+    }
+    void stop() {
+        close();
+    }
+
+    uint16_t port() const {
+        return _port;
+    }
+
+  private:
+    uint16_t _port;
+    int _fd = -1;
+};
+
+#endif /* HOST_POSIXTCP_H_ */
@@ -0,0 +1,94 @@
+/**
+ * @file Print.h
+ * @date 19.10.2026
+ *
+ * minimal Arduino Print / Stream for the host test build of the WebSockets library.
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#ifndef HOST_PRINT_H_
+#define HOST_PRINT_H_
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "WString.h"
+
+class Print {
+  public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t * buffer, size_t size) {
+        size_t n = 0;
+        while(size--) {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+    size_t write(const char * str) {
+        if(str == NULL) {
+            return 0;
+        }
+        return write((const uint8_t *)str, strlen(str));
+    }
+    size_t write(const char * buffer, size_t size) {
+        return write((const uint8_t *)buffer, size);
+    }
+
+    size_t print(const char * str) {
+        return write(str);
+    }
+    size_t print(const String & s) {
+        return write((const uint8_t *)s.c_str(), s.length());
+    }
+    size_t print(char c) {
+        return write((uint8_t)c);
+    }
+    size_t println(void) {
+        return write("\r\n");
+    }
+    template <typename T>
+    size_t println(const T & value) {
+        size_t n = print(value);
+        return n + println();
+    }
+
+    size_t printf(const char * format, ...) __attribute__((format(printf, 2, 3)));
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read()      = 0;
+    virtual int peek()      = 0;
+
+    void setTimeout(unsigned long timeout) {
+        _timeout = timeout;
+    }
+    unsigned long getTimeout(void) {
+        return _timeout;
+    }
+
+    size_t readBytes(char * buffer, size_t length);
+    size_t readBytes(uint8_t * buffer, size_t length) {
+        return readBytes((char *)buffer, length);
+    }
+    String readStringUntil(char terminator);
+
+  protected:
+    int timedRead();
+    unsigned long _timeout = 1000;
+};
+
+#endif /* HOST_PRINT_H_ */
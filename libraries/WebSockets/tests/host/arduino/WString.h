@@ -0,0 +1,194 @@
+/**
+ * @file WString.h
+ * @date 19.10.2026
+ *
+ * minimal Arduino String for the host test build of the WebSockets library.
+ * only implements what the library and the tests need.
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#ifndef HOST_WSTRING_H_
+#define HOST_WSTRING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+
+#define F(var) (var)
+
+class String {
+  public:
+    String() {}
+    String(const char * cstr) {
+        if(cstr) {
+            _s = cstr;
+        }
+    }
+    String(const String & other) = default;
+    String(String && other)      = default;
+    String(const std::string & s)
+        : _s(s) {}
+    explicit String(char c)
+        : _s(1, c) {}
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+    explicit String(T value)
+        : _s(std::to_string(value)) {}
+
+    String & operator=(const String & other) = default;
+    String & operator=(String && other)      = default;
+    String & operator=(const char * cstr) {
+        _s = cstr ? cstr : "";
+        return *this;
+    }
+
+    const char * c_str() const {
+        return _s.c_str();
+    }
+    unsigned int length() const {
+        return _s.length();
+    }
+    bool reserve(unsigned int size) {
+        _s.reserve(size);
+        return true;
+    }
+
+    char operator[](unsigned int index) const {
+        return index < _s.length() ? _s[index] : 0;
+    }
+    char & operator[](unsigned int index) {
+        return _s[index];
+    }
+    char charAt(unsigned int index) const {
+        return (*this)[index];
+    }
+
+    bool concat(const String & s) {
+        _s += s._s;
+        return true;
+    }
+    bool concat(const char * cstr) {
+        if(cstr) {
+            _s += cstr;
+        }
+        return true;
+    }
+    bool concat(char c) {
+        _s += c;
+        return true;
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+    bool concat(T value) {
+        _s += std::to_string(value);
+        return true;
+    }
+
+    template <typename T>
+    String & operator+=(const T & value) {
+        concat(value);
+        return *this;
+    }
+
+    bool equals(const String & s) const {
+        return _s == s._s;
+    }
+    bool equals(const char * cstr) const {
+        return _s == (cstr ? cstr : "");
+    }
+    bool equalsIgnoreCase(const String & s) const;
+    bool startsWith(const String & prefix) const {
+        return _s.compare(0, prefix._s.length(), prefix._s) == 0;
+    }
+    bool endsWith(const String & suffix) const {
+        return _s.length() >= suffix._s.length() && _s.compare(_s.length() - suffix._s.length(), suffix._s.length(), suffix._s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t p = _s.find(c, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    int indexOf(const String & s, unsigned int from = 0) const {
+        size_t p = _s.find(s._s, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    int lastIndexOf(char c) const {
+        size_t p = _s.rfind(c);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+
+    String substring(unsigned int from) const {
+        return from >= _s.length() ? String() : String(_s.substr(from));
+    }
+    String substring(unsigned int from, unsigned int to) const;
+
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1) {
+        if(index < _s.length()) {
+            _s.erase(index, count);
+        }
+    }
+    void replace(const String & find, const String & replace);
+    void trim();
+    void toLowerCase();
+    void toUpperCase();
+    long toInt() const;
+
+    explicit operator bool() const {
+        return true;
+    }
+
+    friend bool operator==(const String & a, const String & b) {
+        return a._s == b._s;
+    }
+    friend bool operator==(const String & a, const char * b) {
+        return a.equals(b);
+    }
+    friend bool operator!=(const String & a, const String & b) {
+        return a._s != b._s;
+    }
+    friend bool operator!=(const String & a, const char * b) {
+        return !a.equals(b);
+    }
+
+  private:
+    std::string _s;
+};
+
+inline String operator+(const String & a, const String & b) {
+    String r(a);
+    r.concat(b);
+    return r;
+}
+
+inline String operator+(const String & a, const char * b) {
+    String r(a);
+    r.concat(b);
+    return r;
+}
+
+inline String operator+(const char * a, const String & b) {
+    String r(a);
+    r.concat(b);
+    return r;
+}
+
+inline String operator+(const String & a, char b) {
+    String r(a);
+    r.concat(b);
+    return r;
+}
+
+template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+inline String operator+(const String & a, T b) {
+    String r(a);
+    r.concat(b);
+    return r;
+}
+
+#endif /* HOST_WSTRING_H_ */
@@ -0,0 +1,859 @@
+/**
+ * @file bench_loopback.cpp
+ * @date 19.10.2026
+ *
+ * WebSocketsServer <-> WebSocketsClient benchmark over localhost
+ *
+ *  - handshake latency and its phases (client getConnectTiming)
+ *  - server handshakes/s and heap allocations per handshake (raw socket client)
+ *  - messages/s and MB/s for text and binary frames (client -> server)
+ *  - cost of sending one message in fragments
+ *  - reassembly of 64 KB messages in 1 KB frames: String in the application against enableReassembly
+ *  - broadcast fan-out (server -> n clients)
+ *  - receive buffer pool: server allocations per message and heap fragmentation (glibc)
+ *  - send path: allocations per message of the client (masked copy) and the server
+ *  - outbound coalescing: TCP segments per small message with and without enableCoalescing (Linux)
+ *  - UTF-8 validation: unmask + validate of ASCII heavy JSON against the plain unmask loop
+ *  - Socket.IO event dispatch: SocketIOclient::on() router against deserializeJson in onEvent (ArduinoJson)
+ *
+ * both ends run in one thread, the numbers include the work of both sides.
+ * run with --quick for a short smoke run.
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/tcp.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <new>
+#include <string>
+
+#ifdef HOST_ARDUINOJSON
+#include <ArduinoJson.h>
+#endif
+
+#include "loopback.h"
+
+extern "C" {
+#include "libutf8/utf8.h"
+}
+
+// heap allocations: operator new (String on the host) and malloc / realloc (linked with --wrap on Linux)
+static size_t allocations = 0;
+
+#ifdef BENCH_WRAP_MALLOC
+extern "C" {
+void * __real_malloc(size_t size);
+void * __real_realloc(void * ptr, size_t size);
+
+void * __wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void * __wrap_realloc(void * ptr, size_t size) {
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+}
+#define BENCH_MALLOC(size) __real_malloc(size)
+#else
+#define BENCH_MALLOC(size) malloc(size)
+#endif
+
+void * operator new(size_t size) {
+    allocations++;
+    void * ptr = BENCH_MALLOC(size ? size : 1);
+    if(!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void * operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void * ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void * ptr, size_t) noexcept {
+    free(ptr);
+}
+
+// messages send before waiting for the receiver to catch up
+#define BENCH_WINDOW (32)
+
+static bool quick = false;
+
+static std::string pattern(size_t length) {
+    std::string s(length, ' ');
+    for(size_t i = 0; i < length; i++) {
+        s[i] = 'a' + (i * 7 + i / 13) % 26;
+    }
+    return s;
+}
+
+static void report(const char * name, size_t length, int count, unsigned long us) {
+    double seconds = us / 1000000.0;
+    double rate    = seconds > 0 ? count / seconds : 0;
+    printf("%-28s %6zu byte %8d msg %10.0f msg/s %8.2f MB/s\n", name, length, count, rate, rate * length / (1024.0 * 1024.0));
+}
+
+static bool benchHandshake() {
+    const int count = quick ? 5 : 200;
+
+    LoopbackServer server;
+    server.begin();
+
+    unsigned long total = 0;
+    unsigned long best  = (unsigned long)-1;
+    unsigned long worst = 0;
+
+    // client side phases (getConnectTiming)
+    unsigned long dns     = 0;
+    unsigned long connect = 0;
+    unsigned long upgrade = 0;
+
+    for(int i = 0; i < count; i++) {
+        LoopbackClient client;
+        bool connected = false;
+        client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+            if(t == WStype_CONNECTED) {
+                connected = true;
+            }
+        });
+
+        unsigned long start = micros();
+        connectClient(server, client);
+        if(!pump(server, { &client }, [&]() { return connected && server.connectedClients() == 1; })) {
+            printf("handshake timeout\n");
+            return false;
+        }
+        unsigned long us = micros() - start;
+
+        total += us;
+        best  = std::min(best, us);
+        worst = std::max(worst, us);
+
+        const WSconnectTiming_t & timing = client.getConnectTiming();
+        dns += timing.dns;
+        connect += timing.connect;
+        upgrade += timing.upgrade;
+
+        client.disconnect();
+        pump(server, {}, [&]() { return server.connectedClients() == 0; });
+    }
+
+    printf("%-28s %6d runs  avg %6lu us  min %6lu us  max %6lu us\n", "handshake", count, total / count, best, worst);
+    printf("%-28s dns %6lu us  connect %6lu us  upgrade %6lu us\n", "handshake phases (avg)", dns / count, connect / count, upgrade / count);
+    server.close();
+    return true;
+}
+
+// request head as send by a browser
+static const char browserRequest[] =
+    "GET /ws HTTP/1.1\r\n"
+    "Host: 127.0.0.1:81\r\n"
+    "Connection: Upgrade\r\n"
+    "Pragma: no-cache\r\n"
+    "Cache-Control: no-cache\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+    "Upgrade: websocket\r\n"
+    "Origin: http://127.0.0.1\r\n"
+    "Sec-WebSocket-Version: 13\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+    "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n"
+    "\r\n";
+
+static bool benchServerHandshake() {
+    const int count = quick ? 5 : 2000;
+
+    LoopbackServer server;
+    server.begin();
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(server.port());
+
+    size_t allocationsTotal = 0;
+    unsigned long start     = micros();
+
+    for(int i = 0; i < count; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if(fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            printf("connect failed\n");
+            return false;
+        }
+        send(fd, browserRequest, sizeof(browserRequest) - 1, 0);
+
+        size_t before = allocations;
+        if(!pump(server, {}, [&]() { return server.connectedClients() == 1; })) {
+            printf("handshake timeout\n");
+            close(fd);
+            return false;
+        }
+        allocationsTotal += allocations - before;
+
+        char response[512];
+        if(recv(fd, response, sizeof(response), 0) <= 0 || strncmp(response, "HTTP/1.1 101", 12) != 0) {
+            printf("no 101 response\n");
+            close(fd);
+            return false;
+        }
+        close(fd);
+        pump(server, {}, [&]() { return server.connectedClients() == 0; });
+    }
+
+    unsigned long us = micros() - start;
+    printf("%-28s %6d runs  %8.0f handshakes/s  %5.1f allocations/handshake\n", "server handshake", count, count / (us / 1000000.0), (double)allocationsTotal / count);
+    server.close();
+    return true;
+}
+
+static bool benchThroughput(WStype_t type, size_t length, int fragments, bool utf8 = false) {
+    const int count = quick ? 50 : (int)std::min<size_t>(100000, std::max<size_t>(2000, (256 * 1024 * 1024) / (length * fragments)));
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::string message = pattern(length);
+    bool connected      = false;
+    int received        = 0;
+
+    if(utf8) {
+        server.enableUtf8Validation();
+    }
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == type || t == WStype_FRAGMENT_FIN) {
+            received++;
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            connected = true;
+        }
+    });
+    connectClient(server, client);
+    if(!pump(server, { &client }, [&]() { return connected && server.connectedClients() == 1; })) {
+        printf("connect timeout\n");
+        return false;
+    }
+
+    uint8_t * data      = (uint8_t *)&message[0];
+    WSopcode_t opcode   = (type == WStype_TEXT) ? WSop_text : WSop_binary;
+    size_t piece        = length / fragments;
+    unsigned long start = micros();
+
+    for(int sent = 0; sent < count;) {
+        for(int w = 0; w < BENCH_WINDOW && sent < count; w++, sent++) {
+            if(fragments <= 1) {
+                if(type == WStype_TEXT) {
+                    client.sendTXT(data, length);
+                } else {
+                    client.sendBIN(data, length);
+                }
+            } else {
+                size_t offset = 0;
+                for(int f = 0; f < fragments; f++) {
+                    size_t n = (f == fragments - 1) ? (length - offset) : piece;
+                    client.sendFragment(f == 0 ? opcode : WSop_continuation, data + offset, n, f == fragments - 1);
+                    offset += n;
+                }
+            }
+        }
+        int target = sent;
+        if(!pump(server, { &client }, [&]() { return received >= target; })) {
+            printf("receive timeout (%d / %d)\n", received, target);
+            return false;
+        }
+    }
+
+    unsigned long us = micros() - start;
+
+    char name[40];
+    if(fragments <= 1) {
+        snprintf(name, sizeof(name), "%s%s", type == WStype_TEXT ? "text" : "binary", utf8 ? " utf8" : "");
+    } else {
+        snprintf(name, sizeof(name), "%s %d fragments", type == WStype_TEXT ? "text" : "binary", fragments);
+    }
+    report(name, length, count, us);
+
+    client.disconnect();
+    server.close();
+    return true;
+}
+
+static bool benchBroadcast(int clientCount, size_t length) {
+    const int count = quick ? 20 : 2000;
+
+    LoopbackServer server;
+    std::vector<LoopbackClient> clients(clientCount);
+    std::vector<WebSocketsClient *> list;
+    std::string message = pattern(length);
+    long received       = 0;
+
+    server.begin();
+    for(LoopbackClient & client : clients) {
+        client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+            if(t == WStype_BIN) {
+                received++;
+            }
+        });
+        connectClient(server, client);
+        list.push_back(&client);
+    }
+    if(!pump(server, list, [&]() { return server.connectedClients() == clientCount; })) {
+        printf("connect timeout\n");
+        return false;
+    }
+
+    unsigned long start = micros();
+    for(int sent = 0; sent < count;) {
+        for(int w = 0; w < BENCH_WINDOW && sent < count; w++, sent++) {
+            server.broadcastBIN((const uint8_t *)message.data(), length);
+        }
+        long target = (long)sent * clientCount;
+        if(!pump(server, list, [&]() { return received >= target; })) {
+            printf("receive timeout (%ld / %ld)\n", received, target);
+            return false;
+        }
+    }
+    unsigned long us = micros() - start;
+
+    char name[40];
+    snprintf(name, sizeof(name), "broadcast to %d", clientCount);
+    report(name, length, count * clientCount, us);
+
+    for(LoopbackClient & client : clients) {
+        client.disconnect();
+    }
+    server.close();
+    return true;
+}
+
+/**
+ * TCP segments send on the socket (0 if unknown)
+ */
+static unsigned long segmentsOut(int fd) {
+#ifdef __linux__
+    struct tcp_info info;
+    socklen_t length = sizeof(info);
+    if(fd >= 0 && getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &length) == 0) {
+        return info.tcpi_segs_out;
+    }
+#endif
+    return 0;
+}
+
+/**
+ * small status frames send one per loop() like a sketch does, with and without coalescing
+ */
+static bool benchCoalesce(bool coalesce, size_t length) {
+    const int count = quick ? 200 : 100000;
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::string message = pattern(length);
+    bool connected      = false;
+    int received        = 0;
+
+    if(coalesce) {
+        client.enableCoalescing();
+    }
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_TEXT) {
+            received++;
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            connected = true;
+        }
+    });
+    connectClient(server, client);
+    if(!pump(server, { &client }, [&]() { return connected && server.connectedClients() == 1; })) {
+        printf("connect timeout\n");
+        return false;
+    }
+
+    unsigned long segments = segmentsOut(client.fd());
+    unsigned long start    = micros();
+
+    for(int sent = 0; sent < count; sent++) {
+        client.sendTXT(message.c_str(), length);
+        client.loop();
+        server.loop();
+    }
+    if(!pump(server, { &client }, [&]() { return received >= count; })) {
+        printf("receive timeout (%d / %d)\n", received, count);
+        return false;
+    }
+
+    unsigned long us = micros() - start;
+    segments         = segmentsOut(client.fd()) - segments;
+
+    double seconds = us / 1000000.0;
+    printf("%-28s %6zu byte %8d msg %10.0f msg/s %10.0f packets/s %6.2f packets/msg\n", coalesce ? "coalescing" : "no coalescing", length, count, count / seconds, segments / seconds,
+           (double)segments / count);
+
+    client.disconnect();
+    server.close();
+    return true;
+}
+
+static bool benchPool(bool pool) {
+    const int count = quick ? 200 : 50000;
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::string message = pattern(4096);
+    bool connected      = false;
+    int received        = 0;
+
+    server.setBufferPoolSize(pool ? WEBSOCKETS_POOL_SIZE : 0);
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_BIN) {
+            received++;
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            connected = true;
+        }
+    });
+    connectClient(server, client);
+    if(!pump(server, { &client }, [&]() { return connected && server.connectedClients() == 1; })) {
+        printf("connect timeout\n");
+        return false;
+    }
+
+    // message sizes of all pool classes, the client keeps some memory allocated in between
+    std::vector<std::string> hold;
+    randomSeed(1);
+    size_t serverAllocations = 0;
+    size_t bytes             = 0;
+    unsigned long start      = micros();
+
+    for(int sent = 0; sent < count;) {
+        for(int w = 0; w < BENCH_WINDOW && sent < count; w++, sent++) {
+            size_t length = 8 + random(3000);
+            bytes += length;
+            client.sendBIN((const uint8_t *)message.data(), length);
+            if(random(4) == 0) {
+                hold.push_back(std::string(random(200), 'h'));
+                if(hold.size() > 64) {
+                    hold.erase(hold.begin() + random(hold.size()));
+                }
+            }
+        }
+        int target          = sent;
+        unsigned long begin = millis();
+        while(received < target) {
+            if(millis() - begin > 5000) {
+                printf("receive timeout (%d / %d)\n", received, target);
+                return false;
+            }
+            size_t before = allocations;
+            server.loop();
+            serverAllocations += allocations - before;
+            client.loop();
+        }
+    }
+    unsigned long us = micros() - start;
+
+    double seconds = us / 1000000.0;
+    printf("%-28s %6zu byte %8d msg %10.0f msg/s %8.2f MB/s %6.2f server allocations/msg", pool ? "receive pool" : "receive no pool", bytes / count, count, count / seconds, bytes / seconds / (1024.0 * 1024.0), (double)serverAllocations / count);
+#ifdef __GLIBC__
+    struct mallinfo2 info = mallinfo2();
+    printf("  heap free chunks %zu (%zu byte)", info.ordblks, info.fordblks);
+#endif
+    printf("\n");
+
+    client.disconnect();
+    server.close();
+    return true;
+}
+
+/**
+ * heap allocations of the send calls, client (masked copy) and server, per message
+ */
+static bool benchSend(size_t length) {
+    const int count = quick ? 200 : 20000;
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::string message = pattern(length);
+    bool connected      = false;
+    int serverReceived  = 0;
+    int clientReceived  = 0;
+
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_BIN) {
+            serverReceived++;
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            connected = true;
+        } else if(t == WStype_BIN) {
+            clientReceived++;
+        }
+    });
+    connectClient(server, client);
+    if(!pump(server, { &client }, [&]() { return connected && server.connectedClients() == 1; })) {
+        printf("connect timeout\n");
+        return false;
+    }
+
+    size_t clientAllocations = 0;
+    size_t serverAllocations = 0;
+    for(int sent = 0; sent < count;) {
+        for(int w = 0; w < BENCH_WINDOW && sent < count; w++, sent++) {
+            size_t before = allocations;
+            client.sendBIN((const uint8_t *)message.data(), length);
+            clientAllocations += allocations - before;
+            before = allocations;
+            server.sendBIN(0, (const uint8_t *)message.data(), length);
+            serverAllocations += allocations - before;
+        }
+        int target = sent;
+        if(!pump(server, { &client }, [&]() { return serverReceived >= target && clientReceived >= target; })) {
+            printf("receive timeout (%d %d / %d)\n", serverReceived, clientReceived, target);
+            return false;
+        }
+    }
+
+    printf("%-28s %6zu byte %8d msg %6.2f client allocations/msg %6.2f server allocations/msg\n", "send", length, count, (double)clientAllocations / count,
+        (double)serverAllocations / count);
+
+    client.disconnect();
+    server.close();
+    return true;
+}
+
+/**
+ * 64 KB text messages in 1 KB frames, the server sums up the bytes of every message
+ * mode 0: the application appends the WStype_FRAGMENT_* payloads to a String
+ * mode 1: enableReassembly, WStype_MESSAGE with the part list
+ * mode 2: the same with a receive pool which holds the frames of one message
+ * mode 3: enableReassembly contiguous with that pool, WStype_TEXT
+ */
+static bool benchReassembly(int mode) {
+    const size_t length  = 64 * 1024;
+    const int fragments  = 64;
+    const int count      = quick ? 10 : 4000;
+    const char * names[] = { "reassembly String", "reassembly parts", "reassembly parts pool", "reassembly contiguous pool" };
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::string message = pattern(length);
+    bool connected      = false;
+    int received        = 0;
+    bool ok             = true;
+    uint32_t sum        = 0;
+    String assembled;
+
+    if(mode > 0) {
+        server.enableReassembly(length, mode == 3);
+    }
+    if(mode > 1) {
+        server.setBufferPoolSize(2 * length + 16 * 1024);
+    }
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        switch(t) {
+            case WStype_FRAGMENT_TEXT_START:
+                assembled = "";
+                // fallthrough
+            case WStype_FRAGMENT:
+                assembled.concat((const char *)payload);
+                break;
+            case WStype_FRAGMENT_FIN:
+                assembled.concat((const char *)payload);
+                sum = 0;
+                for(size_t i = 0; i < assembled.length(); i++) {
+                    sum += (uint8_t)assembled[i];
+                }
+                ok = ok && (assembled.length() == length);
+                received++;
+                break;
+            case WStype_MESSAGE: {
+                WSmessage_t * m = (WSmessage_t *)payload;
+                sum             = 0;
+                for(size_t p = 0; p < m->count; p++) {
+                    for(size_t i = 0; i < m->parts[p].length; i++) {
+                        sum += m->parts[p].data[i];
+                    }
+                }
+                ok = ok && (m->length == length);
+                received++;
+            } break;
+            case WStype_TEXT:
+                sum = 0;
+                for(size_t i = 0; i < len; i++) {
+                    sum += payload[i];
+                }
+                ok = ok && (len == length);
+                received++;
+                break;
+            default:
+                break;
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            connected = true;
+        }
+    });
+    connectClient(server, client);
+    if(!pump(server, { &client }, [&]() { return connected && server.connectedClients() == 1; })) {
+        printf("connect timeout\n");
+        return false;
+    }
+
+    uint8_t * data           = (uint8_t *)&message[0];
+    size_t piece             = length / fragments;
+    size_t serverAllocations = 0;
+    unsigned long start      = micros();
+
+    // a small window, the socket buffers have to hold it
+    for(int sent = 0; sent < count;) {
+        for(int w = 0; w < 4 && sent < count; w++, sent++) {
+            for(int f = 0; f < fragments; f++) {
+                client.sendFragment(f == 0 ? WSop_text : WSop_continuation, data + f * piece, piece, f == fragments - 1);
+            }
+        }
+        int target          = sent;
+        unsigned long begin = millis();
+        while(received < target) {
+            if(millis() - begin > 5000) {
+                printf("receive timeout (%d / %d)\n", received, target);
+                return false;
+            }
+            size_t before = allocations;
+            server.loop();
+            serverAllocations += allocations - before;
+            client.loop();
+        }
+    }
+    unsigned long us = micros() - start;
+
+    double seconds = us / 1000000.0;
+    printf("%-28s %6zu byte %8d msg %10.0f msg/s %8.2f MB/s %6.2f server allocations/msg\n", names[mode], length, count, count / seconds, (double)length * count / seconds / (1024.0 * 1024.0), (double)serverAllocations / count);
+
+    client.disconnect();
+    server.close();
+    if(!ok || sum == 0) {
+        printf("reassembly: wrong message\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * unmask a received JSON text, byte loop of WebSockets.cpp against utf8_unmask_validate
+ */
+static bool benchUtf8(size_t length) {
+    const int count = quick ? 20 : (int)std::max<size_t>(200, (512 * 1024 * 1024) / length);
+
+    // ASCII heavy JSON with a few 2 / 3 byte characters
+    std::string json;
+    while(json.length() < length) {
+        json += "{\"id\":1234,\"name\":\"sensor caf\xC3\xA9\",\"unit\":\"\xE2\x84\x83\",\"value\":21.5,\"ok\":true},";
+    }
+    json.resize(length);
+    while((json[json.length() - 1] & 0xC0) == 0x80 || (uint8_t)json[json.length() - 1] >= 0xC0) {
+        json.resize(json.length() - 1);
+    }
+    length = json.length();
+
+    // every pass unmasks a fresh copy of the masked frame
+    const uint8_t maskKey[4] = { 0x12, 0x9A, 0x5C, 0xE7 };
+    std::string masked       = json;
+    for(size_t i = 0; i < length; i++) {
+        masked[i] ^= maskKey[i % 4];
+    }
+    std::string buffer    = masked;
+    uint8_t * data        = (uint8_t *)&buffer[0];
+    volatile uint8_t sink = 0;
+
+    unsigned long start = micros();
+    for(int n = 0; n < count; n++) {
+        memcpy(data, masked.data(), length);
+        for(size_t i = 0; i < length; i++) {
+            data[i] = (data[i] ^ maskKey[i % 4]);
+        }
+        sink = sink + data[n % length];
+    }
+    report("unmask", length, count, micros() - start);
+
+    int invalid = 0;
+    start       = micros();
+    for(int n = 0; n < count; n++) {
+        memcpy(data, masked.data(), length);
+        if(utf8_unmask_validate(data, length, maskKey, 0, UTF8_ACCEPT) != UTF8_ACCEPT) {
+            invalid++;
+        }
+    }
+    report("unmask + utf8", length, count, micros() - start);
+
+    if(invalid || buffer != json) {
+        printf("utf8 validation failed\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * dispatch of received Socket.IO events to 8 registered events, the handler reads one argument
+ */
+static bool benchSocketIO() {
+    const int count           = quick ? 2000 : 2000000;
+    const char * const names[] = { "telemetry", "status", "config", "move", "led", "ota", "log", "time" };
+    const size_t nameCount     = sizeof(names) / sizeof(names[0]);
+
+    std::vector<std::string> packets;
+    for(const char * name : names) {
+        packets.push_back(std::string("42[\"") + name + "\",{\"t\":1700000000,\"v\":21.5,\"tags\":[\"a\",\"b\"],\"ok\":true},17]");
+    }
+    size_t length = packets[0].size();
+
+    long sum = 0;
+    LoopbackSocketIO router;
+    for(const char * name : names) {
+        router.on(name, [&](SocketIOargs & args, const SocketIOpacket_t & packet) {
+            sum += args.getInt(1);
+        });
+    }
+    unsigned long start = micros();
+    for(int n = 0; n < count; n++) {
+        std::string & packet = packets[n % nameCount];
+        router.receive((uint8_t *)&packet[0], packet.size());
+    }
+    report("socket.io router", length, count, micros() - start);
+    bool ok = (sum == 17L * count);
+
+#ifdef HOST_ARDUINOJSON
+    // what a sketch does without the router
+    sum = 0;
+    JsonDocument doc;
+    LoopbackSocketIO generic;
+    generic.onEvent([&](socketIOmessageType_t type, uint8_t * payload, size_t len) {
+        if(type != sIOtype_EVENT || deserializeJson(doc, (const char *)payload, len)) {
+            return;
+        }
+        const char * name = doc[0];
+        for(size_t i = 0; i < nameCount; i++) {
+            if(strcmp(name, names[i]) == 0) {
+                sum += doc[2].as<long>();
+                break;
+            }
+        }
+    });
+    start = micros();
+    for(int n = 0; n < count; n++) {
+        std::string & packet = packets[n % nameCount];
+        generic.receive((uint8_t *)&packet[0], packet.size());
+    }
+    report("socket.io deserializeJson", length, count, micros() - start);
+    ok = ok && (sum == 17L * count);
+#endif
+
+    if(!ok) {
+        printf("socket.io dispatch failed\n");
+    }
+    return ok;
+}
+
+int main(int argc, char ** argv) {
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        }
+    }
+
+    bool ok = benchHandshake();
+    ok      = ok && benchServerHandshake();
+
+    const size_t sizes[] = { 16, 128, 1024, 8192 };
+    for(size_t length : sizes) {
+        ok = ok && benchThroughput(WStype_TEXT, length, 1);
+    }
+    for(size_t length : sizes) {
+        ok = ok && benchThroughput(WStype_BIN, length, 1);
+    }
+
+    const int fragments[] = { 4, 16, 64 };
+    for(int n : fragments) {
+        ok = ok && benchThroughput(WStype_BIN, 8192, n);
+    }
+
+    const int fanout[] = { 1, 4, WEBSOCKETS_SERVER_CLIENT_MAX };
+    for(int n : fanout) {
+        ok = ok && benchBroadcast(n, 1024);
+    }
+
+    for(int mode = 0; mode < 4; mode++) {
+        ok = ok && benchReassembly(mode);
+    }
+
+    ok = ok && benchPool(false);
+    ok = ok && benchPool(true);
+
+    for(size_t length : { (size_t)16, (size_t)100, (size_t)1000, (size_t)1300 }) {
+        ok = ok && benchSend(length);
+    }
+
+    for(size_t length : { (size_t)100, (size_t)300 }) {
+        ok = ok && benchCoalesce(false, length);
+        ok = ok && benchCoalesce(true, length);
+    }
+
+    ok = ok && benchUtf8(1024);
+    ok = ok && benchUtf8(16384);
+    for(size_t length : { (size_t)1024, (size_t)8192 }) {
+        ok = ok && benchThroughput(WStype_TEXT, length, 1, false);
+        ok = ok && benchThroughput(WStype_TEXT, length, 1, true);
+    }
+
+    ok = ok && benchSocketIO();
+
+    return ok ? 0 : 1;
+}
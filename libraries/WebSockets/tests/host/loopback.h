@@ -0,0 +1,150 @@
+/**
+ * @file loopback.h
+ * @date 19.10.2026
+ *
+ * helpers for running WebSocketsServer and WebSocketsClient
+ * against each other over localhost in one thread.
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#ifndef HOST_LOOPBACK_H_
+#define HOST_LOOPBACK_H_
+
+#include <functional>
+#include <vector>
+
+#include <WebSocketsServer.h>
+#include <WebSocketsClient.h>
+#include <SocketIOclient.h>
+
+/**
+ * server bound to a free port on 127.0.0.1
+ */
+class LoopbackServer : public WebSocketsServer {
+  public:
+    explicit LoopbackServer(uint16_t port = 0)
+        : WebSocketsServer(port) {}
+
+    uint16_t port() {
+        return _server->port();
+    }
+};
+
+/**
+ * client which can send fragmented messages
+ */
+class LoopbackClient : public WebSocketsClient {
+  public:
+    /**
+     * send one frame of a fragmented message
+     * @param opcode WSopcode_t WSop_text / WSop_binary for the first frame, WSop_continuation for the rest
+     * @param payload uint8_t *
+     * @param length size_t
+     * @param fin bool true for the last frame
+     */
+    bool sendFragment(WSopcode_t opcode, uint8_t * payload, size_t length, bool fin) {
+        return sendFrame(&_client, opcode, payload, length, fin);
+    }
+
+    /**
+     * send one frame as it is, e.g. a part of a compressed message
+     * the mask key is 0, the payload is not changed
+     * @param opcode WSopcode_t
+     * @param payload const uint8_t *
+     * @param length size_t
+     * @param fin bool
+     * @param rsv1 bool  compressed message (first frame only)
+     */
+    bool sendRawFrame(WSopcode_t opcode, const uint8_t * payload, size_t length, bool fin, bool rsv1) {
+        uint8_t maskKey[4] = { 0x00, 0x00, 0x00, 0x00 };
+        uint8_t header[WEBSOCKETS_MAX_HEADER_SIZE];
+        uint8_t headerSize = createHeader(header, opcode, length, true, maskKey, fin, rsv1);
+        return write(&_client, header, headerSize) == headerSize && write(&_client, (uint8_t *)payload, length) == length;
+    }
+
+    /**
+     * connect attempts since the last connection was up and the wait before the next one
+     */
+    uint8_t reconnectAttempts() {
+        return _reconnectAttempts;
+    }
+    unsigned long reconnectWait() {
+        return _reconnectDelay;
+    }
+
+    /**
+     * socket of the connection, -1 if not connected
+     */
+    int fd() {
+        return _client.tcp ? _client.tcp->fd() : -1;
+    }
+};
+
+/**
+ * Socket.IO client which gets its messages without a connection
+ */
+class LoopbackSocketIO : public SocketIOclient {
+  public:
+    /**
+     * handle a Engine.IO text message as if it was received
+     * @param payload uint8_t *  e.g. 42["event",1], is changed like a received payload
+     * @param length size_t
+     */
+    void receive(uint8_t * payload, size_t length) {
+        handleCbEvent(WStype_TEXT, payload, length);
+    }
+
+    /**
+     * connect as a plain webSocket client, without the Engine.IO handshake over HTTP
+     * @param port uint16_t  port of the LoopbackServer
+     * @param coalesceDelay uint16_t  enableCoalescing, 0 = off
+     */
+    void beginPlain(uint16_t port, uint16_t coalesceDelay) {
+        setReconnectInterval(0);
+        if(coalesceDelay > 0) {
+            enableCoalescing(coalesceDelay);
+        }
+        WebSocketsClient::begin("127.0.0.1", port, "/");
+    }
+};
+
+/**
+ * run server and clients until done() returns true
+ * @param server LoopbackServer &
+ * @param clients std::vector<WebSocketsClient *>
+ * @param done std::function<bool()>
+ * @param timeout unsigned long ms
+ * @return true if done() returned true before the timeout
+ */
+inline bool pump(LoopbackServer & server, const std::vector<WebSocketsClient *> & clients, std::function<bool()> done, unsigned long timeout = 5000) {
+    unsigned long start = millis();
+    while(!done()) {
+        if(millis() - start > timeout) {
+            return false;
+        }
+        server.loop();
+        for(WebSocketsClient * client : clients) {
+            client->loop();
+        }
+    }
+    return true;
+}
+
+/**
+ * connect a client to the server
+ * @param server LoopbackServer &
+ * @param client WebSocketsClient &
+ */
+inline void connectClient(LoopbackServer & server, WebSocketsClient & client) {
+    client.setReconnectInterval(0);
+    client.begin("127.0.0.1", server.port(), "/");
+}
+
+#endif /* HOST_LOOPBACK_H_ */
@@ -0,0 +1,1306 @@
+/**
+ * @file test_loopback.cpp
+ * @date 19.10.2026
+ *
+ * WebSocketsServer <-> WebSocketsClient regression tests over localhost
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef HOST_ARDUINOJSON
+#include <ArduinoJson.h>
+#endif
+
+#include "loopback.h"
+
+extern "C" {
+#include "librawdeflate/rawdeflate.h"
+#include "libutf8/utf8.h"
+}
+
+static int failures = 0;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if(!(cond)) {                                                  \
+            printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                \
+        }                                                              \
+    } while(0)
+
+static std::string pattern(size_t length) {
+    std::string s(length, ' ');
+    for(size_t i = 0; i < length; i++) {
+        s[i] = 'a' + (i * 7 + i / 13) % 26;
+    }
+    return s;
+}
+
+/**
+ * client sends, server echos, client compares
+ */
+static void testEcho(const char * name, WStype_t type, size_t length, bool deflate) {
+    printf("%s\n", name);
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::string message = pattern(length);
+    std::string received;
+    bool connected      = false;
+    bool serverDeflate  = false;
+
+    if(deflate) {
+        server.enableDeflate();
+        client.enableDeflate();
+    }
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_TEXT) {
+            server.sendTXT(num, payload, len);
+        } else if(t == WStype_BIN) {
+            server.sendBIN(num, payload, len);
+        }
+        if(t == WStype_CONNECTED) {
+            serverDeflate = server.isDeflate(num);
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            connected = true;
+            if(type == WStype_TEXT) {
+                client.sendTXT(message.c_str(), message.length());
+            } else {
+                client.sendBIN((const uint8_t *)message.data(), message.length());
+            }
+        } else if(t == type) {
+            received.assign((char *)payload, len);
+        }
+    });
+    connectClient(server, client);
+
+    CHECK(pump(server, { &client }, [&]() { return !received.empty(); }));
+    CHECK(connected);
+    CHECK(received == message);
+    CHECK(serverDeflate == deflate);
+    CHECK(client.isDeflate() == deflate);
+    client.disconnect();
+    server.close();
+}
+
+/**
+ * with minSize 0 every message is a candidate for deflate, the empty one is send as it is
+ */
+static void testDeflateEmpty() {
+    printf("deflate empty message\n");
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::vector<std::string> received;
+    WSdeflateConfig_t config;
+    config.minSize = 0;
+
+    server.enableDeflate(config);
+    client.enableDeflate(config);
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_TEXT) {
+            // length 0 means strlen(payload) for sendTXT, the empty payload can be NULL
+            server.sendTXT(num, len ? (const char *)payload : "", len);
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            client.sendTXT("", 0);
+            client.sendTXT("a", 1);
+        } else if(t == WStype_TEXT) {
+            received.push_back(std::string((char *)payload, len));
+        }
+    });
+    connectClient(server, client);
+
+    CHECK(pump(server, { &client }, [&]() { return received.size() == 2; }));
+    CHECK(client.isDeflate());
+    CHECK(received == std::vector<std::string>({ "", "a" }));
+    client.disconnect();
+    server.close();
+}
+
+/**
+ * client sends a message in 4 frames, server reassembles it
+ */
+static void testFragments() {
+    printf("fragments\n");
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::string message = pattern(4000);
+    std::string received;
+    int frames  = 0;
+    bool done   = false;
+
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        switch(t) {
+            case WStype_FRAGMENT_TEXT_START:
+            case WStype_FRAGMENT:
+                received.append((char *)payload, len);
+                frames++;
+                break;
+            case WStype_FRAGMENT_FIN:
+                received.append((char *)payload, len);
+                frames++;
+                done = true;
+                break;
+            default:
+                break;
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            std::string copy = message;
+            uint8_t * data   = (uint8_t *)&copy[0];
+            client.sendFragment(WSop_text, data, 1000, false);
+            client.sendFragment(WSop_continuation, data + 1000, 1000, false);
+            client.sendFragment(WSop_continuation, data + 2000, 1000, false);
+            client.sendFragment(WSop_continuation, data + 3000, 1000, true);
+        }
+    });
+    connectClient(server, client);
+
+    CHECK(pump(server, { &client }, [&]() { return done; }));
+    CHECK(frames == 4);
+    CHECK(received == message);
+    client.disconnect();
+    server.close();
+}
+
+/**
+ * the library reassembles fragmented messages (enableReassembly)
+ * mode 0: part list, 1: contiguous, 2: too big, 3: compressed, 4: continuation without start
+ */
+static void testReassembly() {
+    for(int mode = 0; mode < 5; mode++) {
+        printf("reassembly %d\n", mode);
+
+        LoopbackServer server;
+        LoopbackClient client;
+        std::string message = pattern(4000);
+        std::string received;
+        size_t parts   = 0;
+        int fragments  = 0;
+        int messages   = 0;
+        bool adopted   = false;
+        bool closed    = false;
+
+        server.enableReassembly(mode == 2 ? 3500 : 64 * 1024, mode == 1);
+        if(mode == 3) {
+            server.enableDeflate();
+            client.enableDeflate();
+        }
+        server.begin();
+        server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+            switch(t) {
+                case WStype_MESSAGE: {
+                    WSmessage_t * m = (WSmessage_t *)payload;
+                    CHECK(m->opcode == WSop_text && m->length == len);
+                    received.clear();
+                    for(size_t i = 0; i < m->count; i++) {
+                        received.append((const char *)m->parts[i].data, m->parts[i].length);
+                    }
+                    parts = m->count;
+                    messages++;
+                } break;
+                case WStype_TEXT:
+                    received.assign((char *)payload, len);
+                    if(mode == 1 && server.adoptPayload(payload)) {
+                        adopted = true;
+                        server.releasePayload(payload);
+                    }
+                    messages++;
+                    break;
+                case WStype_FRAGMENT_TEXT_START:
+                case WStype_FRAGMENT:
+                case WStype_FRAGMENT_FIN:
+                    fragments++;
+                    break;
+                case WStype_DISCONNECTED:
+                    closed = true;
+                    break;
+                default:
+                    break;
+            }
+        });
+        client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+            if(t != WStype_CONNECTED) {
+                return;
+            }
+            std::string copy = message;
+            uint8_t * data   = (uint8_t *)&copy[0];
+            if(mode == 3) {
+                // compress the message and send it in 3 frames, rsv1 only on the first one
+                WSdeflateConfig_t config;
+                std::vector<uint8_t> work(rawdeflate_work_size(config.windowBits, config.hashBits));
+                std::vector<uint8_t> out(message.length());
+                size_t n = rawdeflate_compress_message(data, message.length(), out.data(), out.size(), config.windowBits, config.hashBits, config.maxChain, work.data());
+                CHECK(n > 10);
+                client.sendRawFrame(WSop_text, out.data(), 5, false, true);
+                client.sendRawFrame(WSop_continuation, out.data() + 5, 5, false, false);
+                client.sendRawFrame(WSop_continuation, out.data() + 10, n - 10, true, false);
+                return;
+            }
+            if(mode == 4) {
+                client.sendFragment(WSop_continuation, data, 100, true);
+                return;
+            }
+            // an empty frame in the middle, then a message in one frame
+            client.sendFragment(WSop_text, data, 1000, false);
+            client.sendFragment(WSop_continuation, data + 1000, 1000, false);
+            client.sendFragment(WSop_continuation, data + 2000, 0, false);
+            client.sendFragment(WSop_continuation, data + 3000, 1000, false);
+            client.sendFragment(WSop_continuation, data + 2000, 1000, true);
+            client.sendTXT("single");
+        });
+        connectClient(server, client);
+
+        if(mode == 2 || mode == 4) {
+            // 1009 / 1002
+            CHECK(pump(server, { &client }, [&]() { return closed; }));
+            CHECK(messages == 0 && fragments == 0);
+        } else if(mode == 3) {
+            CHECK(pump(server, { &client }, [&]() { return messages == 1; }));
+            CHECK(received == message);
+        } else {
+            std::string expected = message.substr(0, 2000) + message.substr(3000, 1000) + message.substr(2000, 1000);
+            CHECK(pump(server, { &client }, [&]() { return messages == 1; }));
+            CHECK(received == expected);
+            CHECK(parts == (mode == 0 ? 4 : 0));
+            CHECK(adopted == (mode == 1));
+            // not fragmented messages as before
+            CHECK(pump(server, { &client }, [&]() { return messages == 2; }));
+            CHECK(received == "single");
+            CHECK(fragments == 0);
+        }
+        client.disconnect();
+        server.close();
+    }
+}
+
+/**
+ * server receives a big frame in chunks
+ */
+static void testStreaming() {
+    printf("streaming\n");
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::string message = pattern(100000);
+    std::string received;
+    bool done = false;
+
+    server.enableStreaming(1000);
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_STREAM) {
+            WSstreamChunk_t * chunk = (WSstreamChunk_t *)payload;
+            CHECK(chunk->offset == received.length());
+            CHECK(chunk->total == message.length());
+            received.append((char *)chunk->data, chunk->length);
+            done = chunk->fin && (chunk->offset + chunk->length == chunk->total);
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            client.sendBIN((const uint8_t *)message.data(), message.length());
+        }
+    });
+    connectClient(server, client);
+
+    CHECK(pump(server, { &client }, [&]() { return done; }));
+    CHECK(received == message);
+    client.disconnect();
+    server.close();
+}
+
+/**
+ * server keeps the received payloads (adoptPayload) and gives them back later
+ */
+static void testAdoptPayload() {
+    printf("adopt payload\n");
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::vector<std::string> messages = { pattern(10), pattern(300), pattern(5000) };
+    std::vector<uint8_t *> kept;
+    std::vector<size_t> lengths;
+
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_TEXT) {
+            CHECK(server.adoptPayload(payload));
+            // only the payload of the running event
+            CHECK(!server.adoptPayload(payload + 1));
+            kept.push_back(payload);
+            lengths.push_back(len);
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            for(const std::string & message : messages) {
+                client.sendTXT(message.c_str(), message.length());
+            }
+        }
+    });
+    connectClient(server, client);
+
+    CHECK(pump(server, { &client }, [&]() { return kept.size() == messages.size(); }));
+    for(size_t i = 0; i < kept.size() && i < messages.size(); i++) {
+        CHECK(std::string((char *)kept[i], lengths[i]) == messages[i]);
+        server.releasePayload(kept[i]);
+    }
+
+    client.disconnect();
+    server.close();
+}
+
+/**
+ * server broadcasts to all connected clients
+ */
+static void testBroadcast() {
+    printf("broadcast\n");
+
+    const int count = 4;
+    LoopbackServer server;
+    LoopbackClient clients[count];
+    std::vector<WebSocketsClient *> list;
+    int received = 0;
+
+    server.begin();
+    for(int i = 0; i < count; i++) {
+        clients[i].onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+            if(t == WStype_TEXT && std::string((char *)payload, len) == "hello") {
+                received++;
+            }
+        });
+        connectClient(server, clients[i]);
+        list.push_back(&clients[i]);
+    }
+
+    CHECK(pump(server, list, [&]() { return server.connectedClients() == count; }));
+    server.broadcastTXT("hello");
+    CHECK(pump(server, list, [&]() { return received == count; }));
+
+    for(int i = 0; i < count; i++) {
+        clients[i].disconnect();
+    }
+    server.close();
+}
+
+/**
+ * send a request head with a raw socket (in parts) and return the status line of the response
+ */
+static std::string rawHandshake(LoopbackServer & server, const std::vector<std::string> & parts) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(server.port());
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        return "";
+    }
+
+    for(const std::string & part : parts) {
+        send(fd, part.data(), part.length(), MSG_NOSIGNAL);
+        // let the server see every part on its own
+        unsigned long start = millis();
+        while(millis() - start < 5) {
+            server.loop();
+        }
+    }
+
+    std::string response;
+    pump(server, {}, [&]() {
+        char buf[512];
+        ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if(n > 0) {
+            response.append(buf, n);
+        }
+        return response.find("\r\n") != std::string::npos;
+    });
+    close(fd);
+    pump(server, {}, [&]() { return server.connectedClients() == 0; });
+
+    return response.substr(0, response.find("\r\n"));
+}
+
+/**
+ * HTTP request head parser of the server
+ */
+static void testRequestHead() {
+    printf("request head\n");
+
+    LoopbackServer server;
+    server.begin();
+
+    std::string head =
+        "GET /ws HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "connection: keep-alive, Upgrade\r\n"
+        "UPGRADE: WebSocket\r\n"
+        "Cookie: " + std::string(1000, 'c') + "\r\n"
+        "sec-websocket-version: 13\r\n"
+        "Sec-WebSocket-Key:   dGhlIHNhbXBsZSBub25jZQ==  \r\n"
+        "\r\n";
+
+    // in one part, byte by byte split over two lines, case insensitive names, long unused header
+    CHECK(rawHandshake(server, { head }) == "HTTP/1.1 101 Switching Protocols");
+    CHECK(rawHandshake(server, { head.substr(0, 20), head.substr(20, 7), head.substr(27) }) == "HTTP/1.1 101 Switching Protocols");
+
+    // missing key
+    CHECK(rawHandshake(server, { "GET / HTTP/1.1\r\nConnection: Upgrade\r\nUpgrade: websocket\r\nSec-WebSocket-Version: 13\r\n\r\n" }) == "HTTP/1.1 400 Bad Request");
+
+    // URL does not fit into the line buffer
+    CHECK(rawHandshake(server, { "GET /" + std::string(WEBSOCKETS_HTTP_LINE_SIZE, 'u') + " HTTP/1.1\r\n\r\n" }) == "HTTP/1.1 431 Request Header Fields Too Large");
+
+    // a cut value of a needed header is not used
+    std::string protocol = head;
+    protocol.insert(protocol.find("Cookie"), "Sec-WebSocket-Protocol: " + std::string(WEBSOCKETS_HTTP_LINE_SIZE, 'p') + "\r\n");
+    CHECK(rawHandshake(server, { protocol }) == "HTTP/1.1 431 Request Header Fields Too Large");
+
+    // one line buffer: the second client waits until the first one ends its line
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(server.port());
+    int fds[2];
+    for(int & fd : fds) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        CHECK(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    }
+    send(fds[0], head.data(), 30, MSG_NOSIGNAL);
+    pump(server, {}, [&]() { return server.connectedClients() == 2; }, 100);
+    send(fds[1], head.data(), head.length(), MSG_NOSIGNAL);
+    send(fds[0], head.data() + 30, head.length() - 30, MSG_NOSIGNAL);
+    for(int fd : fds) {
+        std::string response;
+        pump(server, {}, [&]() {
+            char buf[512];
+            ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+            if(n > 0) {
+                response.append(buf, n);
+            }
+            return response.find("\r\n") != std::string::npos;
+        });
+        CHECK(response.substr(0, response.find("\r\n")) == "HTTP/1.1 101 Switching Protocols");
+        close(fd);
+    }
+    pump(server, {}, [&]() { return server.connectedClients() == 0; });
+
+    // head too large
+    std::string big = "GET / HTTP/1.1\r\n";
+    while(big.length() <= WEBSOCKETS_MAX_HTTP_HEAD_SIZE) {
+        big += "X-Padding: " + std::string(100, 'p') + "\r\n";
+    }
+    CHECK(rawHandshake(server, { big }) == "HTTP/1.1 431 Request Header Fields Too Large");
+
+    server.close();
+}
+
+/**
+ * validator against known sequences, split at every position and masked at every offset
+ */
+static void testUtf8Validator() {
+    printf("utf8 validator\n");
+
+    struct {
+        const char * data;
+        bool valid;
+    } cases[] = {
+        { "plain ascii text, long enough for a few words", true },
+        { "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 \xF4\x8F\xBF\xBF \xEF\xBF\xBF", true },
+        { "\xED\x9F\xBF \xEE\x80\x80 \xE0\xA0\x80 \xF0\x90\x80\x80", true },
+        { "abc\xC0\xAF", false },            // overlong '/'
+        { "abc\xE0\x80\xAF", false },        // overlong 3 byte
+        { "abc\xF0\x80\x80\xAF", false },    // overlong 4 byte
+        { "abc\xED\xA0\x80", false },        // surrogate
+        { "abc\xF4\x90\x80\x80", false },    // > U+10FFFF
+        { "abc\xF5\x80\x80\x80", false },
+        { "abc\xFF", false },
+        { "abc\x80", false },                // lone continuation
+        { "abcdefghijklmnop\xC3\x28", false },
+        { "abc\xE2\x82", false },            // truncated
+    };
+
+    const uint8_t maskKey[4] = { 0x12, 0x9A, 0x5C, 0xE7 };
+
+    for(auto & c : cases) {
+        std::string text(c.data);
+        // long ASCII runs around the sequence for the word / SIMD path
+        for(const std::string & data : { text, pattern(37) + text, text + pattern(41) }) {
+            bool valid = c.valid;
+            for(size_t split = 0; split <= data.length(); split++) {
+                uint8_t state = utf8_validate((const uint8_t *)data.data(), split, UTF8_ACCEPT);
+                state         = utf8_validate((const uint8_t *)data.data() + split, data.length() - split, state);
+                CHECK((state == UTF8_ACCEPT) == valid);
+            }
+            for(size_t offset = 0; offset < 4; offset++) {
+                std::string masked = data;
+                for(size_t i = 0; i < masked.length(); i++) {
+                    masked[i] ^= maskKey[(offset + i) & 3];
+                }
+                uint8_t state = utf8_unmask_validate((uint8_t *)&masked[0], masked.length(), maskKey, offset, UTF8_ACCEPT);
+                CHECK((state == UTF8_ACCEPT) == valid);
+                if(valid) {
+                    CHECK(masked == data);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * text split inside UTF-8 sequences over frames (and chunks) is accepted,
+ * invalid text closes the connection
+ */
+static void testUtf8(const char * name, size_t chunkSize, bool deflate) {
+    printf("%s\n", name);
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::string message = "h\xC3\xA9llo \xF0\x9F\x98\x80 caf\xC3\xA9 " + pattern(100);
+    std::string invalid = pattern(2000) + "\xED\xA0\x80";
+    std::string received;
+    bool done             = false;
+    bool invalidDelivered = false;
+    bool serverClosed     = false;
+    bool clientClosed     = false;
+
+    server.enableUtf8Validation();
+    if(chunkSize) {
+        server.enableStreaming(chunkSize);
+    }
+    if(deflate) {
+        server.enableDeflate();
+        client.enableDeflate();
+    }
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        bool last = false;
+        switch(t) {
+            case WStype_TEXT:
+            case WStype_FRAGMENT_FIN:
+                last = true;
+                // fallthrough
+            case WStype_FRAGMENT_TEXT_START:
+            case WStype_FRAGMENT:
+                if(!done) {
+                    received.append((char *)payload, len);
+                }
+                break;
+            case WStype_STREAM: {
+                WSstreamChunk_t * chunk = (WSstreamChunk_t *)payload;
+                last                    = chunk->fin && (chunk->offset + chunk->length == chunk->total);
+                if(!done) {
+                    received.append((char *)chunk->data, chunk->length);
+                }
+            } break;
+            case WStype_DISCONNECTED:
+                serverClosed = true;
+                break;
+            default:
+                break;
+        }
+        if(last) {
+            invalidDelivered = done;
+            done             = true;
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            std::string copy = message;
+            uint8_t * data   = (uint8_t *)&copy[0];
+            // split after the first byte of a 2 and the second byte of a 4 byte sequence
+            client.sendFragment(WSop_text, data, 2, false);
+            client.sendFragment(WSop_continuation, data + 2, 10, false);
+            client.sendFragment(WSop_continuation, data + 12, copy.length() - 12, true);
+            client.sendTXT(invalid.c_str(), invalid.length());
+        } else if(t == WStype_DISCONNECTED) {
+            clientClosed = true;
+        }
+    });
+    connectClient(server, client);
+
+    CHECK(pump(server, { &client }, [&]() { return serverClosed && clientClosed; }));
+    CHECK(done);
+    CHECK(received == message);
+    CHECK(!invalidDelivered);
+    client.disconnect();
+    server.close();
+}
+
+/**
+ * small frames are collected and written together, control frames keep their order
+ */
+static void testCoalescing() {
+    printf("coalescing\n");
+
+    LoopbackServer server;
+    LoopbackClient client;
+    std::string serverReceived;
+    std::string clientReceived;
+    std::string expected;
+    for(int i = 0; i < 40; i++) {
+        expected += "status " + std::to_string(i) + " " + pattern(100) + "|";
+    }
+    int pings = 0;
+
+    server.enableCoalescing(20);
+    client.enableCoalescing(20, 512);
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            for(int i = 0; i < 40; i++) {
+                std::string msg = "status " + std::to_string(i) + " " + pattern(100) + "|";
+                server.sendTXT(num, msg.c_str(), msg.length());
+                if(i == 19) {
+                    server.sendPing(num);
+                }
+            }
+        } else if(t == WStype_TEXT) {
+            serverReceived.append((char *)payload, len);
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_TEXT) {
+            clientReceived.append((char *)payload, len);
+            // echo, the client collects them too
+            client.sendTXT(payload, len);
+        } else if(t == WStype_PING) {
+            // the server pings after the handshake, the second ping follows the first 20 frames
+            if(++pings == 2) {
+                CHECK(clientReceived.length() == expected.find("status 20 "));
+            }
+        }
+    });
+    connectClient(server, client);
+
+    CHECK(pump(server, { &client }, [&]() { return serverReceived.length() == expected.length(); }));
+    CHECK(pings == 2);
+    CHECK(clientReceived == expected);
+    CHECK(serverReceived == expected);
+    client.disconnect();
+    server.close();
+}
+
+/**
+ * a local port nobody listens on
+ */
+static uint16_t freePort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    socklen_t size = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    getsockname(fd, (struct sockaddr *)&addr, &size);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+/**
+ * loop() does not block while the client connects, phase timing is set
+ */
+static void testConnect() {
+    printf("connect\n");
+
+    // unroutable address, the connect hangs (or fails at once without network)
+    {
+        WebSocketsClient client;
+        client.setReconnectInterval(0);
+        client.begin("10.255.255.1", 81, "/");
+
+        unsigned long worst = 0;
+        unsigned long start = millis();
+        while(millis() - start < 600) {
+            unsigned long t = micros();
+            client.loop();
+            worst = std::max(worst, micros() - t);
+        }
+        CHECK(!client.isConnected());
+        CHECK(worst < 250000);    // a blocking connect waits WEBSOCKETS_TCP_TIMEOUT
+        client.disconnect();
+    }
+
+    // closed port, the connect fails without an event
+    {
+        WebSocketsClient client;
+        bool event = false;
+        client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+            event = true;
+        });
+        client.setReconnectInterval(0);
+        client.begin("127.0.0.1", freePort(), "/");
+        for(int i = 0; i < 100; i++) {
+            client.loop();
+        }
+        CHECK(!client.isConnected());
+        CHECK(!event);
+    }
+
+    // IPv6 address, the TCP connect is accepted (skipped without IPv6)
+    {
+        int listener = socket(AF_INET6, SOCK_STREAM, 0);
+        struct sockaddr_in6 addr;
+        socklen_t size = sizeof(addr);
+        memset(&addr, 0, sizeof(addr));
+        addr.sin6_family = AF_INET6;
+        addr.sin6_addr   = in6addr_loopback;
+        if(listener >= 0 && bind(listener, (struct sockaddr *)&addr, sizeof(addr)) == 0 && listen(listener, 1) == 0) {
+            getsockname(listener, (struct sockaddr *)&addr, &size);
+            fcntl(listener, F_SETFL, fcntl(listener, F_GETFL, 0) | O_NONBLOCK);
+            WebSocketsClient client;
+            client.setReconnectInterval(0);
+            client.begin("::1", ntohs(addr.sin6_port), "/");
+            int fd              = -1;
+            unsigned long start = millis();
+            while(fd < 0 && millis() - start < 1000) {
+                client.loop();
+                fd = accept(listener, NULL, NULL);
+            }
+            CHECK(fd >= 0);
+            if(fd >= 0) {
+                close(fd);
+            }
+            client.disconnect();
+        }
+        if(listener >= 0) {
+            close(listener);
+        }
+    }
+
+    // server up, all phases are measured
+    {
+        LoopbackServer server;
+        LoopbackClient client;
+        bool connected = false;
+
+        server.begin();
+        client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+            if(t == WStype_CONNECTED) {
+                connected = true;
+            }
+        });
+        connectClient(server, client);
+
+        CHECK(pump(server, { &client }, [&]() { return connected; }));
+        const WSconnectTiming_t & timing = client.getConnectTiming();
+        CHECK(timing.upgrade > 0);
+        CHECK(timing.tls == 0);
+        CHECK(timing.total >= timing.dns + timing.connect + timing.upgrade);
+
+        // the adopted socket has the options of a normal connect
+        int value       = 0;
+        socklen_t size  = sizeof(value);
+        struct timeval to;
+        socklen_t toSize = sizeof(to);
+        CHECK(getsockopt(client.fd(), IPPROTO_TCP, TCP_NODELAY, &value, &size) == 0 && value);
+        CHECK(getsockopt(client.fd(), SOL_SOCKET, SO_KEEPALIVE, &value, &size) == 0 && value);
+        CHECK(getsockopt(client.fd(), SOL_SOCKET, SO_SNDTIMEO, &to, &toSize) == 0 && to.tv_sec == WEBSOCKETS_TCP_TIMEOUT / 1000);
+        client.disconnect();
+        server.close();
+    }
+}
+
+/**
+ * the reconnect wait doubles up to the limit, jitter stays in range, a connection resets it
+ */
+static void testReconnectBackoff() {
+    printf("reconnect backoff\n");
+
+    for(uint8_t jitter : { (uint8_t)0, (uint8_t)50 }) {
+        // closed port until the server is started
+        uint16_t port = freePort();
+        LoopbackServer server(port);
+        LoopbackClient client;
+        std::vector<unsigned long> waits;
+        bool connected = false;
+
+        client.setReconnectInterval(10);
+        client.setReconnectBackoff(160, jitter);
+        client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+            if(t == WStype_CONNECTED) {
+                connected = true;
+            }
+        });
+        client.begin("127.0.0.1", port, "/");
+
+        uint8_t attempts    = 0;
+        unsigned long start = millis();
+        while(millis() - start < 700) {
+            client.loop();
+            if(client.reconnectAttempts() != attempts) {
+                attempts = client.reconnectAttempts();
+                waits.push_back(client.reconnectWait());
+            }
+        }
+
+        CHECK(waits.size() >= 5);
+        unsigned long expected = 10;
+        for(unsigned long wait : waits) {
+            CHECK(wait <= expected);
+            CHECK(wait >= expected - (expected * jitter) / 100);
+            expected = std::min(expected * 2, 160UL);
+        }
+
+        server.begin();
+        CHECK(pump(server, { &client }, [&]() { return connected; }, 2000));
+        CHECK(client.reconnectAttempts() == 0);
+        CHECK(client.reconnectWait() <= 10);
+        client.disconnect();
+        server.close();
+    }
+}
+
+/**
+ * begin() again closes the connection of the last one before it connects
+ */
+static void testRebegin() {
+    printf("begin again\n");
+
+    uint16_t port = freePort();
+    LoopbackServer server(port);
+    server.begin();
+    LoopbackClient client;
+    int connects    = 0;
+    int disconnects = 0;
+
+    client.setReconnectInterval(10);
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_CONNECTED) {
+            connects++;
+        } else if(t == WStype_DISCONNECTED) {
+            disconnects++;
+        }
+    });
+    client.begin("127.0.0.1", port, "/");
+    CHECK(pump(server, { &client }, [&]() { return connects == 1; }, 2000));
+    int fd = client.fd();
+
+    client.begin("127.0.0.1", port, "/");
+    CHECK(disconnects == 1);
+    CHECK(fcntl(fd, F_GETFD) == -1 || client.fd() != fd);
+    CHECK(pump(server, { &client }, [&]() { return connects == 2; }, 2000));
+    CHECK(pump(server, { &client }, [&]() { return server.connectedClients() == 1; }, 2000));
+
+    client.disconnect();
+    server.close();
+}
+
+/**
+ * Socket.IO packet header, lazy arguments and the event router
+ */
+static void testSocketIO() {
+    printf("socket.io events\n");
+
+    struct {
+        const char * text;
+        socketIOmessageType_t type;
+        const char * nsp;
+        int32_t ackId;
+        uint8_t attachments;
+        const char * data;
+    } packets[] = {
+        { "2[\"chat\",1]", sIOtype_EVENT, "/", -1, 0, "[\"chat\",1]" },
+        { "2/admin,12[\"chat\"]", sIOtype_EVENT, "/admin", 12, 0, "[\"chat\"]" },
+        { "51-/up,[\"file\",{\"_placeholder\":true,\"num\":0}]", sIOtype_BINARY_EVENT, "/up", -1, 1, "[\"file\",{\"_placeholder\":true,\"num\":0}]" },
+        { "37[\"ok\"]", sIOtype_ACK, "/", 7, 0, "[\"ok\"]" },
+        { "1/admin", sIOtype_DISCONNECT, "/admin", -1, 0, "" },
+        { "0", sIOtype_CONNECT, "/", -1, 0, "" },
+    };
+    for(auto & expected : packets) {
+        SocketIOpacket_t packet;
+        CHECK(SocketIOargs::parsePacket((const uint8_t *)expected.text, strlen(expected.text), &packet));
+        CHECK(packet.type == expected.type);
+        CHECK(std::string(packet.nsp, packet.nspLength) == expected.nsp);
+        CHECK(packet.ackId == expected.ackId);
+        CHECK(packet.attachments == expected.attachments);
+        CHECK(std::string(packet.data, packet.length) == expected.data);
+    }
+    SocketIOpacket_t packet;
+    CHECK(!SocketIOargs::parsePacket((const uint8_t *)"9[]", 3, &packet));
+    CHECK(!SocketIOargs::parsePacket((const uint8_t *)"5[\"x\"]", 6, &packet));
+
+    // arguments
+    const char * json = " [ \"move\" , {\"x\":[1,{\"y\":\"]\"}]} , -42, 2.5e1, true, null, \"a\\\"b\\\\c\\n\\u00e9\\ud83d\\ude00\" ] ";
+    SocketIOargs args(json, strlen(json));
+    size_t nameLength = 0;
+    const char * name = args.event(&nameLength);
+    CHECK(name && std::string(name, nameLength) == "move");
+    CHECK(args.getInt(1) == -42);
+    CHECK(args.getFloat(2) == 25.0);
+    CHECK(args.getBool(3) == true);
+    CHECK(args.isNull(4));
+    SocketIOarg_t arg;
+    CHECK(args.get(0, &arg) && std::string(arg.data, arg.length) == "{\"x\":[1,{\"y\":\"]\"}]}");
+    CHECK(args.isString(5));
+    char buffer[32];
+    CHECK(args.getString(5, buffer, sizeof(buffer)) == 12);
+    CHECK(strcmp(buffer, "a\"b\\c\n\xc3\xa9\xf0\x9f\x98\x80") == 0);
+    CHECK(args.getString(5, buffer, 4) == 3 && strcmp(buffer, "a\"b") == 0);
+    CHECK(args.getString(1, buffer, sizeof(buffer)) == 0 && buffer[0] == 0);
+    CHECK(args.count() == 6);
+    CHECK(!args.get(6, &arg));
+    CHECK(args.getInt(7, 99) == 99);
+
+    // incomplete data
+    const char * broken = "[\"move\",{\"x\":1";
+    SocketIOargs brokenArgs(broken, strlen(broken));
+    CHECK(brokenArgs.event(&nameLength) && nameLength == 4);
+    CHECK(!brokenArgs.get(0, &arg));
+
+    // router
+    LoopbackSocketIO io;
+    int moves = 0, other = 0, generic = 0;
+    long lastX = 0;
+    io.onEvent([&](socketIOmessageType_t type, uint8_t * payload, size_t length) {
+        generic++;
+    });
+    CHECK(io.on("move", [&](SocketIOargs & a, const SocketIOpacket_t & p) {
+        moves++;
+        lastX = a.getInt(0);
+        CHECK(p.ackId == 3);
+    }));
+    CHECK(io.on("other", [&](SocketIOargs & a, const SocketIOpacket_t & p) { other++; }));
+    CHECK(!io.on("", [&](SocketIOargs & a, const SocketIOpacket_t & p) {}));
+
+    std::string text = "423[\"move\",17]";
+    io.receive((uint8_t *)&text[0], text.size());
+    CHECK(moves == 1 && lastX == 17 && generic == 0);
+    text = "42[\"unknown\",1]";
+    io.receive((uint8_t *)&text[0], text.size());
+    CHECK(generic == 1);
+    text = "43[\"move\"]";
+    io.receive((uint8_t *)&text[0], text.size());
+    CHECK(moves == 1 && generic == 2);
+
+    // table full, removed slots are reused
+    int registered = 2;
+    for(int i = 0; i < SIO_EVENT_HANDLER_MAX; i++) {
+        std::string event = "e" + std::to_string(i);
+        if(io.on(event.c_str(), [&](SocketIOargs & a, const SocketIOpacket_t & p) {})) {
+            registered++;
+        }
+    }
+    CHECK(registered == SIO_EVENT_HANDLER_MAX - 1);
+    CHECK(io.off("move"));
+    CHECK(!io.off("move"));
+    text = "42[\"other\"]";
+    io.receive((uint8_t *)&text[0], text.size());
+    CHECK(other == 1);
+    CHECK(io.on("late", [&](SocketIOargs & a, const SocketIOpacket_t & p) { other += 10; }));
+    text = "42[\"late\"]";
+    io.receive((uint8_t *)&text[0], text.size());
+    CHECK(other == 11);
+}
+
+/**
+ * events are written directly (writev), the Engine.IO messages collected by enableCoalescing before them go first
+ */
+static void testSocketIOCoalescing() {
+    printf("socket.io coalescing\n");
+
+    LoopbackServer server;
+    LoopbackSocketIO io;
+    std::vector<std::string> received;
+
+    server.begin();
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_TEXT) {
+            received.push_back(std::string((char *)payload, len));
+        }
+    });
+    io.onEvent([&](socketIOmessageType_t type, uint8_t * payload, size_t length) {
+        if(type == sIOtype_CONNECT) {
+            // "2probe" and "5" wait in the coalescing buffer
+            io.sendEVENT("[\"status\",1]");
+#ifdef HOST_ARDUINOJSON
+            // serialized behind the header room of a buffer of the caller
+            JsonDocument doc;
+            doc.add("json");
+            doc.add(2);
+            uint8_t buffer[SIO_MAX_HEADER_SIZE + 16];
+            CHECK(!io.sendEVENT(doc, buffer, SIO_MAX_HEADER_SIZE + 10));
+            CHECK(io.sendEVENT(doc, buffer, sizeof(buffer)));
+#endif
+        }
+    });
+    io.beginPlain(server.port(), 50);
+
+#ifdef HOST_ARDUINOJSON
+    const size_t count = 4;
+#else
+    const size_t count = 3;
+#endif
+    unsigned long start = millis();
+    while(received.size() < count && millis() - start < 5000) {
+        server.loop();
+        io.loop();
+    }
+    CHECK(received.size() == count);
+    if(received.size() == count) {
+        CHECK(received[0] == "2probe");
+        CHECK(received[1] == "5");
+        CHECK(received[2] == "42[\"status\",1]");
+#ifdef HOST_ARDUINOJSON
+        CHECK(received[3] == "42[\"json\",2]");
+#endif
+    }
+    io.disconnect();
+    server.close();
+}
+
+/**
+ * per connection and global counters, export as JSON and MessagePack
+ */
+static void testMetrics() {
+    printf("metrics\n");
+
+    WebSockets::resetGlobalMetrics();
+
+    LoopbackServer server;
+    LoopbackClient client;
+    int texts = 0, pongs = 0;
+    server.onEvent([&](uint8_t num, WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_TEXT) {
+            texts++;
+        }
+    });
+    client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+        if(t == WStype_PONG) {
+            pongs++;
+        }
+    });
+    server.begin();
+    connectClient(server, client);
+    CHECK(pump(server, { &client }, [&]() { return client.isConnected(); }));
+
+    std::string text = pattern(100);
+    for(int i = 0; i < 10; i++) {
+        client.sendTXT(text.c_str(), text.size());
+    }
+    client.sendPing();
+    CHECK(pump(server, { &client }, [&]() { return texts == 10 && pongs == 1; }));
+
+    const WSmetrics_t & c  = client.getMetrics();
+    const WSmetrics_t * s  = server.getMetrics(0);
+    const WSmetrics_t & g  = WebSockets::globalMetrics();
+    CHECK(s && server.getMetrics(WEBSOCKETS_SERVER_CLIENT_MAX) == NULL);
+    CHECK(c.framesOut >= 11);
+    CHECK(s->framesIn >= 11);
+    CHECK(s->bytesIn >= 10 * (100 + 6));
+    CHECK(c.bytesOut > s->bytesIn);    // and the HTTP request
+    CHECK(c.rtt.count == 1 && c.rtt.max == c.rtt.sum);
+    CHECK(c.sendTime.count > 0);
+    uint32_t buckets = 0;
+    for(uint32_t n : c.sendTime.bucket) {
+        buckets += n;
+    }
+    CHECK(buckets == c.sendTime.count);
+
+    // both ends run here, the global counters are the sum
+    CHECK(g.framesIn == c.framesIn + s->framesIn);
+    CHECK(g.framesOut == c.framesOut + s->framesOut);
+    CHECK(g.bytesOut == c.bytesOut + s->bytesOut);
+    CHECK(g.rtt.count == c.rtt.count + s->rtt.count);
+    CHECK(g.payloadHeap == 0);
+    CHECK(g.payloadPeak >= 101);
+
+    uint8_t buffer[1024];
+    size_t jsonLength = WebSockets::exportMetrics(c, WSmetrics_JSON, buffer, sizeof(buffer));
+    CHECK(jsonLength < sizeof(buffer) && buffer[jsonLength] == 0);
+    CHECK(WebSockets::exportMetrics(c, WSmetrics_JSON, NULL, 0) == jsonLength);
+    CHECK(WebSockets::exportMetrics(c, WSmetrics_JSON, buffer, 10) == jsonLength);
+    jsonLength = WebSockets::exportMetrics(c, WSmetrics_JSON, buffer, sizeof(buffer));
+    CHECK(strstr((const char *)buffer, (std::string("\"framesOut\":") + std::to_string(c.framesOut) + ",").c_str()) != NULL);
+    CHECK(strstr((const char *)buffer, "\"rtt\":{\"count\":1,") != NULL);
+
+    uint8_t packed[1024];
+    size_t packedLength = WebSockets::exportMetrics(c, WSmetrics_MSGPACK, packed, sizeof(packed));
+    CHECK(packedLength > 0 && packedLength < jsonLength);
+
+#ifdef HOST_ARDUINOJSON
+    for(int msgpack = 0; msgpack < 2; msgpack++) {
+        JsonDocument doc;
+        DeserializationError error = msgpack ? deserializeMsgPack(doc, packed, packedLength) : deserializeJson(doc, buffer, jsonLength);
+        CHECK(!error);
+        CHECK(doc["framesIn"] == c.framesIn);
+        CHECK(doc["framesOut"] == c.framesOut);
+        CHECK(doc["bytesOut"] == c.bytesOut);
+        CHECK(doc["rtt"]["count"] == 1);
+        CHECK(doc["sendTime"]["sum"] == c.sendTime.sum);
+        CHECK(doc["sendTime"]["buckets"].size() == WEBSOCKETS_METRICS_BUCKETS);
+    }
+#endif
+
+    // a new connection starts with cleared counters (the client reconnects by itself)
+    client.disconnect();
+    CHECK(pump(server, { &client }, [&]() { return client.isConnected() && server.connectedClients() == 1; }));
+    CHECK(client.getMetrics().framesIn <= 1 && client.getMetrics().rtt.count == 0);
+    client.disconnect();
+    server.close();
+}
+
+/**
+ * round trip time from the heartbeat pings, adaptive interval / timeout, no pings while data flows
+ */
+static void testHeartbeat() {
+    printf("heartbeat\n");
+
+    // 0: fixed, 1: adaptive idle, 2: adaptive with data from the client, 3: adaptive, client stops answering
+    for(int mode = 0; mode < 4; mode++) {
+        LoopbackServer server;
+        LoopbackClient client;
+        int pings = 0;
+        client.onEvent([&](WStype_t t, uint8_t * payload, size_t len) {
+            if(t == WStype_PING) {
+                pings++;
+            }
+        });
+        if(mode == 0) {
+            server.enableHeartbeat(20, 3000, 2);
+        } else {
+            server.enableAdaptiveHeartbeat(20, 160, 3000, 2);
+        }
+        server.begin();
+        connectClient(server, client);
+        CHECK(pump(server, { &client }, [&]() { return client.isConnected(); }));
+
+        unsigned long start = millis();
+        if(mode == 2) {
+            while(millis() - start < 500) {
+                client.sendTXT("x");
+                unsigned long sent = millis();
+                pump(server, { &client }, [&]() { return millis() - sent >= 5; });
+            }
+            // at most the first ping before the data
+            CHECK(pings <= 1);
+            client.disconnect();
+            server.close();
+            continue;
+        }
+
+        // idle link
+        pump(server, { &client }, [&]() { return millis() - start > 700; });
+        const WSheartbeat_t * hb = server.getHeartbeat(0);
+        CHECK(hb && server.getHeartbeat(WEBSOCKETS_SERVER_CLIENT_MAX) == NULL);
+        CHECK(hb->samples >= 3);
+        CHECK(hb->srtt > 0 && hb->srtt < 50000);
+        if(mode == 0) {
+            CHECK(hb->interval == 20);
+            CHECK(hb->timeout == 3000);
+            CHECK(pings > 20);
+        } else {
+            CHECK(hb->interval == 160);
+            CHECK(hb->timeout == WEBSOCKETS_HB_MIN_TIMEOUT);
+            CHECK(pings >= 3 && pings < 12);
+        }
+
+        if(mode == 3) {
+            // the short timeout finds the dead peer fast (fixed: 2 * 3000 ms)
+            start = millis();
+            CHECK(pump(server, {}, [&]() { return server.connectedClients() == 0; }, 5000));
+            CHECK(millis() - start < 2500);
+        }
+        client.disconnect();
+        server.close();
+    }
+}
+
+/**
+ * only the pong of the last heartbeat ping answers it, not an other pong with "HB"
+ */
+static void testHeartbeatStalePong() {
+    printf("heartbeat stale pong\n");
+
+    LoopbackServer server;
+    LoopbackClient client;
+    server.enableHeartbeat(50, 30, 2);
+    server.begin();
+    connectClient(server, client);
+    CHECK(pump(server, { &client }, [&]() { return client.isConnected() && server.getHeartbeat(0)->samples >= 2; }));
+    uint32_t samples = server.getHeartbeat(0)->samples;
+    uint32_t srtt    = server.getHeartbeat(0)->srtt;
+
+    // the client does not answer the pings any more, it sends pongs of an earlier ping
+    uint8_t stale[]     = { 'H', 'B', 0x00, 0x00, 0x00, 0x01 };
+    unsigned long start = millis();
+    while(server.connectedClients() == 1 && millis() - start < 1000) {
+        client.sendRawFrame(WSop_pong, stale, sizeof(stale), true, false);
+        pump(server, {}, [&]() { return false; }, 5);
+        if(server.connectedClients() == 1) {
+            CHECK(server.getHeartbeat(0)->samples == samples && server.getHeartbeat(0)->srtt == srtt);
+        }
+    }
+    // no pong of the last pings: two timeouts
+    CHECK(server.connectedClients() == 0);
+    CHECK(millis() - start < 300);
+
+    client.disconnect();
+    server.close();
+}
+
+int main() {
+    testEcho("text echo", WStype_TEXT, 100, false);
+    testEcho("binary echo", WStype_BIN, 10000, false);
+    testEcho("deflate echo", WStype_TEXT, 6000, true);
+    testDeflateEmpty();
+    testFragments();
+    testReassembly();
+    testStreaming();
+    testUtf8Validator();
+    testUtf8("utf8 fragments", 0, false);
+    testUtf8("utf8 streaming", 5, false);
+    testUtf8("utf8 deflate", 0, true);
+    testCoalescing();
+    testAdoptPayload();
+    testBroadcast();
+    testRequestHead();
+    testConnect();
+    testReconnectBackoff();
+    testRebegin();
+    testSocketIO();
+    testSocketIOCoalescing();
+    testMetrics();
+    testHeartbeat();
+    testHeartbeatStalePong();
+
+    if(failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all passed\n");
+    return 0;
+}